@@ -30,7 +30,7 @@ int main(void) {
         memset(&txs[i], 0, sizeof(PCTransaction));
         memcpy(txs[i].from, sender.public_key, 32);
         memcpy(txs[i].to, receiver.public_key, 32);
-        txs[i].amount = 1.0;
+        txs[i].amount = pc_amount_from_coins(1.0);
         txs[i].nonce = i;
         txs[i].timestamp = time(NULL);
         pc_transaction_sign(&txs[i], &sender);
@@ -71,6 +71,31 @@ int main(void) {
         printf("  Throughput: %.0f verify/sec\n\n", tps);
     }
     
+    // Multi-scalar batch verification through the public API
+    const PCTransaction** ptrs = malloc(NUM_TXS * sizeof(PCTransaction*));
+    int* results = malloc(NUM_TXS * sizeof(int));
+    for (int i = 0; i < NUM_TXS; i++) ptrs[i] = &txs[i];
+    
+    int threads = omp_get_max_threads();
+    int thread_counts[2] = { 1, threads };
+    for (int t = 0; t < (threads > 1 ? 2 : 1); t++) {
+        printf("═══ Batch Verification (%d thread%s) ═══\n", thread_counts[t],
+               thread_counts[t] == 1 ? "" : "s");
+        omp_set_num_threads(thread_counts[t]);
+        double start = omp_get_wtime();
+        int pass = pc_transaction_verify_batch(ptrs, NUM_TXS, results);
+        double elapsed = omp_get_wtime() - start;
+        double tps = NUM_TXS / elapsed;
+        
+        printf("  Time:       %.3f sec\n", elapsed);
+        printf("  Verified:   %d / %d\n", pass, NUM_TXS);
+        printf("  Throughput: %.0f verify/sec (%.0f per core)\n\n", tps, tps / thread_counts[t]);
+    }
+    omp_set_num_threads(threads);
+    
+    free(ptrs);
+    free(results);
+    
     // Calculate speedup
     printf("╔═══════════════════════════════════════════════════════════════╗\n");
     printf("║  Speedup from parallelization measured above                  ║\n");
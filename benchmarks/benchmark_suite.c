@@ -30,7 +30,7 @@ void benchmark_storage(FILE* out) {
     PCKeypair kp;
     pc_keypair_generate(&kp);
     PCState state;
-    pc_state_genesis(&state, kp.public_key, 1000.0);
+    pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000.0));
     
     uint8_t buffer[65536];
     size_t size = pc_state_serialize(&state, buffer, sizeof(buffer));
@@ -50,7 +50,7 @@ void benchmark_throughput(FILE* out) {
     pc_keypair_generate(&wallets[1]);
     
     PCState state;
-    pc_state_genesis(&state, wallets[0].public_key, 1000000.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(1000000.0));
     pc_state_create_wallet(&state, wallets[1].public_key, 0);
     
     // Benchmark
@@ -60,7 +60,7 @@ void benchmark_throughput(FILE* out) {
         PCTransaction tx = {0};
         memcpy(tx.from, wallets[0].public_key, 32);
         memcpy(tx.to, wallets[1].public_key, 32);
-        tx.amount = 1.0;
+        tx.amount = pc_amount_from_coins(1.0);
         tx.nonce = i;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &wallets[0]);
@@ -91,7 +91,7 @@ void benchmark_state_scaling(FILE* out) {
         pc_keypair_generate(&kp);
         
         PCState state;
-        pc_state_genesis(&state, kp.public_key, 1000000.0);
+        pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000000.0));
         
         // Add wallets
         for (int j = 1; j < wallet_counts[i]; j++) {
@@ -122,7 +122,7 @@ void benchmark_latency(FILE* out) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     // Measure individual transaction times
@@ -132,7 +132,7 @@ void benchmark_latency(FILE* out) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 1.0;
+        tx.amount = pc_amount_from_coins(1.0);
         tx.nonce = i;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -160,12 +160,12 @@ void benchmark_conservation(FILE* out) {
     }
     
     PCState state;
-    pc_state_genesis(&state, wallets[0].public_key, 10000.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(10000.0));
     for (int i = 1; i < NUM_WALLETS; i++) {
         pc_state_create_wallet(&state, wallets[i].public_key, 0);
     }
     
-    double initial_supply = state.total_supply;
+    PCAmount initial_supply = state.total_supply;
     uint64_t nonces[NUM_WALLETS] = {0};
     
     srand(42);
@@ -176,11 +176,11 @@ void benchmark_conservation(FILE* out) {
     for (int t = 0; t <= 5000; t++) {
         // Record at checkpoints
         if (checkpoint_idx < num_checkpoints && t == checkpoints[checkpoint_idx]) {
-            double sum = 0;
+            PCAmount sum = 0;
             for (uint32_t i = 0; i < state.num_wallets; i++) {
-                sum += state.wallets[i].energy;
+                sum += pc_state_wallet_at(&state, i)->energy;
             }
-            double error = sum - initial_supply;
+            double error = pc_amount_to_coins(sum - initial_supply);
             
             fprintf(out, "    {\"tx_count\": %d, \"error\": %.15e}%s\n",
                     t, error, checkpoint_idx < num_checkpoints - 1 ? "," : "");
@@ -195,10 +195,10 @@ void benchmark_conservation(FILE* out) {
         if (from_idx == to_idx) continue;
         
         PCWallet* from_wallet = pc_state_get_wallet(&state, wallets[from_idx].public_key);
-        if (!from_wallet || from_wallet->energy < 1.0) continue;
+        if (!from_wallet || from_wallet->energy < PC_AMOUNT_SCALE) continue;
         
-        double amount = (rand() % 100) + 1.0;
-        if (amount > from_wallet->energy) amount = from_wallet->energy * 0.5;
+        PCAmount amount = (PCAmount)(rand() % 100 + 1) * PC_AMOUNT_SCALE;
+        if (amount > from_wallet->energy) amount = from_wallet->energy / 2;
         
         PCTransaction tx = {0};
         memcpy(tx.from, wallets[from_idx].public_key, 32);
@@ -325,7 +325,7 @@ void benchmark_bytes_per_wallet(FILE* out) {
         pc_keypair_generate(&kp);
         
         PCState state;
-        pc_state_genesis(&state, kp.public_key, 1000000.0);
+        pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000000.0));
         
         for (int j = 1; j < wallet_counts[i]; j++) {
             PCKeypair w;
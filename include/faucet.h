@@ -16,7 +16,7 @@ void pc_faucet_init(void);
 
 // Request faucet funds
 // Returns PC_OK on success, PC_ERR_RATE_LIMIT if cooldown not expired
-PCError pc_faucet_request(PCState* state, const uint8_t* address, double* amount_out);
+PCError pc_faucet_request(PCState* state, const uint8_t* address, PCAmount* amount_out);
 
 // Check if address can request faucet
 int pc_faucet_can_request(const uint8_t* address);
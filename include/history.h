@@ -0,0 +1,78 @@
+// history.h - Random-access on-disk time-travel history
+// Checkpoints are independently decodable blocks; a footer indexes them by
+// timestamp so a query reads only the block it needs
+
+#ifndef PHYSICSCOIN_HISTORY_H
+#define PHYSICSCOIN_HISTORY_H
+
+#include "physicscoin.h"
+#include "timetravel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PC_HISTORY_CACHE_BLOCKS 4  // Decoded checkpoints kept resident
+
+// Footer index entry (one per checkpoint block, in timestamp order)
+typedef struct {
+    uint64_t timestamp;
+    uint64_t offset;             // Block header position
+    uint64_t length;             // Payload bytes (compact state)
+    uint32_t transaction_index;
+    uint32_t reserved;
+    uint8_t state_hash[32];
+} PCHistoryIndexEntry;
+
+// Decoded checkpoint in the cache
+typedef struct {
+    uint32_t entry;     // Index entry it was decoded from
+    uint64_t last_use;  // 0 = empty slot
+    PCState state;
+} PCHistoryCacheSlot;
+
+// History file opened for queries, or for appends and queries
+typedef struct {
+    int fd;
+    const uint8_t* map;           // Whole file, read-only; blocks fault in on use
+    size_t map_size;              // Remapped when an append grows the file past it
+    PCHistoryIndexEntry* index;
+    uint32_t num_entries;
+    uint32_t index_capacity;      // Entries allocated (appenders grow it)
+    uint64_t end;                 // Where the footer (and the next block) starts
+    int writable;
+    uint64_t clock;               // Cache use counter
+    PCHistoryCacheSlot cache[PC_HISTORY_CACHE_BLOCKS];
+} PCHistoryFile;
+
+// Append a checkpoint of state; only the footer is rewritten
+PCError pc_history_append(const char* filename, const PCState* state, uint32_t tx_index);
+
+// Open for appends (creating the file if needed) as well as queries. The
+// index stays in memory, so each pc_history_add writes one block and the
+// footer without reading anything back.
+PCError pc_history_open_append(PCHistoryFile* file, const char* filename);
+PCError pc_history_add(PCHistoryFile* file, const PCState* state, uint32_t tx_index);
+
+// Write an in-memory checkpoint history as a history file
+PCError pc_history_write(const PCCheckpointHistory* history, const char* filename);
+
+// Map the file and read its footer. A torn footer (crash during an append)
+// is rebuilt by scanning the blocks.
+PCError pc_history_open(PCHistoryFile* file, const char* filename);
+
+// Wallet contents / balance at the checkpoint before timestamp; a wallet
+// that did not exist yet reads as zero
+PCError pc_history_wallet_at(PCHistoryFile* file, const uint8_t* pubkey,
+                             uint64_t timestamp, PCWallet* wallet);
+PCError pc_history_balance_at(PCHistoryFile* file, const uint8_t* pubkey,
+                              uint64_t timestamp, PCAmount* balance);
+PCError pc_history_state_hash_at(const PCHistoryFile* file, uint64_t timestamp, uint8_t* hash_out);
+
+void pc_history_close(PCHistoryFile* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHYSICSCOIN_HISTORY_H
@@ -0,0 +1,58 @@
+// journal.h - Append-only mutation journals for on-disk registries
+// A registry keeps a snapshot file plus a journal of records applied on top
+
+#ifndef PHYSICSCOIN_JOURNAL_H
+#define PHYSICSCOIN_JOURNAL_H
+
+#include "physicscoin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Journal file header; records follow as JournalRecord + payload
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t generation;  // Snapshot this journal applies to
+} JournalHeader;
+
+typedef struct {
+    uint32_t type;        // Registry-defined record type
+    uint32_t length;      // Payload bytes
+    uint8_t checksum[32]; // SHA-256 of type, length and payload
+} JournalRecord;
+
+typedef struct {
+    int fd;  // -1 when closed
+    char path[256];
+    uint64_t generation;
+    uint32_t records;  // Appended since the last snapshot
+} PCJournal;
+
+// Replays one record into the registry
+typedef void (*PCJournalApplyFn)(void* ctx, uint32_t type, const void* data, uint32_t length);
+
+// Open the journal for a snapshot of the given generation, replay its
+// records through apply and cut off a torn tail. A journal left from
+// another generation is already folded into the snapshot and is discarded.
+PCError pc_journal_open(PCJournal* journal, const char* path, uint64_t generation,
+                        PCJournalApplyFn apply, void* ctx);
+
+// Append one record with a single write and fdatasync
+PCError pc_journal_append(PCJournal* journal, uint32_t type, const void* data, uint32_t length);
+
+// Start an empty journal once the snapshot of generation is durable
+PCError pc_journal_reset(PCJournal* journal, uint64_t generation);
+
+// Compact once the journal holds more records than the registry has entries
+// (and at least a minimum, so small registries do not rewrite on every call)
+int pc_journal_should_compact(const PCJournal* journal, uint32_t live_entries);
+
+void pc_journal_close(PCJournal* journal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHYSICSCOIN_JOURNAL_H
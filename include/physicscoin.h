@@ -8,7 +8,7 @@
 #include <stddef.h>
 
 #define PHYSICSCOIN_VERSION "1.0.0"
-#define PHYSICSCOIN_MAX_WALLETS 10000
+#define PHYSICSCOIN_MAX_WALLETS (1u << 30)
 #define PHYSICSCOIN_KEY_SIZE 32
 #define PHYSICSCOIN_SIG_SIZE 64
 #define PHYSICSCOIN_HASH_SIZE 32
@@ -35,10 +35,24 @@ typedef enum {
     PC_ERR_INVALID_BLOCK = -17
 } PCError;
 
-// Wallet structure
+// Fixed-point amounts: 1 coin = PC_AMOUNT_SCALE base units
+typedef int64_t PCAmount;
+#define PC_AMOUNT_SCALE 100000000LL
+
+// Coins to base units, rounded to the nearest unit
+static inline PCAmount pc_amount_from_coins(double coins) {
+    double units = coins * (double)PC_AMOUNT_SCALE;
+    return (PCAmount)(units < 0 ? units - 0.5 : units + 0.5);
+}
+
+// Base units to coins (for display and rate math only)
+static inline double pc_amount_to_coins(PCAmount amount) {
+    return (double)amount / (double)PC_AMOUNT_SCALE;
+}
+
+// Wallet balance record; the owning public key lives in the state's key column
 typedef struct {
-    uint8_t public_key[PHYSICSCOIN_KEY_SIZE];
-    double energy;       // Balance as Hamiltonian energy
+    PCAmount energy;     // Balance as Hamiltonian energy (base units)
     uint64_t nonce;      // Transaction counter (replay protection)
 } PCWallet;
 
@@ -46,24 +60,102 @@ typedef struct {
 typedef struct {
     uint8_t from[PHYSICSCOIN_KEY_SIZE];
     uint8_t to[PHYSICSCOIN_KEY_SIZE];
-    double amount;
+    PCAmount amount;
     uint64_t nonce;
     uint64_t timestamp;
     uint8_t signature[PHYSICSCOIN_SIG_SIZE];
 } PCTransaction;
 
-// Universe state - the entire ledger
+// Wallet store page geometry: wallets live in fixed pages and never move.
+// A page is also the unit of copy-on-write, checkpoint increments and
+// time-travel sharing, so it is kept small (4 KB of wallets)
+#define PC_WALLET_PAGE_SHIFT 8
+#define PC_WALLET_PAGE_SIZE (1u << PC_WALLET_PAGE_SHIFT)
+#define PC_WALLET_PAGE_MASK (PC_WALLET_PAGE_SIZE - 1)
+
+// Merkle tree depth bound (2^32 leaves)
+#define PC_MERKLE_MAX_DEPTH 32
+
+// Incremental Merkle tree over wallet leaves (zeroed = empty tree)
 typedef struct {
+    uint8_t* levels[PC_MERKLE_MAX_DEPTH + 1];        // levels[0] = leaf hashes, 32 bytes per node
+    uint32_t level_capacity[PC_MERKLE_MAX_DEPTH + 1]; // Allocated nodes per level
+    uint32_t num_leaves;        // Leaves covered by the stored levels
+    uint32_t* dirty;            // Leaves touched since the last update
+    uint32_t num_dirty;
+    uint32_t dirty_capacity;
+    uint8_t* dirty_bits;        // Dedup bitmap for the dirty list
+    uint32_t dirty_bits_size;   // Bitmap size in bytes
+    int needs_rebuild;          // Stored levels are stale; rebuild on next update
+} PCMerkleTree;
+
+// Inclusion proof for one wallet leaf
+typedef struct {
+    uint32_t leaf_index;
+    uint32_t depth;
+    uint8_t siblings[PC_MERKLE_MAX_DEPTH][PHYSICSCOIN_HASH_SIZE];
+} PCMerkleProof;
+
+// One-pass aggregates over every wallet balance
+typedef struct {
+    uint64_t sum;           // Wrapping sum of all balances (compare with (uint64_t)total_supply)
+    PCAmount min;           // INT64_MAX when there are no wallets
+    PCAmount max;           // INT64_MIN when there are no wallets
+    uint32_t negative;      // Wallets below zero
+    uint32_t positive;      // Wallets above zero
+    uint64_t positive_sum;  // Sum over wallets above zero
+} PCScanStats;
+
+// Page ownership bits (PCState.page_flags)
+#define PC_PAGE_OWN_WALLETS 0x01     // The wallet page is freed with this state
+#define PC_PAGE_OWN_KEYS 0x02        // The key page is freed with this state
+#define PC_PAGE_SHARED_WALLETS 0x04  // Wallet page also backs the frozen view
+#define PC_PAGE_SHARED_KEYS 0x08     // Key page also backs the frozen view
+
+// Universe state - the entire ledger
+typedef struct PCState {
     uint64_t version;
     uint64_t timestamp;
     uint32_t num_wallets;
-    double total_supply;
+    PCAmount total_supply;
     uint8_t state_hash[PHYSICSCOIN_HASH_SIZE];
     uint8_t prev_hash[PHYSICSCOIN_HASH_SIZE];
-    PCWallet* wallets;
-    size_t wallets_capacity;
+    PCWallet** wallet_pages;    // Page directory; page p holds wallets [p << SHIFT, (p + 1) << SHIFT)
+    uint8_t** key_pages;        // Key column, paged alongside wallet_pages (32 bytes per wallet)
+    uint32_t num_pages;         // Pages allocated
+    uint32_t page_slots;        // Directory capacity
+    uint64_t* wallet_index;     // Open-addressing pubkey index: (tag << 32) | (slot + 1)
+    uint32_t index_capacity;    // Index slots (power of two, 0 = not built)
+    uint32_t index_count;       // Wallets currently present in the index
+    uint64_t index_seed;        // Pubkey hash key (0 = take the process seed on first build)
+    void* snapshot;             // Mapped snapshot file, NULL when the state is all heap
+    size_t snapshot_size;
+    uint8_t* page_flags;        // PC_PAGE_* per page (page_slots entries); mapped pages own nothing
+    struct PCState* view;       // Frozen view sharing pages with this state (NULL = none)
+    int index_mapped;           // wallet_index lives inside the mapping
+    uint64_t checkpoint_id;     // Checkpoint this state was saved as or loaded from (0 = none)
+    uint8_t* dirty_pages;       // Bit per page written since that checkpoint
+    uint32_t dirty_bytes;       // Bitmap size in bytes
+    PCMerkleTree merkle;        // Wallet commitment folded into state_hash
 } PCState;
 
+// Wallet by insertion index (i < num_wallets); mutate through pc_state_get_wallet
+static inline const PCWallet* pc_state_wallet_at(const PCState* state, uint32_t i) {
+    return &state->wallet_pages[i >> PC_WALLET_PAGE_SHIFT][i & PC_WALLET_PAGE_MASK];
+}
+
+// Mutable wallet by index; the caller keeps the Merkle tree in sync and
+// calls pc_state_mark_dirty first
+static inline PCWallet* pc_state_wallet_mut(PCState* state, uint32_t i) {
+    return &state->wallet_pages[i >> PC_WALLET_PAGE_SHIFT][i & PC_WALLET_PAGE_MASK];
+}
+
+// Public key of the wallet at index i (keys never change once created)
+static inline const uint8_t* pc_state_key_at(const PCState* state, uint32_t i) {
+    return state->key_pages[i >> PC_WALLET_PAGE_SHIFT] +
+           (size_t)(i & PC_WALLET_PAGE_MASK) * PHYSICSCOIN_KEY_SIZE;
+}
+
 // Keypair for signing
 typedef struct {
     uint8_t public_key[PHYSICSCOIN_KEY_SIZE];
@@ -79,23 +171,137 @@ PCError pc_state_init(PCState* state);
 void pc_state_free(PCState* state);
 
 // Create genesis state with initial supply
-PCError pc_state_genesis(PCState* state, const uint8_t* founder_pubkey, double initial_supply);
+PCError pc_state_genesis(PCState* state, const uint8_t* founder_pubkey, PCAmount initial_supply);
 
-// Get wallet by public key (returns NULL if not found)
+// Get wallet by public key for mutation (marks its page dirty; returns NULL if not found)
 PCWallet* pc_state_get_wallet(PCState* state, const uint8_t* pubkey);
 
+// Read-only wallet lookup for const states (returns NULL if not found)
+const PCWallet* pc_state_find_wallet(const PCState* state, const uint8_t* pubkey);
+
+// Deep copy a state (wallets, index and tree) into an uninitialized destination
+PCError pc_state_clone(PCState* dst, const PCState* src);
+
+// Rebuild the pubkey index from the wallet pages
+PCError pc_state_rebuild_index(PCState* state);
+
+// Insertion index of a wallet (no Merkle bookkeeping)
+PCError pc_state_find_index(const PCState* state, const uint8_t* pubkey, uint32_t* index_out);
+
+// Allocate pages for at least count wallets (wallets already present stay in place)
+PCError pc_state_reserve_wallets(PCState* state, uint32_t count);
+
+// Call before writing wallet i: copies its page away from a frozen view and
+// records that the page changed since the last checkpoint
+PCError pc_state_mark_dirty(PCState* state, uint32_t i);
+
+// Whether page p changed since the last checkpoint
+static inline int pc_state_page_dirty(const PCState* state, uint32_t p) {
+    return (p >> 3) < state->dirty_bytes && (state->dirty_pages[p >> 3] >> (p & 7)) & 1;
+}
+
+// Forget page changes (the state now matches checkpoint_id on disk)
+void pc_state_clear_dirty(PCState* state);
+
+// Take a point-in-time, read-only view of the wallets in O(pages): the view
+// shares every page, and the state copies a page the first time it writes to
+// it afterwards. The view takes over the dirty pages. It may be read from
+// another thread while the owner keeps executing; one view at a time.
+PCError pc_state_freeze(PCState* state, PCState* view);
+
+// Detach and free the view (owner thread, once nobody reads the view). Dirty
+// pages the view still holds go back to the state.
+void pc_state_thaw(PCState* state, PCState* view);
+
 // Create new wallet in state
-PCError pc_state_create_wallet(PCState* state, const uint8_t* pubkey, double initial_balance);
+PCError pc_state_create_wallet(PCState* state, const uint8_t* pubkey, PCAmount initial_balance);
 
 // Execute a transaction
 PCError pc_state_execute_tx(PCState* state, const PCTransaction* tx);
 
+// Execute a transaction whose signature has already been verified
+PCError pc_state_apply_tx(PCState* state, const PCTransaction* tx);
+
+// Verify every signature in parallel, then apply valid transactions in order.
+// results[i] (optional) receives each transaction's PCError; returns the number applied.
+uint32_t pc_state_execute_batch(PCState* state, const PCTransaction* txs,
+                                uint32_t count, int* results);
+
+// Nonce, funds and amount checks plus the exact balance move (no signature, no hashing)
+PCError pc_state_transfer(PCWallet* from, PCWallet* to, const PCTransaction* tx);
+
 // Verify conservation law
 PCError pc_state_verify_conservation(const PCState* state);
 
-// Compute state hash
+// Compute state hash (header fields + Merkle root of the wallets)
 void pc_state_compute_hash(PCState* state);
 
+// Hash header fields with a wallet root as if the state held num_wallets wallets
+void pc_state_hash_header(const PCState* state, uint32_t num_wallets,
+                          const uint8_t* root, uint8_t* hash_out);
+
+// Current Merkle root over the wallets (flushes pending leaf updates)
+PCError pc_state_merkle_root(PCState* state, uint8_t* root_out);
+
+// Build an inclusion proof for a wallet against pc_state_merkle_root
+PCError pc_state_merkle_proof(PCState* state, const uint8_t* pubkey, PCMerkleProof* proof);
+
+// ============ Merkle API ============
+
+// Release tree storage and reset to the empty tree
+void pc_merkle_free(PCMerkleTree* tree);
+
+// Deep copy a tree into an uninitialized destination
+PCError pc_merkle_clone(PCMerkleTree* dst, const PCMerkleTree* src);
+
+// Record that a leaf's wallet may have changed
+void pc_merkle_mark_dirty(PCMerkleTree* tree, uint32_t leaf);
+
+// Drop all stored hashes; the next update rebuilds from the wallets
+void pc_merkle_invalidate(PCMerkleTree* tree);
+
+// Rehash dirty leaves and their paths so the root matches the state
+PCError pc_merkle_update(PCMerkleTree* tree, const PCState* state);
+
+// Install precomputed leaf hashes into a clean tree of num_leaves and rehash
+// their paths. Leaves appended since the last update must all be listed;
+// leaves is reordered in place.
+PCError pc_merkle_set_leaves(PCMerkleTree* tree, uint32_t num_leaves,
+                             uint32_t* leaves, const uint8_t* hashes, uint32_t count);
+
+// Root of an up-to-date tree (all zeros when empty)
+void pc_merkle_root(const PCMerkleTree* tree, uint8_t* root_out);
+
+// Hash of a single wallet leaf
+void pc_merkle_leaf_hash(const uint8_t* pubkey, const PCWallet* wallet, uint8_t* hash_out);
+
+// Fill the sibling path for a leaf of an up-to-date tree
+PCError pc_merkle_proof(const PCMerkleTree* tree, uint32_t leaf, PCMerkleProof* proof);
+
+// Check a wallet against a root using an inclusion proof
+PCError pc_merkle_verify_proof(const uint8_t* root, const uint8_t* pubkey, const PCWallet* wallet,
+                               const PCMerkleProof* proof);
+
+// ============ Scan API ============
+// Bulk reductions over wallet balances; AVX-512 or AVX2 when the build
+// targets them, scalar otherwise
+
+// Wrapping sum of all balances
+uint64_t pc_scan_sum(const PCState* state);
+
+// Sum, min/max and sign counts in a single pass
+void pc_scan_stats(const PCState* state, PCScanStats* out);
+
+// Bucket balances by ascending bounds: counts[0] holds balances below
+// bounds[0], counts[j] those in [bounds[j-1], bounds[j]), counts[num_bounds]
+// the rest. counts must have num_bounds + 1 entries.
+void pc_scan_histogram(const PCState* state, const PCAmount* bounds,
+                       uint32_t num_bounds, uint32_t* counts);
+
+// k-th largest balance: at least k wallets hold this much or more
+// (INT64_MIN when there are fewer than k wallets, INT64_MAX when k is 0)
+PCAmount pc_scan_topk_threshold(const PCState* state, uint32_t k);
+
 // ============ Crypto API ============
 
 // Generate new keypair
@@ -107,20 +313,46 @@ PCError pc_transaction_sign(PCTransaction* tx, const PCKeypair* kp);
 // Verify transaction signature
 PCError pc_transaction_verify(const PCTransaction* tx);
 
+// Verify many signatures in parallel (results[i] = 1 if valid; returns valid count)
+int pc_transaction_verify_batch(const PCTransaction** txs, int count, int* results);
+
 // ============ Serialization API ============
 
-// Save state to file
+// Save state as a mappable snapshot (written aside, then renamed over filename)
 PCError pc_state_save(const PCState* state, const char* filename);
 
-// Load state from file
+// Load state from file. Snapshots are mapped copy-on-write: pages, keys and
+// the pubkey index are used in place and only touched pages get copied.
+// Older formats are read into the heap.
 PCError pc_state_load(PCState* state, const char* filename);
 
+// Load like pc_state_load, but map snapshot pages read-only; wallets must
+// not be created or modified (for explorers and query-only commands)
+PCError pc_state_load_readonly(PCState* state, const char* filename);
+
 // Serialize state to buffer (returns bytes written)
 size_t pc_state_serialize(const PCState* state, uint8_t* buffer, size_t max_size);
 
-// Deserialize state from buffer
+// Deserialize state from buffer (raw or compact format)
 PCError pc_state_deserialize(PCState* state, const uint8_t* buffer, size_t size);
 
+// Byte sink and source for the streaming compact codec; each returns the
+// number of bytes moved (short only on error or end of input)
+typedef size_t (*PCWriteFn)(void* ctx, const void* data, size_t len);
+typedef size_t (*PCReadFn)(void* ctx, void* data, size_t len);
+
+// Stream state in the compact format: keys front-coded against the previous
+// key, varint balances and nonces, LZ-compressed 64 KB blocks. Memory use is
+// one block either way.
+PCError pc_state_write_compact(const PCState* state, PCWriteFn write, void* ctx);
+PCError pc_state_read_compact(PCState* state, PCReadFn read, void* ctx);
+
+// Compact format into a buffer (returns bytes written, 0 if it does not fit)
+size_t pc_state_serialize_compact(const PCState* state, uint8_t* buffer, size_t max_size);
+
+// Save in the compact format for transfer or archive; pc_state_load reads it
+PCError pc_state_save_compact(const PCState* state, const char* filename);
+
 // ============ Utility ============
 
 // Convert public key to hex string
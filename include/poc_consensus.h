@@ -47,8 +47,8 @@ typedef struct {
     uint64_t round;               // Consensus round
     uint8_t prev_state_hash[32];  // Hash of previous state
     uint8_t new_state_hash[32];   // Hash of proposed new state
-    double total_supply;          // Must be unchanged (conservation)
-    double delta_sum;             // Sum of balance changes (must be 0)
+    PCAmount total_supply;        // Must be unchanged (conservation)
+    PCAmount delta_sum;           // Sum of balance changes (must be 0)
     uint64_t timestamp;           // Proposal timestamp
     uint8_t proposer_pubkey[32];  // Who proposed this
     uint8_t proposer_sig[64];     // Ed25519 signature
@@ -77,7 +77,7 @@ typedef struct {
 typedef struct {
     uint8_t sender_pubkey[32];    // Who is sending
     uint8_t lock_hash[32];        // Hash of the lock
-    double amount;                // Amount being locked
+    PCAmount amount;              // Amount being locked
     uint8_t source_shard;         // Source shard ID
     uint8_t target_shard;         // Target shard ID
     uint64_t sequence;            // Lock sequence number
@@ -121,7 +121,7 @@ typedef struct {
     int is_validator;
     
     // Conservation tracking
-    double expected_total_supply;
+    PCAmount expected_total_supply;
 } POCConsensus;
 
 // ============ Initialization ============
@@ -192,7 +192,7 @@ void poc_next_round(POCConsensus* consensus);
 // Acquire a lock for cross-shard transaction
 PCError poc_acquire_lock(POCConsensus* consensus,
                          const uint8_t* sender,
-                         double amount,
+                         PCAmount amount,
                          uint8_t source_shard,
                          uint8_t target_shard);
 
@@ -0,0 +1,73 @@
+// replay.h - State Replay Engine
+// Deterministically verify state by replaying transaction history
+
+#ifndef PHYSICSCOIN_REPLAY_H
+#define PHYSICSCOIN_REPLAY_H
+
+#include "physicscoin.h"
+#include "timetravel.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Replay log held in memory (up to MAX_REPLAY_TRANSACTIONS)
+typedef struct {
+    PCState genesis;                     // Initial state
+    PCTransaction* transactions;         // All transactions in order
+    uint32_t num_transactions;
+    uint8_t expected_final_hash[32];    // What we expect at the end
+} PCReplayLog;
+
+// Replay log file read a chunk at a time; memory use does not grow with
+// the number of transactions
+typedef struct {
+    int fd;
+    PCState genesis;
+    uint32_t num_transactions;
+    uint32_t position;                  // Transactions read so far
+    uint64_t tx_offset;                 // File offset of the first transaction
+    uint8_t expected_final_hash[32];
+} PCReplayStream;
+
+// Replay log file written one transaction at a time
+typedef struct {
+    FILE* f;
+    uint32_t num_transactions;
+    long count_offset;                  // Where the count is patched on close
+} PCReplayWriter;
+
+PCError pc_replay_init(PCReplayLog* log, const PCState* genesis);
+PCError pc_replay_add_tx(PCReplayLog* log, const PCTransaction* tx);
+PCError pc_replay_verify(const PCReplayLog* log, const uint8_t* expected_hash);
+PCError pc_replay_execute(const PCReplayLog* log, PCState* final_state);
+void pc_replay_free(PCReplayLog* log);
+PCError pc_replay_save(const PCReplayLog* log, const char* filename);
+PCError pc_replay_load(PCReplayLog* log, const char* filename);
+void pc_replay_print(const PCReplayLog* log);
+
+// Split the log at checkpoints and replay the segments in parallel
+PCError pc_replay_verify_segmented(const PCReplayLog* log, const PCCheckpointHistory* checkpoints,
+                                   const uint8_t* expected_hash);
+
+// Streaming writer (same file format as pc_replay_save)
+PCError pc_replay_writer_open(PCReplayWriter* writer, const char* filename, const PCState* genesis);
+PCError pc_replay_writer_add(PCReplayWriter* writer, const PCTransaction* tx);
+PCError pc_replay_writer_close(PCReplayWriter* writer, const uint8_t* final_hash);
+
+// Streaming reader: genesis and the expected hash are loaded on open,
+// transactions on demand
+PCError pc_replay_stream_open(PCReplayStream* stream, const char* filename);
+uint32_t pc_replay_stream_read(PCReplayStream* stream, PCTransaction* txs, uint32_t max);
+void pc_replay_stream_close(PCReplayStream* stream);
+
+// Verify / execute straight from the stream (expected_hash NULL = the file's own)
+PCError pc_replay_verify_stream(PCReplayStream* stream, const uint8_t* expected_hash);
+PCError pc_replay_execute_stream(PCReplayStream* stream, PCState* final_state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHYSICSCOIN_REPLAY_H
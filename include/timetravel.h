@@ -0,0 +1,96 @@
+// timetravel.h - Time-Travel Balance Queries
+// Checkpoints of past states plus per-wallet change logs
+
+#ifndef PHYSICSCOIN_TIMETRAVEL_H
+#define PHYSICSCOIN_TIMETRAVEL_H
+
+#include "physicscoin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// State checkpoint structure
+typedef struct {
+    uint8_t state_hash[32];
+    uint64_t timestamp;
+    uint32_t transaction_index;  // Which transaction created this state
+    PCState state;                // Read-only state at this point (pages shared)
+} PCStateCheckpoint;
+
+// Wallet contents after one recorded change
+typedef struct {
+    uint64_t timestamp;
+    uint64_t version;    // History-wide change counter (orders changes within a timestamp)
+    PCAmount energy;
+    uint64_t nonce;
+} PCBalanceChange;
+
+// Change log of one wallet, in version order
+typedef struct {
+    uint8_t pubkey[32];
+    PCBalanceChange* changes;
+    uint32_t num_changes;
+    uint32_t capacity;
+} PCWalletLog;
+
+// Checkpoint history
+typedef struct {
+    PCStateCheckpoint* checkpoints;
+    uint32_t num_checkpoints;
+    uint32_t checkpoint_interval;  // Checkpoint every N transactions
+    uint32_t capacity;
+    PCWalletLog* logs;             // One per wallet changed since recording began
+    uint32_t num_logs;
+    uint32_t log_capacity;
+    uint64_t* log_index;           // Open-addressing pubkey index: (tag << 32) | (log + 1)
+    uint32_t log_index_capacity;   // Power of two
+    uint64_t log_seed;
+    uint64_t version;              // Changes recorded so far
+} PCCheckpointHistory;
+
+PCError pc_checkpoints_init(PCCheckpointHistory* history, uint32_t interval);
+PCError pc_checkpoints_add(PCCheckpointHistory* history, const PCState* state, uint32_t tx_index);
+
+// Keep only the newest keep checkpoints (at least one) and the changes since
+// the oldest of them; queries before its timestamp are no longer answered
+PCError pc_checkpoints_trim(PCCheckpointHistory* history, uint32_t keep);
+
+// Record both sides of a transaction just applied to state
+PCError pc_checkpoints_record_tx(PCCheckpointHistory* history, const PCState* state,
+                                 const PCTransaction* tx);
+
+// Record one wallet's current contents (for changes made outside transactions)
+PCError pc_checkpoints_record_wallet(PCCheckpointHistory* history, const PCState* state,
+                                     const uint8_t* pubkey, uint64_t timestamp);
+
+// Wallet contents / balance at timestamp; a wallet that did not exist yet reads as zero
+PCError pc_query_wallet_at(PCCheckpointHistory* history, const uint8_t* pubkey,
+                           uint64_t timestamp, PCWallet* wallet);
+PCError pc_query_balance_at(PCCheckpointHistory* history, const uint8_t* pubkey,
+                            uint64_t timestamp, PCAmount* balance);
+PCError pc_query_state_hash_at(PCCheckpointHistory* history, uint64_t timestamp, uint8_t* hash_out);
+
+// Samples in [t0, t1] at step, or 0 when the range is empty or too long
+static inline uint32_t pc_query_range_points(uint64_t t0, uint64_t t1, uint64_t step) {
+    if (step == 0 || t1 < t0 || (t1 - t0) / step >= UINT32_MAX) return 0;
+    return (uint32_t)((t1 - t0) / step + 1);
+}
+
+// Balances of num_keys wallets (32-byte keys, packed) at t0, t0 + step, ... <= t1.
+// out receives one row of pc_query_range_points() balances per wallet.
+PCError pc_query_balance_range(const PCCheckpointHistory* history, const uint8_t* pubkeys,
+                               uint32_t num_keys, uint64_t t0, uint64_t t1, uint64_t step,
+                               PCAmount* out);
+
+void pc_checkpoints_print(const PCCheckpointHistory* history);
+void pc_checkpoints_free(PCCheckpointHistory* history);
+size_t pc_checkpoints_storage(const PCCheckpointHistory* history);
+PCError pc_checkpoints_save(const PCCheckpointHistory* history, const char* filename);
+PCError pc_checkpoints_load(PCCheckpointHistory* history, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHYSICSCOIN_TIMETRAVEL_H
@@ -0,0 +1,162 @@
+// wal.h - Durable Write-Ahead Log
+// Segmented log with synchronous, group-commit and io_uring append paths
+
+#ifndef PHYSICSCOIN_WAL_H
+#define PHYSICSCOIN_WAL_H
+
+#include "physicscoin.h"
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Segment header; entries follow it and the zeroed tail marks the end
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t created_at;
+    uint64_t segment_id;
+    uint64_t first_sequence;  // Sequence of the segment's first entry
+    uint8_t state_hash[32];   // Last checkpoint written to this segment
+    uint32_t flags;
+} WALHeader;
+
+// io_uring submission/completion state and background checkpoint (private to wal.c)
+struct PCWALRing;
+struct PCWALCheckpointJob;
+
+// WAL state
+typedef struct {
+    int fd;  // Current segment, -1 when closed
+    char path[256];  // Base path; segments live at path.NNNNNNNN, checkpoints at path.checkpoint[.NNNNNNNN]
+    WALHeader header;  // Header of the current segment
+    uint64_t first_segment;  // Oldest segment not yet retired
+    uint64_t write_offset;  // Next append position in the current segment
+    uint64_t current_sequence;
+    int legacy;  // A v3 single-file log at path precedes the segments
+    int sync_on_write;  // SECURITY: Whether to fsync after each write
+    
+    // Group commit: appenders wait, one flusher fsyncs for all of them
+    pthread_mutex_t lock;       // Guards the segment and every field below
+    pthread_cond_t pending;     // Appender -> flusher: entries are waiting
+    pthread_cond_t durable;     // Flusher -> appenders: synced_sequence moved
+    pthread_t flusher;
+    int group_commit;           // Flusher thread running
+    int stopping;               // Flusher asked to drain and exit
+    int sync_failed;            // Last group fsync failed
+    int syncing;                // Flusher is in fdatasync on fd
+    uint64_t synced_sequence;   // Entries with sequence < this are on disk
+    uint64_t oldest_pending_us; // Arrival time of the oldest unsynced entry
+    uint32_t max_delay_us;      // Longest the flusher holds a group open
+    uint32_t max_group;         // Flush as soon as this many entries wait
+    
+    struct PCWALRing* ring;     // Async writer, NULL when not enabled
+    struct PCWALCheckpointJob* checkpoint_job; // Background checkpoint, NULL when idle
+    
+    // Checkpoints: a base snapshot plus increments holding only dirty pages
+    uint64_t checkpoint_id;     // Newest checkpoint on disk (base or increment)
+    uint64_t base_id;           // Newest checkpoint folded into the base
+    uint64_t covered_sequence;  // Entries below this are in a durable checkpoint
+    pthread_mutex_t checkpoint_lock; // Serializes base rewrites
+    pthread_cond_t compact;     // Checkpoint -> compactor: increments piled up
+    pthread_t compactor;
+    int compacting;             // Compactor thread running
+    int compact_stop;           // Compactor asked to exit
+    uint32_t compact_after;     // Fold once this many increments sit on the base
+} PCWAL;
+
+// Runs once an async append is durable (err == PC_OK) or has failed
+typedef void (*PCWALDoneFn)(void* ctx, PCError err);
+
+// Open or create the log; filename is the base name of the segment and
+// checkpoint files
+PCError pc_wal_init(PCWAL* wal, const char* filename);
+
+// Sync, stop background work and close the current segment
+void pc_wal_close(PCWAL* wal);
+
+// Log a transaction; returns once it is durable when sync_on_write is set
+PCError pc_wal_log_tx(PCWAL* wal, const PCTransaction* tx);
+
+// Log genesis creation (durable like pc_wal_log_tx)
+PCError pc_wal_log_genesis(PCWAL* wal, const uint8_t* creator_pubkey, PCAmount supply);
+
+// Write the pages changed since state's last checkpoint as an increment (a
+// full base when state is not on top of the newest checkpoint) and log a
+// checkpoint entry. Clears the state's dirty pages.
+PCError pc_wal_checkpoint(PCWAL* wal, PCState* state);
+
+// Checkpoint without stalling the caller: freezes a view of state (O(pages),
+// see pc_state_freeze), then writes, fsyncs and logs it on a helper thread
+// while the caller keeps executing. done runs from pc_wal_poll on the
+// caller's thread once the checkpoint is durable or has failed; until then
+// state must stay alive. One at a time (PC_ERR_INVALID_STATE while busy);
+// pc_wal_checkpoint waits for a pending one.
+PCError pc_wal_checkpoint_async(PCWAL* wal, PCState* state, PCWALDoneFn done, void* ctx);
+
+// Wait for a background checkpoint and run its callback (no-op when idle)
+void pc_wal_checkpoint_finish(PCWAL* wal);
+
+// Append an explicit durability point
+PCError pc_wal_sync_marker(PCWAL* wal);
+
+// Load the base and its increments, then replay every live segment into state
+PCError pc_wal_recover(PCWAL* wal, PCState* state);
+
+// Rotate to a fresh segment and retire all older ones
+PCError pc_wal_truncate(PCWAL* wal);
+
+// Retire only sealed segments the newest checkpoint fully covers; safe with
+// async entries in flight
+PCError pc_wal_retire(PCWAL* wal);
+
+// fsync after every append (1, default) or leave it to the OS (0)
+void pc_wal_set_sync_mode(PCWAL* wal, int sync_on_write);
+
+// Batch concurrent sync appends into one fsync per group. max_delay_us bounds
+// how long a group stays open (0 = flush as soon as the flusher is free);
+// max_group entries (0 = default) flush a group at once.
+PCError pc_wal_enable_group_commit(PCWAL* wal, uint32_t max_delay_us, uint32_t max_group);
+
+// Drain pending groups and stop the flusher
+void pc_wal_disable_group_commit(PCWAL* wal);
+
+// Submit async appends through io_uring as a write linked to an fdatasync,
+// keeping up to depth entries in flight. Returns PC_ERR_IO when the kernel
+// has no io_uring (pc_wal_log_tx_async then falls back to the sync path) and
+// PC_ERR_INVALID_STATE while group commit is on. Async appends are meant to
+// be driven from a single event-loop thread.
+PCError pc_wal_enable_async(PCWAL* wal, uint32_t depth);
+
+// Descriptor that polls readable when async completions are ready (-1 if none)
+int pc_wal_async_fd(const PCWAL* wal);
+
+// Log a transaction without waiting for the disk. done runs from
+// pc_wal_poll once the entry (and every entry before it) is durable; on the
+// sync fallback it runs before this returns. Callbacks run in log order, so
+// callers apply the transaction there: a checkpoint covers an async entry
+// only once its callback has run, and recovery replays the rest.
+PCError pc_wal_log_tx_async(PCWAL* wal, const PCTransaction* tx, PCWALDoneFn done, void* ctx);
+
+// Reap finished async writes and run their callbacks in log order, then
+// finish a completed background checkpoint; never blocks. Returns the number
+// of callbacks run.
+uint32_t pc_wal_poll(PCWAL* wal);
+
+// Fold increments into the base on a background thread once compact_after
+// (0 = default) of them sit on top of it, and at least once a minute.
+// Without a compactor, checkpoints rewrite the base at that point instead.
+PCError pc_wal_enable_compaction(PCWAL* wal, uint32_t compact_after);
+
+// Stop the compactor (increments stay until the next fold)
+void pc_wal_disable_compaction(PCWAL* wal);
+
+// Print WAL info
+void pc_wal_print(const PCWAL* wal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHYSICSCOIN_WAL_H
@@ -5,6 +5,8 @@
 #include "../include/physicscoin.h"
 #include "../include/network_config.h"
 #include "../include/faucet.h"
+#include "../include/wal.h"
+#include "../include/history.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <poll.h>
 #include <time.h>
 
 // Explorer API endpoint declarations
@@ -26,9 +29,17 @@ extern void handle_explorer_state_hash(int client, PCState* state);
 extern void handle_explorer_supply(int client, PCState* state);
 extern void handle_explorer_conservation_check(int client, PCState* state);
 extern void handle_explorer_wallets_top(int client, PCState* state, const char* count_str);
+extern void handle_explorer_balance_history(int client, PCCheckpointHistory* history, PCHistoryFile* file,
+                                            const char* json);
 
 #define API_PORT 8545
 #define MAX_REQUEST_SIZE 8192
+#define API_WAL_FILENAME "api.wal"
+#define API_WAL_DEPTH 64  // Transactions awaiting durability
+#define API_WAL_CHECKPOINT_TXS 1000  // Transactions between checkpoints that truncate api.wal
+#define API_CHECKPOINT_INTERVAL 1000  // Transactions between history checkpoints
+#define API_HISTORY_FILENAME "history.pch"  // Checkpoints kept on disk for later queries
+#define API_HISTORY_RESIDENT 64  // Checkpoints kept in memory; older ranges read history.pch
 
 // Rate limiting
 #define MAX_REQUESTS_PER_MINUTE 60
@@ -49,11 +60,30 @@ static int rate_limit_count = 0;
 static struct {
     char from[65];
     char to[65];
-    double amount;
+    PCAmount amount;
     uint64_t timestamp;
 } tx_history[MAX_TX_HISTORY];
 static int tx_history_count = 0;
 
+// Transaction log; /transaction/send answers once its entry is durable
+static PCWAL api_wal;
+
+static uint32_t api_wal_txs = 0;  // Applied since api.wal was last truncated
+
+// Balance history behind /explorer/history: recent checkpoints and changes
+// in memory, every checkpoint in the history file
+static PCCheckpointHistory api_history;
+static PCHistoryFile api_history_file;
+static uint32_t api_history_txs = 0;
+static uint32_t api_history_unsaved = 0;  // Newest checkpoints not yet in the file
+
+// Client waiting for its transaction's WAL entry
+typedef struct {
+    int client;
+    PCState* state;
+    PCTransaction tx;
+} ApiTxAck;
+
 // Check rate limit for an IP
 static int check_rate_limit(uint32_t ip_addr) {
     time_t now = time(NULL);
@@ -89,7 +119,7 @@ static int check_rate_limit(uint32_t ip_addr) {
     return 1;  // Allowed
 }
 
-static void record_transaction(const char* from, const char* to, double amount) {
+static void record_transaction(const char* from, const char* to, PCAmount amount) {
     if (tx_history_count >= MAX_TX_HISTORY) {
         // Shift old transactions out
         memmove(&tx_history[0], &tx_history[1], sizeof(tx_history[0]) * (MAX_TX_HISTORY - 1));
@@ -106,14 +136,23 @@ static void record_transaction(const char* from, const char* to, double amount)
 
 // API response helpers (non-static for use by explorer_api.c)
 void send_json_response(int client, int status, const char* body) {
-    char response[8192];
-    snprintf(response, sizeof(response),
-             "HTTP/1.1 %d OK\r\n"
-             "Content-Type: application/json\r\n"
-             "Access-Control-Allow-Origin: *\r\n"
-             "Content-Length: %zu\r\n\r\n%s",
-             status, strlen(body), body);
-    send(client, response, strlen(response), 0);
+    char header[256];
+    size_t length = strlen(body);
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %d OK\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Access-Control-Allow-Origin: *\r\n"
+                     "Content-Length: %zu\r\n\r\n",
+                     status, length);
+    send(client, header, (size_t)n, MSG_MORE);
+    
+    // Large bodies (history series) may take several sends
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t w = send(client, body + sent, length - sent, 0);
+        if (w <= 0) break;
+        sent += (size_t)w;
+    }
 }
 
 void send_error(int client, int code, const char* message) {
@@ -127,7 +166,7 @@ static void handle_status(int client, PCState* state) {
     char body[512];
     snprintf(body, sizeof(body),
              "{\"version\":\"%s\",\"wallets\":%u,\"total_supply\":%.8f,\"timestamp\":%lu,\"tx_count\":%d,\"peers\":1,\"secure\":true}",
-             PHYSICSCOIN_VERSION, state->num_wallets, state->total_supply, state->timestamp, tx_history_count);
+             PHYSICSCOIN_VERSION, state->num_wallets, pc_amount_to_coins(state->total_supply), state->timestamp, tx_history_count);
     send_json_response(client, 200, body);
 }
 
@@ -139,7 +178,7 @@ static void handle_balance(int client, PCState* state, const char* address) {
         return;
     }
     
-    PCWallet* wallet = pc_state_get_wallet(state, pubkey);
+    const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
     if (!wallet) {
         // Return 0 balance for non-existent wallets (not an error)
         char body[256];
@@ -151,7 +190,7 @@ static void handle_balance(int client, PCState* state, const char* address) {
     
     char body[256];
     snprintf(body, sizeof(body), "{\"address\":\"%s\",\"balance\":%.8f,\"nonce\":%lu,\"exists\":true}",
-             address, wallet->energy, wallet->nonce);
+             address, pc_amount_to_coins(wallet->energy), wallet->nonce);
     send_json_response(client, 200, body);
 }
 
@@ -161,10 +200,11 @@ static void handle_wallets(int client, PCState* state) {
     char* p = body + strlen(body);
     
     for (uint32_t i = 0; i < state->num_wallets && i < 100; i++) {
+        const PCWallet* w = pc_state_wallet_at(state, i);
         char addr[65];
-        pc_pubkey_to_hex(state->wallets[i].public_key, addr);
+        pc_pubkey_to_hex(pc_state_key_at(state, i), addr);
         p += sprintf(p, "%s{\"address\":\"%.16s...\",\"balance\":%.8f}",
-                     i > 0 ? "," : "", addr, state->wallets[i].energy);
+                     i > 0 ? "," : "", addr, pc_amount_to_coins(w->energy));
     }
     strcat(body, "]}");
     send_json_response(client, 200, body);
@@ -199,7 +239,7 @@ static double get_json_number(const char* json, const char* field) {
     return start ? atof(start + strlen(search)) : 0.0;
 }
 
-static uint64_t get_json_uint64(const char* json, const char* field) {
+uint64_t get_json_uint64(const char* json, const char* field) {
     char search[128];
     snprintf(search, sizeof(search), "\"%s\":", field);
     char* start = strstr(json, search);
@@ -224,15 +264,11 @@ static void handle_wallet_create(int client, PCState* state) {
     
     // SECURITY FIX: Register wallet with ZERO balance (no faucet)
     // Wallet will need to receive funds from existing wallets
-    PCWallet* existing = pc_state_get_wallet(state, kp.public_key);
+    const PCWallet* existing = pc_state_find_wallet(state, kp.public_key);
     if (!existing) {
-        // Add new wallet to state with ZERO balance
-        if (state->num_wallets < state->wallets_capacity) {
-            PCWallet* new_wallet = &state->wallets[state->num_wallets++];
-            memcpy(new_wallet->public_key, kp.public_key, 32);
-            new_wallet->energy = 0.0;  // SECURITY: No free coins!
-            new_wallet->nonce = 0;
-            // DO NOT modify total_supply - conservation law preserved
+        // Add new wallet to state with ZERO balance (SECURITY: No free coins!)
+        // A zero initial balance leaves total_supply untouched - conservation preserved
+        if (pc_state_create_wallet(state, kp.public_key, 0) == PC_OK) {
             pc_state_compute_hash(state);
         }
     }
@@ -244,31 +280,84 @@ static void handle_wallet_create(int client, PCState* state) {
     send_json_response(client, 200, body);
 }
 
+// WAL completion: the transaction is durable, so apply it in log order -
+// exactly what recovery will do - then answer and close the client
+static void api_tx_durable(void* ctx, PCError err) {
+    ApiTxAck* ack = ctx;
+    PCState* state = ack->state;
+    
+    // Signature was checked before logging
+    if (err != PC_OK) {
+        send_error(ack->client, -32000, "Transaction not logged");
+    } else if ((err = pc_state_apply_tx(state, &ack->tx)) != PC_OK) {
+        char error_msg[128];
+        snprintf(error_msg, sizeof(error_msg), "Transaction failed: %s", pc_strerror(err));
+        send_error(ack->client, -32000, error_msg);
+    } else {
+        // Record the transaction
+        char from[65], to[65];
+        pc_pubkey_to_hex(ack->tx.from, from);
+        pc_pubkey_to_hex(ack->tx.to, to);
+        record_transaction(from, to, ack->tx.amount);
+        pc_checkpoints_record_tx(&api_history, state, &ack->tx);
+        if (++api_history_txs % API_CHECKPOINT_INTERVAL == 0 &&
+            pc_checkpoints_add(&api_history, state, api_history_txs) == PC_OK) {
+            api_history_unsaved++;
+        }
+        api_wal_txs++;
+        
+        char body[256];
+        snprintf(body, sizeof(body), "{\"success\":true,\"amount\":%.8f,\"tx_hash\":\"pending\"}",
+                 pc_amount_to_coins(ack->tx.amount));
+        send_json_response(ack->client, 200, body);
+    }
+    close(ack->client);
+    free(ack);
+}
+
+// Run WAL completions, then write the checkpoints they added to the history
+// file (their clients are already answered) and trim the resident history
+static void api_poll(void) {
+    pc_wal_poll(&api_wal);
+    if (api_history_unsaved == 0) return;
+    
+    uint32_t n = api_history.num_checkpoints;
+    for (uint32_t i = n - api_history_unsaved; i < n; i++) {
+        const PCStateCheckpoint* cp = &api_history.checkpoints[i];
+        if (pc_history_add(&api_history_file, &cp->state, cp->transaction_index) != PC_OK) {
+            printf("Warning: history checkpoint at TX %u not written\n", cp->transaction_index);
+        }
+    }
+    api_history_unsaved = 0;
+    pc_checkpoints_trim(&api_history, API_HISTORY_RESIDENT);
+}
+
 // POST /transaction/send - Send SIGNED transaction
 // SECURITY: Requires cryptographic signature from sender
-static void handle_transaction_send(int client, PCState* state, const char* json) {
+// Returns 1 when the response is sent (and the client closed) by api_tx_durable
+static int handle_transaction_send(int client, PCState* state, const char* json) {
     const char* from = get_json_field(json, "from");
     const char* to = get_json_field(json, "to");
     const char* signature_hex = get_json_field(json, "signature");
-    double amount = get_json_number(json, "amount");
+    PCAmount amount = pc_amount_from_coins(get_json_number(json, "amount"));
     uint64_t nonce = get_json_uint64(json, "nonce");
     uint64_t timestamp = get_json_uint64(json, "timestamp");
     
     // SECURITY: Require all fields including signature
     if (!from || !to || amount <= 0) {
         send_error(client, -32602, "Missing required fields: from, to, amount");
-        return;
+        return 0;
     }
     
     if (!signature_hex || strlen(signature_hex) != 128) {
         send_error(client, -32602, "Missing or invalid signature (must be 128 hex chars)");
-        return;
+        return 0;
     }
     
     uint8_t from_key[32], to_key[32];
     if (pc_hex_to_pubkey(from, from_key) != PC_OK || pc_hex_to_pubkey(to, to_key) != PC_OK) {
         send_error(client, -32602, "Invalid address format");
-        return;
+        return 0;
     }
     
     // Parse signature from hex
@@ -277,7 +366,7 @@ static void handle_transaction_send(int client, PCState* state, const char* json
         unsigned int byte;
         if (sscanf(signature_hex + (i * 2), "%02x", &byte) != 1) {
             send_error(client, -32602, "Invalid signature hex encoding");
-            return;
+            return 0;
         }
         signature[i] = (uint8_t)byte;
     }
@@ -292,25 +381,29 @@ static void handle_transaction_send(int client, PCState* state, const char* json
     tx.timestamp = timestamp ? timestamp : (uint64_t)time(NULL);
     memcpy(tx.signature, signature, 64);
     
-    // SECURITY: Execute transaction with signature verification
-    // pc_state_execute_tx will verify the signature internally
-    PCError err = pc_state_execute_tx(state, &tx);
+    // SECURITY: Verify the signature before the transaction reaches the log
+    PCError err = pc_transaction_verify(&tx);
+    const PCWallet* sender = err == PC_OK ? pc_state_find_wallet(state, tx.from) : NULL;
+    if (err == PC_OK && !sender) err = PC_ERR_WALLET_NOT_FOUND;
+    if (err == PC_OK && tx.nonce < sender->nonce) err = PC_ERR_INVALID_SIGNATURE;  // Replayed
     if (err != PC_OK) {
         char error_msg[128];
         snprintf(error_msg, sizeof(error_msg), "Transaction failed: %s", pc_strerror(err));
         send_error(client, -32000, error_msg);
-        return;
+        return 0;
     }
     
-    // Record the transaction
-    record_transaction(from, to, amount);
-    
-    // Save state after successful transaction
-    pc_state_save(state, "state.pcs");
-    
-    char body[256];
-    snprintf(body, sizeof(body), "{\"success\":true,\"amount\":%.8f,\"tx_hash\":\"pending\"}", amount);
-    send_json_response(client, 200, body);
+    // Log first; api_tx_durable applies and responds once the entry is durable
+    ApiTxAck* ack = malloc(sizeof(ApiTxAck));
+    if (!ack) {
+        send_error(client, -32000, "Out of memory");
+        return 0;
+    }
+    ack->client = client;
+    ack->state = state;
+    ack->tx = tx;
+    pc_wal_log_tx_async(&api_wal, &tx, api_tx_durable, ack);
+    return 1;
 }
 
 // POST /stream/open - Open payment stream (requires signature)
@@ -356,8 +449,8 @@ static void handle_proof_generate(int client, PCState* state, const char* json)
         return;
     }
     
-    PCWallet* wallet = pc_state_get_wallet(state, pubkey);
-    double balance = wallet ? wallet->energy : 0.0;
+    const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
+    double balance = wallet ? pc_amount_to_coins(wallet->energy) : 0.0;
     uint64_t nonce = wallet ? wallet->nonce : 0;
     
     // Generate proof hash
@@ -387,7 +480,7 @@ static void handle_transactions(int client) {
         int written = sprintf(p, "%s{\"from\":\"%.16s...\",\"to\":\"%.16s...\",\"amount\":%.8f,\"timestamp\":%lu}",
                      i < tx_history_count - 1 ? "," : "",
                      tx_history[i].from, tx_history[i].to,
-                     tx_history[i].amount, tx_history[i].timestamp);
+                     pc_amount_to_coins(tx_history[i].amount), tx_history[i].timestamp);
         p += written;
         remaining -= written;
     }
@@ -398,16 +491,14 @@ static void handle_transactions(int client) {
 // GET /conservation - Verify conservation law
 static void handle_conservation(int client, PCState* state) {
     PCError err = pc_state_verify_conservation(state);
-    double sum = 0.0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        sum += state->wallets[i].energy;
-    }
-    double error = state->total_supply - sum;
+    uint64_t sum = pc_scan_sum(state);
+    PCAmount error = (PCAmount)((uint64_t)state->total_supply - sum);
     
     char body[256];
     snprintf(body, sizeof(body),
-             "{\"verified\":%s,\"total_supply\":%.8f,\"wallet_sum\":%.8f,\"error\":%.12e}",
-             err == PC_OK ? "true" : "false", state->total_supply, sum, error);
+             "{\"verified\":%s,\"total_supply\":%.8f,\"wallet_sum\":%.8f,\"error\":%.8f}",
+             err == PC_OK ? "true" : "false", pc_amount_to_coins(state->total_supply),
+             pc_amount_to_coins((PCAmount)sum), pc_amount_to_coins(error));
     send_json_response(client, 200, body);
 }
 
@@ -444,16 +535,21 @@ static void handle_faucet_request(int client, PCState* state, const char* json_b
     }
     
     // Request faucet funds
-    double amount = 0.0;
+    PCAmount amount = 0;
     PCError err = pc_faucet_request(state, address, &amount);
     
     if (err == PC_OK) {
+        pc_checkpoints_record_wallet(&api_history, state, address, (uint64_t)time(NULL));
+        
+        // Grants are not log entries; a checkpoint makes them durable
+        pc_wal_checkpoint(&api_wal, state);
+        
         char body[512];
         char addr_hex[65];
         pc_pubkey_to_hex(address, addr_hex);
         snprintf(body, sizeof(body),
                  "{\"success\":true,\"address\":\"%s\",\"amount\":%.8f,\"message\":\"Faucet funds sent successfully\"}",
-                 addr_hex, amount);
+                 addr_hex, pc_amount_to_coins(amount));
         send_json_response(client, 200, body);
     } else {
         send_error(client, -32000, pc_strerror(err));
@@ -515,7 +611,41 @@ int pc_api_serve(PCState* state, int port) {
     }
     printf("\n");
     
+    // Replay acknowledged transactions over the starting state; a fresh log
+    // gets a base checkpoint so later replays have something to start from
+    if (pc_wal_init(&api_wal, API_WAL_FILENAME) != PC_OK ||
+        pc_wal_recover(&api_wal, state) != PC_OK ||
+        (state->checkpoint_id == 0 && pc_wal_checkpoint(&api_wal, state) != PC_OK)) {
+        fprintf(stderr, "Failed to recover transaction log\n");
+        if (api_wal.fd >= 0) pc_wal_close(&api_wal);
+        close(server_fd);
+        return -1;
+    }
+    if (pc_wal_enable_async(&api_wal, API_WAL_DEPTH) != PC_OK) {
+        printf("io_uring unavailable, logging transactions synchronously\n");
+    }
+    // The file covers earlier runs; it gets the starting state too, so a
+    // restart leaves no gap before the resident history begins
+    if (pc_checkpoints_init(&api_history, API_CHECKPOINT_INTERVAL) != PC_OK ||
+        pc_checkpoints_add(&api_history, state, 0) != PC_OK ||
+        pc_history_open_append(&api_history_file, API_HISTORY_FILENAME) != PC_OK ||
+        pc_history_add(&api_history_file, state, 0) != PC_OK) {
+        fprintf(stderr, "Failed to start balance history\n");
+        pc_wal_close(&api_wal);
+        close(server_fd);
+        return -1;
+    }
+    
     while (1) {
+        // Wait for a client or for WAL completions to answer
+        struct pollfd fds[2] = {
+            { server_fd, POLLIN, 0 },
+            { pc_wal_async_fd(&api_wal), POLLIN, 0 }
+        };
+        poll(fds, fds[1].fd >= 0 ? 2 : 1, -1);
+        api_poll();
+        if (!(fds[0].revents & POLLIN)) continue;
+        
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
         int client = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
@@ -549,6 +679,7 @@ int pc_api_serve(PCState* state, int port) {
             continue;
         }
         
+        int deferred = 0;  // Response still waiting on the WAL
         if (strcmp(method, "GET") == 0) {
             if (strcmp(path, "/status") == 0) handle_status(client, state);
             else if (strcmp(path, "/wallets") == 0) handle_wallets(client, state);
@@ -575,16 +706,27 @@ int pc_api_serve(PCState* state, int port) {
             if (!json_body) json_body = "{}";
             
             if (strcmp(path, "/wallet/create") == 0) handle_wallet_create(client, state);
-            else if (strcmp(path, "/transaction/send") == 0) handle_transaction_send(client, state, json_body);
+            else if (strcmp(path, "/transaction/send") == 0) deferred = handle_transaction_send(client, state, json_body);
             else if (strcmp(path, "/stream/open") == 0) handle_stream_open(client, json_body);
             else if (strcmp(path, "/proof/generate") == 0) handle_proof_generate(client, state, json_body);
+            else if (strcmp(path, "/explorer/history") == 0) handle_explorer_balance_history(client, &api_history, &api_history_file, json_body);
             else if (strcmp(path, "/faucet/request") == 0) handle_faucet_request(client, state, json_body);
             else send_error(client, -32601, "Not found");
         }
         else {
             send_error(client, -32600, "Method not allowed");
         }
-        close(client);
+        if (!deferred) close(client);
+        api_poll();
+        
+        // Bound api.wal: drain in-flight entries, checkpoint, drop the old segments
+        if (api_wal_txs >= API_WAL_CHECKPOINT_TXS) {
+            pc_wal_sync_marker(&api_wal);
+            api_poll();
+            if (pc_wal_checkpoint(&api_wal, state) == PC_OK && pc_wal_truncate(&api_wal) == PC_OK) {
+                api_wal_txs = 0;
+            }
+        }
     }
     return 0;
 }
@@ -2,17 +2,66 @@
 // Query blockchain state, wallets, transactions, consensus
 
 #include "../include/physicscoin.h"
+#include "../include/timetravel.h"
+#include "../include/history.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
 
 // External functions from API
 extern void send_json_response(int client, int status, const char* body);
 extern void send_error(int client, int code, const char* message);
 extern char* get_json_field(const char* json, const char* field);
 extern double get_json_number(const char* json, const char* field);
+extern uint64_t get_json_uint64(const char* json, const char* field);
+
+#define HISTORY_MAX_WALLETS 16
+#define HISTORY_MAX_VALUES 16384         // Wallets x points per response
+#define HISTORY_DEFAULT_STEP 3600        // Hourly
+#define HISTORY_DEFAULT_SPAN (30 * 86400)  // 30 days
+
+// Wallet index with its balance, for ranking
+typedef struct {
+    uint32_t index;
+    PCAmount balance;
+} WalletSort;
+
+static int compare_balance_desc(const void* a, const void* b) {
+    const WalletSort* x = a;
+    const WalletSort* y = b;
+    if (x->balance != y->balance) return x->balance < y->balance ? 1 : -1;
+    return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+// Richest wallets, largest first: only balances at or above the k-th largest
+// are collected and sorted. Returns the number collected (>= k unless fewer
+// wallets exist), or 0 with *out NULL on allocation failure.
+static uint32_t collect_top(const PCState* state, uint32_t k, WalletSort** out) {
+    PCAmount threshold = pc_scan_topk_threshold(state, k);
+    
+    uint32_t cap = k, n = 0;
+    WalletSort* top = malloc((size_t)(cap ? cap : 1) * sizeof(WalletSort));
+    for (uint32_t i = 0; top && i < state->num_wallets; i++) {
+        PCAmount balance = pc_state_wallet_at(state, i)->energy;
+        if (k == 0 || balance < threshold) continue;
+        if (n == cap) {
+            // Ties at the threshold can exceed k
+            cap *= 2;
+            WalletSort* grown = realloc(top, (size_t)cap * sizeof(WalletSort));
+            if (!grown) { free(top); top = NULL; break; }
+            top = grown;
+        }
+        top[n].index = i;
+        top[n].balance = balance;
+        n++;
+    }
+    
+    *out = top;
+    if (!top) return 0;
+    qsort(top, n, sizeof(WalletSort), compare_balance_desc);
+    return n;
+}
 
 // GET /explorer/stats - Network statistics
 void handle_explorer_stats(int client, PCState* state) {
@@ -23,16 +72,13 @@ void handle_explorer_stats(int client, PCState* state) {
     uint32_t validators = poa_active_validator_count();
     
     // Calculate richest wallet
-    double max_balance = 0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (state->wallets[i].energy > max_balance) {
-            max_balance = state->wallets[i].energy;
-        }
-    }
+    PCScanStats stats;
+    pc_scan_stats(state, &stats);
+    PCAmount max_balance = stats.max > 0 ? stats.max : 0;
     
     // Calculate average balance
     double avg_balance = state->num_wallets > 0 ? 
-                         state->total_supply / state->num_wallets : 0.0;
+                         pc_amount_to_coins(state->total_supply) / state->num_wallets : 0.0;
     
     char body[1024];
     snprintf(body, sizeof(body),
@@ -47,10 +93,10 @@ void handle_explorer_stats(int client, PCState* state) {
              "\"timestamp\":%lu"
              "}",
              block_height,
-             state->total_supply,
+             pc_amount_to_coins(state->total_supply),
              state->num_wallets,
              avg_balance,
-             max_balance,
+             pc_amount_to_coins(max_balance),
              validators,
              state->version,
              state->timestamp);
@@ -66,7 +112,7 @@ void handle_explorer_wallet(int client, PCState* state, const char* address) {
         return;
     }
     
-    PCWallet* wallet = pc_state_get_wallet(state, pubkey);
+    const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
     if (!wallet) {
         send_error(client, -32602, "Wallet not found");
         return;
@@ -75,13 +121,13 @@ void handle_explorer_wallet(int client, PCState* state, const char* address) {
     // Calculate wallet rank by balance
     uint32_t rank = 1;
     for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (state->wallets[i].energy > wallet->energy) {
+        if (pc_state_wallet_at(state, i)->energy > wallet->energy) {
             rank++;
         }
     }
     
     // Calculate percentage of total supply
-    double percent = (wallet->energy / state->total_supply) * 100.0;
+    double percent = ((double)wallet->energy / (double)state->total_supply) * 100.0;
     
     char body[1024];
     snprintf(body, sizeof(body),
@@ -94,7 +140,7 @@ void handle_explorer_wallet(int client, PCState* state, const char* address) {
              "\"exists\":true"
              "}",
              address,
-             wallet->energy,
+             pc_amount_to_coins(wallet->energy),
              wallet->nonce,
              rank,
              percent);
@@ -104,53 +150,34 @@ void handle_explorer_wallet(int client, PCState* state, const char* address) {
 
 // GET /explorer/rich - Top wallets by balance
 void handle_explorer_rich_list(int client, PCState* state) {
-    // Create sorted list of wallets
-    typedef struct {
-        uint32_t index;
-        double balance;
-    } WalletSort;
+    uint32_t limit = state->num_wallets < 20 ? state->num_wallets : 20;
     
-    WalletSort* sorted = malloc(state->num_wallets * sizeof(WalletSort));
+    // Sorted top wallets
+    WalletSort* sorted = NULL;
+    collect_top(state, limit, &sorted);
     if (!sorted) {
         send_error(client, -32000, "Memory allocation failed");
         return;
     }
     
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        sorted[i].index = i;
-        sorted[i].balance = state->wallets[i].energy;
-    }
-    
-    // Bubble sort (good enough for small lists)
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        for (uint32_t j = i + 1; j < state->num_wallets; j++) {
-            if (sorted[j].balance > sorted[i].balance) {
-                WalletSort temp = sorted[i];
-                sorted[i] = sorted[j];
-                sorted[j] = temp;
-            }
-        }
-    }
-    
     // Build JSON response (top 20)
     char body[8192] = "{\"rich_list\":[";
     char* p = body + strlen(body);
     size_t remaining = sizeof(body) - strlen(body) - 10;
     
-    uint32_t limit = state->num_wallets < 20 ? state->num_wallets : 20;
     for (uint32_t i = 0; i < limit && remaining > 200; i++) {
-        PCWallet* w = &state->wallets[sorted[i].index];
+        const PCWallet* w = pc_state_wallet_at(state, sorted[i].index);
         char addr[65];
-        pc_pubkey_to_hex(w->public_key, addr);
+        pc_pubkey_to_hex(pc_state_key_at(state, sorted[i].index), addr);
         
-        double percent = (w->energy / state->total_supply) * 100.0;
+        double percent = ((double)w->energy / (double)state->total_supply) * 100.0;
         
         int written = snprintf(p, remaining,
                               "%s{\"rank\":%u,\"address\":\"%.16s...\",\"balance\":%.8f,\"percent\":%.4f}",
                               i > 0 ? "," : "",
                               i + 1,
                               addr,
-                              w->energy,
+                              pc_amount_to_coins(w->energy),
                               percent);
         p += written;
         remaining -= written;
@@ -164,20 +191,15 @@ void handle_explorer_rich_list(int client, PCState* state) {
 
 // GET /explorer/distribution - Balance distribution statistics
 void handle_explorer_distribution(int client, PCState* state) {
-    uint32_t tiny = 0;     // < 1
-    uint32_t small = 0;    // 1-100
-    uint32_t medium = 0;   // 100-1000
-    uint32_t large = 0;    // 1000-10000
-    uint32_t whale = 0;    // > 10000
-    
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        double bal = state->wallets[i].energy;
-        if (bal < 1.0) tiny++;
-        else if (bal < 100.0) small++;
-        else if (bal < 1000.0) medium++;
-        else if (bal < 10000.0) large++;
-        else whale++;
-    }
+    // tiny < 1, small 1-100, medium 100-1000, large 1000-10000, whale > 10000
+    const PCAmount bounds[4] = {
+        1 * PC_AMOUNT_SCALE, 100 * PC_AMOUNT_SCALE,
+        1000 * PC_AMOUNT_SCALE, 10000 * PC_AMOUNT_SCALE
+    };
+    uint32_t buckets[5];
+    pc_scan_histogram(state, bounds, 4, buckets);
+    uint32_t tiny = buckets[0], small = buckets[1], medium = buckets[2];
+    uint32_t large = buckets[3], whale = buckets[4];
     
     char body[512];
     snprintf(body, sizeof(body),
@@ -200,7 +222,7 @@ void handle_explorer_search(int client, PCState* state, const char* query) {
     // Try as address
     uint8_t pubkey[32];
     if (pc_hex_to_pubkey(query, pubkey) == PC_OK) {
-        PCWallet* wallet = pc_state_get_wallet(state, pubkey);
+        const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
         if (wallet) {
             char body[512];
             snprintf(body, sizeof(body),
@@ -211,7 +233,7 @@ void handle_explorer_search(int client, PCState* state, const char* query) {
                      "\"nonce\":%lu"
                      "}",
                      query,
-                     wallet->energy,
+                     pc_amount_to_coins(wallet->energy),
                      wallet->nonce);
             send_json_response(client, 200, body);
             return;
@@ -249,20 +271,17 @@ void handle_explorer_consensus(int client) {
 void handle_explorer_health(int client, PCState* state) {
     PCError cons = pc_state_verify_conservation(state);
     
-    double sum = 0.0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        sum += state->wallets[i].energy;
-    }
+    uint64_t sum = pc_scan_sum(state);
     
-    double error = fabs(state->total_supply - sum);
-    int healthy = (cons == PC_OK && error < 1e-9);
+    PCAmount error = llabs((PCAmount)((uint64_t)state->total_supply - sum));
+    int healthy = (cons == PC_OK && error == 0);
     
     char body[512];
     snprintf(body, sizeof(body),
              "{"
              "\"status\":\"%s\","
              "\"conservation_verified\":%s,"
-             "\"conservation_error\":%.12e,"
+             "\"conservation_error\":%.8f,"
              "\"total_supply\":%.8f,"
              "\"wallet_sum\":%.8f,"
              "\"wallets\":%u,"
@@ -270,9 +289,9 @@ void handle_explorer_health(int client, PCState* state) {
              "}",
              healthy ? "healthy" : "unhealthy",
              cons == PC_OK ? "true" : "false",
-             error,
-             state->total_supply,
-             sum,
+             pc_amount_to_coins(error),
+             pc_amount_to_coins(state->total_supply),
+             pc_amount_to_coins((PCAmount)sum),
              state->num_wallets,
              state->version);
     
@@ -309,17 +328,12 @@ void handle_explorer_state_hash(int client, PCState* state) {
 
 // GET /explorer/supply - Supply analytics
 void handle_explorer_supply(int client, PCState* state) {
-    double circulating = 0.0;
-    uint32_t active_wallets = 0;
+    PCScanStats stats;
+    pc_scan_stats(state, &stats);
+    PCAmount circulating = (PCAmount)stats.positive_sum;
+    uint32_t active_wallets = stats.positive;
     
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (state->wallets[i].energy > 0) {
-            circulating += state->wallets[i].energy;
-            active_wallets++;
-        }
-    }
-    
-    double velocity = active_wallets > 0 ? circulating / active_wallets : 0.0;
+    double velocity = active_wallets > 0 ? pc_amount_to_coins(circulating) / active_wallets : 0.0;
     
     char body[512];
     snprintf(body, sizeof(body),
@@ -330,8 +344,8 @@ void handle_explorer_supply(int client, PCState* state) {
              "\"inactive_wallets\":%u,"
              "\"velocity\":%.8f"
              "}",
-             state->total_supply,
-             circulating,
+             pc_amount_to_coins(state->total_supply),
+             pc_amount_to_coins(circulating),
              active_wallets,
              state->num_wallets - active_wallets,
              velocity);
@@ -341,28 +355,25 @@ void handle_explorer_supply(int client, PCState* state) {
 
 // GET /explorer/conservation_check - Verify energy conservation law
 void handle_explorer_conservation_check(int client, PCState* state) {
-    double sum = 0.0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        sum += state->wallets[i].energy;
-    }
+    uint64_t sum = pc_scan_sum(state);
     
-    double error = fabs(state->total_supply - sum);
-    int is_valid = (error < 1e-9); // Within floating point precision
+    PCAmount error = llabs((PCAmount)((uint64_t)state->total_supply - sum));
+    int is_valid = (error == 0); // Integer amounts balance exactly
     
     char body[512];
     snprintf(body, sizeof(body),
              "{"
              "\"status\":\"%s\","
              "\"message\":\"%s\","
-             "\"error\":%.12e,"
+             "\"error\":%.8f,"
              "\"total_supply\":%.8f,"
              "\"wallet_sum\":%.8f"
              "}",
              is_valid ? "OK" : "VIOLATED",
              is_valid ? "Conservation law holds" : "Conservation law violated",
-             error,
-             state->total_supply,
-             sum);
+             pc_amount_to_coins(error),
+             pc_amount_to_coins(state->total_supply),
+             pc_amount_to_coins((PCAmount)sum));
     
     send_json_response(client, 200, body);
 }
@@ -374,52 +385,32 @@ void handle_explorer_wallets_top(int client, PCState* state, const char* count_s
     if (count > 100) count = 100; // Limit to 100
     if (count > state->num_wallets) count = state->num_wallets;
     
-    // Create sorted list of wallets
-    typedef struct {
-        uint32_t index;
-        double balance;
-    } WalletSort;
-    
-    WalletSort* sorted = malloc(state->num_wallets * sizeof(WalletSort));
+    // Sorted top wallets
+    WalletSort* sorted = NULL;
+    collect_top(state, count, &sorted);
     if (!sorted) {
         send_error(client, -32000, "Memory allocation failed");
         return;
     }
     
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        sorted[i].index = i;
-        sorted[i].balance = state->wallets[i].energy;
-    }
-    
-    // Bubble sort (good enough for small lists)
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        for (uint32_t j = i + 1; j < state->num_wallets; j++) {
-            if (sorted[j].balance > sorted[i].balance) {
-                WalletSort temp = sorted[i];
-                sorted[i] = sorted[j];
-                sorted[j] = temp;
-            }
-        }
-    }
-    
     // Build JSON response
     char body[16384] = "{\"rich_list\":[";
     char* p = body + strlen(body);
     size_t remaining = sizeof(body) - strlen(body) - 10;
     
     for (uint32_t i = 0; i < count && remaining > 200; i++) {
-        PCWallet* w = &state->wallets[sorted[i].index];
+        const PCWallet* w = pc_state_wallet_at(state, sorted[i].index);
         char addr[65];
-        pc_pubkey_to_hex(w->public_key, addr);
+        pc_pubkey_to_hex(pc_state_key_at(state, sorted[i].index), addr);
         
-        double percent = (w->energy / state->total_supply) * 100.0;
+        double percent = ((double)w->energy / (double)state->total_supply) * 100.0;
         
         int written = snprintf(p, remaining,
                               "%s{\"rank\":%u,\"address\":\"%s\",\"balance\":%.8f,\"percent\":%.4f}",
                               i > 0 ? "," : "",
                               i + 1,
                               addr,
-                              w->energy,
+                              pc_amount_to_coins(w->energy),
                               percent);
         p += written;
         remaining -= written;
@@ -431,6 +422,127 @@ void handle_explorer_wallets_top(int client, PCState* state, const char* count_s
     send_json_response(client, 200, body);
 }
 
+// Parse "addresses":["<hex>",...] into packed keys; returns the count, or -1
+static int parse_history_addresses(const char* json, uint8_t* keys) {
+    const char* p = strstr(json, "\"addresses\":");
+    if (!p) return -1;
+    p = strchr(p, '[');
+    if (!p) return -1;
+    
+    int count = 0;
+    for (p++; *p && *p != ']'; p++) {
+        if (*p != '"') continue;
+        const char* end = strchr(p + 1, '"');
+        if (!end || end - p - 1 != 64 || count == HISTORY_MAX_WALLETS) return -1;
+        
+        char hex[65];
+        memcpy(hex, p + 1, 64);
+        hex[64] = '\0';
+        if (pc_hex_to_pubkey(hex, keys + (size_t)count * 32) != PC_OK) return -1;
+        count++;
+        p = end;
+    }
+    return *p == ']' ? count : -1;
+}
+
+// Samples before the oldest resident checkpoint, read from the history file
+// at checkpoint resolution (zero before its first checkpoint)
+static void file_balance_rows(PCHistoryFile* file, const uint8_t* keys, int num_keys, uint64_t t0,
+                              uint64_t step, uint32_t count, uint32_t points, PCAmount* series) {
+    for (int k = 0; k < num_keys; k++) {
+        PCAmount* row = series + (size_t)k * points;
+        for (uint32_t i = 0; i < count; i++) {
+            if (!file || pc_history_balance_at(file, keys + (size_t)k * 32, t0 + i * step, &row[i]) != PC_OK) {
+                row[i] = 0;
+            }
+        }
+    }
+}
+
+// POST /explorer/history - Balance series {"addresses":[...],"from":t0,"to":t1,"step":s}
+// Defaults: the last 30 days, hourly. Recent samples come exactly from the
+// resident history, older ones from the history file.
+void handle_explorer_balance_history(int client, PCCheckpointHistory* history, PCHistoryFile* file,
+                                     const char* json) {
+    uint8_t keys[HISTORY_MAX_WALLETS * 32];
+    int num_keys = parse_history_addresses(json, keys);
+    if (num_keys <= 0) {
+        send_error(client, -32602, "Expected 1-16 addresses");
+        return;
+    }
+    
+    uint64_t t1 = get_json_uint64(json, "to");
+    if (t1 == 0) t1 = (uint64_t)time(NULL);
+    uint64_t t0 = get_json_uint64(json, "from");
+    if (t0 == 0) t0 = t1 > HISTORY_DEFAULT_SPAN ? t1 - HISTORY_DEFAULT_SPAN : 0;
+    uint64_t step = get_json_uint64(json, "step");
+    if (step == 0) step = HISTORY_DEFAULT_STEP;
+    
+    uint32_t points = pc_query_range_points(t0, t1, step);
+    if (points == 0 || (uint64_t)points * (uint64_t)num_keys > HISTORY_MAX_VALUES) {
+        send_error(client, -32602, "Range empty or too many points");
+        return;
+    }
+    
+    PCAmount* series = malloc((size_t)points * num_keys * sizeof(PCAmount));
+    // Per value: up to 20 digits, point, 8 decimals, comma
+    size_t cap = 256 + (size_t)num_keys * 128 + (size_t)points * num_keys * 32;
+    char* body = malloc(cap);
+    if (!series || !body) {
+        free(series);
+        free(body);
+        send_error(client, -32000, "Memory allocation failed");
+        return;
+    }
+    
+    // Split at the oldest resident checkpoint
+    uint64_t resident = history->num_checkpoints > 0 ? history->checkpoints[0].timestamp : UINT64_MAX;
+    uint32_t old_points = 0;
+    if (t0 < resident) {
+        uint64_t before = (resident - t0 + step - 1) / step;  // Samples earlier than resident
+        old_points = before < points ? (uint32_t)before : points;
+    }
+    file_balance_rows(file, keys, num_keys, t0, step, old_points, points, series);
+    
+    // Recent rows land at the front of the buffer, then move into place
+    uint32_t recent = points - old_points;
+    PCAmount* rows = recent > 0 && old_points > 0 ? malloc((size_t)recent * num_keys * sizeof(PCAmount)) : series;
+    if (recent > 0 && (!rows || pc_query_balance_range(history, keys, (uint32_t)num_keys, t0 + old_points * step,
+                                                       t1, step, rows) != PC_OK)) {
+        if (rows != series) free(rows);
+        free(series);
+        free(body);
+        send_error(client, -32000, "History query failed");
+        return;
+    }
+    if (rows != series) {
+        for (int k = 0; k < num_keys; k++) {
+            memcpy(series + (size_t)k * points + old_points, rows + (size_t)k * recent, recent * sizeof(PCAmount));
+        }
+        free(rows);
+    }
+    
+    size_t len = (size_t)snprintf(body, cap, "{\"from\":%lu,\"to\":%lu,\"step\":%lu,\"points\":%u,\"series\":[",
+                                  t0, t1, step, points);
+    for (int k = 0; k < num_keys; k++) {
+        char addr[65];
+        pc_pubkey_to_hex(keys + (size_t)k * 32, addr);
+        len += (size_t)snprintf(body + len, cap - len, "%s{\"address\":\"%s\",\"balances\":[",
+                                k > 0 ? "," : "", addr);
+        const PCAmount* row = series + (size_t)k * points;
+        for (uint32_t i = 0; i < points; i++) {
+            len += (size_t)snprintf(body + len, cap - len, "%s%.8f", i > 0 ? "," : "",
+                                    pc_amount_to_coins(row[i]));
+        }
+        len += (size_t)snprintf(body + len, cap - len, "]}");
+    }
+    snprintf(body + len, cap - len, "]}");
+    
+    send_json_response(client, 200, body);
+    free(series);
+    free(body);
+}
+
 // Integrate explorer endpoints into main API server
 void register_explorer_endpoints(void) {
     printf("Explorer API endpoints registered:\n");
@@ -445,5 +557,6 @@ void register_explorer_endpoints(void) {
     printf("  GET  /explorer/state/hash           - State hash info\n");
     printf("  GET  /explorer/supply               - Supply analytics\n");
     printf("  GET  /explorer/conservation_check   - Verify conservation law\n");
+    printf("  POST /explorer/history              - Balance series over a time range\n");
 }
 
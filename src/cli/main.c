@@ -20,7 +20,7 @@
 typedef struct {
     uint8_t state_hash[32];
     uint8_t wallet_pubkey[32];
-    double balance;
+    PCAmount balance;
     uint64_t nonce;
     uint64_t timestamp;
     uint8_t proof_hash[32];
@@ -34,9 +34,9 @@ void pc_proof_print(const PCBalanceProof* proof);
 
 // From streams.c - actual API signatures
 uint64_t pc_stream_open(const uint8_t* payer, const uint8_t* receiver,
-                        double rate_per_second, double max_amount,
+                        PCAmount rate_per_second, PCAmount max_amount,
                         const uint8_t* authorization_sig);
-double pc_stream_accumulated(uint64_t stream_id);
+PCAmount pc_stream_accumulated(uint64_t stream_id);
 PCError pc_stream_settle(uint64_t stream_id, PCState* state);
 PCError pc_stream_close(uint64_t stream_id, PCState* state);
 void pc_stream_info(uint64_t stream_id);
@@ -44,8 +44,8 @@ void pc_stream_info(uint64_t stream_id);
 // From delta.c
 typedef struct {
     uint8_t pubkey[32];
-    double old_balance;
-    double new_balance;
+    PCAmount old_balance;
+    PCAmount new_balance;
     uint64_t old_nonce;
     uint64_t new_nonce;
 } PCWalletDelta;
@@ -129,24 +129,25 @@ void print_state(const PCState* state) {
     printf("├──────────────────────────────────────────────────────────────┤\n");
     printf("│ Version:        %-10lu                                   │\n", state->version);
     printf("│ Wallets:        %-10u                                   │\n", state->num_wallets);
-    printf("│ Total Supply:   %-20.8f                   │\n", state->total_supply);
+    printf("│ Total Supply:   %-20.8f                   │\n", pc_amount_to_coins(state->total_supply));
     printf("│ State Hash:     ");
     for (int i = 0; i < 8; i++) printf("%02x", state->state_hash[i]);
     printf("...                         │\n");
     printf("├──────────────────────────────────────────────────────────────┤\n");
     
-    double actual_sum = 0.0;
+    PCAmount actual_sum = 0;
     for (uint32_t i = 0; i < state->num_wallets; i++) {
+        const PCWallet* w = pc_state_wallet_at(state, i);
         char addr[65];
-        pc_pubkey_to_hex(state->wallets[i].public_key, addr);
+        pc_pubkey_to_hex(pc_state_key_at(state, i), addr);
         printf("│ %.8s... : %20.8f (nonce: %lu)     │\n", 
-               addr, state->wallets[i].energy, state->wallets[i].nonce);
-        actual_sum += state->wallets[i].energy;
+               addr, pc_amount_to_coins(w->energy), w->nonce);
+        actual_sum += w->energy;
     }
     
     printf("├──────────────────────────────────────────────────────────────┤\n");
-    double error = state->total_supply - actual_sum;
-    printf("│ Conservation Error: %.12e                          │\n", error);
+    PCAmount error = state->total_supply - actual_sum;
+    printf("│ Conservation Error: %-20ld units                  │\n", error);
     printf("└──────────────────────────────────────────────────────────────┘\n\n");
 }
 
@@ -171,8 +172,8 @@ int cmd_init(double supply) {
     pc_pubkey_to_hex(founder.public_key, addr);
     printf("Founder address: %s\n", addr);
     
-    PCState state;
-    PCError err = pc_state_genesis(&state, founder.public_key, supply);
+    PCState state = {0};
+    PCError err = pc_state_genesis(&state, founder.public_key, pc_amount_from_coins(supply));
     if (err != PC_OK) {
         printf("Error: %s\n", pc_strerror(err));
         return 1;
@@ -216,8 +217,8 @@ int cmd_wallet_create(void) {
 }
 
 int cmd_balance(const char* address) {
-    PCState state;
-    if (pc_state_load(&state, STATE_FILE) != PC_OK) {
+    PCState state = {0};
+    if (pc_state_load_readonly(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state. Run 'physicscoin init' first.\n");
         return 1;
     }
@@ -229,11 +230,11 @@ int cmd_balance(const char* address) {
         return 1;
     }
     
-    PCWallet* w = pc_state_get_wallet(&state, pubkey);
+    const PCWallet* w = pc_state_find_wallet(&state, pubkey);
     if (!w) {
         printf("Balance: 0.00000000 (wallet not found)\n");
     } else {
-        printf("Balance: %.8f\n", w->energy);
+        printf("Balance: %.8f\n", pc_amount_to_coins(w->energy));
         printf("Nonce:   %lu\n", w->nonce);
     }
     
@@ -255,7 +256,7 @@ int cmd_send(const char* to_addr, double amount) {
     }
     fclose(wf);
     
-    PCState state;
+    PCState state = {0};
     if (pc_state_load(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state\n");
         return 1;
@@ -278,7 +279,7 @@ int cmd_send(const char* to_addr, double amount) {
     PCTransaction tx;
     memcpy(tx.from, kp.public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, to_pubkey, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = amount;
+    tx.amount = pc_amount_from_coins(amount);
     tx.nonce = sender->nonce;
     tx.timestamp = (uint64_t)time(NULL);
     
@@ -312,8 +313,8 @@ int cmd_send(const char* to_addr, double amount) {
 }
 
 int cmd_state(void) {
-    PCState state;
-    if (pc_state_load(&state, STATE_FILE) != PC_OK) {
+    PCState state = {0};
+    if (pc_state_load_readonly(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state. Run 'physicscoin init' first.\n");
         return 1;
     }
@@ -324,8 +325,8 @@ int cmd_state(void) {
 }
 
 int cmd_verify(void) {
-    PCState state;
-    if (pc_state_load(&state, STATE_FILE) != PC_OK) {
+    PCState state = {0};
+    if (pc_state_load_readonly(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state\n");
         return 1;
     }
@@ -335,14 +336,11 @@ int cmd_verify(void) {
     PCError err = pc_state_verify_conservation(&state);
     if (err == PC_OK) {
         printf("✓ Conservation law verified!\n");
-        printf("  Total Supply: %.8f\n", state.total_supply);
+        printf("  Total Supply: %.8f\n", pc_amount_to_coins(state.total_supply));
         
-        double sum = 0.0;
-        for (uint32_t i = 0; i < state.num_wallets; i++) {
-            sum += state.wallets[i].energy;
-        }
-        printf("  Actual Sum:   %.8f\n", sum);
-        printf("  Error:        %.12e\n", state.total_supply - sum);
+        PCAmount sum = (PCAmount)pc_scan_sum(&state);
+        printf("  Actual Sum:   %.8f\n", pc_amount_to_coins(sum));
+        printf("  Error:        %ld units\n", state.total_supply - sum);
     } else {
         printf("✗ CONSERVATION VIOLATED!\n");
     }
@@ -354,8 +352,8 @@ int cmd_verify(void) {
 // ============ Proof commands ============
 
 int cmd_prove(const char* address) {
-    PCState state;
-    if (pc_state_load(&state, STATE_FILE) != PC_OK) {
+    PCState state = {0};
+    if (pc_state_load_readonly(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state\n");
         return 1;
     }
@@ -400,8 +398,8 @@ int cmd_verify_proof(const char* filename) {
         return 1;
     }
     
-    PCState state;
-    if (pc_state_load(&state, STATE_FILE) != PC_OK) {
+    PCState state = {0};
+    if (pc_state_load_readonly(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state\n");
         return 1;
     }
@@ -413,7 +411,7 @@ int cmd_verify_proof(const char* filename) {
     PCError err = pc_proof_verify(&state, &proof);
     if (err == PC_OK) {
         printf("✓ Proof VALID!\n");
-        printf("  The wallet had %.8f at the claimed state.\n", proof.balance);
+        printf("  The wallet had %.8f at the claimed state.\n", pc_amount_to_coins(proof.balance));
     } else {
         printf("✗ Proof INVALID: %s\n", pc_strerror(err));
     }
@@ -437,7 +435,7 @@ int cmd_stream_open(const char* to_addr, double rate) {
     }
     fclose(wf);
     
-    PCState state;
+    PCState state = {0};
     if (pc_state_load(&state, STATE_FILE) != PC_OK) {
         printf("Error: Cannot load state\n");
         return 1;
@@ -451,7 +449,7 @@ int cmd_stream_open(const char* to_addr, double rate) {
     }
     
     // Use actual streams.c API: returns uint64_t stream ID
-    uint64_t stream_id = pc_stream_open(kp.public_key, to_pubkey, rate, 1e15, NULL);
+    uint64_t stream_id = pc_stream_open(kp.public_key, to_pubkey, pc_amount_from_coins(rate), 0, NULL);
     if (stream_id == 0) {
         printf("Error: Failed to open stream\n");
         pc_state_free(&state);
@@ -485,20 +483,21 @@ int cmd_stream_demo(void) {
     printf("Alice: %.16s...\n", alice_addr);
     printf("Bob:   %.16s...\n", bob_addr);
     
-    PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    PCState state = {0};
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     
     // IMPORTANT: Create Bob's wallet in state BEFORE opening stream
     // The stream settlement looks up wallets by pubkey in the state
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     printf("\n═══ Initial State ═══\n");
-    printf("Alice: %.8f\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("Bob:   %.8f\n", pc_state_get_wallet(&state, bob.public_key)->energy);
+    printf("Alice: %.8f\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("Bob:   %.8f\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
     
     // Open stream: 1 coin per second (using actual streams.c API)
     // Returns uint64_t stream ID, not error code
-    uint64_t stream_id = pc_stream_open(alice.public_key, bob.public_key, 1.0, 1000.0, NULL);
+    uint64_t stream_id = pc_stream_open(alice.public_key, bob.public_key,
+                                        pc_amount_from_coins(1.0), pc_amount_from_coins(1000.0), NULL);
     
     printf("\n═══ Stream Opened: 1.0 coin/sec ═══\n");
     printf("Stream ID: %lu\n", stream_id);
@@ -507,7 +506,7 @@ int cmd_stream_demo(void) {
     printf("\n═══ Simulating 5 seconds ═══\n");
     for (int i = 1; i <= 5; i++) {
         sleep(1);
-        double acc = pc_stream_accumulated(stream_id);
+        double acc = pc_amount_to_coins(pc_stream_accumulated(stream_id));
         printf("t=%d: Accumulated: %.8f\n", i, acc);
     }
     
@@ -517,8 +516,8 @@ int cmd_stream_demo(void) {
     printf("Settlement: %s\n", err == PC_OK ? "✓ Success" : pc_strerror(err));
     
     printf("\n═══ Final Balances ═══\n");
-    printf("Alice: %.8f\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("Bob:   %.8f\n", pc_state_get_wallet(&state, bob.public_key)->energy);
+    printf("Alice: %.8f\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("Bob:   %.8f\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
     
     // Close stream (using actual streams.c API)
     pc_stream_close(stream_id, &state);
@@ -535,14 +534,14 @@ int cmd_stream_demo(void) {
 // ============ Delta commands ============
 
 int cmd_delta(const char* file1, const char* file2) {
-    PCState state1, state2;
+    PCState state1 = {0}, state2 = {0};
     
-    if (pc_state_load(&state1, file1) != PC_OK) {
+    if (pc_state_load_readonly(&state1, file1) != PC_OK) {
         printf("Error: Cannot load %s\n", file1);
         return 1;
     }
     
-    if (pc_state_load(&state2, file2) != PC_OK) {
+    if (pc_state_load_readonly(&state2, file2) != PC_OK) {
         printf("Error: Cannot load %s\n", file2);
         pc_state_free(&state1);
         return 1;
@@ -601,8 +600,8 @@ int cmd_demo(void) {
     printf("Charlie: %.16s...\n", charlie_addr);
     
     printf("\n═══ GENESIS ═══\n");
-    PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    PCState state = {0};
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     
     pc_state_create_wallet(&state, bob.public_key, 0);
     pc_state_create_wallet(&state, charlie.public_key, 0);
@@ -614,7 +613,7 @@ int cmd_demo(void) {
     PCTransaction tx1 = {0};
     memcpy(tx1.from, alice.public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx1.to, bob.public_key, PHYSICSCOIN_KEY_SIZE);
-    tx1.amount = 100.0;
+    tx1.amount = pc_amount_from_coins(100.0);
     tx1.nonce = 0;
     tx1.timestamp = time(NULL);
     pc_transaction_sign(&tx1, &alice);
@@ -626,7 +625,7 @@ int cmd_demo(void) {
     PCTransaction tx2 = {0};
     memcpy(tx2.from, alice.public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx2.to, charlie.public_key, PHYSICSCOIN_KEY_SIZE);
-    tx2.amount = 50.0;
+    tx2.amount = pc_amount_from_coins(50.0);
     tx2.nonce = 1;
     tx2.timestamp = time(NULL);
     pc_transaction_sign(&tx2, &alice);
@@ -638,7 +637,7 @@ int cmd_demo(void) {
     PCTransaction tx3 = {0};
     memcpy(tx3.from, bob.public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx3.to, charlie.public_key, PHYSICSCOIN_KEY_SIZE);
-    tx3.amount = 25.0;
+    tx3.amount = pc_amount_from_coins(25.0);
     tx3.nonce = 0;
     tx3.timestamp = time(NULL);
     pc_transaction_sign(&tx3, &bob);
@@ -653,7 +652,7 @@ int cmd_demo(void) {
     PCBalanceProof proof;
     pc_proof_generate(&state, alice.public_key, &proof);
     printf("Generated proof for Alice:\n");
-    printf("  Balance: %.8f at state ", proof.balance);
+    printf("  Balance: %.8f at state ", pc_amount_to_coins(proof.balance));
     for (int i = 0; i < 8; i++) printf("%02x", proof.state_hash[i]);
     printf("...\n");
     printf("  Proof hash: ");
@@ -669,6 +668,7 @@ int cmd_demo(void) {
     size_t size = pc_state_serialize(&state, buffer, sizeof(buffer));
     printf("\n═══ STATE COMPRESSION ═══\n");
     printf("State size: %zu bytes\n", size);
+    printf("Compact size: %zu bytes\n", pc_state_serialize_compact(&state, buffer, sizeof(buffer)));
     printf("Compression ratio: %.0f million : 1 vs Bitcoin\n", 500.0 * 1024 * 1024 * 1024 / size / 1000000);
     
     pc_state_free(&state);
@@ -881,8 +881,8 @@ int main(int argc, char** argv) {
             pc_keypair_generate(&bob);
             pc_keypair_generate(&charlie);
             
-            PCState state;
-            pc_state_genesis(&state, alice.public_key, 100.0);
+            PCState state = {0};
+            pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(100.0));
             pc_state_create_wallet(&state, bob.public_key, 0);
             pc_state_create_wallet(&state, charlie.public_key, 0);
             
@@ -892,7 +892,7 @@ int main(int argc, char** argv) {
             PCTransaction tx1 = {0};
             memcpy(tx1.from, alice.public_key, 32);
             memcpy(tx1.to, bob.public_key, 32);
-            tx1.amount = 100.0;
+            tx1.amount = pc_amount_from_coins(100.0);
             tx1.nonce = 0;
             tx1.timestamp = time(NULL);
             pc_transaction_sign(&tx1, &alice);
@@ -905,7 +905,7 @@ int main(int argc, char** argv) {
             PCTransaction tx2 = {0};
             memcpy(tx2.from, alice.public_key, 32);
             memcpy(tx2.to, charlie.public_key, 32);
-            tx2.amount = 100.0;
+            tx2.amount = pc_amount_from_coins(100.0);
             tx2.nonce = 1;
             tx2.timestamp = time(NULL);
             pc_transaction_sign(&tx2, &alice);
@@ -915,9 +915,9 @@ int main(int argc, char** argv) {
             printf("%s (%s)\n\n", err2 == PC_OK ? "SUCCESS" : "✗ BLOCKED", pc_strerror(err2));
             
             printf("Final: Alice=%.0f, Bob=%.0f, Charlie=%.0f\n", 
-                   pc_state_get_wallet(&state, alice.public_key)->energy,
-                   pc_state_get_wallet(&state, bob.public_key)->energy,
-                   pc_state_get_wallet(&state, charlie.public_key)->energy);
+                   pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy),
+                   pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy),
+                   pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
             
             printf("\n✓ Double-spend prevented by CONSERVATION LAW\n");
             printf("✓ No blockchain needed - physics enforces security\n\n");
@@ -947,12 +947,12 @@ int main(int argc, char** argv) {
             
             const PCNetworkConfig* config = pc_network_get_config(pc_network_get_current());
             
-            PCState state;
+            PCState state = {0};
             if (pc_state_load(&state, config->state_file) != PC_OK) {
                 printf("Creating %s genesis state for API...\n", config->network_name);
                 PCKeypair genesis;
                 pc_keypair_generate(&genesis);
-                pc_state_genesis(&state, genesis.public_key, config->genesis_supply);
+                pc_state_genesis(&state, genesis.public_key, pc_amount_from_coins(config->genesis_supply));
             }
             
             int port = (argc >= 4) ? atoi(argv[3]) : config->api_port;
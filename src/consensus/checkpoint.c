@@ -27,7 +27,7 @@ typedef struct {
     uint8_t state_hash[32];
     uint8_t prev_checkpoint_hash[32];
     uint64_t timestamp;
-    double total_supply;  // SECURITY: Include for conservation check
+    PCAmount total_supply;  // SECURITY: Include for conservation check
     
     ValidatorSignature signatures[MAX_VALIDATORS];
     uint32_t num_signatures;
@@ -311,7 +311,7 @@ void checkpoint_print(const PCCheckpoint* cp) {
     printf("Checkpoint #%lu:\n", cp->checkpoint_id);
     printf("  TXs since last: %lu\n", cp->tx_count_since_last);
     printf("  Timestamp: %lu\n", cp->timestamp);
-    printf("  Total Supply: %.8f\n", cp->total_supply);
+    printf("  Total Supply: %.8f\n", pc_amount_to_coins(cp->total_supply));
     printf("  State hash: ");
     for (int i = 0; i < 8; i++) printf("%02x", cp->state_hash[i]);
     printf("...\n");
@@ -167,22 +167,39 @@ uint32_t txpool_execute(PCTxPool* pool, PCState* state) {
     // Sort by vector clock
     txpool_sort(pool);
     
-    uint32_t executed = 0;
+    // Gather pending transactions so their signatures verify in one parallel pass
+    uint32_t* pending = malloc(pool->count * sizeof(uint32_t));
+    PCTransaction* txs = malloc(pool->count * sizeof(PCTransaction));
+    int* results = malloc(pool->count * sizeof(int));
+    if (!pending || !txs || !results) {
+        free(pending);
+        free(txs);
+        free(results);
+        return 0;
+    }
     
+    uint32_t n = 0;
     for (uint32_t i = 0; i < pool->count; i++) {
         if (pool->txs[i].executed) continue;
-        
-        PCError err = pc_state_execute_tx(state, &pool->txs[i].tx);
-        
-        if (err == PC_OK) {
-            pool->txs[i].executed = 1;
-            executed++;
+        pending[n] = i;
+        txs[n] = pool->txs[i].tx;
+        n++;
+    }
+    
+    uint32_t executed = pc_state_execute_batch(state, txs, n, results);
+    
+    for (uint32_t k = 0; k < n; k++) {
+        if (results[k] == PC_OK) {
+            pool->txs[pending[k]].executed = 1;
         } else {
             // TX failed (likely insufficient funds from earlier conflict)
-            printf("TX execution failed: %s\n", pc_strerror(err));
+            printf("TX execution failed: %s\n", pc_strerror(results[k]));
         }
     }
     
+    free(pending);
+    free(txs);
+    free(results);
     return executed;
 }
 
@@ -231,7 +248,7 @@ void txpool_print(const PCTxPool* pool) {
         printf("  [%u] ", i);
         for (int j = 0; j < 4; j++) printf("%02x", otx->tx_hash[j]);
         printf("... nonce=%lu amount=%.2f %s\n",
-               otx->tx.nonce, otx->tx.amount,
+               otx->tx.nonce, pc_amount_to_coins(otx->tx.amount),
                otx->executed ? "[EXECUTED]" : "[PENDING]");
     }
 }
@@ -37,7 +37,7 @@ typedef struct {
     uint8_t proposer_pubkey[32];
     uint8_t proposer_signature[64];
     uint32_t num_transactions;
-    double total_supply;
+    PCAmount total_supply;
 } POABlock;
 
 // Vote on a block
@@ -9,7 +9,6 @@
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
-#include <math.h>
 #include <sodium.h>
 
 #define POC_FILE "poc_consensus.dat"
@@ -204,8 +203,8 @@ void poc_hash_proposal(const POCProposal* proposal, uint8_t hash[32]) {
     sha256_update(&ctx, (uint8_t*)&proposal->round, 8);
     sha256_update(&ctx, proposal->prev_state_hash, 32);
     sha256_update(&ctx, proposal->new_state_hash, 32);
-    sha256_update(&ctx, (uint8_t*)&proposal->total_supply, sizeof(double));
-    sha256_update(&ctx, (uint8_t*)&proposal->delta_sum, sizeof(double));
+    sha256_update(&ctx, (uint8_t*)&proposal->total_supply, sizeof(PCAmount));
+    sha256_update(&ctx, (uint8_t*)&proposal->delta_sum, sizeof(PCAmount));
     sha256_update(&ctx, (uint8_t*)&proposal->timestamp, 8);
     sha256_update(&ctx, proposal->proposer_pubkey, 32);
     sha256_update(&ctx, (uint8_t*)&proposal->num_transactions, 4);
@@ -220,38 +219,30 @@ static PCError verify_conservation(const PCState* before, const PCState* after)
     if (!before || !after) return PC_ERR_IO;
     
     // Check 1: Total supply must not change
-    if (fabs(before->total_supply - after->total_supply) > 1e-12) {
+    if (before->total_supply != after->total_supply) {
         printf("POC: Conservation violated - total supply changed from %.8f to %.8f\n",
-               before->total_supply, after->total_supply);
+               pc_amount_to_coins(before->total_supply), pc_amount_to_coins(after->total_supply));
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
     // Check 2: Sum of balances must equal total supply (before)
-    double sum_before = 0.0;
-    for (uint32_t i = 0; i < before->num_wallets; i++) {
-        sum_before += before->wallets[i].energy;
-    }
-    if (fabs(sum_before - before->total_supply) > 1e-9) {
+    if (pc_scan_sum(before) != (uint64_t)before->total_supply) {
         printf("POC: Conservation violated - before state sum mismatch\n");
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
     // Check 3: Sum of balances must equal total supply (after)
-    double sum_after = 0.0;
-    for (uint32_t i = 0; i < after->num_wallets; i++) {
-        sum_after += after->wallets[i].energy;
-    }
-    if (fabs(sum_after - after->total_supply) > 1e-9) {
+    PCScanStats after_stats;
+    pc_scan_stats(after, &after_stats);
+    if (after_stats.sum != (uint64_t)after->total_supply) {
         printf("POC: Conservation violated - after state sum mismatch\n");
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
     // Check 4: No negative balances
-    for (uint32_t i = 0; i < after->num_wallets; i++) {
-        if (after->wallets[i].energy < 0) {
-            printf("POC: Conservation violated - negative balance detected\n");
-            return PC_ERR_INVALID_AMOUNT;
-        }
+    if (after_stats.negative > 0) {
+        printf("POC: Conservation violated - negative balance detected\n");
+        return PC_ERR_INVALID_AMOUNT;
     }
     
     return PC_OK;
@@ -280,18 +271,12 @@ PCError poc_propose_transition(POCConsensus* consensus,
     }
     
     // Calculate delta sum (should be 0 for valid transition)
-    double delta_sum = 0.0;
+    uint64_t delta_sum = 0;
     for (uint32_t i = 0; i < after->num_wallets; i++) {
         // Find corresponding wallet in before state
-        double before_balance = 0.0;
-        for (uint32_t j = 0; j < before->num_wallets; j++) {
-            if (memcmp(before->wallets[j].public_key, 
-                       after->wallets[i].public_key, 32) == 0) {
-                before_balance = before->wallets[j].energy;
-                break;
-            }
-        }
-        delta_sum += (after->wallets[i].energy - before_balance);
+        const PCWallet* prev = pc_state_find_wallet(before, pc_state_key_at(after, i));
+        uint64_t before_balance = prev ? (uint64_t)prev->energy : 0;
+        delta_sum += (uint64_t)pc_state_wallet_at(after, i)->energy - before_balance;
     }
     
     // Create proposal
@@ -303,7 +288,7 @@ PCError poc_propose_transition(POCConsensus* consensus,
     memcpy(proposal->prev_state_hash, before->state_hash, 32);
     memcpy(proposal->new_state_hash, after->state_hash, 32);
     proposal->total_supply = after->total_supply;
-    proposal->delta_sum = delta_sum;
+    proposal->delta_sum = (PCAmount)delta_sum;
     proposal->timestamp = (uint64_t)time(NULL);
     memcpy(proposal->proposer_pubkey, proposer->public_key, 32);
     proposal->num_transactions = 0; // TODO: track actual TX count
@@ -322,7 +307,7 @@ PCError poc_propose_transition(POCConsensus* consensus,
     leader->proposals++;
     leader->last_seen = (uint64_t)time(NULL);
     
-    printf("POC: Proposal #%lu created (delta_sum=%.12f)\n", 
+    printf("POC: Proposal #%lu created (delta_sum=%ld)\n", 
            proposal->sequence_num, proposal->delta_sum);
     
     // Leader auto-votes for their own proposal
@@ -356,14 +341,14 @@ PCError poc_validate_proposal(const POCConsensus* consensus,
     }
     
     // Check 4: Total supply unchanged
-    if (fabs(proposal->total_supply - current_state->total_supply) > 1e-12) {
+    if (proposal->total_supply != current_state->total_supply) {
         printf("POC: CONSERVATION VIOLATION - total supply changed\n");
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
     // Check 5: Delta sum is zero (conservation)
-    if (fabs(proposal->delta_sum) > 1e-12) {
-        printf("POC: CONSERVATION VIOLATION - delta sum is %.12f (should be 0)\n",
+    if (proposal->delta_sum != 0) {
+        printf("POC: CONSERVATION VIOLATION - delta sum is %ld (should be 0)\n",
                proposal->delta_sum);
         return PC_ERR_CONSERVATION_VIOLATED;
     }
@@ -569,7 +554,7 @@ void poc_next_round(POCConsensus* consensus) {
 
 PCError poc_acquire_lock(POCConsensus* consensus,
                          const uint8_t* sender,
-                         double amount,
+                         PCAmount amount,
                          uint8_t source_shard,
                          uint8_t target_shard) {
     if (!consensus || !sender) return PC_ERR_IO;
@@ -599,7 +584,7 @@ PCError poc_acquire_lock(POCConsensus* consensus,
     SHA256_CTX ctx;
     sha256_init(&ctx);
     sha256_update(&ctx, sender, 32);
-    sha256_update(&ctx, (uint8_t*)&amount, sizeof(double));
+    sha256_update(&ctx, (uint8_t*)&amount, sizeof(PCAmount));
     sha256_update(&ctx, &source_shard, 1);
     sha256_update(&ctx, &target_shard, 1);
     sha256_update(&ctx, (uint8_t*)&lock->sequence, 8);
@@ -608,7 +593,7 @@ PCError poc_acquire_lock(POCConsensus* consensus,
     consensus->num_pending_locks++;
     
     printf("POC: Cross-shard lock acquired (shard %u -> %u, %.8f)\n",
-           source_shard, target_shard, amount);
+           source_shard, target_shard, pc_amount_to_coins(amount));
     
     return PC_OK;
 }
@@ -704,7 +689,7 @@ void poc_print_status(const POCConsensus* consensus) {
     if (consensus->has_proposal) {
         printf("\nCurrent Proposal:\n");
         printf("  Sequence:    %lu\n", consensus->current_proposal.sequence_num);
-        printf("  Delta Sum:   %.12f\n", consensus->current_proposal.delta_sum);
+        printf("  Delta Sum:   %ld\n", consensus->current_proposal.delta_sum);
         printf("  Votes:       %u/%u\n", consensus->num_votes, 
                poc_active_validator_count(consensus));
     }
@@ -9,7 +9,7 @@
 #include <time.h>
 
 #define MAX_VALIDATORS 100
-#define MIN_STAKE 1000.0
+#define MIN_STAKE (1000 * PC_AMOUNT_SCALE)
 #define MAX_VOTING_POWER_PCT 10  // No validator can have >10% voting power
 
 // Validator status
@@ -23,7 +23,7 @@ typedef enum {
 // Validator record
 typedef struct {
     uint8_t pubkey[32];
-    double staked_amount;
+    PCAmount staked_amount;
     uint64_t joined_at;
     uint64_t last_active;
     uint32_t blocks_signed;
@@ -36,7 +36,7 @@ typedef struct {
 typedef struct {
     PCValidator validators[MAX_VALIDATORS];
     uint32_t count;
-    double total_staked;
+    PCAmount total_staked;
     uint32_t active_count;
 } PCValidatorRegistry;
 
@@ -59,7 +59,7 @@ static PCValidator* find_validator(PCValidatorRegistry* reg, const uint8_t* pubk
 
 // Register new validator (stake coins)
 PCError validator_stake(PCValidatorRegistry* reg, PCState* state,
-                        const uint8_t* pubkey, double amount) {
+                        const uint8_t* pubkey, PCAmount amount) {
     if (!reg || !state || !pubkey) return PC_ERR_IO;
     if (reg->count >= MAX_VALIDATORS) return PC_ERR_MAX_WALLETS;
     if (amount < MIN_STAKE) return PC_ERR_INSUFFICIENT_FUNDS;
@@ -94,7 +94,7 @@ PCError validator_stake(PCValidatorRegistry* reg, PCState* state,
     reg->total_staked += amount;
     
     printf("Validator staked: %.2f coins (total staked: %.2f)\n", 
-           amount, reg->total_staked);
+           pc_amount_to_coins(amount), pc_amount_to_coins(reg->total_staked));
     
     return PC_OK;
 }
@@ -154,7 +154,7 @@ PCError validator_slash(PCValidatorRegistry* reg, PCState* state,
     PCValidator* v = find_validator(reg, pubkey);
     if (!v) return PC_ERR_WALLET_NOT_FOUND;
     
-    double slash_amount = v->staked_amount * (slash_pct / 100.0);
+    PCAmount slash_amount = (PCAmount)((double)v->staked_amount * (slash_pct / 100.0));
     
     v->staked_amount -= slash_amount;
     reg->total_staked -= slash_amount;
@@ -166,7 +166,7 @@ PCError validator_slash(PCValidatorRegistry* reg, PCState* state,
         reg->active_count--;
     }
     
-    printf("Validator slashed %.2f%% (%.2f coins)\n", slash_pct, slash_amount);
+    printf("Validator slashed %.2f%% (%.2f coins)\n", slash_pct, pc_amount_to_coins(slash_amount));
     
     // Slashed coins are burned (removed from supply)
     state->total_supply -= slash_amount;
@@ -188,7 +188,7 @@ double validator_voting_power(const PCValidatorRegistry* reg, const uint8_t* pub
     
     if (!v || v->status != VALIDATOR_ACTIVE) return 0;
     
-    double power = (v->staked_amount / reg->total_staked) * 100.0;
+    double power = ((double)v->staked_amount / (double)reg->total_staked) * 100.0;
     
     // Cap at MAX_VOTING_POWER_PCT
     if (power > MAX_VOTING_POWER_PCT) {
@@ -206,7 +206,8 @@ double validator_total_power(const PCValidatorRegistry* reg) {
     
     for (uint32_t i = 0; i < reg->count; i++) {
         if (reg->validators[i].status == VALIDATOR_ACTIVE) {
-            double power = (reg->validators[i].staked_amount / reg->total_staked) * 100.0;
+            double power = ((double)reg->validators[i].staked_amount /
+                            (double)reg->total_staked) * 100.0;
             if (power > MAX_VOTING_POWER_PCT) power = MAX_VOTING_POWER_PCT;
             total += power;
         }
@@ -262,7 +263,7 @@ void validator_registry_print(const PCValidatorRegistry* reg) {
     printf("╚═══════════════════════════════════════════════════════════╝\n\n");
     
     printf("Total validators: %u (active: %u)\n", reg->count, reg->active_count);
-    printf("Total staked: %.2f coins\n\n", reg->total_staked);
+    printf("Total staked: %.2f coins\n\n", pc_amount_to_coins(reg->total_staked));
     
     printf("┌──────────┬────────────┬────────────┬────────────┬──────────┐\n");
     printf("│ Pubkey   │ Staked     │ Power      │ Signed     │ Status   │\n");
@@ -283,11 +284,11 @@ void validator_registry_print(const PCValidatorRegistry* reg) {
         for (int j = 0; j < 4; j++) printf("%02x", v->pubkey[j]);
         
         double power = (reg->total_staked > 0) ? 
-                       (v->staked_amount / reg->total_staked) * 100.0 : 0;
+                       ((double)v->staked_amount / (double)reg->total_staked) * 100.0 : 0;
         if (power > MAX_VOTING_POWER_PCT) power = MAX_VOTING_POWER_PCT;
         
         printf(" │ %10.2f │ %9.1f%% │ %10u │ %-8s │\n",
-               v->staked_amount, power, v->blocks_signed, status_str);
+               pc_amount_to_coins(v->staked_amount), power, v->blocks_signed, status_str);
     }
     
     printf("└──────────┴────────────┴────────────┴────────────┴──────────┘\n");
@@ -5,8 +5,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 #define MAX_BATCH_SIZE 1000
+#define NO_WALLET UINT32_MAX
 
 // Batch processing result
 typedef struct {
@@ -40,13 +42,7 @@ PCError pc_batch_analyze(const PCState* state, PCTransactionBatch* batch) {
         PCTransaction* tx = &batch->transactions[i];
         
         // Find sender's current nonce
-        PCWallet* sender = NULL;
-        for (uint32_t j = 0; j < state->num_wallets; j++) {
-            if (memcmp(state->wallets[j].public_key, tx->from, 32) == 0) {
-                sender = &state->wallets[j];
-                break;
-            }
-        }
+        const PCWallet* sender = pc_state_find_wallet(state, tx->from);
         
         if (!sender) {
             batch->results[i] = PC_ERR_WALLET_NOT_FOUND;
@@ -112,18 +108,230 @@ PCError pc_batch_execute(PCState* state, PCTransactionBatch* batch) {
         if (!batch->results) return PC_ERR_IO;
     }
     
-    for (uint32_t i = 0; i < batch->count; i++) {
-        PCError err = pc_state_execute_tx(state, &batch->transactions[i]);
-        batch->results[i] = err;
+    // Signatures are checked in parallel before anything is applied
+    batch->successful = pc_state_execute_batch(state, batch->transactions,
+                                               batch->count, batch->results);
+    batch->failed = batch->count - batch->successful;
+    
+    return PC_OK;
+}
+
+// Per-transaction bookkeeping for parallel execution
+typedef struct {
+    uint32_t from_idx;
+    uint32_t to_idx;
+    uint32_t created;        // Wallet created by this tx, or NO_WALLET
+    uint32_t num_wallets;    // Wallet count once this tx has run
+    uint8_t from_leaf[32];   // Merkle leaves right after this tx
+    uint8_t to_leaf[32];
+} BatchSlot;
+
+static uint32_t uf_find(uint32_t* parent, uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Union keeps the earliest transaction as the group root
+static void uf_union(uint32_t* parent, uint32_t a, uint32_t b) {
+    a = uf_find(parent, a);
+    b = uf_find(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+// Join tx with the first earlier transaction that touched the same wallet
+static void link_wallet(uint64_t* map, uint32_t mask, uint32_t* parent,
+                        uint32_t wallet, uint32_t tx) {
+    uint32_t pos = (wallet * 0x9E3779B1u) & mask;
+    while (map[pos]) {
+        if ((uint32_t)(map[pos] >> 32) == wallet) {
+            uf_union(parent, (uint32_t)map[pos] - 1, tx);
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    map[pos] = ((uint64_t)wallet << 32) | (tx + 1);
+}
+
+// Execute a batch across cores with the same final state and per-tx results
+// as pc_batch_execute. Transactions that share a sender or recipient wallet
+// form one conflict group; groups run concurrently, each in batch order.
+PCError pc_batch_execute_parallel(PCState* state, PCTransactionBatch* batch) {
+    if (!state || !batch || !batch->transactions) return PC_ERR_IO;
+    
+    batch->successful = 0;
+    batch->failed = 0;
+    
+    if (!batch->results) {
+        batch->results = calloc(batch->count, sizeof(int));
+        if (!batch->results) return PC_ERR_IO;
+    }
+    
+    uint32_t count = batch->count;
+    if (count == 0) return PC_OK;
+    
+    // Intermediate roots are replayed on top of a clean tree
+    if (pc_merkle_update(&state->merkle, state) != PC_OK) {
+        return pc_batch_execute(state, batch);
+    }
+    
+    uint32_t map_cap = 16;
+    while (map_cap < (uint64_t)count * 4) map_cap <<= 1;
+    
+    BatchSlot* slots = malloc(count * sizeof(BatchSlot));
+    const PCTransaction** txs = malloc(count * sizeof(PCTransaction*));
+    int* sig_ok = malloc(count * sizeof(int));
+    uint32_t* parent = malloc(count * sizeof(uint32_t));
+    uint32_t* order = malloc(count * sizeof(uint32_t));
+    uint32_t* group_start = malloc((count + 1) * sizeof(uint32_t));
+    uint64_t* map = calloc(map_cap, sizeof(uint64_t));
+    uint32_t* leaves = malloc(count * 3 * sizeof(uint32_t));
+    uint8_t* hashes = malloc((size_t)count * 3 * 32);
+    
+    if (!slots || !txs || !sig_ok || !parent || !order || !group_start ||
+        !map || !leaves || !hashes) {
+        free(slots); free(txs); free(sig_ok); free(parent); free(order);
+        free(group_start); free(map); free(leaves); free(hashes);
+        return pc_batch_execute(state, batch);
+    }
+    
+    int* results = batch->results;
+    
+    // Phase 1: all signatures at once
+    for (uint32_t i = 0; i < count; i++) {
+        txs[i] = &batch->transactions[i];
+    }
+    pc_transaction_verify_batch(txs, (int)count, sig_ok);
+    
+    // Phase 2: resolve wallets in batch order, creating recipients exactly
+    // where sequential execution would (even if the transfer later fails)
+    for (uint32_t i = 0; i < count; i++) {
+        const PCTransaction* tx = txs[i];
+        BatchSlot* slot = &slots[i];
         
-        if (err == PC_OK) {
-            batch->successful++;
-        } else {
+        slot->created = NO_WALLET;
+        parent[i] = i;
+        results[i] = PC_OK;
+        
+        if (!sig_ok[i]) {
+            results[i] = PC_ERR_INVALID_SIGNATURE;
+        } else if (pc_state_find_index(state, tx->from, &slot->from_idx) != PC_OK) {
+            results[i] = PC_ERR_WALLET_NOT_FOUND;
+        } else if (pc_state_find_index(state, tx->to, &slot->to_idx) != PC_OK) {
+            PCError err = pc_state_create_wallet(state, tx->to, 0);
+            if (err != PC_OK) {
+                results[i] = err;
+            } else {
+                slot->created = state->num_wallets - 1;
+                slot->to_idx = slot->created;
+            }
+        }
+        slot->num_wallets = state->num_wallets;
+    }
+    
+    // Phase 3: conflict groups over the wallets each transaction touches;
+    // their pages are readied for writing before the concurrent phase
+    for (uint32_t i = 0; i < count; i++) {
+        if (results[i] != PC_OK) continue;
+        if (pc_state_mark_dirty(state, slots[i].from_idx) != PC_OK ||
+            pc_state_mark_dirty(state, slots[i].to_idx) != PC_OK) {
+            results[i] = PC_ERR_IO;
+            continue;
+        }
+        link_wallet(map, map_cap - 1, parent, slots[i].from_idx, i);
+        link_wallet(map, map_cap - 1, parent, slots[i].to_idx, i);
+    }
+    
+    // Bucket transactions by group root, keeping batch order inside a group
+    memset(group_start, 0, (count + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        if (results[i] != PC_OK) continue;
+        parent[i] = uf_find(parent, i);
+        group_start[parent[i] + 1]++;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        group_start[i + 1] += group_start[i];
+    }
+    uint32_t* fill = leaves;  // Scratch cursor per root
+    memcpy(fill, group_start, count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        if (results[i] != PC_OK) continue;
+        order[fill[parent[i]]++] = i;
+    }
+    
+    // Phase 4: groups own disjoint wallets and run concurrently
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (uint32_t root = 0; root < count; root++) {
+        for (uint32_t k = group_start[root]; k < group_start[root + 1]; k++) {
+            uint32_t i = order[k];
+            BatchSlot* slot = &slots[i];
+            PCWallet* from = pc_state_wallet_mut(state, slot->from_idx);
+            PCWallet* to = pc_state_wallet_mut(state, slot->to_idx);
+            
+            results[i] = pc_state_transfer(from, to, txs[i]);
+            if (results[i] == PC_OK) {
+                pc_merkle_leaf_hash(pc_state_key_at(state, slot->from_idx), from, slot->from_leaf);
+                pc_merkle_leaf_hash(pc_state_key_at(state, slot->to_idx), to, slot->to_leaf);
+            }
+        }
+    }
+    
+    // Phase 5: replay leaf updates and the hash chain in batch order
+    uint64_t now = (uint64_t)time(NULL);
+    uint32_t pending = 0;
+    PCError status = PC_OK;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        BatchSlot* slot = &slots[i];
+        
+        if (slot->created != NO_WALLET) {
+            PCWallet fresh = {0};
+            leaves[pending] = slot->created;
+            pc_merkle_leaf_hash(txs[i]->to, &fresh, hashes + (size_t)pending * 32);
+            pending++;
+        }
+        
+        if (results[i] != PC_OK) {
             batch->failed++;
+            continue;
         }
+        batch->successful++;
+        
+        leaves[pending] = slot->from_idx;
+        memcpy(hashes + (size_t)pending * 32, slot->from_leaf, 32);
+        pending++;
+        leaves[pending] = slot->to_idx;
+        memcpy(hashes + (size_t)pending * 32, slot->to_leaf, 32);
+        pending++;
+        
+        if (status == PC_OK) {
+            status = pc_merkle_set_leaves(&state->merkle, slot->num_wallets,
+                                          leaves, hashes, pending);
+        }
+        pending = 0;
+        
+        uint8_t root[PHYSICSCOIN_HASH_SIZE];
+        pc_merkle_root(&state->merkle, root);
+        state->timestamp = now;
+        memcpy(state->prev_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+        pc_state_hash_header(state, slot->num_wallets, root, state->state_hash);
     }
     
-    return PC_OK;
+    // Wallets created by trailing failed transactions
+    if (pending > 0 && status == PC_OK) {
+        status = pc_merkle_set_leaves(&state->merkle, state->num_wallets, leaves, hashes, pending);
+    }
+    if (status != PC_OK) {
+        pc_merkle_invalidate(&state->merkle);
+    }
+    
+    free(slots); free(txs); free(sig_ok); free(parent); free(order);
+    free(group_start); free(map); free(leaves); free(hashes);
+    
+    return status;
 }
 
 // Get conflict report
@@ -86,7 +86,7 @@ uint64_t pc_faucet_time_until_next(const uint8_t* address) {
 }
 
 // Request faucet funds
-PCError pc_faucet_request(PCState* state, const uint8_t* address, double* amount_out) {
+PCError pc_faucet_request(PCState* state, const uint8_t* address, PCAmount* amount_out) {
     if (!g_initialized) pc_faucet_init();
     
     const PCNetworkConfig* config = pc_network_get_config(pc_network_get_current());
@@ -104,14 +104,15 @@ PCError pc_faucet_request(PCState* state, const uint8_t* address, double* amount
     // Get or create wallet
     PCWallet* wallet = pc_state_get_wallet(state, address);
     if (!wallet) {
-        PCError err = pc_state_create_wallet(state, address, 0.0);
+        PCError err = pc_state_create_wallet(state, address, 0);
         if (err != PC_OK) return err;
         wallet = pc_state_get_wallet(state, address);
     }
     
-    // Add funds
-    wallet->energy += config->faucet_amount;
-    state->total_supply += config->faucet_amount;
+    // Add funds (config is in coins)
+    PCAmount grant = pc_amount_from_coins(config->faucet_amount);
+    wallet->energy += grant;
+    state->total_supply += grant;
     
     // Record request
     PCFaucetRecord* record = faucet_find_record(address);
@@ -129,7 +130,7 @@ PCError pc_faucet_request(PCState* state, const uint8_t* address, double* amount
     record->last_request_time = (uint64_t)time(NULL);
     faucet_save();
     
-    if (amount_out) *amount_out = config->faucet_amount;
+    if (amount_out) *amount_out = grant;
     
     return PC_OK;
 }
@@ -0,0 +1,363 @@
+// merkle.c - Incremental Merkle commitment over the wallet set
+// Leaves are wallets in index order; a transfer rehashes two leaf paths
+
+#include "../include/physicscoin.h"
+#include "../crypto/sha256.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Domain separation between leaf and interior hashes
+#define LEAF_PREFIX 0x00
+#define NODE_PREFIX 0x01
+
+// Above this fraction of dirty leaves a full rebuild is cheaper
+#define REBUILD_DIVISOR 4
+
+// Full rebuilds hash this many nodes per sha256_many call
+#define HASH_CHUNK 64
+
+#define LEAF_MSG_SIZE (1 + PHYSICSCOIN_KEY_SIZE + sizeof(PCAmount) + sizeof(uint64_t))
+#define NODE_MSG_SIZE (1 + 64)
+
+// zero_hash[k] = root of an empty subtree of height k (pads a missing right child)
+static uint8_t zero_hash[PC_MERKLE_MAX_DEPTH + 1][32];
+
+static void node_message(const uint8_t* left, const uint8_t* right, uint8_t* buf) {
+    buf[0] = NODE_PREFIX;
+    memcpy(buf + 1, left, 32);
+    memcpy(buf + 33, right, 32);
+}
+
+static void hash_node(const uint8_t* left, const uint8_t* right, uint8_t* out) {
+    uint8_t buf[NODE_MSG_SIZE];
+    node_message(left, right, buf);
+    sha256(buf, sizeof(buf), out);
+}
+
+__attribute__((constructor))
+static void zero_hash_init(void) {
+    memset(zero_hash[0], 0, 32);
+    for (int k = 0; k < PC_MERKLE_MAX_DEPTH; k++) {
+        hash_node(zero_hash[k], zero_hash[k], zero_hash[k + 1]);
+    }
+}
+
+// Nodes present at a level for n leaves
+static inline uint32_t level_count(uint32_t n, uint32_t level) {
+    return (uint32_t)(((uint64_t)n + ((1ULL << level) - 1)) >> level);
+}
+
+// Level holding the root (0 for a single leaf)
+static uint32_t top_level(uint32_t n) {
+    uint32_t k = 0;
+    while (level_count(n, k) > 1) k++;
+    return k;
+}
+
+static void leaf_message(const uint8_t* pubkey, const PCWallet* wallet, uint8_t* buf) {
+    size_t off = 0;
+    buf[off++] = LEAF_PREFIX;
+    memcpy(buf + off, pubkey, PHYSICSCOIN_KEY_SIZE); off += PHYSICSCOIN_KEY_SIZE;
+    memcpy(buf + off, &wallet->energy, sizeof(wallet->energy)); off += sizeof(wallet->energy);
+    memcpy(buf + off, &wallet->nonce, sizeof(wallet->nonce));
+}
+
+void pc_merkle_leaf_hash(const uint8_t* pubkey, const PCWallet* wallet, uint8_t* hash_out) {
+    uint8_t buf[LEAF_MSG_SIZE];
+    leaf_message(pubkey, wallet, buf);
+    sha256(buf, sizeof(buf), hash_out);
+}
+
+// Leaves [first, first + count) in one multi-buffer call (count <= HASH_CHUNK)
+static void hash_leaf_run(PCMerkleTree* tree, const PCState* state, uint32_t first, uint32_t count) {
+    uint8_t bufs[HASH_CHUNK][LEAF_MSG_SIZE];
+    const uint8_t* msgs[HASH_CHUNK];
+    size_t lens[HASH_CHUNK];
+    for (uint32_t i = 0; i < count; i++) {
+        leaf_message(pc_state_key_at(state, first + i), pc_state_wallet_at(state, first + i), bufs[i]);
+        msgs[i] = bufs[i];
+        lens[i] = LEAF_MSG_SIZE;
+    }
+    sha256_many(msgs, lens, count, (uint8_t (*)[32])(tree->levels[0] + (size_t)first * 32));
+}
+
+// Parents [first, first + count) of level k + 1 in one multi-buffer call
+static void hash_parent_run(PCMerkleTree* tree, uint32_t k, uint32_t first, uint32_t count,
+                            uint32_t child_count) {
+    uint8_t bufs[HASH_CHUNK][NODE_MSG_SIZE];
+    const uint8_t* msgs[HASH_CHUNK];
+    size_t lens[HASH_CHUNK];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t j = first + i;
+        const uint8_t* left = tree->levels[k] + (size_t)(2 * j) * 32;
+        const uint8_t* right = (2 * j + 1 < child_count) ?
+                               tree->levels[k] + (size_t)(2 * j + 1) * 32 : zero_hash[k];
+        node_message(left, right, bufs[i]);
+        msgs[i] = bufs[i];
+        lens[i] = NODE_MSG_SIZE;
+    }
+    sha256_many(msgs, lens, count, (uint8_t (*)[32])(tree->levels[k + 1] + (size_t)first * 32));
+}
+
+// Recompute node j of level k+1 from its children
+static void update_parent(PCMerkleTree* tree, uint32_t k, uint32_t j, uint32_t child_count) {
+    const uint8_t* left = tree->levels[k] + (size_t)(2 * j) * 32;
+    const uint8_t* right = (2 * j + 1 < child_count) ?
+                           tree->levels[k] + (size_t)(2 * j + 1) * 32 : zero_hash[k];
+    hash_node(left, right, tree->levels[k + 1] + (size_t)j * 32);
+}
+
+// Make room for the node counts of n leaves on every level
+static PCError reserve_levels(PCMerkleTree* tree, uint32_t n) {
+    uint32_t top = top_level(n);
+    for (uint32_t k = 0; k <= top; k++) {
+        uint32_t need = level_count(n, k);
+        if (need <= tree->level_capacity[k]) continue;
+
+        uint64_t cap = tree->level_capacity[k] ? tree->level_capacity[k] : 8;
+        while (cap < need) cap *= 2;
+        if (cap > UINT32_MAX) cap = UINT32_MAX;
+
+        uint8_t* grown = realloc(tree->levels[k], (size_t)cap * 32);
+        if (!grown) return PC_ERR_IO;
+        tree->levels[k] = grown;
+        tree->level_capacity[k] = (uint32_t)cap;
+    }
+    return PC_OK;
+}
+
+static void clear_dirty(PCMerkleTree* tree) {
+    if (tree->dirty_bits) memset(tree->dirty_bits, 0, tree->dirty_bits_size);
+    tree->num_dirty = 0;
+}
+
+// Hash every leaf and level from scratch
+static PCError merkle_rebuild(PCMerkleTree* tree, const PCState* state) {
+    uint32_t n = state->num_wallets;
+
+    PCError err = reserve_levels(tree, n);
+    if (err != PC_OK) return err;
+
+    #pragma omp parallel for schedule(static) if(n > 4096)
+    for (uint32_t i = 0; i < n; i += HASH_CHUNK) {
+        hash_leaf_run(tree, state, i, n - i < HASH_CHUNK ? n - i : HASH_CHUNK);
+    }
+
+    uint32_t top = top_level(n);
+    for (uint32_t k = 0; k < top; k++) {
+        uint32_t children = level_count(n, k);
+        uint32_t parents = level_count(n, k + 1);
+        #pragma omp parallel for schedule(static) if(parents > 4096)
+        for (uint32_t j = 0; j < parents; j += HASH_CHUNK) {
+            hash_parent_run(tree, k, j, parents - j < HASH_CHUNK ? parents - j : HASH_CHUNK, children);
+        }
+    }
+
+    tree->num_leaves = n;
+    tree->needs_rebuild = 0;
+    clear_dirty(tree);
+    return PC_OK;
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Recompute the ancestors of sorted leaves (cur is overwritten) for a tree of n leaves
+static void rehash_paths(PCMerkleTree* tree, uint32_t n, uint32_t* cur, uint32_t count) {
+    uint32_t top = top_level(n);
+    for (uint32_t k = 0; k < top; k++) {
+        uint32_t children = level_count(n, k);
+        uint32_t out = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t parent = cur[i] >> 1;
+            if (out > 0 && cur[out - 1] == parent) continue;
+            cur[out++] = parent;
+        }
+        count = out;
+        for (uint32_t i = 0; i < count; i++) {
+            update_parent(tree, k, cur[i], children);
+        }
+    }
+    tree->num_leaves = n;
+}
+
+void pc_merkle_free(PCMerkleTree* tree) {
+    if (!tree) return;
+    for (int k = 0; k <= PC_MERKLE_MAX_DEPTH; k++) {
+        free(tree->levels[k]);
+    }
+    free(tree->dirty);
+    free(tree->dirty_bits);
+    memset(tree, 0, sizeof(PCMerkleTree));
+}
+
+PCError pc_merkle_clone(PCMerkleTree* dst, const PCMerkleTree* src) {
+    memset(dst, 0, sizeof(PCMerkleTree));
+
+    // Pending leaves are not carried over; a stale source yields a stale copy
+    if (src->needs_rebuild || src->num_dirty > 0) {
+        dst->needs_rebuild = 1;
+        return PC_OK;
+    }
+
+    uint32_t n = src->num_leaves;
+    if (n > 0) {
+        uint32_t top = top_level(n);
+        for (uint32_t k = 0; k <= top; k++) {
+            uint32_t count = level_count(n, k);
+            dst->levels[k] = malloc((size_t)count * 32);
+            if (!dst->levels[k]) {
+                pc_merkle_free(dst);
+                return PC_ERR_IO;
+            }
+            memcpy(dst->levels[k], src->levels[k], (size_t)count * 32);
+            dst->level_capacity[k] = count;
+        }
+    }
+    dst->num_leaves = n;
+    return PC_OK;
+}
+
+void pc_merkle_invalidate(PCMerkleTree* tree) {
+    clear_dirty(tree);
+    tree->needs_rebuild = 1;
+}
+
+void pc_merkle_mark_dirty(PCMerkleTree* tree, uint32_t leaf) {
+    if (tree->needs_rebuild) return;
+
+    uint32_t byte = leaf >> 3;
+    if (byte >= tree->dirty_bits_size) {
+        uint64_t size = tree->dirty_bits_size ? tree->dirty_bits_size : 64;
+        while (size <= byte) size *= 2;
+        uint8_t* bits = realloc(tree->dirty_bits, size);
+        if (!bits) { tree->needs_rebuild = 1; return; }
+        memset(bits + tree->dirty_bits_size, 0, size - tree->dirty_bits_size);
+        tree->dirty_bits = bits;
+        tree->dirty_bits_size = (uint32_t)size;
+    }
+
+    uint8_t bit = (uint8_t)(1u << (leaf & 7));
+    if (tree->dirty_bits[byte] & bit) return;
+
+    if (tree->num_dirty >= tree->dirty_capacity) {
+        uint32_t cap = tree->dirty_capacity ? tree->dirty_capacity * 2 : 16;
+        uint32_t* list = realloc(tree->dirty, cap * sizeof(uint32_t));
+        if (!list) { tree->needs_rebuild = 1; return; }
+        tree->dirty = list;
+        tree->dirty_capacity = cap;
+    }
+
+    tree->dirty_bits[byte] |= bit;
+    tree->dirty[tree->num_dirty++] = leaf;
+}
+
+PCError pc_merkle_update(PCMerkleTree* tree, const PCState* state) {
+    uint32_t n = state->num_wallets;
+
+    if (n < tree->num_leaves ||
+        (uint64_t)tree->num_dirty + (n - tree->num_leaves) > n / REBUILD_DIVISOR) {
+        tree->needs_rebuild = 1;
+    }
+
+    // Wallets appended since the last update are new leaves
+    for (uint32_t i = tree->num_leaves; i < n && !tree->needs_rebuild; i++) {
+        pc_merkle_mark_dirty(tree, i);
+    }
+
+    if (tree->needs_rebuild) return merkle_rebuild(tree, state);
+    if (tree->num_dirty == 0) return PC_OK;
+
+    PCError err = reserve_levels(tree, n);
+    if (err != PC_OK) return err;
+
+    // Rehash touched leaves, then walk their paths up one level at a time
+    uint32_t* cur = tree->dirty;
+    uint32_t count = tree->num_dirty;
+    qsort(cur, count, sizeof(uint32_t), cmp_u32);
+
+    for (uint32_t i = 0; i < count; i++) {
+        pc_merkle_leaf_hash(pc_state_key_at(state, cur[i]), pc_state_wallet_at(state, cur[i]),
+                            tree->levels[0] + (size_t)cur[i] * 32);
+        tree->dirty_bits[cur[i] >> 3] = 0;
+    }
+
+    rehash_paths(tree, n, cur, count);
+    tree->num_dirty = 0;
+    return PC_OK;
+}
+
+PCError pc_merkle_set_leaves(PCMerkleTree* tree, uint32_t num_leaves,
+                             uint32_t* leaves, const uint8_t* hashes, uint32_t count) {
+    if (tree->needs_rebuild || tree->num_dirty > 0) return PC_ERR_INVALID_STATE;
+    if (num_leaves < tree->num_leaves) return PC_ERR_INVALID_STATE;
+    if (count == 0 && num_leaves == tree->num_leaves) return PC_OK;
+
+    PCError err = reserve_levels(tree, num_leaves);
+    if (err != PC_OK) return err;
+
+    // Later entries for the same leaf win
+    for (uint32_t i = 0; i < count; i++) {
+        if (leaves[i] >= num_leaves) return PC_ERR_INVALID_DATA;
+        memcpy(tree->levels[0] + (size_t)leaves[i] * 32, hashes + (size_t)i * 32, 32);
+    }
+
+    qsort(leaves, count, sizeof(uint32_t), cmp_u32);
+    rehash_paths(tree, num_leaves, leaves, count);
+    return PC_OK;
+}
+
+void pc_merkle_root(const PCMerkleTree* tree, uint8_t* root_out) {
+    if (tree->num_leaves == 0) {
+        memset(root_out, 0, 32);
+        return;
+    }
+    memcpy(root_out, tree->levels[top_level(tree->num_leaves)], 32);
+}
+
+PCError pc_merkle_proof(const PCMerkleTree* tree, uint32_t leaf, PCMerkleProof* proof) {
+    if (!tree || !proof) return PC_ERR_IO;
+    if (tree->needs_rebuild || tree->num_dirty > 0) return PC_ERR_INVALID_STATE;
+    if (leaf >= tree->num_leaves) return PC_ERR_NOT_FOUND;
+
+    uint32_t n = tree->num_leaves;
+    uint32_t top = top_level(n);
+    uint32_t idx = leaf;
+
+    proof->leaf_index = leaf;
+    proof->depth = top;
+    for (uint32_t k = 0; k < top; k++) {
+        uint32_t sib = idx ^ 1;
+        if (sib < level_count(n, k)) {
+            memcpy(proof->siblings[k], tree->levels[k] + (size_t)sib * 32, 32);
+        } else {
+            memcpy(proof->siblings[k], zero_hash[k], 32);
+        }
+        idx >>= 1;
+    }
+    return PC_OK;
+}
+
+PCError pc_merkle_verify_proof(const uint8_t* root, const uint8_t* pubkey, const PCWallet* wallet,
+                               const PCMerkleProof* proof) {
+    if (!root || !pubkey || !wallet || !proof) return PC_ERR_IO;
+    if (proof->depth > PC_MERKLE_MAX_DEPTH) return PC_ERR_INVALID_DATA;
+
+    uint8_t h[32];
+    pc_merkle_leaf_hash(pubkey, wallet, h);
+
+    uint32_t idx = proof->leaf_index;
+    for (uint32_t k = 0; k < proof->depth; k++) {
+        if (idx & 1) {
+            hash_node(proof->siblings[k], h, h);
+        } else {
+            hash_node(h, proof->siblings[k], h);
+        }
+        idx >>= 1;
+    }
+    if (idx != 0) return PC_ERR_INVALID_DATA;
+
+    return memcmp(h, root, 32) == 0 ? PC_OK : PC_ERR_INVALID_DATA;
+}
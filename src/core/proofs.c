@@ -12,7 +12,7 @@
 typedef struct {
     uint8_t state_hash[32];      // The state being proven
     uint8_t wallet_pubkey[32];   // Wallet in question
-    double balance;               // Claimed balance
+    PCAmount balance;             // Claimed balance
     uint64_t nonce;               // Wallet nonce at that time
     uint64_t timestamp;           // When proof was generated
     uint8_t proof_hash[32];       // Hash binding all fields
@@ -23,13 +23,7 @@ PCError pc_proof_generate(const PCState* state, const uint8_t* pubkey, PCBalance
     if (!state || !pubkey || !proof) return PC_ERR_IO;
     
     // Find wallet
-    PCWallet* wallet = NULL;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (memcmp(state->wallets[i].public_key, pubkey, PHYSICSCOIN_KEY_SIZE) == 0) {
-            wallet = &state->wallets[i];
-            break;
-        }
-    }
+    const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
     
     if (!wallet) return PC_ERR_WALLET_NOT_FOUND;
     
@@ -45,7 +39,7 @@ PCError pc_proof_generate(const PCState* state, const uint8_t* pubkey, PCBalance
     sha256_init(&ctx);
     sha256_update(&ctx, proof->state_hash, 32);
     sha256_update(&ctx, proof->wallet_pubkey, 32);
-    sha256_update(&ctx, (uint8_t*)&proof->balance, sizeof(double));
+    sha256_update(&ctx, (uint8_t*)&proof->balance, sizeof(PCAmount));
     sha256_update(&ctx, (uint8_t*)&proof->nonce, sizeof(uint64_t));
     sha256_update(&ctx, (uint8_t*)&proof->timestamp, sizeof(uint64_t));
     sha256_final(&ctx, proof->proof_hash);
@@ -63,13 +57,7 @@ PCError pc_proof_verify(const PCState* state, const PCBalanceProof* proof) {
     }
     
     // Find wallet and verify balance
-    PCWallet* wallet = NULL;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (memcmp(state->wallets[i].public_key, proof->wallet_pubkey, 32) == 0) {
-            wallet = &state->wallets[i];
-            break;
-        }
-    }
+    const PCWallet* wallet = pc_state_find_wallet(state, proof->wallet_pubkey);
     
     if (!wallet) return PC_ERR_WALLET_NOT_FOUND;
     
@@ -84,7 +72,7 @@ PCError pc_proof_verify(const PCState* state, const PCBalanceProof* proof) {
     sha256_init(&ctx);
     sha256_update(&ctx, proof->state_hash, 32);
     sha256_update(&ctx, proof->wallet_pubkey, 32);
-    sha256_update(&ctx, (uint8_t*)&proof->balance, sizeof(double));
+    sha256_update(&ctx, (uint8_t*)&proof->balance, sizeof(PCAmount));
     sha256_update(&ctx, (uint8_t*)&proof->nonce, sizeof(uint64_t));
     sha256_update(&ctx, (uint8_t*)&proof->timestamp, sizeof(uint64_t));
     sha256_final(&ctx, computed_hash);
@@ -143,7 +131,7 @@ void pc_proof_print(const PCBalanceProof* proof) {
     for (int i = 0; i < 16; i++) printf("%02x", proof->wallet_pubkey[i]);
     printf("...\n");
     
-    printf("  Balance:    %.8f\n", proof->balance);
+    printf("  Balance:    %.8f\n", pc_amount_to_coins(proof->balance));
     printf("  Nonce:      %lu\n", proof->nonce);
     printf("  Timestamp:  %lu\n", proof->timestamp);
     
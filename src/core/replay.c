@@ -2,21 +2,44 @@
 // Deterministically verify state by replaying transaction history
 
 #include "../include/physicscoin.h"
+#include "../include/replay.h"
 #include "../crypto/sha256.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 #define MAX_REPLAY_TRANSACTIONS 100000
+#define REPLAY_CHUNK 1000
+#define REPLAY_PROGRESS_STEPS 100  // Progress lines per replay, at most
+#define REPLAY_MAX_GENESIS_BYTES (1ull << 34)  // Larger sizes in a file are corruption
+
+// Hands out the next chunk of transactions in log order: either a pointer
+// into the source or a copy in buf. Returns the count, 0 at the end.
+typedef uint32_t (*ReplayReadFn)(void* ctx, const PCTransaction** txs, PCTransaction* buf, uint32_t max);
 
-// Replay log structure
 typedef struct {
-    PCState genesis;                     // Initial state
-    PCTransaction* transactions;         // All transactions in order
-    uint32_t num_transactions;
-    uint8_t expected_final_hash[32];    // What we expect at the end
-} PCReplayLog;
+    const PCReplayLog* log;
+    uint32_t position;
+} LogCursor;
+
+static uint32_t read_log(void* ctx, const PCTransaction** txs, PCTransaction* buf, uint32_t max) {
+    (void)buf;
+    LogCursor* cursor = ctx;
+    uint32_t n = cursor->log->num_transactions - cursor->position;
+    if (n > max) n = max;
+    *txs = &cursor->log->transactions[cursor->position];
+    cursor->position += n;
+    return n;
+}
+
+static uint32_t read_stream(void* ctx, const PCTransaction** txs, PCTransaction* buf, uint32_t max) {
+    *txs = buf;
+    return pc_replay_stream_read(ctx, buf, max);
+}
 
 // Create a new replay log from genesis
 PCError pc_replay_init(PCReplayLog* log, const PCState* genesis) {
@@ -25,22 +48,11 @@ PCError pc_replay_init(PCReplayLog* log, const PCState* genesis) {
     memset(log, 0, sizeof(PCReplayLog));
     
     // Deep copy genesis state
-    log->genesis.version = genesis->version;
-    log->genesis.total_supply = genesis->total_supply;
-    log->genesis.num_wallets = genesis->num_wallets;
-    log->genesis.timestamp = genesis->timestamp;
-    memcpy(log->genesis.state_hash, genesis->state_hash, 32);
-    memcpy(log->genesis.prev_hash, genesis->prev_hash, 32);
-    
-    log->genesis.wallets = malloc(genesis->num_wallets * sizeof(PCWallet));
-    if (!log->genesis.wallets) return PC_ERR_IO;
-    
-    memcpy(log->genesis.wallets, genesis->wallets, 
-           genesis->num_wallets * sizeof(PCWallet));
+    if (pc_state_clone(&log->genesis, genesis) != PC_OK) return PC_ERR_IO;
     
     log->transactions = calloc(MAX_REPLAY_TRANSACTIONS, sizeof(PCTransaction));
     if (!log->transactions) {
-        free(log->genesis.wallets);
+        pc_state_free(&log->genesis);
         return PC_ERR_IO;
     }
     
@@ -62,49 +74,58 @@ PCError pc_replay_add_tx(PCReplayLog* log, const PCTransaction* tx) {
     return PC_OK;
 }
 
-// Replay all transactions and verify final state
-PCError pc_replay_verify(const PCReplayLog* log, const uint8_t* expected_hash) {
-    if (!log) return PC_ERR_IO;
-    
+// Replay every transaction from source and verify the final state
+static PCError replay_verify(const PCState* genesis, uint32_t total, ReplayReadFn read, void* ctx,
+                             const uint8_t* expected_hash) {
     printf("═══ REPLAY VERIFICATION ═══\n");
     printf("Genesis hash: ");
-    for (int i = 0; i < 8; i++) printf("%02x", log->genesis.state_hash[i]);
+    for (int i = 0; i < 8; i++) printf("%02x", genesis->state_hash[i]);
     printf("...\n");
-    printf("Replaying %u transactions...\n", log->num_transactions);
+    printf("Replaying %u transactions...\n", total);
     
     // Create working state from genesis
     PCState state;
-    state.version = log->genesis.version;
-    state.total_supply = log->genesis.total_supply;
-    state.num_wallets = log->genesis.num_wallets;
-    state.timestamp = log->genesis.timestamp;
-    memcpy(state.state_hash, log->genesis.state_hash, 32);
-    memcpy(state.prev_hash, log->genesis.prev_hash, 32);
-    
-    state.wallets = malloc(log->genesis.num_wallets * sizeof(PCWallet));
-    if (!state.wallets) return PC_ERR_IO;
-    memcpy(state.wallets, log->genesis.wallets, 
-           log->genesis.num_wallets * sizeof(PCWallet));
-    
-    // Replay each transaction
+    PCTransaction* buf = malloc(REPLAY_CHUNK * sizeof(PCTransaction));
+    if (!buf) return PC_ERR_IO;
+    if (pc_state_clone(&state, genesis) != PC_OK) {
+        free(buf);
+        return PC_ERR_IO;
+    }
+    
+    // Long logs report progress in percent-sized steps, short ones per chunk
+    uint32_t progress_every = total / REPLAY_PROGRESS_STEPS / REPLAY_CHUNK * REPLAY_CHUNK;
+    if (progress_every < REPLAY_CHUNK) progress_every = REPLAY_CHUNK;
+    
+    // Replay in chunks: signatures of a chunk are verified in parallel first
     uint32_t successful = 0;
     uint32_t failed = 0;
+    uint32_t base = 0;
+    int results[REPLAY_CHUNK];
+    const PCTransaction* txs;
+    uint32_t n;
     
-    for (uint32_t i = 0; i < log->num_transactions; i++) {
-        PCError err = pc_state_execute_tx(&state, &log->transactions[i]);
+    while (base < total && (n = read(ctx, &txs, buf, REPLAY_CHUNK)) > 0) {
+        successful += pc_state_execute_batch(&state, txs, n, results);
         
-        if (err == PC_OK) {
-            successful++;
-        } else {
-            failed++;
-            printf("  TX %u failed: %s\n", i, pc_strerror(err));
+        for (uint32_t k = 0; k < n; k++) {
+            if (results[k] != PC_OK) {
+                failed++;
+                printf("  TX %u failed: %s\n", base + k, pc_strerror(results[k]));
+            }
         }
         
-        // Progress indicator every 1000 tx
-        if ((i + 1) % 1000 == 0) {
-            printf("  Processed %u/%u...\n", i + 1, log->num_transactions);
+        base += n;
+        if (n == REPLAY_CHUNK && base % progress_every == 0) {
+            printf("  Processed %u/%u...\n", base, total);
         }
     }
+    free(buf);
+    
+    if (base < total) {
+        printf("\n✗ Replay log ended after %u of %u transactions\n", base, total);
+        pc_state_free(&state);
+        return PC_ERR_IO;
+    }
     
     printf("\nReplay complete:\n");
     printf("  Successful: %u\n", successful);
@@ -138,37 +159,213 @@ PCError pc_replay_verify(const PCReplayLog* log, const uint8_t* expected_hash) {
     return PC_OK;
 }
 
-// Replay and return final state (for inspection)
-PCError pc_replay_execute(const PCReplayLog* log, PCState* final_state) {
-    if (!log || !final_state) return PC_ERR_IO;
+// Replay every transaction from source into final_state
+static PCError replay_execute(const PCState* genesis, uint32_t total, ReplayReadFn read, void* ctx,
+                              PCState* final_state) {
+    PCTransaction* buf = malloc(REPLAY_CHUNK * sizeof(PCTransaction));
+    if (!buf) return PC_ERR_IO;
     
     // Initialize from genesis
-    final_state->version = log->genesis.version;
-    final_state->total_supply = log->genesis.total_supply;
-    final_state->num_wallets = log->genesis.num_wallets;
-    final_state->timestamp = log->genesis.timestamp;
-    memcpy(final_state->state_hash, log->genesis.state_hash, 32);
-    memcpy(final_state->prev_hash, log->genesis.prev_hash, 32);
-    
-    final_state->wallets = malloc(log->genesis.num_wallets * sizeof(PCWallet));
-    if (!final_state->wallets) return PC_ERR_IO;
-    memcpy(final_state->wallets, log->genesis.wallets,
-           log->genesis.num_wallets * sizeof(PCWallet));
-    
-    // Execute all transactions
-    for (uint32_t i = 0; i < log->num_transactions; i++) {
-        pc_state_execute_tx(final_state, &log->transactions[i]);
+    if (pc_state_clone(final_state, genesis) != PC_OK) {
+        free(buf);
+        return PC_ERR_IO;
     }
     
-    return PC_OK;
+    // Execute in chunks (signatures of each chunk verified in parallel)
+    uint32_t done = 0;
+    const PCTransaction* txs;
+    uint32_t n;
+    while (done < total && (n = read(ctx, &txs, buf, REPLAY_CHUNK)) > 0) {
+        pc_state_execute_batch(final_state, txs, n, NULL);
+        done += n;
+    }
+    
+    free(buf);
+    return done == total ? PC_OK : PC_ERR_IO;
+}
+
+// Replay all transactions and verify final state
+PCError pc_replay_verify(const PCReplayLog* log, const uint8_t* expected_hash) {
+    if (!log) return PC_ERR_IO;
+    
+    LogCursor cursor = { log, 0 };
+    return replay_verify(&log->genesis, log->num_transactions, read_log, &cursor, expected_hash);
+}
+
+// One slice of the log, replayed from its own starting snapshot
+typedef struct {
+    const PCState* start;          // Genesis or a checkpoint snapshot
+    uint32_t first_tx;
+    uint32_t end_tx;               // Exclusive
+    const uint8_t* end_root;       // Wallet root of the closing checkpoint (NULL = last segment)
+    const PCState* end_state;      // Closing checkpoint snapshot
+    uint32_t successful;
+    uint32_t failed;
+    uint8_t final_hash[32];
+    PCError result;
+} ReplaySegment;
+
+// Wallet root of a checkpoint snapshot, checked against the snapshot's hash
+static PCError checkpoint_root(const PCStateCheckpoint* cp, uint8_t* root) {
+    PCMerkleTree tree;
+    memset(&tree, 0, sizeof(tree));
+    pc_merkle_invalidate(&tree);
+    PCError err = pc_merkle_update(&tree, &cp->state);
+    if (err != PC_OK) {
+        pc_merkle_free(&tree);
+        return err;
+    }
+    pc_merkle_root(&tree, root);
+    pc_merkle_free(&tree);
+    
+    uint8_t hash[32];
+    pc_state_hash_header(&cp->state, cp->state.num_wallets, root, hash);
+    return memcmp(hash, cp->state_hash, 32) == 0 ? PC_OK : PC_ERR_INVALID_STATE;
+}
+
+static void replay_segment(const PCReplayLog* log, ReplaySegment* seg) {
+    PCState state;
+    if (pc_state_clone(&state, seg->start) != PC_OK) {
+        seg->result = PC_ERR_IO;
+        return;
+    }
+    
+    int results[REPLAY_CHUNK];
+    for (uint32_t base = seg->first_tx; base < seg->end_tx; base += REPLAY_CHUNK) {
+        uint32_t n = seg->end_tx - base;
+        if (n > REPLAY_CHUNK) n = REPLAY_CHUNK;
+        
+        uint32_t ok = pc_state_execute_batch(&state, &log->transactions[base], n, results);
+        seg->successful += ok;
+        seg->failed += n - ok;
+    }
+    
+    // State hashes carry the time each transaction executed, so an inner
+    // boundary is checked on the wallet commitment they are built from
+    seg->result = pc_state_verify_conservation(&state);
+    if (seg->result == PC_OK && seg->end_root) {
+        uint8_t root[32];
+        pc_state_merkle_root(&state, root);
+        if (memcmp(root, seg->end_root, 32) != 0 ||
+            state.num_wallets != seg->end_state->num_wallets ||
+            state.total_supply != seg->end_state->total_supply) {
+            seg->result = PC_ERR_INVALID_STATE;
+        }
+    }
+    memcpy(seg->final_hash, state.state_hash, 32);
+    pc_state_free(&state);
+}
+
+// Replay segments between checkpoints concurrently. Each checkpoint whose
+// transaction_index falls inside the log starts a segment from its snapshot
+// and closes the previous one; the last segment is checked against
+// expected_hash as in pc_replay_verify.
+PCError pc_replay_verify_segmented(const PCReplayLog* log, const PCCheckpointHistory* checkpoints,
+                                   const uint8_t* expected_hash) {
+    if (!log || !checkpoints) return PC_ERR_IO;
+    
+    // Boundaries must move forward through the log
+    const PCStateCheckpoint** cuts = malloc(((size_t)checkpoints->num_checkpoints + 1) * sizeof(*cuts));
+    ReplaySegment* segs = calloc((size_t)checkpoints->num_checkpoints + 1, sizeof(ReplaySegment));
+    uint8_t (*roots)[32] = malloc(((size_t)checkpoints->num_checkpoints + 1) * 32);
+    if (!cuts || !segs || !roots) {
+        free(cuts);
+        free(segs);
+        free(roots);
+        return PC_ERR_IO;
+    }
+    
+    uint32_t num_cuts = 0;
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < checkpoints->num_checkpoints; i++) {
+        const PCStateCheckpoint* cp = &checkpoints->checkpoints[i];
+        if (cp->transaction_index > last && cp->transaction_index < log->num_transactions) {
+            cuts[num_cuts++] = cp;
+            last = cp->transaction_index;
+        }
+    }
+    
+    printf("═══ SEGMENTED REPLAY VERIFICATION ═══\n");
+    printf("Replaying %u transactions in %u segments...\n", log->num_transactions, num_cuts + 1);
+    
+    // Snapshots are only trusted once they match their recorded hashes
+    int bad_cut = -1;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (uint32_t c = 0; c < num_cuts; c++) {
+        if (checkpoint_root(cuts[c], roots[c]) != PC_OK) {
+            #pragma omp critical
+            if (bad_cut < 0 || (int)c < bad_cut) bad_cut = (int)c;
+        }
+    }
+    if (bad_cut >= 0) {
+        printf("\n✗ Checkpoint at TX %u does not match its state hash\n", cuts[bad_cut]->transaction_index);
+        free(cuts);
+        free(segs);
+        free(roots);
+        return PC_ERR_INVALID_STATE;
+    }
+    
+    for (uint32_t k = 0; k <= num_cuts; k++) {
+        ReplaySegment* seg = &segs[k];
+        seg->start = k == 0 ? &log->genesis : &cuts[k - 1]->state;
+        seg->first_tx = k == 0 ? 0 : cuts[k - 1]->transaction_index;
+        seg->end_tx = k < num_cuts ? cuts[k]->transaction_index : log->num_transactions;
+        seg->end_root = k < num_cuts ? roots[k] : NULL;
+        seg->end_state = k < num_cuts ? &cuts[k]->state : NULL;
+    }
+    
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (uint32_t k = 0; k <= num_cuts; k++) {
+        replay_segment(log, &segs[k]);
+    }
+    
+    uint32_t successful = 0, failed = 0;
+    PCError result = PC_OK;
+    for (uint32_t k = 0; k <= num_cuts; k++) {
+        successful += segs[k].successful;
+        failed += segs[k].failed;
+        if (segs[k].result != PC_OK && result == PC_OK) {
+            printf("  Segment %u (TX %u-%u) failed: %s\n", k, segs[k].first_tx, segs[k].end_tx,
+                   segs[k].result == PC_ERR_INVALID_STATE ? "end state differs from checkpoint" :
+                   pc_strerror(segs[k].result));
+            result = segs[k].result;
+        }
+    }
+    
+    printf("\nReplay complete:\n");
+    printf("  Successful: %u\n", successful);
+    printf("  Failed: %u\n", failed);
+    printf("  Final hash: ");
+    for (int i = 0; i < 8; i++) printf("%02x", segs[num_cuts].final_hash[i]);
+    printf("...\n");
+    
+    if (result == PC_OK && expected_hash && memcmp(segs[num_cuts].final_hash, expected_hash, 32) != 0) {
+        result = PC_ERR_INVALID_STATE;
+    }
+    if (result == PC_OK) {
+        printf("\n✓ VERIFICATION SUCCESSFUL! (%u segments)\n", num_cuts + 1);
+    } else {
+        printf("\n✗ VERIFICATION FAILED!\n");
+    }
+    
+    free(cuts);
+    free(segs);
+    free(roots);
+    return result;
+}
+
+// Replay and return final state (for inspection)
+PCError pc_replay_execute(const PCReplayLog* log, PCState* final_state) {
+    if (!log || !final_state) return PC_ERR_IO;
+    
+    LogCursor cursor = { log, 0 };
+    return replay_execute(&log->genesis, log->num_transactions, read_log, &cursor, final_state);
 }
 
 // Free replay log
 void pc_replay_free(PCReplayLog* log) {
     if (log) {
-        if (log->genesis.wallets) {
-            free(log->genesis.wallets);
-        }
+        pc_state_free(&log->genesis);
         if (log->transactions) {
             free(log->transactions);
         }
@@ -176,79 +373,209 @@ void pc_replay_free(PCReplayLog* log) {
     }
 }
 
+// ============ Replay log files ============
+// Layout: genesis size (size_t), serialized genesis, transaction count
+// (uint32_t), the transactions, then the expected final hash
+
+// Start a log file with the genesis state
+PCError pc_replay_writer_open(PCReplayWriter* writer, const char* filename, const PCState* genesis) {
+    if (!writer || !filename || !genesis) return PC_ERR_IO;
+    
+    memset(writer, 0, sizeof(PCReplayWriter));
+    
+    // Serialized size is not known up front: grow until it fits
+    size_t cap = 65536;
+    uint8_t* buf = NULL;
+    size_t genesis_size = 0;
+    while (genesis_size == 0) {
+        uint8_t* grown = realloc(buf, cap);
+        if (!grown) {
+            free(buf);
+            return PC_ERR_IO;
+        }
+        buf = grown;
+        genesis_size = pc_state_serialize(genesis, buf, cap);
+        cap *= 2;
+    }
+    
+    writer->f = fopen(filename, "wb");
+    uint32_t zero = 0;
+    int ok = writer->f &&
+             fwrite(&genesis_size, sizeof(size_t), 1, writer->f) == 1 &&
+             fwrite(buf, genesis_size, 1, writer->f) == 1 &&
+             (writer->count_offset = ftell(writer->f)) >= 0 &&
+             fwrite(&zero, sizeof(uint32_t), 1, writer->f) == 1;
+    free(buf);
+    
+    if (!ok) {
+        if (writer->f) fclose(writer->f);
+        writer->f = NULL;
+        return PC_ERR_IO;
+    }
+    return PC_OK;
+}
+
+// Append one transaction
+PCError pc_replay_writer_add(PCReplayWriter* writer, const PCTransaction* tx) {
+    if (!writer || !writer->f || !tx) return PC_ERR_IO;
+    if (writer->num_transactions == UINT32_MAX) return PC_ERR_LIMIT_EXCEEDED;
+    
+    if (fwrite(tx, sizeof(PCTransaction), 1, writer->f) != 1) return PC_ERR_IO;
+    writer->num_transactions++;
+    return PC_OK;
+}
+
+// Write the final hash, patch in the count and close
+PCError pc_replay_writer_close(PCReplayWriter* writer, const uint8_t* final_hash) {
+    if (!writer || !writer->f) return PC_ERR_IO;
+    
+    uint8_t zero_hash[32] = {0};
+    int ok = fwrite(final_hash ? final_hash : zero_hash, 32, 1, writer->f) == 1 &&
+             fseek(writer->f, writer->count_offset, SEEK_SET) == 0 &&
+             fwrite(&writer->num_transactions, sizeof(uint32_t), 1, writer->f) == 1;
+    if (fclose(writer->f) != 0) ok = 0;
+    writer->f = NULL;
+    return ok ? PC_OK : PC_ERR_IO;
+}
+
 // Save replay log to file (for audit trails)
 PCError pc_replay_save(const PCReplayLog* log, const char* filename) {
-    FILE* f = fopen(filename, "wb");
-    if (!f) return PC_ERR_IO;
+    if (!log) return PC_ERR_IO;
     
-    // Write genesis state
-    uint8_t genesis_buf[65536];
-    size_t genesis_size = pc_state_serialize(&log->genesis, genesis_buf, sizeof(genesis_buf));
-    fwrite(&genesis_size, sizeof(size_t), 1, f);
-    fwrite(genesis_buf, genesis_size, 1, f);
+    PCReplayWriter writer;
+    PCError err = pc_replay_writer_open(&writer, filename, &log->genesis);
+    for (uint32_t i = 0; err == PC_OK && i < log->num_transactions; i++) {
+        err = pc_replay_writer_add(&writer, &log->transactions[i]);
+    }
+    if (err != PC_OK) {
+        if (writer.f) fclose(writer.f);
+        return err;
+    }
+    return pc_replay_writer_close(&writer, log->expected_final_hash);
+}
+
+// Open a log file: genesis and the final hash now, transactions on demand
+PCError pc_replay_stream_open(PCReplayStream* stream, const char* filename) {
+    if (!stream || !filename) return PC_ERR_IO;
     
-    // Write number of transactions
-    fwrite(&log->num_transactions, sizeof(uint32_t), 1, f);
+    memset(stream, 0, sizeof(PCReplayStream));
+    stream->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (stream->fd < 0) return PC_ERR_IO;
     
-    // Write all transactions
-    fwrite(log->transactions, sizeof(PCTransaction), log->num_transactions, f);
+    struct stat st;
+    size_t genesis_size;
+    if (fstat(stream->fd, &st) != 0 ||
+        pread(stream->fd, &genesis_size, sizeof(size_t), 0) != (ssize_t)sizeof(size_t) ||
+        genesis_size == 0 || genesis_size > REPLAY_MAX_GENESIS_BYTES ||
+        sizeof(size_t) + genesis_size + sizeof(uint32_t) > (uint64_t)st.st_size) {
+        goto error;
+    }
+    
+    uint8_t* buf = malloc(genesis_size);
+    if (!buf) goto error;
+    PCError err = pread(stream->fd, buf, genesis_size, sizeof(size_t)) == (ssize_t)genesis_size ?
+                  pc_state_deserialize(&stream->genesis, buf, genesis_size) : PC_ERR_IO;
+    free(buf);
+    if (err != PC_OK) goto error;
+    
+    uint64_t count_offset = sizeof(size_t) + genesis_size;
+    stream->tx_offset = count_offset + sizeof(uint32_t);
+    if (pread(stream->fd, &stream->num_transactions, sizeof(uint32_t), (off_t)count_offset) !=
+        (ssize_t)sizeof(uint32_t)) {
+        goto error;
+    }
     
-    // Write expected final hash
-    fwrite(log->expected_final_hash, 32, 1, f);
+    // The transactions must all be there; a missing final hash reads as zero
+    uint64_t hash_offset = stream->tx_offset + (uint64_t)stream->num_transactions * sizeof(PCTransaction);
+    if (hash_offset > (uint64_t)st.st_size) goto error;
+    if (pread(stream->fd, stream->expected_final_hash, 32, (off_t)hash_offset) != 32) {
+        memset(stream->expected_final_hash, 0, 32);
+    }
     
-    fclose(f);
+    posix_fadvise(stream->fd, (off_t)stream->tx_offset, 0, POSIX_FADV_SEQUENTIAL);
     return PC_OK;
+
+error:
+    pc_replay_stream_close(stream);
+    return PC_ERR_IO;
 }
 
-// Load replay log from file
-PCError pc_replay_load(PCReplayLog* log, const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f) return PC_ERR_IO;
+// Next transactions in log order; returns the count, 0 at the end or on error
+uint32_t pc_replay_stream_read(PCReplayStream* stream, PCTransaction* txs, uint32_t max) {
+    if (!stream || stream->fd < 0 || !txs) return 0;
     
-    // Read genesis state
-    size_t genesis_size;
-    if (fread(&genesis_size, sizeof(size_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+    uint32_t n = stream->num_transactions - stream->position;
+    if (n > max) n = max;
+    if (n == 0) return 0;
     
-    uint8_t genesis_buf[65536];
-    if (fread(genesis_buf, genesis_size, 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
+    size_t bytes = (size_t)n * sizeof(PCTransaction);
+    off_t offset = (off_t)(stream->tx_offset + (uint64_t)stream->position * sizeof(PCTransaction));
+    if (pread(stream->fd, txs, bytes, offset) != (ssize_t)bytes) return 0;
+    
+    stream->position += n;
+    return n;
+}
+
+void pc_replay_stream_close(PCReplayStream* stream) {
+    if (!stream) return;
+    if (stream->fd >= 0) close(stream->fd);
+    stream->fd = -1;
+    pc_state_free(&stream->genesis);
+}
+
+// Verify from the start of the stream
+PCError pc_replay_verify_stream(PCReplayStream* stream, const uint8_t* expected_hash) {
+    if (!stream || stream->fd < 0) return PC_ERR_IO;
+    
+    // An all-zero stored hash means the writer recorded none: skip the comparison
+    static const uint8_t none[32] = {0};
+    if (!expected_hash && memcmp(stream->expected_final_hash, none, 32) != 0) {
+        expected_hash = stream->expected_final_hash;
     }
     
-    pc_state_deserialize(&log->genesis, genesis_buf, genesis_size);
+    stream->position = 0;
+    return replay_verify(&stream->genesis, stream->num_transactions, read_stream, stream,
+                         expected_hash);
+}
+
+// Execute from the start of the stream
+PCError pc_replay_execute_stream(PCReplayStream* stream, PCState* final_state) {
+    if (!stream || stream->fd < 0 || !final_state) return PC_ERR_IO;
     
-    // Read transactions
-    if (fread(&log->num_transactions, sizeof(uint32_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+    stream->position = 0;
+    return replay_execute(&stream->genesis, stream->num_transactions, read_stream, stream, final_state);
+}
+
+// Load replay log from file into memory
+PCError pc_replay_load(PCReplayLog* log, const char* filename) {
+    if (!log) return PC_ERR_IO;
     
-    log->transactions = calloc(log->num_transactions, sizeof(PCTransaction));
-    if (!log->transactions) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+    PCReplayStream stream;
+    if (pc_replay_stream_open(&stream, filename) != PC_OK) return PC_ERR_IO;
     
-    if (fread(log->transactions, sizeof(PCTransaction), log->num_transactions, f) != log->num_transactions) {
+    memset(log, 0, sizeof(PCReplayLog));
+    log->transactions = calloc(stream.num_transactions ? stream.num_transactions : 1, sizeof(PCTransaction));
+    if (!log->transactions ||
+        pc_replay_stream_read(&stream, log->transactions, stream.num_transactions) != stream.num_transactions) {
         free(log->transactions);
-        fclose(f);
+        log->transactions = NULL;
+        pc_replay_stream_close(&stream);
         return PC_ERR_IO;
     }
     
-    // Read expected hash
-    fread(log->expected_final_hash, 32, 1, f);
-    
-    fclose(f);
+    // Genesis moves over to the log
+    log->genesis = stream.genesis;
+    memset(&stream.genesis, 0, sizeof(PCState));
+    log->num_transactions = stream.num_transactions;
+    memcpy(log->expected_final_hash, stream.expected_final_hash, 32);
+    pc_replay_stream_close(&stream);
     return PC_OK;
 }
 
 // Print replay log summary
 void pc_replay_print(const PCReplayLog* log) {
     printf("Replay Log Summary:\n");
-    printf("  Genesis Supply: %.8f\n", log->genesis.total_supply);
+    printf("  Genesis Supply: %.8f\n", pc_amount_to_coins(log->genesis.total_supply));
     printf("  Genesis Wallets: %u\n", log->genesis.num_wallets);
     printf("  Transactions: %u\n", log->num_transactions);
     printf("  Expected Hash: ");
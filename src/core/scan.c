@@ -0,0 +1,290 @@
+// scan.c - Bulk reductions over wallet balances
+// Audits, explorer aggregates and rich lists read every balance; these kernels
+// do it page by page with AVX-512 or AVX2 gathers, falling back to scalar code
+
+#include "../include/physicscoin.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Balances sit one PCWallet apart inside a page
+#define STRIDE (sizeof(PCWallet) / sizeof(PCAmount))
+_Static_assert(sizeof(PCWallet) % sizeof(PCAmount) == 0, "wallet stride must be whole amounts");
+
+// Most histogram buckets a caller may ask for
+#define MAX_BOUNDS 64
+
+// First balance of the page holding wallet base, and how many follow it
+static inline const PCAmount* page_run(const PCState* state, uint32_t base, uint32_t* n) {
+    uint32_t left = state->num_wallets - base;
+    *n = left < PC_WALLET_PAGE_SIZE ? left : PC_WALLET_PAGE_SIZE;
+    return &state->wallet_pages[base >> PC_WALLET_PAGE_SHIFT][0].energy;
+}
+
+#if defined(__AVX512F__)
+#define LANES 8
+static inline __m512i gather(const PCAmount* e) {
+    const __m512i idx = _mm512_set_epi64(7 * STRIDE, 6 * STRIDE, 5 * STRIDE, 4 * STRIDE,
+                                         3 * STRIDE, 2 * STRIDE, STRIDE, 0);
+    return _mm512_i64gather_epi64(idx, (const void*)e, 8);
+}
+#elif defined(__AVX2__)
+#define LANES 4
+static inline __m256i gather(const PCAmount* e) {
+    const __m256i idx = _mm256_set_epi64x(3 * STRIDE, 2 * STRIDE, STRIDE, 0);
+    return _mm256_i64gather_epi64((const long long*)e, idx, 8);
+}
+static inline uint32_t lane_mask(__m256i m) {
+    return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(m));
+}
+#endif
+
+// ============ Sum / stats ============
+
+static uint64_t sum_run(const PCAmount* e, uint32_t n) {
+    uint64_t sum = 0;
+    uint32_t i = 0;
+#if defined(__AVX512F__)
+    __m512i acc = _mm512_setzero_si512();
+    for (; i + LANES <= n; i += LANES) {
+        acc = _mm512_add_epi64(acc, gather(e + i * STRIDE));
+    }
+    sum = (uint64_t)_mm512_reduce_add_epi64(acc);
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + LANES <= n; i += LANES) {
+        acc = _mm256_add_epi64(acc, gather(e + i * STRIDE));
+    }
+    uint64_t lanes[LANES];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; i++) sum += (uint64_t)e[i * STRIDE];
+    return sum;
+}
+
+static void stats_run(const PCAmount* e, uint32_t n, PCScanStats* s) {
+    uint32_t i = 0;
+#if defined(__AVX512F__)
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i vsum = zero, vpos = zero;
+    __m512i vmin = _mm512_set1_epi64(s->min), vmax = _mm512_set1_epi64(s->max);
+    uint32_t neg = 0, pos = 0;
+    for (; i + LANES <= n; i += LANES) {
+        __m512i v = gather(e + i * STRIDE);
+        __mmask8 gt = _mm512_cmpgt_epi64_mask(v, zero);
+        __mmask8 lt = _mm512_cmplt_epi64_mask(v, zero);
+        vsum = _mm512_add_epi64(vsum, v);
+        vpos = _mm512_mask_add_epi64(vpos, gt, vpos, v);
+        vmin = _mm512_min_epi64(vmin, v);
+        vmax = _mm512_max_epi64(vmax, v);
+        pos += (uint32_t)__builtin_popcount(gt);
+        neg += (uint32_t)__builtin_popcount(lt);
+    }
+    s->sum += (uint64_t)_mm512_reduce_add_epi64(vsum);
+    s->positive_sum += (uint64_t)_mm512_reduce_add_epi64(vpos);
+    s->min = _mm512_reduce_min_epi64(vmin);
+    s->max = _mm512_reduce_max_epi64(vmax);
+    s->positive += pos;
+    s->negative += neg;
+#elif defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i vsum = zero, vpos = zero;
+    __m256i vmin = _mm256_set1_epi64x(s->min), vmax = _mm256_set1_epi64x(s->max);
+    uint32_t neg = 0, pos = 0;
+    for (; i + LANES <= n; i += LANES) {
+        __m256i v = gather(e + i * STRIDE);
+        __m256i gt = _mm256_cmpgt_epi64(v, zero);
+        __m256i lt = _mm256_cmpgt_epi64(zero, v);
+        vsum = _mm256_add_epi64(vsum, v);
+        vpos = _mm256_add_epi64(vpos, _mm256_and_si256(v, gt));
+        vmin = _mm256_blendv_epi8(vmin, v, _mm256_cmpgt_epi64(vmin, v));
+        vmax = _mm256_blendv_epi8(vmax, v, _mm256_cmpgt_epi64(v, vmax));
+        pos += (uint32_t)__builtin_popcount(lane_mask(gt));
+        neg += (uint32_t)__builtin_popcount(lane_mask(lt));
+    }
+    int64_t a[LANES], b[LANES], lo[LANES], hi[LANES];
+    _mm256_storeu_si256((__m256i*)a, vsum);
+    _mm256_storeu_si256((__m256i*)b, vpos);
+    _mm256_storeu_si256((__m256i*)lo, vmin);
+    _mm256_storeu_si256((__m256i*)hi, vmax);
+    for (int l = 0; l < LANES; l++) {
+        s->sum += (uint64_t)a[l];
+        s->positive_sum += (uint64_t)b[l];
+        if (lo[l] < s->min) s->min = lo[l];
+        if (hi[l] > s->max) s->max = hi[l];
+    }
+    s->positive += pos;
+    s->negative += neg;
+#endif
+    for (; i < n; i++) {
+        PCAmount v = e[i * STRIDE];
+        s->sum += (uint64_t)v;
+        if (v < s->min) s->min = v;
+        if (v > s->max) s->max = v;
+        if (v > 0) {
+            s->positive++;
+            s->positive_sum += (uint64_t)v;
+        } else if (v < 0) {
+            s->negative++;
+        }
+    }
+}
+
+uint64_t pc_scan_sum(const PCState* state) {
+    uint64_t sum = 0;
+    for (uint32_t base = 0; base < state->num_wallets; base += PC_WALLET_PAGE_SIZE) {
+        uint32_t n;
+        const PCAmount* e = page_run(state, base, &n);
+        sum += sum_run(e, n);
+    }
+    return sum;
+}
+
+void pc_scan_stats(const PCState* state, PCScanStats* out) {
+    memset(out, 0, sizeof(*out));
+    out->min = INT64_MAX;
+    out->max = INT64_MIN;
+    for (uint32_t base = 0; base < state->num_wallets; base += PC_WALLET_PAGE_SIZE) {
+        uint32_t n;
+        const PCAmount* e = page_run(state, base, &n);
+        stats_run(e, n, out);
+    }
+}
+
+// ============ Histogram ============
+
+// at_least[j] += balances >= bounds[j]
+static void histogram_run(const PCAmount* e, uint32_t n, const PCAmount* bounds,
+                          uint32_t num_bounds, uint64_t* at_least) {
+    uint32_t i = 0;
+#if defined(__AVX512F__)
+    __m512i vb[MAX_BOUNDS];
+    for (uint32_t j = 0; j < num_bounds; j++) vb[j] = _mm512_set1_epi64(bounds[j]);
+    for (; i + LANES <= n; i += LANES) {
+        __m512i v = gather(e + i * STRIDE);
+        for (uint32_t j = 0; j < num_bounds; j++) {
+            at_least[j] += (uint64_t)__builtin_popcount(_mm512_cmpge_epi64_mask(v, vb[j]));
+        }
+    }
+#elif defined(__AVX2__)
+    __m256i vb[MAX_BOUNDS];
+    for (uint32_t j = 0; j < num_bounds; j++) vb[j] = _mm256_set1_epi64x(bounds[j]);
+    for (; i + LANES <= n; i += LANES) {
+        __m256i v = gather(e + i * STRIDE);
+        for (uint32_t j = 0; j < num_bounds; j++) {
+            // v >= b  <=>  !(b > v)
+            uint32_t below = lane_mask(_mm256_cmpgt_epi64(vb[j], v));
+            at_least[j] += (uint64_t)(LANES - __builtin_popcount(below));
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        PCAmount v = e[i * STRIDE];
+        for (uint32_t j = 0; j < num_bounds && v >= bounds[j]; j++) at_least[j]++;
+    }
+}
+
+void pc_scan_histogram(const PCState* state, const PCAmount* bounds,
+                       uint32_t num_bounds, uint32_t* counts) {
+    // Kernels take MAX_BOUNDS bounds per pass; more bounds take more passes.
+    // Cumulative "at least" counts turn into per-bucket counts as they come.
+    uint64_t prev = state->num_wallets;
+    for (uint32_t first = 0; first < num_bounds; first += MAX_BOUNDS) {
+        uint32_t m = num_bounds - first < MAX_BOUNDS ? num_bounds - first : MAX_BOUNDS;
+        uint64_t at_least[MAX_BOUNDS] = {0};
+        for (uint32_t base = 0; base < state->num_wallets; base += PC_WALLET_PAGE_SIZE) {
+            uint32_t n;
+            const PCAmount* e = page_run(state, base, &n);
+            histogram_run(e, n, bounds + first, m, at_least);
+        }
+
+        for (uint32_t j = 0; j < m; j++) {
+            counts[first + j] = (uint32_t)(prev - at_least[j]);
+            prev = at_least[j];
+        }
+    }
+    counts[num_bounds] = (uint32_t)prev;
+}
+
+// ============ Top-K threshold ============
+
+// Min-heap of the k largest balances seen so far
+typedef struct {
+    PCAmount* v;
+    uint32_t size;
+    uint32_t k;
+} TopHeap;
+
+static void heap_push(TopHeap* h, PCAmount x) {
+    if (h->size < h->k) {
+        uint32_t i = h->size++;
+        while (i > 0 && h->v[(i - 1) / 2] > x) {
+            h->v[i] = h->v[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        h->v[i] = x;
+        return;
+    }
+    if (x <= h->v[0]) return;
+
+    // Replace the minimum and sift down
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= h->size) break;
+        if (c + 1 < h->size && h->v[c + 1] < h->v[c]) c++;
+        if (h->v[c] >= x) break;
+        h->v[i] = h->v[c];
+        i = c;
+    }
+    h->v[i] = x;
+}
+
+static void topk_run(const PCAmount* e, uint32_t n, TopHeap* h) {
+    uint32_t i = 0;
+    // Until the heap fills every balance is a candidate
+    for (; i < n && h->size < h->k; i++) heap_push(h, e[i * STRIDE]);
+#if defined(__AVX512F__)
+    for (; i + LANES <= n; i += LANES) {
+        // Only lanes above the current k-th largest can enter the heap
+        __mmask8 m = _mm512_cmpgt_epi64_mask(gather(e + i * STRIDE), _mm512_set1_epi64(h->v[0]));
+        while (m) {
+            int l = __builtin_ctz(m);
+            m &= (__mmask8)(m - 1);
+            heap_push(h, e[(i + (uint32_t)l) * STRIDE]);
+        }
+    }
+#elif defined(__AVX2__)
+    for (; i + LANES <= n; i += LANES) {
+        uint32_t m = lane_mask(_mm256_cmpgt_epi64(gather(e + i * STRIDE),
+                                                  _mm256_set1_epi64x(h->v[0])));
+        while (m) {
+            int l = __builtin_ctz(m);
+            m &= m - 1;
+            heap_push(h, e[(i + (uint32_t)l) * STRIDE]);
+        }
+    }
+#endif
+    for (; i < n; i++) heap_push(h, e[i * STRIDE]);
+}
+
+PCAmount pc_scan_topk_threshold(const PCState* state, uint32_t k) {
+    if (k == 0) return INT64_MAX;
+    if (state->num_wallets < k) return INT64_MIN;
+
+    TopHeap h = { malloc((size_t)k * sizeof(PCAmount)), 0, k };
+    if (!h.v) return INT64_MIN;
+
+    for (uint32_t base = 0; base < state->num_wallets; base += PC_WALLET_PAGE_SIZE) {
+        uint32_t n;
+        const PCAmount* e = page_run(state, base, &n);
+        topk_run(e, n, &h);
+    }
+
+    PCAmount threshold = h.v[0];
+    free(h.v);
+    return threshold;
+}
@@ -6,7 +6,117 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
+#include <sys/mman.h>
+
+// Pubkey index tuning: slots stay at most half full
+#define INDEX_MIN_CAPACITY 256
+#define INDEX_EMPTY 0
+#define INDEX_NONE UINT32_MAX
+
+// Mutable wallet slot by insertion index
+static inline PCWallet* wallet_slot(PCState* state, uint32_t i) {
+    return &state->wallet_pages[i >> PC_WALLET_PAGE_SHIFT][i & PC_WALLET_PAGE_MASK];
+}
+
+// Mutable key column entry by insertion index
+static inline uint8_t* key_slot(PCState* state, uint32_t i) {
+    return state->key_pages[i >> PC_WALLET_PAGE_SHIFT] +
+           (size_t)(i & PC_WALLET_PAGE_MASK) * PHYSICSCOIN_KEY_SIZE;
+}
+
+// Per-process hash seed. Public keys are chosen by users, so an unkeyed
+// hash would let anyone grind keys into a single probe chain.
+static uint64_t index_seed;
+
+__attribute__((constructor))
+static void index_seed_init(void) {
+    index_seed = ((uint64_t)time(NULL) << 32) ^ (uint64_t)(uintptr_t)&index_seed ^
+                 0x9e3779b97f4a7c15ULL;
+}
+
+// Keyed 64-bit mix of a 32-byte public key
+static inline uint64_t pubkey_hash(uint64_t seed, const uint8_t* pubkey) {
+    uint64_t w[4];
+    memcpy(w, pubkey, sizeof(w));
+    
+    uint64_t h = seed;
+    for (int i = 0; i < 4; i++) {
+        h ^= w[i];
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 29;
+    return h;
+}
+
+// Place a wallet into an index table (caller guarantees a free slot)
+static void index_place(uint64_t* slots, uint32_t capacity, uint64_t h, uint32_t wallet_idx) {
+    uint32_t mask = capacity - 1;
+    uint32_t pos = (uint32_t)h & mask;
+    
+    while (slots[pos] != INDEX_EMPTY) {
+        pos = (pos + 1) & mask;
+    }
+    slots[pos] = ((h >> 32) << 32) | ((uint64_t)wallet_idx + 1);
+}
+
+// Reallocate the index with the given capacity and reinsert every wallet
+static PCError index_resize(PCState* state, uint32_t capacity) {
+    uint64_t* slots = calloc(capacity, sizeof(uint64_t));
+    if (!slots) return PC_ERR_IO;
+    
+    // The seed travels with the index so snapshots can map it as is
+    if (state->index_seed == 0) state->index_seed = index_seed;
+    
+    for (uint32_t i = 0; i < state->num_wallets; i++) {
+        index_place(slots, capacity, pubkey_hash(state->index_seed, pc_state_key_at(state, i)), i);
+    }
+    
+    if (!state->index_mapped) free(state->wallet_index);
+    state->wallet_index = slots;
+    state->index_mapped = 0;
+    state->index_capacity = capacity;
+    state->index_count = state->num_wallets;
+    
+    return PC_OK;
+}
+
+// Probe the index; only candidates with a matching tag touch the key column
+static uint32_t index_lookup(const PCState* state, const uint8_t* pubkey) {
+    if (state->index_capacity == 0) return INDEX_NONE;
+    
+    uint64_t h = pubkey_hash(state->index_seed, pubkey);
+    uint64_t tag = h >> 32;
+    uint32_t mask = state->index_capacity - 1;
+    uint32_t pos = (uint32_t)h & mask;
+    uint64_t slot;
+    
+    while ((slot = state->wallet_index[pos]) != INDEX_EMPTY) {
+        if ((slot >> 32) == tag) {
+            uint32_t idx = (uint32_t)slot - 1;
+            if (memcmp(pc_state_key_at(state, idx), pubkey, PHYSICSCOIN_KEY_SIZE) == 0) {
+                return idx;
+            }
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return INDEX_NONE;
+}
+
+// Rebuild the pubkey index from scratch
+PCError pc_state_rebuild_index(PCState* state) {
+    if (!state) return PC_ERR_IO;
+    
+    uint64_t capacity = INDEX_MIN_CAPACITY;
+    while (capacity < (uint64_t)state->num_wallets * 2) {
+        capacity <<= 1;
+    }
+    if (capacity > UINT32_MAX) return PC_ERR_MAX_WALLETS;
+    
+    return index_resize(state, (uint32_t)capacity);
+}
 
 // Initialize empty state
 PCError pc_state_init(PCState* state) {
@@ -16,11 +126,7 @@ PCError pc_state_init(PCState* state) {
     state->version = 1;
     state->timestamp = (uint64_t)time(NULL);
     state->num_wallets = 0;
-    state->total_supply = 0.0;
-    
-    state->wallets_capacity = 100;
-    state->wallets = calloc(state->wallets_capacity, sizeof(PCWallet));
-    if (!state->wallets) return PC_ERR_IO;
+    state->total_supply = 0;
     
     memset(state->state_hash, 0, PHYSICSCOIN_HASH_SIZE);
     memset(state->prev_hash, 0, PHYSICSCOIN_HASH_SIZE);
@@ -30,14 +136,103 @@ PCError pc_state_init(PCState* state) {
 
 // Free state resources
 void pc_state_free(PCState* state) {
-    if (state && state->wallets) {
-        free(state->wallets);
-        state->wallets = NULL;
+    if (!state) return;
+    
+    // Pages inside a snapshot mapping go away with munmap; a view frees only
+    // the pages its state copied away from it
+    for (uint32_t p = 0; p < state->num_pages; p++) {
+        if (state->page_flags[p] & PC_PAGE_OWN_WALLETS) free(state->wallet_pages[p]);
+        if (state->page_flags[p] & PC_PAGE_OWN_KEYS) free(state->key_pages[p]);
     }
+    free(state->wallet_pages);
+    free(state->key_pages);
+    free(state->page_flags);
+    state->wallet_pages = NULL;
+    state->key_pages = NULL;
+    state->page_flags = NULL;
+    state->view = NULL;
+    state->num_pages = 0;
+    state->page_slots = 0;
+    
+    if (!state->index_mapped) free(state->wallet_index);
+    state->wallet_index = NULL;
+    state->index_capacity = 0;
+    state->index_count = 0;
+    state->index_mapped = 0;
+    
+    if (state->snapshot) munmap(state->snapshot, state->snapshot_size);
+    state->snapshot = NULL;
+    state->snapshot_size = 0;
+    
+    free(state->dirty_pages);
+    state->dirty_pages = NULL;
+    state->dirty_bytes = 0;
+    state->checkpoint_id = 0;
+    
+    pc_merkle_free(&state->merkle);
+}
+
+// Deep copy a state
+PCError pc_state_clone(PCState* dst, const PCState* src) {
+    if (!dst || !src) return PC_ERR_IO;
+    
+    memcpy(dst, src, sizeof(PCState));
+    dst->wallet_pages = NULL;
+    dst->key_pages = NULL;
+    dst->num_pages = 0;
+    dst->page_slots = 0;
+    dst->wallet_index = NULL;
+    dst->index_capacity = 0;
+    dst->index_count = 0;
+    dst->index_mapped = 0;
+    dst->snapshot = NULL;
+    dst->snapshot_size = 0;
+    dst->page_flags = NULL;
+    dst->view = NULL;
+    dst->checkpoint_id = 0;  // Not tracked: the next checkpoint of a clone is a full one
+    dst->dirty_pages = NULL;
+    dst->dirty_bytes = 0;
+    memset(&dst->merkle, 0, sizeof(PCMerkleTree));
+    
+    if (pc_state_reserve_wallets(dst, src->num_wallets) != PC_OK) {
+        pc_state_free(dst);
+        return PC_ERR_IO;
+    }
+    // Only wallets in use are copied: a checkpoint keeps just that prefix of
+    // its tail page, and the fresh pages are already zeroed past it
+    for (uint32_t base = 0; base < src->num_wallets; base += PC_WALLET_PAGE_SIZE) {
+        uint32_t p = base >> PC_WALLET_PAGE_SHIFT;
+        uint32_t left = src->num_wallets - base;
+        size_t n = left < PC_WALLET_PAGE_SIZE ? left : PC_WALLET_PAGE_SIZE;
+        memcpy(dst->wallet_pages[p], src->wallet_pages[p], n * sizeof(PCWallet));
+        memcpy(dst->key_pages[p], src->key_pages[p], n * PHYSICSCOIN_KEY_SIZE);
+    }
+    
+    if (pc_merkle_clone(&dst->merkle, &src->merkle) != PC_OK) {
+        pc_state_free(dst);
+        return PC_ERR_IO;
+    }
+    
+    // Reuse the source index when it is current
+    if (src->index_capacity > 0 && src->index_count == src->num_wallets) {
+        dst->wallet_index = malloc(src->index_capacity * sizeof(uint64_t));
+        if (!dst->wallet_index) {
+            pc_state_free(dst);
+            return PC_ERR_IO;
+        }
+        memcpy(dst->wallet_index, src->wallet_index, src->index_capacity * sizeof(uint64_t));
+        dst->index_capacity = src->index_capacity;
+        dst->index_count = src->index_count;
+        return PC_OK;
+    }
+    
+    PCError err = pc_state_rebuild_index(dst);
+    if (err != PC_OK) pc_state_free(dst);
+    return err;
 }
 
 // Create genesis state
-PCError pc_state_genesis(PCState* state, const uint8_t* founder_pubkey, double initial_supply) {
+PCError pc_state_genesis(PCState* state, const uint8_t* founder_pubkey, PCAmount initial_supply) {
     if (initial_supply <= 0) return PC_ERR_INVALID_AMOUNT;
     
     PCError err = pc_state_init(state);
@@ -53,43 +248,251 @@ PCError pc_state_genesis(PCState* state, const uint8_t* founder_pubkey, double i
     return PC_OK;
 }
 
-// Find wallet by public key
-PCWallet* pc_state_get_wallet(PCState* state, const uint8_t* pubkey) {
+// Slot of a wallet; falls back to a scan if the index is stale
+static uint32_t wallet_find_slot(const PCState* state, const uint8_t* pubkey) {
+    if (state->index_count == state->num_wallets) {
+        return index_lookup(state, pubkey);
+    }
+    
     for (uint32_t i = 0; i < state->num_wallets; i++) {
-        if (memcmp(state->wallets[i].public_key, pubkey, PHYSICSCOIN_KEY_SIZE) == 0) {
-            return &state->wallets[i];
+        if (memcmp(pc_state_key_at(state, i), pubkey, PHYSICSCOIN_KEY_SIZE) == 0) {
+            return i;
         }
     }
-    return NULL;
+    return INDEX_NONE;
+}
+
+// Find wallet by public key (O(1) via the pubkey index)
+// The caller may modify the wallet, so its Merkle leaf is marked dirty
+PCWallet* pc_state_get_wallet(PCState* state, const uint8_t* pubkey) {
+    // Wallets appended behind our back: bring the index up to date
+    if (state->index_count != state->num_wallets) {
+        if (pc_state_rebuild_index(state) != PC_OK) return NULL;
+    }
+    uint32_t idx = index_lookup(state, pubkey);
+    if (idx == INDEX_NONE) return NULL;
+    
+    if (pc_state_mark_dirty(state, idx) != PC_OK) return NULL;
+    pc_merkle_mark_dirty(&state->merkle, idx);
+    return wallet_slot(state, idx);
+}
+
+// Read-only lookup
+const PCWallet* pc_state_find_wallet(const PCState* state, const uint8_t* pubkey) {
+    uint32_t idx = wallet_find_slot(state, pubkey);
+    return idx == INDEX_NONE ? NULL : pc_state_wallet_at(state, idx);
+}
+
+// Wallet index lookup
+PCError pc_state_find_index(const PCState* state, const uint8_t* pubkey, uint32_t* index_out) {
+    uint32_t idx = wallet_find_slot(state, pubkey);
+    if (idx == INDEX_NONE) return PC_ERR_WALLET_NOT_FOUND;
+    *index_out = idx;
+    return PC_OK;
+}
+
+// Grow the page directory and allocate pages; existing pages only move
+// when copied away from a frozen view
+PCError pc_state_reserve_wallets(PCState* state, uint32_t count) {
+    if (!state) return PC_ERR_IO;
+    if (count > PHYSICSCOIN_MAX_WALLETS) return PC_ERR_MAX_WALLETS;
+    
+    uint32_t pages = (count + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    
+    if (pages > state->page_slots) {
+        uint32_t slots = state->page_slots ? state->page_slots : 4;
+        while (slots < pages) slots *= 2;
+        PCWallet** dir = realloc(state->wallet_pages, slots * sizeof(PCWallet*));
+        if (!dir) return PC_ERR_IO;
+        state->wallet_pages = dir;
+        uint8_t** key_dir = realloc(state->key_pages, slots * sizeof(uint8_t*));
+        if (!key_dir) return PC_ERR_IO;
+        state->key_pages = key_dir;
+        uint8_t* flags = realloc(state->page_flags, slots);
+        if (!flags) return PC_ERR_IO;
+        state->page_flags = flags;
+        state->page_slots = slots;
+    }
+    
+    while (state->num_pages < pages) {
+        PCWallet* page = calloc(PC_WALLET_PAGE_SIZE, sizeof(PCWallet));
+        uint8_t* keys = calloc(PC_WALLET_PAGE_SIZE, PHYSICSCOIN_KEY_SIZE);
+        if (!page || !keys) {
+            free(page);
+            free(keys);
+            return PC_ERR_IO;
+        }
+        state->wallet_pages[state->num_pages] = page;
+        state->key_pages[state->num_pages] = keys;
+        state->page_flags[state->num_pages] = PC_PAGE_OWN_WALLETS | PC_PAGE_OWN_KEYS;
+        state->num_pages++;
+    }
+    
+    return PC_OK;
+}
+
+// Give the state a private copy of a page it shares with the frozen view;
+// the view takes over the old page
+static PCError page_unshare(PCState* state, uint32_t p, uint8_t shared) {
+    if (!(state->page_flags[p] & shared)) return PC_OK;
+    
+    PCState* view = state->view;
+    if (shared == PC_PAGE_SHARED_WALLETS) {
+        PCWallet* copy = malloc(PC_WALLET_PAGE_SIZE * sizeof(PCWallet));
+        if (!copy) return PC_ERR_IO;
+        memcpy(copy, state->wallet_pages[p], PC_WALLET_PAGE_SIZE * sizeof(PCWallet));
+        view->page_flags[p] |= state->page_flags[p] & PC_PAGE_OWN_WALLETS;
+        state->wallet_pages[p] = copy;
+        state->page_flags[p] |= PC_PAGE_OWN_WALLETS;
+    } else {
+        uint8_t* copy = malloc(PC_WALLET_PAGE_SIZE * PHYSICSCOIN_KEY_SIZE);
+        if (!copy) return PC_ERR_IO;
+        memcpy(copy, state->key_pages[p], PC_WALLET_PAGE_SIZE * PHYSICSCOIN_KEY_SIZE);
+        view->page_flags[p] |= state->page_flags[p] & PC_PAGE_OWN_KEYS;
+        state->key_pages[p] = copy;
+        state->page_flags[p] |= PC_PAGE_OWN_KEYS;
+    }
+    state->page_flags[p] &= (uint8_t)~shared;
+    return PC_OK;
+}
+
+// Ready a wallet's page for writing and set its dirty bit, growing the
+// bitmap as pages are added
+PCError pc_state_mark_dirty(PCState* state, uint32_t i) {
+    uint32_t p = i >> PC_WALLET_PAGE_SHIFT;
+    PCError err = page_unshare(state, p, PC_PAGE_SHARED_WALLETS);
+    if (err != PC_OK) return err;
+    
+    if ((p >> 3) >= state->dirty_bytes) {
+        uint32_t bytes = state->dirty_bytes ? state->dirty_bytes : 16;
+        while (bytes <= (p >> 3)) bytes *= 2;
+        uint8_t* bits = realloc(state->dirty_pages, bytes);
+        if (!bits) {
+            // Without a bitmap the next checkpoint cannot be incremental
+            state->checkpoint_id = 0;
+            return PC_OK;
+        }
+        memset(bits + state->dirty_bytes, 0, bytes - state->dirty_bytes);
+        state->dirty_pages = bits;
+        state->dirty_bytes = bytes;
+    }
+    state->dirty_pages[p >> 3] |= (uint8_t)(1u << (p & 7));
+    return PC_OK;
+}
+
+// Clear every dirty bit
+void pc_state_clear_dirty(PCState* state) {
+    if (state->dirty_pages) memset(state->dirty_pages, 0, state->dirty_bytes);
+}
+
+// Freeze a view: copy the page directory and mark every page shared
+PCError pc_state_freeze(PCState* state, PCState* view) {
+    if (!state || !view) return PC_ERR_IO;
+    if (state->view) return PC_ERR_INVALID_STATE;
+    
+    memset(view, 0, sizeof(PCState));
+    uint32_t slots = state->num_pages ? state->num_pages : 1;
+    view->wallet_pages = malloc(slots * sizeof(PCWallet*));
+    view->key_pages = malloc(slots * sizeof(uint8_t*));
+    view->page_flags = calloc(slots, 1);
+    if (!view->wallet_pages || !view->key_pages || !view->page_flags) {
+        pc_state_free(view);
+        return PC_ERR_IO;
+    }
+    
+    view->version = state->version;
+    view->timestamp = state->timestamp;
+    view->num_wallets = state->num_wallets;
+    view->total_supply = state->total_supply;
+    memcpy(view->state_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(view->prev_hash, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
+    view->index_seed = state->index_seed;
+    view->checkpoint_id = state->checkpoint_id;
+    view->num_pages = state->num_pages;
+    view->page_slots = slots;
+    
+    for (uint32_t p = 0; p < state->num_pages; p++) {
+        view->wallet_pages[p] = state->wallet_pages[p];
+        view->key_pages[p] = state->key_pages[p];
+        state->page_flags[p] |= PC_PAGE_SHARED_WALLETS | PC_PAGE_SHARED_KEYS;
+    }
+    
+    // Pages changed since the last checkpoint belong to the view's checkpoint
+    view->dirty_pages = state->dirty_pages;
+    view->dirty_bytes = state->dirty_bytes;
+    state->dirty_pages = NULL;
+    state->dirty_bytes = 0;
+    
+    // The view has no index (lookups scan) and rebuilds its tree on demand
+    pc_merkle_invalidate(&view->merkle);
+    state->view = view;
+    
+    return PC_OK;
+}
+
+// Thaw: stop sharing, fold leftover dirty bits back and free the view
+void pc_state_thaw(PCState* state, PCState* view) {
+    if (!state || !view || state->view != view) return;
+    
+    for (uint32_t p = 0; p < state->num_pages; p++) {
+        state->page_flags[p] &= (uint8_t)~(PC_PAGE_SHARED_WALLETS | PC_PAGE_SHARED_KEYS);
+    }
+    state->view = NULL;
+    
+    for (uint32_t b = 0; b < view->dirty_bytes; b++) {
+        if (!view->dirty_pages[b]) continue;
+        for (uint32_t bit = 0; bit < 8; bit++) {
+            if ((view->dirty_pages[b] >> bit) & 1) {
+                pc_state_mark_dirty(state, ((b << 3) + bit) << PC_WALLET_PAGE_SHIFT);
+            }
+        }
+    }
+    
+    pc_state_free(view);
 }
 
 // Create new wallet
-PCError pc_state_create_wallet(PCState* state, const uint8_t* pubkey, double initial_balance) {
+PCError pc_state_create_wallet(PCState* state, const uint8_t* pubkey, PCAmount initial_balance) {
+    // Supply must stay representable
+    if (initial_balance > 0 && initial_balance > INT64_MAX - state->total_supply) {
+        return PC_ERR_INVALID_AMOUNT;
+    }
+    
     // Check if already exists
     if (pc_state_get_wallet(state, pubkey)) {
         return PC_ERR_WALLET_EXISTS;
     }
     
-    // Expand capacity if needed
-    if (state->num_wallets >= state->wallets_capacity) {
-        size_t new_cap = state->wallets_capacity == 0 ? 8 : state->wallets_capacity * 2;
-        if (new_cap > PHYSICSCOIN_MAX_WALLETS) {
-            return PC_ERR_MAX_WALLETS;
-        }
-        PCWallet* new_wallets = realloc(state->wallets, new_cap * sizeof(PCWallet));
-        if (!new_wallets) return PC_ERR_IO;
-        state->wallets = new_wallets;
-        state->wallets_capacity = new_cap;
-    }
+    // Add a page when the last one is full
+    PCError err = pc_state_reserve_wallets(state, state->num_wallets + 1);
+    if (err != PC_OK) return err;
     
-    // Add wallet
-    PCWallet* w = &state->wallets[state->num_wallets];
-    memcpy(w->public_key, pubkey, PHYSICSCOIN_KEY_SIZE);
+    // Add wallet (the last page may still back a frozen view)
+    err = pc_state_mark_dirty(state, state->num_wallets);
+    if (err == PC_OK) err = page_unshare(state, state->num_wallets >> PC_WALLET_PAGE_SHIFT,
+                                         PC_PAGE_SHARED_KEYS);
+    if (err != PC_OK) return err;
+    
+    PCWallet* w = wallet_slot(state, state->num_wallets);
+    memcpy(key_slot(state, state->num_wallets), pubkey, PHYSICSCOIN_KEY_SIZE);
     w->energy = initial_balance;
     w->nonce = 0;
     
     state->num_wallets++;
     
+    // Keep the index in sync (grow at 50% load)
+    if ((uint64_t)state->index_count * 2 + 2 > state->index_capacity) {
+        err = pc_state_rebuild_index(state);
+        if (err != PC_OK) {
+            state->num_wallets--;
+            return err;
+        }
+    } else {
+        index_place(state->wallet_index, state->index_capacity,
+                    pubkey_hash(state->index_seed, pubkey), state->num_wallets - 1);
+        state->index_count++;
+    }
+    
     // Update total supply only for genesis
     if (initial_balance > 0) {
         state->total_supply += initial_balance;
@@ -104,6 +507,50 @@ PCError pc_state_execute_tx(PCState* state, const PCTransaction* tx) {
     PCError err = pc_transaction_verify(tx);
     if (err != PC_OK) return err;
     
+    return pc_state_apply_tx(state, tx);
+}
+
+// Verify all signatures up front, then apply in order without re-verifying
+uint32_t pc_state_execute_batch(PCState* state, const PCTransaction* txs,
+                                uint32_t count, int* results) {
+    if (!state || !txs || count == 0) return 0;
+    
+    const PCTransaction** ptrs = malloc(count * sizeof(PCTransaction*));
+    int* sig_ok = malloc(count * sizeof(int));
+    uint32_t applied = 0;
+    
+    if (!ptrs || !sig_ok) {
+        // Out of memory: fall back to one-at-a-time execution
+        free(ptrs);
+        free(sig_ok);
+        for (uint32_t i = 0; i < count; i++) {
+            PCError err = pc_state_execute_tx(state, &txs[i]);
+            if (results) results[i] = err;
+            if (err == PC_OK) applied++;
+        }
+        return applied;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        ptrs[i] = &txs[i];
+    }
+    pc_transaction_verify_batch(ptrs, (int)count, sig_ok);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        PCError err = sig_ok[i] ? pc_state_apply_tx(state, &txs[i]) : PC_ERR_INVALID_SIGNATURE;
+        if (results) results[i] = err;
+        if (err == PC_OK) applied++;
+    }
+    
+    free(ptrs);
+    free(sig_ok);
+    return applied;
+}
+
+// Apply a pre-verified transaction
+PCError pc_state_apply_tx(PCState* state, const PCTransaction* tx) {
+    PCError err;
+    
     // Find wallets
     PCWallet* from = pc_state_get_wallet(state, tx->from);
     PCWallet* to = pc_state_get_wallet(state, tx->to);
@@ -117,6 +564,19 @@ PCError pc_state_execute_tx(PCState* state, const PCTransaction* tx) {
         to = pc_state_get_wallet(state, tx->to);
     }
     
+    err = pc_state_transfer(from, to, tx);
+    if (err != PC_OK) return err;
+    
+    // Update state
+    state->timestamp = (uint64_t)time(NULL);
+    memcpy(state->prev_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+    pc_state_compute_hash(state);
+    
+    return PC_OK;
+}
+
+// Move energy between two wallets (signature already checked)
+PCError pc_state_transfer(PCWallet* from, PCWallet* to, const PCTransaction* tx) {
     // Check nonce (replay protection)
     if (tx->nonce != from->nonce) {
         return PC_ERR_INVALID_SIGNATURE;
@@ -132,38 +592,18 @@ PCError pc_state_execute_tx(PCState* state, const PCTransaction* tx) {
     }
     
     // ===== ATOMIC ENERGY TRANSFER =====
-    double before_sum = from->energy + to->energy;
-    
+    // Integer units: the pair sum is unchanged by construction
     from->energy -= tx->amount;
     to->energy += tx->amount;
     from->nonce++;
     
-    double after_sum = from->energy + to->energy;
-    
-    // Verify conservation
-    if (fabs(before_sum - after_sum) > 1e-12) {
-        from->energy += tx->amount;
-        to->energy -= tx->amount;
-        from->nonce--;
-        return PC_ERR_CONSERVATION_VIOLATED;
-    }
-    
-    // Update state
-    state->timestamp = (uint64_t)time(NULL);
-    memcpy(state->prev_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
-    pc_state_compute_hash(state);
-    
     return PC_OK;
 }
 
 // Verify total energy conservation
 PCError pc_state_verify_conservation(const PCState* state) {
-    double actual_sum = 0.0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        actual_sum += state->wallets[i].energy;
-    }
-    
-    if (fabs(actual_sum - state->total_supply) > 1e-9) {
+    // Exact integer sum (wrapping arithmetic, so corrupt input cannot trap)
+    if (pc_scan_sum(state) != (uint64_t)state->total_supply) {
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
@@ -171,24 +611,53 @@ PCError pc_state_verify_conservation(const PCState* state) {
 }
 
 // Compute SHA-256 hash of state
+// Wallets enter through the Merkle root, so only touched leaves are rehashed
 void pc_state_compute_hash(PCState* state) {
+    uint8_t root[PHYSICSCOIN_HASH_SIZE];
+    pc_state_merkle_root(state, root);
+    pc_state_hash_header(state, state->num_wallets, root, state->state_hash);
+}
+
+// Header fields + wallet root
+void pc_state_hash_header(const PCState* state, uint32_t num_wallets,
+                          const uint8_t* root, uint8_t* hash_out) {
     SHA256_CTX ctx;
     sha256_init(&ctx);
     
     sha256_update(&ctx, (uint8_t*)&state->version, sizeof(state->version));
     sha256_update(&ctx, (uint8_t*)&state->timestamp, sizeof(state->timestamp));
-    sha256_update(&ctx, (uint8_t*)&state->num_wallets, sizeof(state->num_wallets));
+    sha256_update(&ctx, (uint8_t*)&num_wallets, sizeof(num_wallets));
     sha256_update(&ctx, (uint8_t*)&state->total_supply, sizeof(state->total_supply));
     sha256_update(&ctx, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
+    sha256_update(&ctx, root, PHYSICSCOIN_HASH_SIZE);
     
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        PCWallet* w = &state->wallets[i];
-        sha256_update(&ctx, w->public_key, PHYSICSCOIN_KEY_SIZE);
-        sha256_update(&ctx, (uint8_t*)&w->energy, sizeof(w->energy));
-        sha256_update(&ctx, (uint8_t*)&w->nonce, sizeof(w->nonce));
+    sha256_final(&ctx, hash_out);
+}
+
+// Merkle root over the wallets in index order
+PCError pc_state_merkle_root(PCState* state, uint8_t* root_out) {
+    if (!state || !root_out) return PC_ERR_IO;
+    
+    PCError err = pc_merkle_update(&state->merkle, state);
+    if (err != PC_OK) {
+        memset(root_out, 0, PHYSICSCOIN_HASH_SIZE);
+        return err;
     }
+    pc_merkle_root(&state->merkle, root_out);
+    return PC_OK;
+}
+
+// Inclusion proof for one wallet
+PCError pc_state_merkle_proof(PCState* state, const uint8_t* pubkey, PCMerkleProof* proof) {
+    if (!state || !pubkey || !proof) return PC_ERR_IO;
+    
+    uint32_t idx = wallet_find_slot(state, pubkey);
+    if (idx == INDEX_NONE) return PC_ERR_WALLET_NOT_FOUND;
+    
+    PCError err = pc_merkle_update(&state->merkle, state);
+    if (err != PC_OK) return err;
     
-    sha256_final(&ctx, state->state_hash);
+    return pc_merkle_proof(&state->merkle, idx, proof);
 }
 
 // Error messages
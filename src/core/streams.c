@@ -3,17 +3,19 @@
 // SECURITY HARDENED: Persisted to disk for crash recovery
 
 #include "../include/physicscoin.h"
+#include "../include/journal.h"
 #include "../crypto/sha256.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
-#include <math.h>
 #include <unistd.h>
 
-#define MAX_STREAMS 1000
 #define STREAM_FILE "streams.dat"
+#define STREAM_JOURNAL STREAM_FILE ".journal"
 #define STREAM_MAGIC 0x53545245  // "STRE"
+#define STREAM_VERSION 3          // Explicit header with count and generation
+#define STREAM_VERSION_DOUBLE 1   // v1 stored amounts as double coins
 
 // Stream status
 typedef enum {
@@ -27,30 +29,71 @@ typedef struct {
     uint64_t stream_id;
     uint8_t payer[32];
     uint8_t receiver[32];
-    double rate_per_second;  // Coins per second
+    PCAmount rate_per_second;  // Base units per second
     uint64_t start_time;
     uint64_t pause_time;     // When paused, 0 if active
     uint64_t total_paused_seconds;  // Accumulated pause time
-    double max_amount;       // Cap on total transfer
-    double settled_amount;   // Already settled
+    PCAmount max_amount;     // Cap on total transfer
+    PCAmount settled_amount; // Already settled
     StreamStatus status;
     uint8_t authorization_sig[64];  // Payer's signature authorizing stream
 } PCPaymentStream;
 
-// Persistent stream registry
+// Journal records: the whole stream after each mutation
+typedef enum {
+    STREAM_RECORD_PUT = 1
+} StreamRecordType;
+
+// Snapshot file header; num_streams PCPaymentStream records follow
 typedef struct {
     uint32_t magic;
     uint32_t version;
     uint64_t next_stream_id;
     uint32_t num_streams;
-    PCPaymentStream streams[MAX_STREAMS];
+    uint32_t reserved;
+    uint64_t generation;     // Journal generation this snapshot starts
+} StreamFileHeader;
+
+// Persistent stream registry; streams stay sorted by id
+typedef struct {
+    uint64_t next_stream_id;
+    uint32_t num_streams;
+    uint32_t capacity;
+    PCPaymentStream* streams;
+    uint64_t generation;
+    PCJournal journal;
 } PCStreamRegistry;
 
 // Global registry
 static PCStreamRegistry g_stream_registry = {0};
 static int g_registry_initialized = 0;
 
-// Save registry to disk
+// Room for one more stream
+static PCError reserve_stream(void) {
+    if (g_stream_registry.num_streams < g_stream_registry.capacity) return PC_OK;
+    
+    uint32_t capacity = g_stream_registry.capacity ? g_stream_registry.capacity * 2 : 64;
+    PCPaymentStream* grown = realloc(g_stream_registry.streams, capacity * sizeof(PCPaymentStream));
+    if (!grown) return PC_ERR_IO;
+    g_stream_registry.streams = grown;
+    g_stream_registry.capacity = capacity;
+    return PC_OK;
+}
+
+// Get stream by ID (binary search: ids are handed out in order)
+static PCPaymentStream* find_stream(uint64_t stream_id) {
+    uint32_t lo = 0, hi = g_stream_registry.num_streams;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t id = g_stream_registry.streams[mid].stream_id;
+        if (id == stream_id) return &g_stream_registry.streams[mid];
+        if (id < stream_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// Write all streams as a new snapshot generation, then start its journal
 static PCError save_stream_registry(void) {
     FILE* f = fopen(STREAM_FILE ".tmp", "wb");
     if (!f) {
@@ -58,103 +101,129 @@ static PCError save_stream_registry(void) {
         return PC_ERR_IO;
     }
     
-    g_stream_registry.magic = STREAM_MAGIC;
-    g_stream_registry.version = 1;
+    StreamFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = STREAM_MAGIC;
+    hdr.version = STREAM_VERSION;
+    hdr.next_stream_id = g_stream_registry.next_stream_id;
+    hdr.num_streams = g_stream_registry.num_streams;
+    hdr.generation = g_stream_registry.generation + 1;
     
-    // Write header
-    if (fwrite(&g_stream_registry, sizeof(uint32_t) * 4, 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
-    
-    // Write streams
-    for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
-        if (fwrite(&g_stream_registry.streams[i], sizeof(PCPaymentStream), 1, f) != 1) {
-            fclose(f);
-            return PC_ERR_IO;
-        }
-    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+             fwrite(g_stream_registry.streams, sizeof(PCPaymentStream),
+                    g_stream_registry.num_streams, f) == g_stream_registry.num_streams;
     
     // Sync to disk
-    fflush(f);
-    fsync(fileno(f));
+    if (ok && (fflush(f) != 0 || fsync(fileno(f)) != 0)) ok = 0;
     fclose(f);
     
-    // Atomic rename
-    if (rename(STREAM_FILE ".tmp", STREAM_FILE) != 0) {
-        perror("Failed to rename stream file");
+    // Atomic rename; the old journal is folded in from here on
+    if (!ok || rename(STREAM_FILE ".tmp", STREAM_FILE) != 0) {
+        perror("Failed to write stream file");
+        remove(STREAM_FILE ".tmp");
         return PC_ERR_IO;
     }
+    g_stream_registry.generation = hdr.generation;
     
-    return PC_OK;
+    return pc_journal_reset(&g_stream_registry.journal, hdr.generation);
 }
 
-// Load registry from disk
-static PCError load_stream_registry(void) {
-    FILE* f = fopen(STREAM_FILE, "rb");
-    if (!f) {
-        // No existing file - start fresh
-        memset(&g_stream_registry, 0, sizeof(g_stream_registry));
-        g_stream_registry.magic = STREAM_MAGIC;
-        g_stream_registry.version = 1;
-        g_stream_registry.next_stream_id = 1;
-        g_registry_initialized = 1;
-        return PC_OK;
-    }
-    
-    // Read header
-    uint32_t header[4];
-    if (fread(header, sizeof(uint32_t), 4, f) != 4) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+// Record a mutated stream; folds the journal once it outgrows the registry
+static PCError log_stream(const PCPaymentStream* stream) {
+    PCError err = pc_journal_append(&g_stream_registry.journal, STREAM_RECORD_PUT,
+                                    stream, sizeof(PCPaymentStream));
+    if (err != PC_OK) return err;
     
-    if (header[0] != STREAM_MAGIC) {
-        printf("Invalid stream file magic\n");
-        fclose(f);
-        return PC_ERR_IO;
+    if (pc_journal_should_compact(&g_stream_registry.journal, g_stream_registry.num_streams)) {
+        return save_stream_registry();
     }
+    return PC_OK;
+}
+
+// Journal replay: insert or replace the stream
+static void apply_stream_record(void* ctx, uint32_t type, const void* data, uint32_t length) {
+    (void)ctx;
+    if (type != STREAM_RECORD_PUT || length != sizeof(PCPaymentStream)) return;
     
-    g_stream_registry.magic = header[0];
-    g_stream_registry.version = header[1];
-    g_stream_registry.next_stream_id = header[2] | ((uint64_t)header[3] << 32);
-    
-    // Read stream count first
-    if (fread(&g_stream_registry.num_streams, sizeof(uint32_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
-    
-    // Seek back to proper position
-    fseek(f, sizeof(uint32_t) * 4, SEEK_SET);
-    
-    // Re-read properly
-    fclose(f);
-    f = fopen(STREAM_FILE, "rb");
-    fseek(f, sizeof(uint32_t) * 2, SEEK_SET);  // Skip magic and version
-    
-    if (fread(&g_stream_registry.next_stream_id, sizeof(uint64_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+    PCPaymentStream stream;
+    memcpy(&stream, data, sizeof(stream));
     
-    if (fread(&g_stream_registry.num_streams, sizeof(uint32_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
+    PCPaymentStream* slot = find_stream(stream.stream_id);
+    if (!slot) {
+        uint32_t n = g_stream_registry.num_streams;
+        if (n > 0 && g_stream_registry.streams[n - 1].stream_id > stream.stream_id) return;
+        if (reserve_stream() != PC_OK) return;
+        slot = &g_stream_registry.streams[g_stream_registry.num_streams++];
     }
+    *slot = stream;
     
-    if (g_stream_registry.num_streams > MAX_STREAMS) {
-        g_stream_registry.num_streams = MAX_STREAMS;
+    if (stream.stream_id >= g_stream_registry.next_stream_id) {
+        g_stream_registry.next_stream_id = stream.stream_id + 1;
     }
-    
-    // Read streams
-    for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
+}
+
+// Read the streams of a snapshot file
+static PCError read_streams(FILE* f, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (reserve_stream() != PC_OK) return PC_ERR_IO;
         if (fread(&g_stream_registry.streams[i], sizeof(PCPaymentStream), 1, f) != 1) {
             break;
         }
+        g_stream_registry.num_streams++;
     }
+    return PC_OK;
+}
+
+// Load the snapshot, then replay its journal
+static PCError load_stream_registry(void) {
+    free(g_stream_registry.streams);
+    memset(&g_stream_registry, 0, sizeof(g_stream_registry));
+    g_stream_registry.next_stream_id = 1;
+    g_stream_registry.journal.fd = -1;
+    
+    FILE* f = fopen(STREAM_FILE, "rb");
+    if (f) {
+        StreamFileHeader hdr;
+        size_t got = fread(&hdr, 1, sizeof(hdr), f);
+        if (got < sizeof(uint32_t) * 5 || hdr.magic != STREAM_MAGIC ||
+            (hdr.version >= STREAM_VERSION && got != sizeof(hdr))) {
+            printf("Invalid stream file magic\n");
+            fclose(f);
+            return PC_ERR_IO;
+        }
+        uint32_t version = hdr.version;
+        
+        if (version >= STREAM_VERSION) {
+            g_stream_registry.next_stream_id = hdr.next_stream_id;
+            g_stream_registry.generation = hdr.generation;
+            read_streams(f, hdr.num_streams);
+        } else {
+            // v1/v2 files: 16-byte header, count, then streams at offset 20
+            g_stream_registry.next_stream_id = hdr.next_stream_id;
+            fseek(f, sizeof(uint32_t) * 5, SEEK_SET);
+            read_streams(f, hdr.num_streams);
+        }
+        fclose(f);
+        
+        // v1 registries held double coins in the amount fields
+        if (version == STREAM_VERSION_DOUBLE) {
+            for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
+                PCPaymentStream* s = &g_stream_registry.streams[i];
+                double rate, max, settled;
+                memcpy(&rate, &s->rate_per_second, sizeof(rate));
+                memcpy(&max, &s->max_amount, sizeof(max));
+                memcpy(&settled, &s->settled_amount, sizeof(settled));
+                s->rate_per_second = pc_amount_from_coins(rate);
+                s->max_amount = max >= 1e10 ? INT64_MAX : pc_amount_from_coins(max);
+                s->settled_amount = pc_amount_from_coins(settled);
+            }
+        }
+    }
+    
+    PCError err = pc_journal_open(&g_stream_registry.journal, STREAM_JOURNAL,
+                                  g_stream_registry.generation, apply_stream_record, NULL);
+    if (err != PC_OK) return err;
     
-    fclose(f);
     g_registry_initialized = 1;
     
     printf("Loaded %u streams from disk\n", g_stream_registry.num_streams);
@@ -171,7 +240,7 @@ void pc_stream_init(void) {
 
 // Open a new payment stream (with authorization signature)
 uint64_t pc_stream_open(const uint8_t* payer, const uint8_t* receiver,
-                        double rate_per_second, double max_amount,
+                        PCAmount rate_per_second, PCAmount max_amount,
                         const uint8_t* authorization_sig) {
     if (!g_registry_initialized) {
         load_stream_registry();
@@ -181,8 +250,8 @@ uint64_t pc_stream_open(const uint8_t* payer, const uint8_t* receiver,
         return 0;
     }
     
-    if (g_stream_registry.num_streams >= MAX_STREAMS) {
-        printf("Maximum streams reached\n");
+    if (reserve_stream() != PC_OK) {
+        printf("Out of memory for streams\n");
         return 0;
     }
     
@@ -195,7 +264,7 @@ uint64_t pc_stream_open(const uint8_t* payer, const uint8_t* receiver,
     stream->start_time = (uint64_t)time(NULL);
     stream->pause_time = 0;
     stream->total_paused_seconds = 0;
-    stream->max_amount = max_amount > 0 ? max_amount : 1e15;  // Default: very high
+    stream->max_amount = max_amount > 0 ? max_amount : INT64_MAX;  // Default: unlimited
     stream->settled_amount = 0;
     stream->status = STREAM_ACTIVE;
     
@@ -208,27 +277,26 @@ uint64_t pc_stream_open(const uint8_t* payer, const uint8_t* receiver,
     g_stream_registry.num_streams++;
     
     // Persist to disk
-    save_stream_registry();
+    log_stream(stream);
     
-    printf("Opened stream #%lu: %.8f coins/sec\n", stream->stream_id, rate_per_second);
+    printf("Opened stream #%lu: %.8f coins/sec\n", stream->stream_id,
+           pc_amount_to_coins(rate_per_second));
     
     return stream->stream_id;
 }
 
-// Get stream by ID
+// Get stream by ID, loading the registry on first use
 static PCPaymentStream* get_stream(uint64_t stream_id) {
-    for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
-        if (g_stream_registry.streams[i].stream_id == stream_id) {
-            return &g_stream_registry.streams[i];
-        }
+    if (!g_registry_initialized) {
+        load_stream_registry();
     }
-    return NULL;
+    return find_stream(stream_id);
 }
 
 // Calculate accumulated amount owed
-double pc_stream_accumulated(uint64_t stream_id) {
+PCAmount pc_stream_accumulated(uint64_t stream_id) {
     PCPaymentStream* stream = get_stream(stream_id);
-    if (!stream || stream->status == STREAM_CLOSED) return 0.0;
+    if (!stream || stream->status == STREAM_CLOSED) return 0;
     
     uint64_t now = (uint64_t)time(NULL);
     uint64_t active_seconds;
@@ -240,15 +308,16 @@ double pc_stream_accumulated(uint64_t stream_id) {
         active_seconds = now - stream->start_time - stream->total_paused_seconds;
     }
     
-    double total_owed = active_seconds * stream->rate_per_second;
-    double unsettled = total_owed - stream->settled_amount;
+    // Widened so long-running fast streams saturate instead of wrapping
+    __int128 total_owed = (__int128)active_seconds * stream->rate_per_second;
+    __int128 unsettled = total_owed - stream->settled_amount;
     
     // Cap at max amount
-    if (unsettled > stream->max_amount - stream->settled_amount) {
-        unsettled = stream->max_amount - stream->settled_amount;
+    if (unsettled > (__int128)stream->max_amount - stream->settled_amount) {
+        unsettled = (__int128)stream->max_amount - stream->settled_amount;
     }
     
-    return unsettled > 0 ? unsettled : 0;
+    return unsettled > 0 ? (PCAmount)unsettled : 0;
 }
 
 // Pause stream
@@ -260,7 +329,7 @@ PCError pc_stream_pause(uint64_t stream_id) {
     stream->pause_time = (uint64_t)time(NULL);
     stream->status = STREAM_PAUSED;
     
-    save_stream_registry();
+    log_stream(stream);
     
     printf("Stream #%lu paused\n", stream_id);
     return PC_OK;
@@ -277,7 +346,7 @@ PCError pc_stream_resume(uint64_t stream_id) {
     stream->pause_time = 0;
     stream->status = STREAM_ACTIVE;
     
-    save_stream_registry();
+    log_stream(stream);
     
     printf("Stream #%lu resumed\n", stream_id);
     return PC_OK;
@@ -289,7 +358,7 @@ PCError pc_stream_settle(uint64_t stream_id, PCState* state) {
     if (!stream) return PC_ERR_WALLET_NOT_FOUND;
     if (stream->status == STREAM_CLOSED) return PC_ERR_INVALID_SIGNATURE;
     
-    double amount = pc_stream_accumulated(stream_id);
+    PCAmount amount = pc_stream_accumulated(stream_id);
     if (amount <= 0) return PC_OK;  // Nothing to settle
     
     // Find wallets
@@ -307,19 +376,9 @@ PCError pc_stream_settle(uint64_t stream_id, PCState* state) {
         if (amount <= 0) return PC_ERR_INSUFFICIENT_FUNDS;
     }
     
-    // Execute settlement (atomic)
-    double before_sum = payer->energy + receiver->energy;
+    // Execute settlement (exact integer move)
     payer->energy -= amount;
     receiver->energy += amount;
-    double after_sum = payer->energy + receiver->energy;
-    
-    // Verify conservation
-    if (fabs(before_sum - after_sum) > 1e-12) {
-        // Rollback
-        payer->energy += amount;
-        receiver->energy -= amount;
-        return PC_ERR_CONSERVATION_VIOLATED;
-    }
     
     stream->settled_amount += amount;
     payer->nonce++;
@@ -328,9 +387,9 @@ PCError pc_stream_settle(uint64_t stream_id, PCState* state) {
     pc_state_compute_hash(state);
     
     // Persist changes
-    save_stream_registry();
+    log_stream(stream);
     
-    printf("Stream #%lu settled %.8f coins\n", stream_id, amount);
+    printf("Stream #%lu settled %.8f coins\n", stream_id, pc_amount_to_coins(amount));
     
     return PC_OK;
 }
@@ -350,10 +409,10 @@ PCError pc_stream_close(uint64_t stream_id, PCState* state) {
     stream->status = STREAM_CLOSED;
     
     // Persist
-    save_stream_registry();
+    log_stream(stream);
     
     printf("Stream #%lu closed (total settled: %.8f)\n", 
-           stream_id, stream->settled_amount);
+           stream_id, pc_amount_to_coins(stream->settled_amount));
     
     return PC_OK;
 }
@@ -381,10 +440,11 @@ void pc_stream_info(uint64_t stream_id) {
     printf("  Receiver: ");
     for (int i = 0; i < 8; i++) printf("%02x", stream->receiver[i]);
     printf("...\n");
-    printf("  Rate: %.8f coins/sec\n", stream->rate_per_second);
+    printf("  Rate: %.8f coins/sec\n", pc_amount_to_coins(stream->rate_per_second));
     printf("  Started: %lu\n", stream->start_time);
-    printf("  Settled: %.8f / %.8f\n", stream->settled_amount, stream->max_amount);
-    printf("  Pending: %.8f\n", pc_stream_accumulated(stream_id));
+    printf("  Settled: %.8f / %.8f\n", pc_amount_to_coins(stream->settled_amount),
+           pc_amount_to_coins(stream->max_amount));
+    printf("  Pending: %.8f\n", pc_amount_to_coins(pc_stream_accumulated(stream_id)));
 }
 
 // List all streams
@@ -408,7 +468,8 @@ void pc_stream_list(void) {
         }
         
         printf("│ %-6lu │ %-8s │ %14.8f │ %14.8f │\n",
-               s->stream_id, status, s->rate_per_second, s->settled_amount);
+               s->stream_id, status, pc_amount_to_coins(s->rate_per_second),
+               pc_amount_to_coins(s->settled_amount));
     }
     
     printf("└────────┴──────────┴────────────────┴────────────────┘\n");
@@ -435,8 +496,8 @@ void pc_stream_find_for_wallet(const uint8_t* pubkey) {
             printf("  Stream #%lu: %s (%.8f/sec, settled: %.8f)\n",
                    s->stream_id, 
                    is_payer ? "PAYING" : "RECEIVING",
-                   s->rate_per_second,
-                   s->settled_amount);
+                   pc_amount_to_coins(s->rate_per_second),
+                   pc_amount_to_coins(s->settled_amount));
             found++;
         }
     }
@@ -447,14 +508,14 @@ void pc_stream_find_for_wallet(const uint8_t* pubkey) {
 }
 
 // Get total pending payments for a payer
-double pc_stream_total_pending_out(const uint8_t* payer) {
-    if (!payer) return 0.0;
+PCAmount pc_stream_total_pending_out(const uint8_t* payer) {
+    if (!payer) return 0;
     
     if (!g_registry_initialized) {
         load_stream_registry();
     }
     
-    double total = 0.0;
+    PCAmount total = 0;
     
     for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
         PCPaymentStream* s = &g_stream_registry.streams[i];
@@ -468,14 +529,14 @@ double pc_stream_total_pending_out(const uint8_t* payer) {
 }
 
 // Get total pending payments for a receiver
-double pc_stream_total_pending_in(const uint8_t* receiver) {
-    if (!receiver) return 0.0;
+PCAmount pc_stream_total_pending_in(const uint8_t* receiver) {
+    if (!receiver) return 0;
     
     if (!g_registry_initialized) {
         load_stream_registry();
     }
     
-    double total = 0.0;
+    PCAmount total = 0;
     
     for (uint32_t i = 0; i < g_stream_registry.num_streams; i++) {
         PCPaymentStream* s = &g_stream_registry.streams[i];
@@ -507,6 +568,7 @@ void pc_stream_cleanup(void) {
         }
     }
     
+    // Removals are not journaled: write a fresh snapshot instead
     if (removed > 0) {
         save_stream_registry();
         printf("Cleaned up %u closed streams\n", removed);
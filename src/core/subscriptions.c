@@ -2,17 +2,20 @@
 // Monthly/yearly subscriptions with auto-renewal and cancellation
 
 #include "../include/physicscoin.h"
+#include "../include/journal.h"
 #include "../crypto/sha256.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
-#include <math.h>
 #include <unistd.h>
 
-#define MAX_SUBSCRIPTIONS 1000
+#define LEGACY_MAX_SUBSCRIPTIONS 1000  // Array size of the v1/v2 fixed registry
 #define SUBSCRIPTION_FILE "subscriptions.dat"
+#define SUBSCRIPTION_JOURNAL SUBSCRIPTION_FILE ".journal"
 #define SUBSCRIPTION_MAGIC 0x53554253  // "SUBS"
+#define SUBSCRIPTION_VERSION 3          // Header with counts, growable arrays
+#define SUBSCRIPTION_VERSION_FIXED 2    // Fixed registry; v1 stored prices as double coins
 
 // Subscription types
 typedef enum {
@@ -34,7 +37,7 @@ typedef struct {
     uint64_t plan_id;
     char name[128];
     char description[256];
-    double price;
+    PCAmount price;
     uint32_t duration_seconds;  // Billing period
     SubscriptionType type;
     uint8_t provider_pubkey[32];
@@ -51,72 +54,283 @@ typedef struct {
     uint64_t started_at;
     uint64_t next_billing;
     uint64_t cancelled_at;
-    double price;
+    PCAmount price;
     uint32_t billing_period;
     SubscriptionStatus status;
     uint32_t payment_failures;
     uint8_t authorization_sig[64];
 } Subscription;
 
-// Registry
+// Registry; plans and subscriptions stay sorted by id
+typedef struct {
+    uint32_t num_plans;
+    uint32_t num_subscriptions;
+    uint32_t plan_capacity;
+    uint32_t sub_capacity;
+    SubscriptionPlan* plans;
+    Subscription* subscriptions;
+    uint64_t next_plan_id;
+    uint64_t next_sub_id;
+    uint64_t generation;
+    PCJournal journal;
+} SubscriptionRegistry;
+
+// v1/v2 file: the fixed-size registry written whole
 typedef struct {
     uint32_t magic;
     uint32_t version;
     uint32_t num_plans;
     uint32_t num_subscriptions;
-    SubscriptionPlan plans[MAX_SUBSCRIPTIONS];
-    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    SubscriptionPlan plans[LEGACY_MAX_SUBSCRIPTIONS];
+    Subscription subscriptions[LEGACY_MAX_SUBSCRIPTIONS];
     uint64_t next_plan_id;
     uint64_t next_sub_id;
-} SubscriptionRegistry;
+} LegacySubscriptionRegistry;
+
+// Snapshot file header; plans, then subscriptions follow
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_plans;
+    uint32_t num_subscriptions;
+    uint64_t next_plan_id;
+    uint64_t next_sub_id;
+    uint64_t generation;     // Journal generation this snapshot starts
+} SubscriptionFileHeader;
+
+// Journal records: the whole plan or subscription after each mutation
+typedef enum {
+    SUB_RECORD_PLAN = 1,
+    SUB_RECORD_SUBSCRIPTION = 2
+} SubscriptionRecordType;
 
 static SubscriptionRegistry g_sub_registry = {0};
 static int g_sub_initialized = 0;
 
-// Save to disk
+// Grow an array of size-byte entries to hold one more
+static int reserve_entry(void** items, uint32_t count, uint32_t* capacity, size_t size) {
+    if (count < *capacity) return 1;
+    uint32_t grown_capacity = *capacity ? *capacity * 2 : 64;
+    void* grown = realloc(*items, grown_capacity * size);
+    if (!grown) return 0;
+    *items = grown;
+    *capacity = grown_capacity;
+    return 1;
+}
+
+static int reserve_plan(void) {
+    return reserve_entry((void**)&g_sub_registry.plans, g_sub_registry.num_plans,
+                         &g_sub_registry.plan_capacity, sizeof(SubscriptionPlan));
+}
+
+static int reserve_subscription(void) {
+    return reserve_entry((void**)&g_sub_registry.subscriptions, g_sub_registry.num_subscriptions,
+                         &g_sub_registry.sub_capacity, sizeof(Subscription));
+}
+
+// Binary search by id (ids are handed out in order)
+static SubscriptionPlan* find_plan(uint64_t plan_id) {
+    uint32_t lo = 0, hi = g_sub_registry.num_plans;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t id = g_sub_registry.plans[mid].plan_id;
+        if (id == plan_id) return &g_sub_registry.plans[mid];
+        if (id < plan_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+static Subscription* find_subscription(uint64_t sub_id) {
+    uint32_t lo = 0, hi = g_sub_registry.num_subscriptions;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint64_t id = g_sub_registry.subscriptions[mid].subscription_id;
+        if (id == sub_id) return &g_sub_registry.subscriptions[mid];
+        if (id < sub_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+// Write everything as a new snapshot generation, then start its journal
 static PCError save_subscriptions(void) {
     FILE* f = fopen(SUBSCRIPTION_FILE ".tmp", "wb");
     if (!f) return PC_ERR_IO;
     
-    g_sub_registry.magic = SUBSCRIPTION_MAGIC;
-    g_sub_registry.version = 1;
-    
-    fwrite(&g_sub_registry, sizeof(SubscriptionRegistry), 1, f);
-    fflush(f);
-    fsync(fileno(f));
+    SubscriptionFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SUBSCRIPTION_MAGIC;
+    hdr.version = SUBSCRIPTION_VERSION;
+    hdr.num_plans = g_sub_registry.num_plans;
+    hdr.num_subscriptions = g_sub_registry.num_subscriptions;
+    hdr.next_plan_id = g_sub_registry.next_plan_id;
+    hdr.next_sub_id = g_sub_registry.next_sub_id;
+    hdr.generation = g_sub_registry.generation + 1;
+    
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+             fwrite(g_sub_registry.plans, sizeof(SubscriptionPlan), hdr.num_plans, f) == hdr.num_plans &&
+             fwrite(g_sub_registry.subscriptions, sizeof(Subscription),
+                    hdr.num_subscriptions, f) == hdr.num_subscriptions;
+    if (ok && (fflush(f) != 0 || fsync(fileno(f)) != 0)) ok = 0;
     fclose(f);
     
-    if (rename(SUBSCRIPTION_FILE ".tmp", SUBSCRIPTION_FILE) != 0) {
+    if (!ok || rename(SUBSCRIPTION_FILE ".tmp", SUBSCRIPTION_FILE) != 0) {
+        remove(SUBSCRIPTION_FILE ".tmp");
         return PC_ERR_IO;
     }
+    g_sub_registry.generation = hdr.generation;
     
+    return pc_journal_reset(&g_sub_registry.journal, hdr.generation);
+}
+
+// Record one mutated entry; folds the journal once it outgrows the registry
+static PCError log_entry(uint32_t type, const void* entry, uint32_t size) {
+    PCError err = pc_journal_append(&g_sub_registry.journal, type, entry, size);
+    if (err != PC_OK) return err;
+    
+    if (pc_journal_should_compact(&g_sub_registry.journal,
+                                  g_sub_registry.num_plans + g_sub_registry.num_subscriptions)) {
+        return save_subscriptions();
+    }
     return PC_OK;
 }
 
-// Load from disk
-static PCError load_subscriptions(void) {
-    FILE* f = fopen(SUBSCRIPTION_FILE, "rb");
-    if (!f) {
-        memset(&g_sub_registry, 0, sizeof(SubscriptionRegistry));
-        g_sub_registry.magic = SUBSCRIPTION_MAGIC;
-        g_sub_registry.version = 1;
-        g_sub_registry.next_plan_id = 1;
-        g_sub_registry.next_sub_id = 1;
-        g_sub_initialized = 1;
-        return PC_OK;
+static PCError log_plan(const SubscriptionPlan* plan) {
+    return log_entry(SUB_RECORD_PLAN, plan, sizeof(SubscriptionPlan));
+}
+
+static PCError log_subscription(const Subscription* sub) {
+    return log_entry(SUB_RECORD_SUBSCRIPTION, sub, sizeof(Subscription));
+}
+
+// Journal replay: insert or replace the plan or subscription
+static void apply_sub_record(void* ctx, uint32_t type, const void* data, uint32_t length) {
+    (void)ctx;
+    
+    if (type == SUB_RECORD_PLAN && length == sizeof(SubscriptionPlan)) {
+        SubscriptionPlan plan;
+        memcpy(&plan, data, sizeof(plan));
+        SubscriptionPlan* slot = find_plan(plan.plan_id);
+        if (!slot) {
+            uint32_t n = g_sub_registry.num_plans;
+            if (n > 0 && g_sub_registry.plans[n - 1].plan_id > plan.plan_id) return;
+            if (!reserve_plan()) return;
+            slot = &g_sub_registry.plans[g_sub_registry.num_plans++];
+        }
+        *slot = plan;
+        if (plan.plan_id >= g_sub_registry.next_plan_id) {
+            g_sub_registry.next_plan_id = plan.plan_id + 1;
+        }
+    } else if (type == SUB_RECORD_SUBSCRIPTION && length == sizeof(Subscription)) {
+        Subscription sub;
+        memcpy(&sub, data, sizeof(sub));
+        Subscription* slot = find_subscription(sub.subscription_id);
+        if (!slot) {
+            uint32_t n = g_sub_registry.num_subscriptions;
+            if (n > 0 && g_sub_registry.subscriptions[n - 1].subscription_id > sub.subscription_id) return;
+            if (!reserve_subscription()) return;
+            slot = &g_sub_registry.subscriptions[g_sub_registry.num_subscriptions++];
+        }
+        *slot = sub;
+        if (sub.subscription_id >= g_sub_registry.next_sub_id) {
+            g_sub_registry.next_sub_id = sub.subscription_id + 1;
+        }
     }
-    
-    if (fread(&g_sub_registry, sizeof(SubscriptionRegistry), 1, f) != 1) {
-        fclose(f);
+}
+
+// Copy plans and subscriptions into the registry arrays
+static int adopt_entries(const SubscriptionPlan* plans, uint32_t num_plans,
+                         const Subscription* subs, uint32_t num_subs) {
+    for (uint32_t i = 0; i < num_plans; i++) {
+        if (!reserve_plan()) return 0;
+        g_sub_registry.plans[g_sub_registry.num_plans++] = plans[i];
+    }
+    for (uint32_t i = 0; i < num_subs; i++) {
+        if (!reserve_subscription()) return 0;
+        g_sub_registry.subscriptions[g_sub_registry.num_subscriptions++] = subs[i];
+    }
+    return 1;
+}
+
+// Read a v1/v2 fixed-size registry
+static PCError load_legacy_subscriptions(FILE* f) {
+    LegacySubscriptionRegistry* legacy = malloc(sizeof(LegacySubscriptionRegistry));
+    if (!legacy) return PC_ERR_IO;
+    
+    rewind(f);
+    if (fread(legacy, sizeof(LegacySubscriptionRegistry), 1, f) != 1 ||
+        legacy->num_plans > LEGACY_MAX_SUBSCRIPTIONS ||
+        legacy->num_subscriptions > LEGACY_MAX_SUBSCRIPTIONS) {
+        free(legacy);
         return PC_ERR_IO;
     }
     
-    fclose(f);
+    // v1 registries held double coins in the price fields
+    if (legacy->version < SUBSCRIPTION_VERSION_FIXED) {
+        double price;
+        for (uint32_t i = 0; i < legacy->num_plans; i++) {
+            memcpy(&price, &legacy->plans[i].price, sizeof(price));
+            legacy->plans[i].price = pc_amount_from_coins(price);
+        }
+        for (uint32_t i = 0; i < legacy->num_subscriptions; i++) {
+            memcpy(&price, &legacy->subscriptions[i].price, sizeof(price));
+            legacy->subscriptions[i].price = pc_amount_from_coins(price);
+        }
+    }
     
-    if (g_sub_registry.magic != SUBSCRIPTION_MAGIC) {
-        return PC_ERR_IO;
+    g_sub_registry.next_plan_id = legacy->next_plan_id;
+    g_sub_registry.next_sub_id = legacy->next_sub_id;
+    int ok = adopt_entries(legacy->plans, legacy->num_plans,
+                           legacy->subscriptions, legacy->num_subscriptions);
+    free(legacy);
+    return ok ? PC_OK : PC_ERR_IO;
+}
+
+// Read a v3 snapshot
+static PCError load_snapshot_subscriptions(FILE* f, const SubscriptionFileHeader* hdr) {
+    g_sub_registry.next_plan_id = hdr->next_plan_id;
+    g_sub_registry.next_sub_id = hdr->next_sub_id;
+    g_sub_registry.generation = hdr->generation;
+    
+    for (uint32_t i = 0; i < hdr->num_plans; i++) {
+        if (!reserve_plan() ||
+            fread(&g_sub_registry.plans[i], sizeof(SubscriptionPlan), 1, f) != 1) return PC_ERR_IO;
+        g_sub_registry.num_plans++;
+    }
+    for (uint32_t i = 0; i < hdr->num_subscriptions; i++) {
+        if (!reserve_subscription() ||
+            fread(&g_sub_registry.subscriptions[i], sizeof(Subscription), 1, f) != 1) return PC_ERR_IO;
+        g_sub_registry.num_subscriptions++;
+    }
+    return PC_OK;
+}
+
+// Load the snapshot, then replay its journal
+static PCError load_subscriptions(void) {
+    free(g_sub_registry.plans);
+    free(g_sub_registry.subscriptions);
+    memset(&g_sub_registry, 0, sizeof(SubscriptionRegistry));
+    g_sub_registry.next_plan_id = 1;
+    g_sub_registry.next_sub_id = 1;
+    g_sub_registry.journal.fd = -1;
+    
+    FILE* f = fopen(SUBSCRIPTION_FILE, "rb");
+    if (f) {
+        SubscriptionFileHeader hdr;
+        PCError err = PC_ERR_IO;
+        if (fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == SUBSCRIPTION_MAGIC) {
+            err = hdr.version >= SUBSCRIPTION_VERSION ? load_snapshot_subscriptions(f, &hdr)
+                                                      : load_legacy_subscriptions(f);
+        }
+        fclose(f);
+        if (err != PC_OK) return err;
     }
     
+    PCError err = pc_journal_open(&g_sub_registry.journal, SUBSCRIPTION_JOURNAL,
+                                  g_sub_registry.generation, apply_sub_record, NULL);
+    if (err != PC_OK) return err;
+    
     g_sub_initialized = 1;
     
     printf("Loaded %u subscription plans, %u active subscriptions\n",
@@ -134,11 +348,12 @@ void sub_init(void) {
 
 // Create subscription plan
 uint64_t sub_create_plan(const uint8_t* provider_pubkey, const char* name,
-                         const char* description, double price,
+                         const char* description, PCAmount price,
                          SubscriptionType type) {
     if (!provider_pubkey || !name || price <= 0) return 0;
     
-    if (g_sub_registry.num_plans >= MAX_SUBSCRIPTIONS) return 0;
+    sub_init();
+    if (!reserve_plan()) return 0;
     
     SubscriptionPlan* plan = &g_sub_registry.plans[g_sub_registry.num_plans];
     
@@ -170,23 +385,19 @@ uint64_t sub_create_plan(const uint8_t* provider_pubkey, const char* name,
     }
     
     g_sub_registry.num_plans++;
-    save_subscriptions();
+    log_plan(plan);
     
     printf("Created subscription plan #%lu: %s (%.2f per period)\n",
-           plan->plan_id, name, price);
+           plan->plan_id, name, pc_amount_to_coins(price));
     
     return plan->plan_id;
 }
 
-// Get plan
+// Get an active plan
 static SubscriptionPlan* get_plan(uint64_t plan_id) {
-    for (uint32_t i = 0; i < g_sub_registry.num_plans; i++) {
-        if (g_sub_registry.plans[i].plan_id == plan_id && 
-            g_sub_registry.plans[i].active) {
-            return &g_sub_registry.plans[i];
-        }
-    }
-    return NULL;
+    sub_init();
+    SubscriptionPlan* plan = find_plan(plan_id);
+    return plan && plan->active ? plan : NULL;
 }
 
 // Subscribe to plan
@@ -197,7 +408,7 @@ uint64_t sub_subscribe(uint64_t plan_id, const uint8_t* subscriber_pubkey,
     SubscriptionPlan* plan = get_plan(plan_id);
     if (!plan) return 0;
     
-    if (g_sub_registry.num_subscriptions >= MAX_SUBSCRIPTIONS) return 0;
+    if (!reserve_subscription()) return 0;
     
     Subscription* sub = &g_sub_registry.subscriptions[g_sub_registry.num_subscriptions];
     
@@ -219,7 +430,7 @@ uint64_t sub_subscribe(uint64_t plan_id, const uint8_t* subscriber_pubkey,
     }
     
     g_sub_registry.num_subscriptions++;
-    save_subscriptions();
+    log_subscription(sub);
     
     printf("Subscription #%lu created for plan '%s'\n", 
            sub->subscription_id, plan->name);
@@ -229,12 +440,8 @@ uint64_t sub_subscribe(uint64_t plan_id, const uint8_t* subscriber_pubkey,
 
 // Get subscription
 static Subscription* get_subscription(uint64_t sub_id) {
-    for (uint32_t i = 0; i < g_sub_registry.num_subscriptions; i++) {
-        if (g_sub_registry.subscriptions[i].subscription_id == sub_id) {
-            return &g_sub_registry.subscriptions[i];
-        }
-    }
-    return NULL;
+    sub_init();
+    return find_subscription(sub_id);
 }
 
 // Cancel subscription
@@ -249,7 +456,7 @@ PCError sub_cancel(uint64_t sub_id) {
     sub->status = SUB_CANCELLED;
     sub->cancelled_at = time(NULL);
     
-    save_subscriptions();
+    log_subscription(sub);
     
     printf("Subscription #%lu cancelled\n", sub_id);
     
@@ -267,7 +474,7 @@ PCError sub_pause(uint64_t sub_id) {
     
     sub->status = SUB_PAUSED;
     
-    save_subscriptions();
+    log_subscription(sub);
     
     printf("Subscription #%lu paused\n", sub_id);
     
@@ -287,7 +494,7 @@ PCError sub_resume(uint64_t sub_id) {
     // Reset next billing to now + period
     sub->next_billing = time(NULL) + sub->billing_period;
     
-    save_subscriptions();
+    log_subscription(sub);
     
     printf("Subscription #%lu resumed\n", sub_id);
     
@@ -298,6 +505,7 @@ PCError sub_resume(uint64_t sub_id) {
 PCError sub_process_billing(PCState* state) {
     if (!state) return PC_ERR_IO;
     
+    sub_init();
     uint64_t now = time(NULL);
     uint32_t processed = 0;
     uint32_t failed = 0;
@@ -318,6 +526,7 @@ PCError sub_process_billing(PCState* state) {
             if (sub->payment_failures >= 3) {
                 sub->status = SUB_EXPIRED;
             }
+            log_subscription(sub);
             failed++;
             continue;
         }
@@ -330,38 +539,27 @@ PCError sub_process_billing(PCState* state) {
                 printf("Subscription #%lu expired due to insufficient funds\n", 
                        sub->subscription_id);
             }
+            log_subscription(sub);
             failed++;
             continue;
         }
         
-        // Execute payment
-        double before_sum = subscriber->energy + provider->energy;
+        // Execute payment (exact integer move)
         subscriber->energy -= sub->price;
         provider->energy += sub->price;
-        double after_sum = subscriber->energy + provider->energy;
-        
-        // Verify conservation
-        if (fabs(before_sum - after_sum) > 1e-12) {
-            // Rollback
-            subscriber->energy += sub->price;
-            provider->energy -= sub->price;
-            sub->payment_failures++;
-            failed++;
-            continue;
-        }
         
         // Success - update subscription
         subscriber->nonce++;
         sub->next_billing = now + sub->billing_period;
         sub->payment_failures = 0;
+        log_subscription(sub);
         processed++;
         
         printf("Subscription #%lu billed: %.2f coins\n", 
-               sub->subscription_id, sub->price);
+               sub->subscription_id, pc_amount_to_coins(sub->price));
     }
     
     if (processed > 0 || failed > 0) {
-        save_subscriptions();
         printf("Billing complete: %u processed, %u failed\n", processed, failed);
     }
     
@@ -387,7 +585,7 @@ void sub_list_plans(void) {
         }
         
         printf("│ %-6lu │ %-24s │ %10.2f │ %-8s │\n",
-               p->plan_id, p->name, p->price, period);
+               p->plan_id, p->name, pc_amount_to_coins(p->price), period);
     }
     
     printf("└────────┴──────────────────────────┴────────────┴──────────┘\n");
@@ -427,7 +625,7 @@ void sub_list_subscriptions(void) {
         }
         
         printf("│ %-6lu │ %-7lu │ %10.2f │ %-17s │\n",
-               s->subscription_id, s->plan_id, s->price, next_billing);
+               s->subscription_id, s->plan_id, pc_amount_to_coins(s->price), next_billing);
     }
     
     printf("└────────┴─────────┴────────────┴───────────────────┘\n");
@@ -445,7 +643,7 @@ void sub_info(uint64_t sub_id) {
     
     printf("\nSubscription #%lu:\n", sub_id);
     printf("  Plan: %s\n", plan ? plan->name : "Unknown");
-    printf("  Price: %.2f per billing period\n", sub->price);
+    printf("  Price: %.2f per billing period\n", pc_amount_to_coins(sub->price));
     printf("  Status: ");
     switch (sub->status) {
         case SUB_ACTIVE: printf("ACTIVE\n"); break;
@@ -476,6 +674,7 @@ void sub_cleanup(void) {
         }
     }
     
+    // Removals are not journaled: write a fresh snapshot instead
     if (removed > 0) {
         save_subscriptions();
         printf("Cleaned up %u expired/cancelled subscriptions\n", removed);
@@ -1,78 +1,342 @@
 // timetravel.c - Time-Travel Balance Queries
 // Query wallet balance at any point in history using checkpoints
+// Per-wallet change logs answer exactly between checkpoints
+// Checkpoints share unchanged wallet and key pages (refcounted), so each one
+// costs only the pages that changed since the previous checkpoint
 
 #include "../include/physicscoin.h"
+#include "../include/timetravel.h"
 #include "../crypto/sha256.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
 
-#define MAX_CHECKPOINTS 10000
+#define CHECKPOINT_INITIAL_CAPACITY 64
+#define LOG_INITIAL_CAPACITY 4
+#define LOG_INDEX_INITIAL_CAPACITY 64
+#define LOG_INDEX_EMPTY 0
+#define CHECKPOINT_MAX_STATE_BYTES (1ull << 32)  // Larger sizes in a file are corruption
+#define PAGE_HEADER 16  // Refcount ahead of each page; keeps page data 16-byte aligned
 
-// State checkpoint structure
-typedef struct {
-    uint8_t state_hash[32];
-    uint64_t timestamp;
-    uint32_t transaction_index;  // Which transaction created this state
-    PCState state;                // Full state at this point
-} PCStateCheckpoint;
+// ============ Shared pages ============
 
-// Checkpoint history
-typedef struct {
-    PCStateCheckpoint* checkpoints;
-    uint32_t num_checkpoints;
-    uint32_t checkpoint_interval;  // Checkpoint every N transactions
-} PCCheckpointHistory;
+// New page holding a copy of bytes (refcount 1)
+static void* page_copy(const void* src, size_t bytes) {
+    uint8_t* block = malloc(PAGE_HEADER + bytes);
+    if (!block) return NULL;
+    *(uint64_t*)block = 1;
+    memcpy(block + PAGE_HEADER, src, bytes);
+    return block + PAGE_HEADER;
+}
+
+static void* page_share(void* page) {
+    (*(uint64_t*)((uint8_t*)page - PAGE_HEADER))++;
+    return page;
+}
+
+static void page_release(void* page) {
+    if (!page) return;
+    uint64_t* refs = (uint64_t*)((uint8_t*)page - PAGE_HEADER);
+    if (--*refs == 0) free(refs);
+}
+
+// Drop a checkpoint's page references, then its directory and index
+static void checkpoint_state_free(PCState* cp) {
+    for (uint32_t p = 0; p < cp->num_pages; p++) {
+        page_release(cp->wallet_pages[p]);
+        page_release(cp->key_pages[p]);
+    }
+    pc_state_free(cp);  // page_flags are clear: the state owns no pages
+}
+
+// Wallets in use on page p; checkpoints keep only these, so a partly filled
+// tail page costs what it holds
+static uint32_t page_used(const PCState* state, uint32_t p) {
+    uint32_t left = state->num_wallets - (p << PC_WALLET_PAGE_SHIFT);
+    return left < PC_WALLET_PAGE_SIZE ? left : PC_WALLET_PAGE_SIZE;
+}
+
+// Share prev's page when state still holds the same bytes, else copy it
+static void* checkpoint_page(void* prev_page, const void* page, size_t bytes) {
+    if (prev_page && memcmp(prev_page, page, bytes) == 0) return page_share(prev_page);
+    return page_copy(page, bytes);
+}
+
+// Build a read-only copy of state that shares unchanged pages with prev
+static PCError checkpoint_state(PCState* cp, const PCState* state, const PCState* prev) {
+    memset(cp, 0, sizeof(PCState));
+    uint32_t slots = state->num_pages ? state->num_pages : 1;
+    cp->wallet_pages = calloc(slots, sizeof(PCWallet*));
+    cp->key_pages = calloc(slots, sizeof(uint8_t*));
+    cp->page_flags = calloc(slots, 1);
+    if (!cp->wallet_pages || !cp->key_pages || !cp->page_flags) {
+        pc_state_free(cp);
+        return PC_ERR_IO;
+    }
+    cp->page_slots = slots;
+    
+    cp->version = state->version;
+    cp->timestamp = state->timestamp;
+    cp->num_wallets = state->num_wallets;
+    cp->total_supply = state->total_supply;
+    memcpy(cp->state_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(cp->prev_hash, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
+    cp->index_seed = state->index_seed;
+    
+    // Pages past num_wallets hold nothing and are left out; prev's page is
+    // only a candidate when it holds as many wallets
+    uint32_t pages = (state->num_wallets + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    for (uint32_t p = 0; p < pages; p++) {
+        uint32_t used = page_used(state, p);
+        int shared = prev && p < prev->num_pages && page_used(prev, p) == used;
+        cp->wallet_pages[p] = checkpoint_page(shared ? prev->wallet_pages[p] : NULL,
+                                              state->wallet_pages[p], used * sizeof(PCWallet));
+        cp->key_pages[p] = checkpoint_page(shared ? prev->key_pages[p] : NULL,
+                                           state->key_pages[p], (size_t)used * PHYSICSCOIN_KEY_SIZE);
+        cp->num_pages = p + 1;
+        if (!cp->wallet_pages[p] || !cp->key_pages[p]) {
+            checkpoint_state_free(cp);
+            return PC_ERR_IO;
+        }
+    }
+    
+    // Merkle tree is rebuilt lazily if anyone hashes the checkpoint
+    pc_merkle_invalidate(&cp->merkle);
+    return PC_OK;
+}
+
+// Copy the state's index when it covers every wallet, else build one
+static PCError checkpoint_index(PCState* cp, const PCState* state) {
+    if (state->index_capacity == 0 || state->index_count != state->num_wallets) {
+        return pc_state_rebuild_index(cp);
+    }
+    
+    cp->wallet_index = malloc((size_t)state->index_capacity * sizeof(uint64_t));
+    if (!cp->wallet_index) return PC_ERR_IO;
+    memcpy(cp->wallet_index, state->wallet_index, (size_t)state->index_capacity * sizeof(uint64_t));
+    cp->index_capacity = state->index_capacity;
+    cp->index_count = state->index_count;
+    return PC_OK;
+}
 
 // Initialize checkpoint history
 PCError pc_checkpoints_init(PCCheckpointHistory* history, uint32_t interval) {
     if (!history) return PC_ERR_IO;
     
-    history->checkpoints = calloc(MAX_CHECKPOINTS, sizeof(PCStateCheckpoint));
+    memset(history, 0, sizeof(PCCheckpointHistory));
+    history->checkpoints = calloc(CHECKPOINT_INITIAL_CAPACITY, sizeof(PCStateCheckpoint));
     if (!history->checkpoints) return PC_ERR_IO;
     
     history->num_checkpoints = 0;
     history->checkpoint_interval = interval;
+    history->capacity = CHECKPOINT_INITIAL_CAPACITY;
     
     return PC_OK;
 }
 
-// Add checkpoint
-PCError pc_checkpoints_add(PCCheckpointHistory* history, const PCState* state, uint32_t tx_index) {
-    if (!history || !state) return PC_ERR_IO;
-    if (history->num_checkpoints >= MAX_CHECKPOINTS) {
-        return PC_ERR_MAX_WALLETS;
+// Append a checkpoint of state with the given metadata
+static PCError add_checkpoint(PCCheckpointHistory* history, const PCState* state,
+                              const uint8_t* state_hash, uint64_t timestamp, uint32_t tx_index) {
+    if (history->num_checkpoints == history->capacity) {
+        uint32_t capacity = history->capacity ? history->capacity * 2 : CHECKPOINT_INITIAL_CAPACITY;
+        PCStateCheckpoint* grown = realloc(history->checkpoints, capacity * sizeof(PCStateCheckpoint));
+        if (!grown) return PC_ERR_IO;
+        history->checkpoints = grown;
+        history->capacity = capacity;
     }
     
+    PCStateCheckpoint* prev = history->num_checkpoints > 0 ?
+                              &history->checkpoints[history->num_checkpoints - 1] : NULL;
     PCStateCheckpoint* cp = &history->checkpoints[history->num_checkpoints];
     
     // Copy metadata
-    memcpy(cp->state_hash, state->state_hash, 32);
-    cp->timestamp = state->timestamp;
+    memcpy(cp->state_hash, state_hash, 32);
+    cp->timestamp = timestamp;
     cp->transaction_index = tx_index;
     
-    // Deep copy state
-    cp->state.version = state->version;
-    cp->state.total_supply = state->total_supply;
-    cp->state.num_wallets = state->num_wallets;
-    cp->state.timestamp = state->timestamp;
-    memcpy(cp->state.state_hash, state->state_hash, 32);
-    memcpy(cp->state.prev_hash, state->prev_hash, 32);
-    
-    cp->state.wallets = malloc(state->num_wallets * sizeof(PCWallet));
-    if (!cp->state.wallets) return PC_ERR_IO;
+    if (checkpoint_state(&cp->state, state, prev ? &prev->state : NULL) != PC_OK) return PC_ERR_IO;
     
-    memcpy(cp->state.wallets, state->wallets, 
-           state->num_wallets * sizeof(PCWallet));
+    // Wallets are never removed, so the newest checkpoint's index resolves
+    // keys for every older one; only it keeps an index
+    if (checkpoint_index(&cp->state, state) != PC_OK) {
+        checkpoint_state_free(&cp->state);
+        return PC_ERR_IO;
+    }
+    if (prev) {
+        free(prev->state.wallet_index);
+        prev->state.wallet_index = NULL;
+        prev->state.index_capacity = 0;
+        prev->state.index_count = 0;
+    }
     
     history->num_checkpoints++;
     
     return PC_OK;
 }
 
+// Add checkpoint
+PCError pc_checkpoints_add(PCCheckpointHistory* history, const PCState* state, uint32_t tx_index) {
+    if (!history || !state) return PC_ERR_IO;
+    return add_checkpoint(history, state, state->state_hash, state->timestamp, tx_index);
+}
+
+// ============ Wallet change logs ============
+
+// Keyed 64-bit mix of a 32-byte public key (keys are user-chosen)
+static inline uint64_t log_hash(uint64_t seed, const uint8_t* pubkey) {
+    uint64_t w[4];
+    memcpy(w, pubkey, sizeof(w));
+    
+    uint64_t h = seed;
+    for (int i = 0; i < 4; i++) {
+        h ^= w[i];
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 29;
+    return h;
+}
+
+static void log_index_place(uint64_t* slots, uint32_t capacity, uint64_t h, uint32_t log) {
+    uint32_t mask = capacity - 1;
+    uint32_t pos = (uint32_t)h & mask;
+    
+    while (slots[pos] != LOG_INDEX_EMPTY) {
+        pos = (pos + 1) & mask;
+    }
+    slots[pos] = ((h >> 32) << 32) | ((uint64_t)log + 1);
+}
+
+// Log for pubkey, or NULL when the wallet has no recorded change
+static PCWalletLog* find_log(const PCCheckpointHistory* history, const uint8_t* pubkey) {
+    if (history->log_index_capacity == 0) return NULL;
+    
+    uint64_t h = log_hash(history->log_seed, pubkey);
+    uint64_t tag = h >> 32;
+    uint32_t mask = history->log_index_capacity - 1;
+    uint32_t pos = (uint32_t)h & mask;
+    uint64_t slot;
+    
+    while ((slot = history->log_index[pos]) != LOG_INDEX_EMPTY) {
+        if ((slot >> 32) == tag) {
+            PCWalletLog* log = &history->logs[(uint32_t)slot - 1];
+            if (memcmp(log->pubkey, pubkey, 32) == 0) return log;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return NULL;
+}
+
+// Log for pubkey, created on first use
+static PCWalletLog* get_log(PCCheckpointHistory* history, const uint8_t* pubkey) {
+    PCWalletLog* log = find_log(history, pubkey);
+    if (log) return log;
+    
+    if (history->num_logs == history->log_capacity) {
+        uint32_t capacity = history->log_capacity ? history->log_capacity * 2 : LOG_INDEX_INITIAL_CAPACITY;
+        PCWalletLog* grown = realloc(history->logs, capacity * sizeof(PCWalletLog));
+        if (!grown) return NULL;
+        history->logs = grown;
+        history->log_capacity = capacity;
+    }
+    
+    // Keep the index at most 3/4 full
+    if ((uint64_t)(history->num_logs + 1) * 4 > (uint64_t)history->log_index_capacity * 3) {
+        uint32_t capacity = history->log_index_capacity ? history->log_index_capacity * 2 : LOG_INDEX_INITIAL_CAPACITY;
+        uint64_t* slots = calloc(capacity, sizeof(uint64_t));
+        if (!slots) return NULL;
+        
+        if (history->log_seed == 0) {
+            history->log_seed = ((uint64_t)time(NULL) << 32) ^ (uint64_t)(uintptr_t)history ^
+                                0x9e3779b97f4a7c15ULL;
+        }
+        for (uint32_t i = 0; i < history->num_logs; i++) {
+            log_index_place(slots, capacity, log_hash(history->log_seed, history->logs[i].pubkey), i);
+        }
+        free(history->log_index);
+        history->log_index = slots;
+        history->log_index_capacity = capacity;
+    }
+    
+    log = &history->logs[history->num_logs];
+    memset(log, 0, sizeof(PCWalletLog));
+    memcpy(log->pubkey, pubkey, 32);
+    log_index_place(history->log_index, history->log_index_capacity,
+                    log_hash(history->log_seed, pubkey), history->num_logs);
+    history->num_logs++;
+    return log;
+}
+
+// Append the wallet's current contents to its log
+static PCError log_wallet(PCCheckpointHistory* history, const PCState* state,
+                          const uint8_t* pubkey, uint64_t timestamp) {
+    const PCWallet* wallet = pc_state_find_wallet(state, pubkey);
+    if (!wallet) return PC_ERR_WALLET_NOT_FOUND;
+    
+    PCWalletLog* log = get_log(history, pubkey);
+    if (!log) return PC_ERR_IO;
+    
+    if (log->num_changes == log->capacity) {
+        uint32_t capacity = log->capacity ? log->capacity * 2 : LOG_INITIAL_CAPACITY;
+        PCBalanceChange* grown = realloc(log->changes, capacity * sizeof(PCBalanceChange));
+        if (!grown) return PC_ERR_IO;
+        log->changes = grown;
+        log->capacity = capacity;
+    }
+    
+    // Lookups binary-search timestamps, so a clock step back must not reorder them
+    if (log->num_changes > 0 && timestamp < log->changes[log->num_changes - 1].timestamp) {
+        timestamp = log->changes[log->num_changes - 1].timestamp;
+    }
+    
+    PCBalanceChange* change = &log->changes[log->num_changes++];
+    change->timestamp = timestamp;
+    change->version = ++history->version;
+    change->energy = wallet->energy;
+    change->nonce = wallet->nonce;
+    return PC_OK;
+}
+
+// Record both sides of a transaction just applied to state
+PCError pc_checkpoints_record_tx(PCCheckpointHistory* history, const PCState* state,
+                                 const PCTransaction* tx) {
+    if (!history || !state || !tx) return PC_ERR_IO;
+    
+    PCError err = log_wallet(history, state, tx->from, state->timestamp);
+    if (err != PC_OK) return err;
+    return log_wallet(history, state, tx->to, state->timestamp);
+}
+
+// Record one wallet changed outside a transaction (e.g. a faucet grant)
+PCError pc_checkpoints_record_wallet(PCCheckpointHistory* history, const PCState* state,
+                                     const uint8_t* pubkey, uint64_t timestamp) {
+    if (!history || !state || !pubkey) return PC_ERR_IO;
+    return log_wallet(history, state, pubkey, timestamp);
+}
+
+// Last change at or before timestamp, or NULL when the log starts later
+static const PCBalanceChange* find_change_before(const PCWalletLog* log, uint64_t timestamp) {
+    uint32_t left = 0;
+    uint32_t right = log->num_changes;
+    
+    // First change after timestamp; the one before it is the answer
+    while (left < right) {
+        uint32_t mid = left + (right - left) / 2;
+        if (log->changes[mid].timestamp <= timestamp) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    
+    return left > 0 ? &log->changes[left - 1] : NULL;
+}
+
 // Find checkpoint closest to (but before) timestamp
-static PCStateCheckpoint* find_checkpoint_before(PCCheckpointHistory* history, uint64_t timestamp) {
+static PCStateCheckpoint* find_checkpoint_before(const PCCheckpointHistory* history, uint64_t timestamp) {
     if (history->num_checkpoints == 0) return NULL;
     
     // Binary search for closest checkpoint
@@ -95,14 +359,52 @@ static PCStateCheckpoint* find_checkpoint_before(PCCheckpointHistory* history, u
     return best;
 }
 
-// Query balance at specific timestamp
-PCError pc_query_balance_at(PCCheckpointHistory* history,
-                             const uint8_t* pubkey,
-                             uint64_t timestamp,
-                             double* balance) {
-    if (!history || !pubkey || !balance) return PC_ERR_IO;
+// Drop the oldest checkpoints and the changes made before the oldest one
+// kept. A wallet unchanged since then reads from the checkpoints, so answers
+// from that timestamp on stay exact.
+PCError pc_checkpoints_trim(PCCheckpointHistory* history, uint32_t keep) {
+    if (!history) return PC_ERR_IO;
+    if (keep == 0) keep = 1;  // The newest checkpoint holds the key index
+    if (history->num_checkpoints <= keep) return PC_OK;
+    
+    uint32_t drop = history->num_checkpoints - keep;
+    for (uint32_t i = 0; i < drop; i++) {
+        checkpoint_state_free(&history->checkpoints[i].state);
+    }
+    memmove(history->checkpoints, history->checkpoints + drop, keep * sizeof(PCStateCheckpoint));
+    history->num_checkpoints = keep;
+    
+    uint64_t cutoff = history->checkpoints[0].timestamp;
+    if (cutoff == 0) return PC_OK;
+    for (uint32_t i = 0; i < history->num_logs; i++) {
+        PCWalletLog* log = &history->logs[i];
+        const PCBalanceChange* last = find_change_before(log, cutoff - 1);
+        if (!last) continue;
+        
+        uint32_t gone = (uint32_t)(last - log->changes) + 1;
+        log->num_changes -= gone;
+        memmove(log->changes, log->changes + gone, log->num_changes * sizeof(PCBalanceChange));
+    }
+    return PC_OK;
+}
+
+// Query wallet contents at specific timestamp
+PCError pc_query_wallet_at(PCCheckpointHistory* history,
+                           const uint8_t* pubkey,
+                           uint64_t timestamp,
+                           PCWallet* wallet) {
+    if (!history || !pubkey || !wallet) return PC_ERR_IO;
+    
+    // Exact when the wallet changed at or before timestamp
+    const PCWalletLog* log = find_log(history, pubkey);
+    const PCBalanceChange* change = log ? find_change_before(log, timestamp) : NULL;
+    if (change) {
+        wallet->energy = change->energy;
+        wallet->nonce = change->nonce;
+        return PC_OK;
+    }
     
-    // Find checkpoint before timestamp
+    // Otherwise it is unchanged since the checkpoint before timestamp
     PCStateCheckpoint* cp = find_checkpoint_before(history, timestamp);
     
     if (!cp) {
@@ -110,17 +412,78 @@ PCError pc_query_balance_at(PCCheckpointHistory* history,
         return PC_ERR_WALLET_NOT_FOUND;
     }
     
-    printf("Using checkpoint at timestamp %lu (TX %u)\n", 
+    printf("Using checkpoint at timestamp %lu (TX %u)\n",
            cp->timestamp, cp->transaction_index);
     
-    // Find wallet in this checkpoint
-    PCWallet* wallet = pc_state_get_wallet(&cp->state, pubkey);
+    // Resolve the key through the newest index; wallets created after this
+    // checkpoint did not exist yet
+    const PCState* newest = &history->checkpoints[history->num_checkpoints - 1].state;
+    uint32_t idx;
     
-    if (!wallet) {
-        *balance = 0.0;
+    if (pc_state_find_index(newest, pubkey, &idx) != PC_OK || idx >= cp->state.num_wallets) {
+        memset(wallet, 0, sizeof(PCWallet));
         printf("Wallet not found at that time (balance: 0)\n");
     } else {
-        *balance = wallet->energy;
+        *wallet = *pc_state_wallet_at(&cp->state, idx);
+    }
+    
+    return PC_OK;
+}
+
+// Query balance at specific timestamp
+PCError pc_query_balance_at(PCCheckpointHistory* history,
+                             const uint8_t* pubkey,
+                             uint64_t timestamp,
+                             PCAmount* balance) {
+    if (!balance) return PC_ERR_IO;
+    
+    PCWallet wallet;
+    PCError err = pc_query_wallet_at(history, pubkey, timestamp, &wallet);
+    if (err == PC_OK) *balance = wallet.energy;
+    return err;
+}
+
+// Balance series for a set of wallets; each wallet's log and the checkpoint
+// list are walked once with cursors that only move forward
+PCError pc_query_balance_range(const PCCheckpointHistory* history, const uint8_t* pubkeys,
+                               uint32_t num_keys, uint64_t t0, uint64_t t1, uint64_t step,
+                               PCAmount* out) {
+    if (!history || (num_keys > 0 && (!pubkeys || !out))) return PC_ERR_IO;
+    
+    uint32_t points = pc_query_range_points(t0, t1, step);
+    if (points == 0) return PC_ERR_INVALID_DATA;
+    
+    const PCState* newest = history->num_checkpoints > 0 ?
+                            &history->checkpoints[history->num_checkpoints - 1].state : NULL;
+    
+    for (uint32_t k = 0; k < num_keys; k++) {
+        const uint8_t* pubkey = pubkeys + (size_t)k * PHYSICSCOIN_KEY_SIZE;
+        PCAmount* row = out + (size_t)k * points;
+        
+        const PCWalletLog* log = find_log(history, pubkey);
+        uint32_t idx;
+        int indexed = newest && pc_state_find_index(newest, pubkey, &idx) == PC_OK;
+        
+        // Cursors: first change / checkpoint after the current sample
+        const PCBalanceChange* first = log ? find_change_before(log, t0) : NULL;
+        uint32_t c = first ? (uint32_t)(first - log->changes) + 1 : 0;
+        const PCStateCheckpoint* cp = find_checkpoint_before(history, t0);
+        uint32_t n = cp ? (uint32_t)(cp - history->checkpoints) + 1 : 0;
+        
+        uint64_t t = t0;
+        for (uint32_t i = 0; i < points; i++, t += step) {
+            while (log && c < log->num_changes && log->changes[c].timestamp <= t) c++;
+            
+            if (c > 0) {
+                row[i] = log->changes[c - 1].energy;
+                continue;
+            }
+            
+            // Not changed yet: read the checkpoint before t
+            while (n < history->num_checkpoints && history->checkpoints[n].timestamp <= t) n++;
+            const PCState* at = n > 0 ? &history->checkpoints[n - 1].state : NULL;
+            row[i] = at && indexed && idx < at->num_wallets ? pc_state_wallet_at(at, idx)->energy : 0;
+        }
     }
     
     return PC_OK;
@@ -147,7 +510,7 @@ void pc_checkpoints_print(const PCCheckpointHistory* history) {
     for (uint32_t i = 0; i < history->num_checkpoints; i++) {
         const PCStateCheckpoint* cp = &history->checkpoints[i];
         
-        printf("[%u] TX %u | Time %lu | Hash ", 
+        printf("[%u] TX %u | Time %lu | Hash ",
                i, cp->transaction_index, cp->timestamp);
         for (int j = 0; j < 8; j++) printf("%02x", cp->state_hash[j]);
         printf("...\n");
@@ -158,33 +521,62 @@ void pc_checkpoints_print(const PCCheckpointHistory* history) {
 void pc_checkpoints_free(PCCheckpointHistory* history) {
     if (history && history->checkpoints) {
         for (uint32_t i = 0; i < history->num_checkpoints; i++) {
-            if (history->checkpoints[i].state.wallets) {
-                free(history->checkpoints[i].state.wallets);
-            }
+            checkpoint_state_free(&history->checkpoints[i].state);
         }
         free(history->checkpoints);
         history->checkpoints = NULL;
         history->num_checkpoints = 0;
+        history->capacity = 0;
+    }
+    if (history) {
+        for (uint32_t i = 0; i < history->num_logs; i++) {
+            free(history->logs[i].changes);
+        }
+        free(history->logs);
+        free(history->log_index);
+        history->logs = NULL;
+        history->log_index = NULL;
+        history->num_logs = 0;
+        history->log_capacity = 0;
+        history->log_index_capacity = 0;
     }
 }
 
-// Calculate storage used by checkpoints
+// Calculate storage used by checkpoints (each shared page counted once)
 size_t pc_checkpoints_storage(const PCCheckpointHistory* history) {
     if (!history) return 0;
     
     size_t total = 0;
     
     for (uint32_t i = 0; i < history->num_checkpoints; i++) {
-        const PCStateCheckpoint* cp = &history->checkpoints[i];
+        const PCState* state = &history->checkpoints[i].state;
+        const PCState* prev = i > 0 ? &history->checkpoints[i - 1].state : NULL;
         
         // Hash + timestamp + index
         total += 32 + 8 + 4;
         
-        // State
-        total += sizeof(PCWallet) * cp->state.num_wallets;
-        total += 100;  // Overhead
+        // Page directory, then the pages this checkpoint introduced; a page
+        // is only ever shared along a run of consecutive checkpoints
+        total += state->num_pages * (sizeof(PCWallet*) + sizeof(uint8_t*) + 1);
+        for (uint32_t p = 0; p < state->num_pages; p++) {
+            int shared = prev && p < prev->num_pages;
+            size_t used = page_used(state, p);
+            if (!shared || prev->wallet_pages[p] != state->wallet_pages[p]) {
+                total += PAGE_HEADER + used * sizeof(PCWallet);
+            }
+            if (!shared || prev->key_pages[p] != state->key_pages[p]) {
+                total += PAGE_HEADER + used * PHYSICSCOIN_KEY_SIZE;
+            }
+        }
+        total += (size_t)state->index_capacity * sizeof(uint64_t);
     }
     
+    // Change logs
+    for (uint32_t i = 0; i < history->num_logs; i++) {
+        total += 32 + (size_t)history->logs[i].num_changes * sizeof(PCBalanceChange);
+    }
+    total += (size_t)history->log_index_capacity * sizeof(uint64_t);
+    
     return total;
 }
 
@@ -197,8 +589,23 @@ PCError pc_checkpoints_save(const PCCheckpointHistory* history, const char* file
     fwrite(&history->num_checkpoints, sizeof(uint32_t), 1, f);
     fwrite(&history->checkpoint_interval, sizeof(uint32_t), 1, f);
     
-    // Write each checkpoint
+    // Compact records never exceed a raw record plus block framing
+    uint32_t max_wallets = 0;
     for (uint32_t i = 0; i < history->num_checkpoints; i++) {
+        if (history->checkpoints[i].state.num_wallets > max_wallets) {
+            max_wallets = history->checkpoints[i].state.num_wallets;
+        }
+    }
+    size_t cap = 4096 + (size_t)max_wallets * 64;
+    uint8_t* state_buf = malloc(cap);
+    if (!state_buf) {
+        fclose(f);
+        return PC_ERR_IO;
+    }
+    
+    // Write each checkpoint
+    int ok = 1;
+    for (uint32_t i = 0; ok && i < history->num_checkpoints; i++) {
         const PCStateCheckpoint* cp = &history->checkpoints[i];
         
         fwrite(cp->state_hash, 32, 1, f);
@@ -206,61 +613,70 @@ PCError pc_checkpoints_save(const PCCheckpointHistory* history, const char* file
         fwrite(&cp->transaction_index, sizeof(uint32_t), 1, f);
         
         // Serialize state
-        uint8_t state_buf[65536];
-        size_t state_size = pc_state_serialize(&cp->state, state_buf, sizeof(state_buf));
+        size_t state_size = pc_state_serialize_compact(&cp->state, state_buf, cap);
+        ok = state_size > 0;
         fwrite(&state_size, sizeof(size_t), 1, f);
         fwrite(state_buf, state_size, 1, f);
     }
     
-    fclose(f);
-    return PC_OK;
+    free(state_buf);
+    if (fclose(f) != 0) ok = 0;
+    return ok ? PC_OK : PC_ERR_IO;
 }
 
-// Load checkpoints from file
+// Load checkpoints from file; consecutive checkpoints share pages again
 PCError pc_checkpoints_load(PCCheckpointHistory* history, const char* filename) {
     FILE* f = fopen(filename, "rb");
     if (!f) return PC_ERR_IO;
     
     // Read header
-    if (fread(&history->num_checkpoints, sizeof(uint32_t), 1, f) != 1) {
+    uint32_t count, interval;
+    if (fread(&count, sizeof(uint32_t), 1, f) != 1 ||
+        fread(&interval, sizeof(uint32_t), 1, f) != 1 ||
+        pc_checkpoints_init(history, interval) != PC_OK) {
         fclose(f);
         return PC_ERR_IO;
     }
     
-    if (fread(&history->checkpoint_interval, sizeof(uint32_t), 1, f) != 1) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
-    
-    history->checkpoints = calloc(history->num_checkpoints, sizeof(PCStateCheckpoint));
-    if (!history->checkpoints) {
-        fclose(f);
-        return PC_ERR_IO;
-    }
+    uint8_t* state_buf = NULL;
+    size_t buf_size = 0;
+    PCState state = {0};
     
     // Read each checkpoint
-    for (uint32_t i = 0; i < history->num_checkpoints; i++) {
-        PCStateCheckpoint* cp = &history->checkpoints[i];
-        
-        if (fread(cp->state_hash, 32, 1, f) != 1) goto error;
-        if (fread(&cp->timestamp, sizeof(uint64_t), 1, f) != 1) goto error;
-        if (fread(&cp->transaction_index, sizeof(uint32_t), 1, f) != 1) goto error;
-        
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t state_hash[32];
+        uint64_t timestamp;
+        uint32_t tx_index;
         size_t state_size;
+        
+        if (fread(state_hash, 32, 1, f) != 1) goto error;
+        if (fread(&timestamp, sizeof(uint64_t), 1, f) != 1) goto error;
+        if (fread(&tx_index, sizeof(uint32_t), 1, f) != 1) goto error;
         if (fread(&state_size, sizeof(size_t), 1, f) != 1) goto error;
+        if (state_size == 0 || state_size > CHECKPOINT_MAX_STATE_BYTES) goto error;
         
-        uint8_t state_buf[65536];
+        if (state_size > buf_size) {
+            uint8_t* grown = realloc(state_buf, state_size);
+            if (!grown) goto error;
+            state_buf = grown;
+            buf_size = state_size;
+        }
         if (fread(state_buf, state_size, 1, f) != 1) goto error;
         
-        if (pc_state_deserialize(&cp->state, state_buf, state_size) != PC_OK) {
+        if (pc_state_deserialize(&state, state_buf, state_size) != PC_OK ||
+            add_checkpoint(history, &state, state_hash, timestamp, tx_index) != PC_OK) {
             goto error;
         }
     }
     
+    pc_state_free(&state);
+    free(state_buf);
     fclose(f);
     return PC_OK;
-    
+
 error:
+    pc_state_free(&state);
+    free(state_buf);
     pc_checkpoints_free(history);
     fclose(f);
     return PC_ERR_IO;
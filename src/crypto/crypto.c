@@ -3,6 +3,7 @@
 
 #include "../include/physicscoin.h"
 #include "sha256.h"
+#include "ed25519.h"
 #include <sodium.h>
 #include <string.h>
 #include <stdio.h>
@@ -37,6 +38,11 @@ PCError pc_keypair_generate(PCKeypair* kp) {
     return PC_OK;
 }
 
+// All-zero signature prefix marks an unsigned transaction
+static inline int is_unsigned(const uint8_t* sig) {
+    return *(const uint64_t*)sig == 0 && *(const uint64_t*)(sig + 8) == 0;
+}
+
 static inline size_t create_message(const PCTransaction* tx, uint8_t* message) {
     memcpy(message, tx->from, 32);
     memcpy(message + 32, tx->to, 32);
@@ -64,37 +70,85 @@ PCError pc_transaction_sign(PCTransaction* tx, const PCKeypair* kp) {
 PCError pc_transaction_verify(const PCTransaction* tx) {
     ensure_sodium_init();
     
-    if (*(uint64_t*)tx->signature == 0 && *(uint64_t*)(tx->signature + 8) == 0) {
+    if (is_unsigned(tx->signature)) {
         return PC_ERR_INVALID_SIGNATURE;
     }
     
     uint8_t message[128];
     size_t msg_len = create_message(tx, message);
     
-    if (crypto_sign_verify_detached(tx->signature, message, msg_len, tx->from) != 0) {
+    // Cofactored, so the verdict matches the batch path
+    if (!ed25519_verify(message, msg_len, tx->from, tx->signature)) {
         return PC_ERR_INVALID_SIGNATURE;
     }
     
     return PC_OK;
 }
 
-// OpenMP parallel batch verification
-int pc_transaction_verify_batch(const PCTransaction** txs, int count, int* results) {
-    ensure_sodium_init();
+// Below this many signatures a failed batch is resolved one by one
+#define BATCH_SPLIT_MIN 4
+
+// Batch-check entries [0, n); on failure split in halves to isolate the bad ones
+static int verify_span(const uint8_t* const msgs[], const size_t lens[],
+                       const uint8_t* const pks[], const uint8_t* const sigs[],
+                       const int* slots, int n, int* results) {
+    if (n >= BATCH_SPLIT_MIN && ed25519_verify_batch(msgs, lens, pks, sigs, (size_t)n)) {
+        for (int i = 0; i < n; i++) results[slots[i]] = 1;
+        return n;
+    }
     
-    int success = 0;
+    if (n <= BATCH_SPLIT_MIN) {
+        int ok = 0;
+        for (int i = 0; i < n; i++) {
+            results[slots[i]] = ed25519_verify(msgs[i], lens[i], pks[i], sigs[i]);
+            ok += results[slots[i]];
+        }
+        return ok;
+    }
+    
+    int half = n / 2;
+    return verify_span(msgs, lens, pks, sigs, slots, half, results) +
+           verify_span(msgs + half, lens + half, pks + half, sigs + half, slots + half,
+                       n - half, results);
+}
+
+// One multi-scalar batch per chunk of up to ED25519_BATCH_MAX transactions
+static int verify_chunk(const PCTransaction** txs, int count, int* results) {
+    uint8_t messages[ED25519_BATCH_MAX][128];
+    const uint8_t* msgs[ED25519_BATCH_MAX];
+    const uint8_t* pks[ED25519_BATCH_MAX];
+    const uint8_t* sigs[ED25519_BATCH_MAX];
+    size_t lens[ED25519_BATCH_MAX];
+    int slots[ED25519_BATCH_MAX];
+    int n = 0;
     
-    #pragma omp parallel for reduction(+:success) schedule(dynamic, 64)
     for (int i = 0; i < count; i++) {
-        uint8_t message[128];
-        size_t msg_len = create_message(txs[i], message);
-        
-        if (crypto_sign_verify_detached(txs[i]->signature, message, msg_len, txs[i]->from) == 0) {
-            results[i] = 1;
-            success++;
-        } else {
+        // Same unsigned-transaction shortcut as pc_transaction_verify
+        if (is_unsigned(txs[i]->signature)) {
             results[i] = 0;
+            continue;
         }
+        lens[n] = create_message(txs[i], messages[n]);
+        msgs[n] = messages[n];
+        pks[n] = txs[i]->from;
+        sigs[n] = txs[i]->signature;
+        slots[n] = i;
+        n++;
+    }
+    
+    return verify_span(msgs, lens, pks, sigs, slots, n, results);
+}
+
+// Batched Ed25519 verification, chunks spread across OpenMP threads
+int pc_transaction_verify_batch(const PCTransaction** txs, int count, int* results) {
+    ensure_sodium_init();
+    
+    int success = 0;
+    
+    #pragma omp parallel for reduction(+:success) schedule(dynamic, 1)
+    for (int start = 0; start < count; start += ED25519_BATCH_MAX) {
+        int n = count - start < ED25519_BATCH_MAX ? count - start : ED25519_BATCH_MAX;
+        success += verify_chunk(txs + start, n, results + start);
     }
     
     return success;
@@ -0,0 +1,537 @@
+// ed25519.c - Ed25519 batch verification
+// Radix 2^51 field arithmetic, extended twisted Edwards points and a Straus
+// multi-scalar multiplication; SHA-512 and scalar arithmetic mod L come from libsodium
+
+#include "ed25519.h"
+#include <sodium.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint64_t fe[5];
+typedef unsigned __int128 u128;
+
+#define MASK51 ((1ULL << 51) - 1)
+
+// Extended coordinates: x = X/Z, y = Y/Z, x*y = T/Z
+typedef struct { fe X, Y, Z, T; } ge;
+
+// Addend form: (Y + X, Y - X, 2Z, 2dT)
+typedef struct { fe YpX, YmX, Z2, T2d; } ge_cached;
+
+// Odd multiples P, 3P, ..., 15P per point (signed window digits up to 15)
+#define TABLE_SIZE 8
+
+// Group order L, little-endian
+static const uint8_t group_order[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+static fe fe_d, fe_d2, fe_sqrtm1;
+static ge base_point;
+
+// ===== Field arithmetic mod p = 2^255 - 19 =====
+
+static inline void fe_0(fe h) { memset(h, 0, sizeof(fe)); }
+
+static inline void fe_1(fe h) { fe_0(h); h[0] = 1; }
+
+static inline void fe_add(fe h, const fe f, const fe g) {
+    for (int i = 0; i < 5; i++) h[i] = f[i] + g[i];
+}
+
+// f - g biased by 4p; g limbs must stay below 2^53
+static inline void fe_sub(fe h, const fe f, const fe g) {
+    h[0] = f[0] + 0x1fffffffffffb4ULL - g[0];
+    for (int i = 1; i < 5; i++) h[i] = f[i] + 0x1ffffffffffffcULL - g[i];
+}
+
+static inline void fe_neg(fe h, const fe f) {
+    fe zero;
+    fe_0(zero);
+    fe_sub(h, zero, f);
+}
+
+// Fold 128-bit column sums back into 51-bit limbs
+static inline void fe_carry(fe h, u128 r0, u128 r1, u128 r2, u128 r3, u128 r4) {
+    r1 += (uint64_t)(r0 >> 51);
+    r2 += (uint64_t)(r1 >> 51);
+    r3 += (uint64_t)(r2 >> 51);
+    r4 += (uint64_t)(r3 >> 51);
+    u128 c = (r4 >> 51) * 19 + ((uint64_t)r0 & MASK51);
+    h[0] = (uint64_t)c & MASK51;
+    h[1] = ((uint64_t)r1 & MASK51) + (uint64_t)(c >> 51);
+    h[2] = (uint64_t)r2 & MASK51;
+    h[3] = (uint64_t)r3 & MASK51;
+    h[4] = (uint64_t)r4 & MASK51;
+}
+
+// Inputs may carry limbs up to 2^55
+static void fe_mul(fe h, const fe f, const fe g) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3], g4 = g[4];
+    uint64_t g1_19 = 19 * g1, g2_19 = 19 * g2, g3_19 = 19 * g3, g4_19 = 19 * g4;
+
+    u128 r0 = (u128)f0 * g0 + (u128)f1 * g4_19 + (u128)f2 * g3_19 + (u128)f3 * g2_19 + (u128)f4 * g1_19;
+    u128 r1 = (u128)f0 * g1 + (u128)f1 * g0 + (u128)f2 * g4_19 + (u128)f3 * g3_19 + (u128)f4 * g2_19;
+    u128 r2 = (u128)f0 * g2 + (u128)f1 * g1 + (u128)f2 * g0 + (u128)f3 * g4_19 + (u128)f4 * g3_19;
+    u128 r3 = (u128)f0 * g3 + (u128)f1 * g2 + (u128)f2 * g1 + (u128)f3 * g0 + (u128)f4 * g4_19;
+    u128 r4 = (u128)f0 * g4 + (u128)f1 * g3 + (u128)f2 * g2 + (u128)f3 * g1 + (u128)f4 * g0;
+    fe_carry(h, r0, r1, r2, r3, r4);
+}
+
+static void fe_sq(fe h, const fe f) {
+    uint64_t f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3], f4 = f[4];
+    uint64_t f0_2 = 2 * f0, f1_2 = 2 * f1, f2_2 = 2 * f2;
+    uint64_t f3_19 = 19 * f3, f4_19 = 19 * f4;
+
+    u128 r0 = (u128)f0 * f0 + (u128)f1_2 * f4_19 + (u128)f2_2 * f3_19;
+    u128 r1 = (u128)f0_2 * f1 + (u128)f2_2 * f4_19 + (u128)f3 * f3_19;
+    u128 r2 = (u128)f0_2 * f2 + (u128)f1 * f1 + (u128)(2 * f3) * f4_19;
+    u128 r3 = (u128)f0_2 * f3 + (u128)f1_2 * f2 + (u128)f4 * f4_19;
+    u128 r4 = (u128)f0_2 * f4 + (u128)f1_2 * f3 + (u128)f2 * f2;
+    fe_carry(h, r0, r1, r2, r3, r4);
+}
+
+static void fe_sq_n(fe h, const fe f, int n) {
+    fe_sq(h, f);
+    while (--n > 0) fe_sq(h, h);
+}
+
+static void fe_frombytes(fe h, const uint8_t s[32]) {
+    uint64_t w[4];
+    memcpy(w, s, 32);
+    h[0] = w[0] & MASK51;
+    h[1] = ((w[0] >> 51) | (w[1] << 13)) & MASK51;
+    h[2] = ((w[1] >> 38) | (w[2] << 26)) & MASK51;
+    h[3] = ((w[2] >> 25) | (w[3] << 39)) & MASK51;
+    h[4] = (w[3] >> 12) & MASK51;
+}
+
+// Fully reduced little-endian encoding
+static void fe_tobytes(uint8_t s[32], const fe f) {
+    uint64_t t[5];
+    memcpy(t, f, sizeof(t));
+
+    for (int pass = 0; pass < 2; pass++) {
+        t[1] += t[0] >> 51; t[0] &= MASK51;
+        t[2] += t[1] >> 51; t[1] &= MASK51;
+        t[3] += t[2] >> 51; t[2] &= MASK51;
+        t[4] += t[3] >> 51; t[3] &= MASK51;
+        t[0] += 19 * (t[4] >> 51); t[4] &= MASK51;
+    }
+
+    // Now t < 2^255 + 19; adding 19 then 2^255 - 19 and dropping bit 255 subtracts p when t >= p
+    t[0] += 19;
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[0] += 19 * (t[4] >> 51); t[4] &= MASK51;
+
+    t[0] += (1ULL << 51) - 19;
+    for (int i = 1; i < 5; i++) t[i] += (1ULL << 51) - 1;
+    t[1] += t[0] >> 51; t[0] &= MASK51;
+    t[2] += t[1] >> 51; t[1] &= MASK51;
+    t[3] += t[2] >> 51; t[2] &= MASK51;
+    t[4] += t[3] >> 51; t[3] &= MASK51;
+    t[4] &= MASK51;
+
+    uint64_t w[4];
+    w[0] = t[0] | (t[1] << 51);
+    w[1] = (t[1] >> 13) | (t[2] << 38);
+    w[2] = (t[2] >> 26) | (t[3] << 25);
+    w[3] = (t[3] >> 39) | (t[4] << 12);
+    memcpy(s, w, 32);
+}
+
+static int fe_iszero(const fe f) {
+    uint8_t s[32];
+    fe_tobytes(s, f);
+    uint8_t acc = 0;
+    for (int i = 0; i < 32; i++) acc |= s[i];
+    return acc == 0;
+}
+
+static int fe_isneg(const fe f) {
+    uint8_t s[32];
+    fe_tobytes(s, f);
+    return s[0] & 1;
+}
+
+// z^(2^250 - 1), with z^11 on the side
+static void fe_pow_2_250_1(fe out, fe z11, const fe z) {
+    fe t0, t1, t2;
+    fe_sq(t0, z);                 // 2
+    fe_sq_n(t1, t0, 2);           // 8
+    fe_mul(t1, z, t1);            // 9
+    fe_mul(z11, t0, t1);          // 11
+    fe_sq(t0, z11);               // 22
+    fe_mul(t0, t1, t0);           // 2^5 - 1
+    fe_sq_n(t1, t0, 5);
+    fe_mul(t0, t1, t0);           // 2^10 - 1
+    fe_sq_n(t1, t0, 10);
+    fe_mul(t1, t1, t0);           // 2^20 - 1
+    fe_sq_n(t2, t1, 20);
+    fe_mul(t1, t2, t1);           // 2^40 - 1
+    fe_sq_n(t1, t1, 10);
+    fe_mul(t0, t1, t0);           // 2^50 - 1
+    fe_sq_n(t1, t0, 50);
+    fe_mul(t1, t1, t0);           // 2^100 - 1
+    fe_sq_n(t2, t1, 100);
+    fe_mul(t1, t2, t1);           // 2^200 - 1
+    fe_sq_n(t1, t1, 50);
+    fe_mul(out, t1, t0);          // 2^250 - 1
+}
+
+// z^(p - 2)
+static void fe_invert(fe out, const fe z) {
+    fe t, z11;
+    fe_pow_2_250_1(t, z11, z);
+    fe_sq_n(t, t, 5);             // 2^255 - 32
+    fe_mul(out, t, z11);          // 2^255 - 21
+}
+
+// z^((p - 5) / 8)
+static void fe_pow22523(fe out, const fe z) {
+    fe t, z11;
+    fe_pow_2_250_1(t, z11, z);
+    fe_sq_n(t, t, 2);             // 2^252 - 4
+    fe_mul(out, t, z);            // 2^252 - 3
+}
+
+// ===== Group operations =====
+
+static void ge_identity(ge* p) {
+    fe_0(p->X);
+    fe_1(p->Y);
+    fe_1(p->Z);
+    fe_0(p->T);
+}
+
+static void ge_to_cached(ge_cached* c, const ge* p) {
+    fe_add(c->YpX, p->Y, p->X);
+    fe_sub(c->YmX, p->Y, p->X);
+    fe_add(c->Z2, p->Z, p->Z);
+    fe_mul(c->T2d, p->T, fe_d2);
+}
+
+// r = p + q (add-2008-hwcd-3)
+static void ge_add(ge* r, const ge* p, const ge_cached* q) {
+    fe a, b, c, d, e, f, g, h;
+    fe_sub(a, p->Y, p->X);
+    fe_mul(a, a, q->YmX);
+    fe_add(b, p->Y, p->X);
+    fe_mul(b, b, q->YpX);
+    fe_mul(c, p->T, q->T2d);
+    fe_mul(d, p->Z, q->Z2);
+    fe_sub(e, b, a);
+    fe_sub(f, d, c);
+    fe_add(g, d, c);
+    fe_add(h, b, a);
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->T, e, h);
+    fe_mul(r->Z, f, g);
+}
+
+// r = p - q
+static void ge_sub(ge* r, const ge* p, const ge_cached* q) {
+    fe a, b, c, d, e, f, g, h;
+    fe_sub(a, p->Y, p->X);
+    fe_mul(a, a, q->YpX);
+    fe_add(b, p->Y, p->X);
+    fe_mul(b, b, q->YmX);
+    fe_mul(c, p->T, q->T2d);
+    fe_mul(d, p->Z, q->Z2);
+    fe_sub(e, b, a);
+    fe_add(f, d, c);
+    fe_sub(g, d, c);
+    fe_add(h, b, a);
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->T, e, h);
+    fe_mul(r->Z, f, g);
+}
+
+// r = 2p (dbl-2008-hwcd, a = -1)
+static void ge_dbl(ge* r, const ge* p) {
+    fe a, b, c, e, f, g, h;
+    fe_sq(a, p->X);
+    fe_sq(b, p->Y);
+    fe_sq(c, p->Z);
+    fe_add(c, c, c);
+    fe_add(h, a, b);
+    fe_add(e, p->X, p->Y);
+    fe_sq(e, e);
+    fe_sub(e, e, h);
+    fe_sub(g, b, a);
+    fe_sub(f, g, c);
+    fe_neg(h, h);
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->T, e, h);
+    fe_mul(r->Z, f, g);
+}
+
+static void ge_neg(ge* p) {
+    fe_neg(p->X, p->X);
+    fe_neg(p->T, p->T);
+}
+
+// Order divides 8: eight times the point is the identity (x = 0 after doubling)
+static int ge_has_small_order(const ge* p) {
+    ge q;
+    ge_dbl(&q, p);
+    ge_dbl(&q, &q);
+    ge_dbl(&q, &q);
+    return fe_iszero(q.X);
+}
+
+// Decode a canonical point encoding; fails on anything libsodium would not re-encode identically
+static int ge_frombytes(ge* h, const uint8_t s[32]) {
+    fe u, v, v3, vxx, check;
+    uint8_t enc[32];
+
+    fe_frombytes(h->Y, s);
+    fe_tobytes(enc, h->Y);
+    enc[31] |= s[31] & 0x80;
+    if (memcmp(enc, s, 32) != 0) return -1;
+
+    fe_1(h->Z);
+    fe_sq(u, h->Y);
+    fe_mul(v, u, fe_d);
+    fe_sub(u, u, h->Z);           // y^2 - 1
+    fe_add(v, v, h->Z);           // d y^2 + 1
+
+    fe_sq(v3, v);
+    fe_mul(v3, v3, v);            // v^3
+    fe_sq(h->X, v3);
+    fe_mul(h->X, h->X, v);
+    fe_mul(h->X, h->X, u);        // u v^7
+    fe_pow22523(h->X, h->X);
+    fe_mul(h->X, h->X, v3);
+    fe_mul(h->X, h->X, u);        // u v^3 (u v^7)^((p - 5) / 8)
+
+    fe_sq(vxx, h->X);
+    fe_mul(vxx, vxx, v);
+    fe_sub(check, vxx, u);
+    if (!fe_iszero(check)) {
+        fe_add(check, vxx, u);
+        if (!fe_iszero(check)) return -1;
+        fe_mul(h->X, h->X, fe_sqrtm1);
+    }
+
+    int sign = s[31] >> 7;
+    if (sign && fe_iszero(h->X)) return -1;
+    if (fe_isneg(h->X) != sign) fe_neg(h->X, h->X);
+
+    fe_mul(h->T, h->X, h->Y);
+    return 0;
+}
+
+// Plain square-and-multiply, setup only
+static void fe_pow_bytes(fe out, const fe z, const uint8_t e[32]) {
+    fe r;
+    fe_1(r);
+    for (int i = 255; i >= 0; i--) {
+        fe_sq(r, r);
+        if ((e[i >> 3] >> (i & 7)) & 1) fe_mul(r, r, z);
+    }
+    memcpy(out, r, sizeof(fe));
+}
+
+__attribute__((constructor))
+static void ed25519_constants_init(void) {
+    fe a, b;
+
+    // d = -121665 / 121666
+    fe_0(a); a[0] = 121666;
+    fe_invert(b, a);
+    fe_0(a); a[0] = 121665;
+    fe_mul(fe_d, a, b);
+    fe_neg(fe_d, fe_d);
+    fe_carry(fe_d, fe_d[0], fe_d[1], fe_d[2], fe_d[3], fe_d[4]);
+    fe_add(fe_d2, fe_d, fe_d);
+
+    // sqrt(-1) = 2^((p - 1) / 4)
+    uint8_t e[32];
+    memset(e, 0xff, 32);
+    e[0] = 0xfb;
+    e[31] = 0x1f;                 // 2^253 - 5
+    fe_0(a); a[0] = 2;
+    fe_pow_bytes(fe_sqrtm1, a, e);
+
+    // Base point: y = 4/5, x even
+    fe_0(a); a[0] = 5;
+    fe_invert(b, a);
+    fe_0(a); a[0] = 4;
+    fe_mul(a, a, b);
+    uint8_t enc[32];
+    fe_tobytes(enc, a);
+    ge_frombytes(&base_point, enc);
+}
+
+// ===== Multi-scalar multiplication =====
+
+// Signed sliding window digits: odd, |digit| <= 15 (scalar < 2^255)
+static void slide(int8_t r[256], const uint8_t a[32]) {
+    for (int i = 0; i < 256; i++) {
+        r[i] = 1 & (a[i >> 3] >> (i & 7));
+    }
+    for (int i = 0; i < 256; i++) {
+        if (!r[i]) continue;
+        for (int b = 1; b <= 6 && i + b < 256; b++) {
+            if (!r[i + b]) continue;
+            if (r[i] + (r[i + b] << b) <= 15) {
+                r[i] += r[i + b] << b;
+                r[i + b] = 0;
+            } else if (r[i] - (r[i + b] << b) >= -15) {
+                r[i] -= r[i + b] << b;
+                for (int k = i + b; k < 256; k++) {
+                    if (!r[k]) {
+                        r[k] = 1;
+                        break;
+                    }
+                    r[k] = 0;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+// Sum of scalars[i] * points[i] with one shared doubling chain (Straus)
+static int ge_multiscalar(ge* out, const ge* points, const uint8_t (*scalars)[32], size_t n) {
+    ge_cached (*tables)[TABLE_SIZE] = malloc(n * sizeof(*tables));
+    int8_t (*digits)[256] = malloc(n * sizeof(*digits));
+    if (!tables || !digits) {
+        free(tables);
+        free(digits);
+        return -1;
+    }
+
+    int top = -1;
+    for (size_t j = 0; j < n; j++) {
+        ge p2, cur = points[j];
+        ge_cached p2c;
+        ge_dbl(&p2, &points[j]);
+        ge_to_cached(&p2c, &p2);
+        ge_to_cached(&tables[j][0], &cur);
+        for (int k = 1; k < TABLE_SIZE; k++) {
+            ge_add(&cur, &cur, &p2c);
+            ge_to_cached(&tables[j][k], &cur);
+        }
+
+        slide(digits[j], scalars[j]);
+        for (int i = 255; i > top; i--) {
+            if (digits[j][i]) {
+                top = i;
+                break;
+            }
+        }
+    }
+
+    ge_identity(out);
+    for (int i = top; i >= 0; i--) {
+        ge_dbl(out, out);
+        for (size_t j = 0; j < n; j++) {
+            int8_t d = digits[j][i];
+            if (d > 0) {
+                ge_add(out, out, &tables[j][d / 2]);
+            } else if (d < 0) {
+                ge_sub(out, out, &tables[j][-d / 2]);
+            }
+        }
+    }
+
+    free(tables);
+    free(digits);
+    return 0;
+}
+
+// ===== Batch verification =====
+
+// s < L
+static int scalar_is_canonical(const uint8_t s[32]) {
+    for (int i = 31; i >= 0; i--) {
+        if (s[i] < group_order[i]) return 1;
+        if (s[i] > group_order[i]) return 0;
+    }
+    return 0;
+}
+
+// With random odd 128-bit weights z_i, checks the cofactored equation
+//   [8]([sum z_i s_i] B - sum [z_i] R_i - sum [z_i h_i] A_i) == identity
+// The factor 8 clears any small-order component of R or A, so what is left is
+// a prime-order point per signature and a forged one survives with
+// probability 2^-128. With one signature the check is exact. Decoding rules
+// match crypto_sign_verify_detached (canonical s, R and A; no small-order R
+// or A). Repeated public keys share one point and one summed scalar.
+int ed25519_verify_batch(const uint8_t* const msgs[], const size_t lens[],
+                         const uint8_t* const pks[], const uint8_t* const sigs[],
+                         size_t count) {
+    if (count == 0) return 1;
+    if (count > ED25519_BATCH_MAX) return 0;
+
+    // Layout: B, then R_0..R_{count-1}, then the distinct public keys
+    ge points[2 * ED25519_BATCH_MAX + 1];
+    uint8_t scalars[2 * ED25519_BATCH_MAX + 1][32];
+    const uint8_t* keys[ED25519_BATCH_MAX];
+    uint8_t weights[ED25519_BATCH_MAX][16];
+    size_t num_keys = 0;
+
+    randombytes_buf(weights, count * sizeof(weights[0]));
+    for (size_t i = 0; i < count; i++) weights[i][0] |= 1;
+    memset(scalars, 0, (2 * count + 1) * 32);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* sig = sigs[i];
+        ge* r = &points[1 + i];
+
+        if (!scalar_is_canonical(sig + 32)) return 0;
+        if (ge_frombytes(r, sig) != 0 || ge_has_small_order(r)) return 0;
+        ge_neg(r);
+
+        size_t k = 0;
+        while (k < num_keys && memcmp(keys[k], pks[i], 32) != 0) k++;
+        if (k == num_keys) {
+            ge* a = &points[1 + count + k];
+            if (ge_frombytes(a, pks[i]) != 0 || ge_has_small_order(a)) return 0;
+            ge_neg(a);
+            keys[num_keys++] = pks[i];
+        }
+
+        // h = SHA-512(R || A || M) mod L
+        crypto_hash_sha512_state st;
+        uint8_t h64[64], h[32];
+        crypto_hash_sha512_init(&st);
+        crypto_hash_sha512_update(&st, sig, 32);
+        crypto_hash_sha512_update(&st, pks[i], 32);
+        crypto_hash_sha512_update(&st, msgs[i], lens[i]);
+        crypto_hash_sha512_final(&st, h64);
+        crypto_core_ed25519_scalar_reduce(h, h64);
+
+        uint8_t* z = scalars[1 + i];
+        uint8_t* a_scalar = scalars[1 + count + k];
+        uint8_t t[32];
+        memcpy(z, weights[i], sizeof(weights[i]));
+        crypto_core_ed25519_scalar_mul(t, z, h);
+        crypto_core_ed25519_scalar_add(a_scalar, a_scalar, t);
+        crypto_core_ed25519_scalar_mul(t, z, sig + 32);
+        crypto_core_ed25519_scalar_add(scalars[0], scalars[0], t);
+    }
+
+    points[0] = base_point;
+
+    ge sum;
+    if (ge_multiscalar(&sum, points, (const uint8_t (*)[32])scalars, 1 + count + num_keys) != 0) {
+        return 0;
+    }
+    return ge_has_small_order(&sum);    // [8] sum == identity
+}
+
+int ed25519_verify(const uint8_t* msg, size_t len, const uint8_t* pk, const uint8_t* sig) {
+    return ed25519_verify_batch(&msg, &len, &pk, &sig, 1);
+}
@@ -0,0 +1,28 @@
+// ed25519.h - Ed25519 batch verification
+// Random-linear-combination check over one multi-scalar multiplication.
+// Both entry points use the cofactored equation, so a signer cannot make
+// the batch and single verdicts differ with mixed-order keys or nonces.
+
+#ifndef ED25519_H
+#define ED25519_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Signatures checked by one multi-scalar multiplication
+#define ED25519_BATCH_MAX 64
+
+// Check count (<= ED25519_BATCH_MAX) signatures at once.
+// Returns 1 if every signature passes ed25519_verify; 0 means at least one
+// fails (or the batch could not be evaluated) and the caller must fall back
+// to single verification to find out which.
+int ed25519_verify_batch(const uint8_t* const msgs[], const size_t lens[],
+                         const uint8_t* const pks[], const uint8_t* const sigs[],
+                         size_t count);
+
+// Single signature: 1 if valid. Accepts exactly what the batch accepts.
+// Differs from crypto_sign_verify_detached only for keys or R values with a
+// small-order component, which honest signers never produce.
+int ed25519_verify(const uint8_t* msg, size_t len, const uint8_t* pk, const uint8_t* sig);
+
+#endif
@@ -1,8 +1,13 @@
 // sha256.c - Self-contained SHA-256 implementation
-// Public domain implementation
+// Public domain implementation; SHA-NI and 8-lane AVX2 backends picked at startup
 
 #include "sha256.h"
 #include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_X86 1
+#endif
 
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
 #define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
@@ -23,7 +28,7 @@ static const uint32_t k[64] = {
     0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 };
 
-static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[]) {
+static void sha256_transform(uint32_t state[8], const uint8_t data[]) {
     uint32_t a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
 
     for (i = 0, j = 0; i < 16; ++i, j += 4)
@@ -32,8 +37,8 @@ static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[]) {
     for (; i < 64; ++i)
         m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
 
-    a = ctx->state[0]; b = ctx->state[1]; c = ctx->state[2]; d = ctx->state[3];
-    e = ctx->state[4]; f = ctx->state[5]; g = ctx->state[6]; h = ctx->state[7];
+    a = state[0]; b = state[1]; c = state[2]; d = state[3];
+    e = state[4]; f = state[5]; g = state[6]; h = state[7];
 
     for (i = 0; i < 64; ++i) {
         t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
@@ -42,33 +47,156 @@ static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[]) {
         d = c; c = b; b = a; a = t1 + t2;
     }
 
-    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
-    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static void compress_scalar(uint32_t state[8], const uint8_t* data, size_t nblocks) {
+    for (size_t i = 0; i < nblocks; i++) {
+        sha256_transform(state, data + i * 64);
+    }
+}
+
+#ifdef SHA256_X86
+// One block per 4 rounds of sha256rnds2 pairs; state kept as ABEF/CDGH
+__attribute__((target("sha,sse4.1")))
+static void compress_shani(uint32_t state[8], const uint8_t* data, size_t nblocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+    __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+    __m128i s0 = _mm_alignr_epi8(tmp, s1, 8);
+    s1 = _mm_blend_epi16(s1, tmp, 0xF0);
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        __m128i abef = s0, cdgh = s1;
+        __m128i w[4];
+
+        for (int i = 0; i < 16; i++) {
+            __m128i* cur = &w[i & 3];
+            if (i < 4) {
+                *cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * i)), bswap);
+            } else {
+                __m128i prev = w[(i - 1) & 3];
+                __m128i x = _mm_sha256msg1_epu32(*cur, w[(i - 3) & 3]);
+                x = _mm_add_epi32(x, _mm_alignr_epi8(prev, w[(i - 2) & 3], 4));
+                *cur = _mm_sha256msg2_epu32(x, prev);
+            }
+            __m128i msg = _mm_add_epi32(*cur, _mm_loadu_si128((const __m128i*)&k[4 * i]));
+            s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+            s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(msg, 0x0E));
+        }
+
+        s0 = _mm_add_epi32(s0, abef);
+        s1 = _mm_add_epi32(s1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(s0, 0x1B);
+    s1 = _mm_shuffle_epi32(s1, 0xB1);
+    _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(tmp, s1, 0xF0));
+    _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(s1, tmp, 8));
+}
+
+// Eight independent messages, one per 32-bit lane
+#define LANES 8
+#define VROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+__attribute__((target("avx2")))
+static void compress_avx2_x8(__m256i s[8], const uint8_t* const blocks[LANES]) {
+    __m256i w[64];
+    for (int i = 0; i < 16; i++) {
+        uint32_t v[LANES];
+        for (int l = 0; l < LANES; l++) {
+            uint32_t x;
+            memcpy(&x, blocks[l] + 4 * i, 4);
+            v[l] = __builtin_bswap32(x);
+        }
+        w[i] = _mm256_loadu_si256((const __m256i*)v);
+    }
+    for (int i = 16; i < 64; i++) {
+        __m256i x15 = w[i - 15], x2 = w[i - 2];
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(VROTR(x15, 7), VROTR(x15, 18)),
+                                      _mm256_srli_epi32(x15, 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(VROTR(x2, 17), VROTR(x2, 19)),
+                                      _mm256_srli_epi32(x2, 10));
+        w[i] = _mm256_add_epi32(_mm256_add_epi32(s1, w[i - 7]), _mm256_add_epi32(s0, w[i - 16]));
+    }
+
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+    __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; i++) {
+        __m256i ep1 = _mm256_xor_si256(_mm256_xor_si256(VROTR(e, 6), VROTR(e, 11)), VROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, ep1),
+                     _mm256_add_epi32(ch, _mm256_add_epi32(w[i], _mm256_set1_epi32((int)k[i]))));
+        __m256i ep0 = _mm256_xor_si256(_mm256_xor_si256(VROTR(a, 2), VROTR(a, 13)), VROTR(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(ep0, maj);
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+    }
+
+    s[0] = _mm256_add_epi32(s[0], a); s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c); s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e); s[5] = _mm256_add_epi32(s[5], f);
+    s[6] = _mm256_add_epi32(s[6], g); s[7] = _mm256_add_epi32(s[7], h);
+}
+#endif
+
+static const uint32_t initial_state[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// Selected once at startup
+static void (*compress)(uint32_t state[8], const uint8_t* data, size_t nblocks) = compress_scalar;
+static int use_avx2_lanes;
+
+__attribute__((constructor))
+static void sha256_select_backend(void) {
+#ifdef SHA256_X86
+    unsigned int eax, ebx, ecx, edx;
+    __builtin_cpu_init();
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) &&
+        __builtin_cpu_supports("sse4.1")) {
+        compress = compress_shani;
+    } else if (__builtin_cpu_supports("avx2")) {
+        use_avx2_lanes = 1;
+    }
+#endif
 }
 
 void sha256_init(SHA256_CTX *ctx) {
     ctx->datalen = 0;
     ctx->bitlen = 0;
-    ctx->state[0] = 0x6a09e667;
-    ctx->state[1] = 0xbb67ae85;
-    ctx->state[2] = 0x3c6ef372;
-    ctx->state[3] = 0xa54ff53a;
-    ctx->state[4] = 0x510e527f;
-    ctx->state[5] = 0x9b05688c;
-    ctx->state[6] = 0x1f83d9ab;
-    ctx->state[7] = 0x5be0cd19;
+    memcpy(ctx->state, initial_state, sizeof(initial_state));
 }
 
 void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len) {
-    for (size_t i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64) {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
-        }
+    // Top up a partial block first
+    if (ctx->datalen > 0) {
+        size_t take = 64 - ctx->datalen;
+        if (take > len) take = len;
+        memcpy(ctx->data + ctx->datalen, data, take);
+        ctx->datalen += (uint32_t)take;
+        data += take;
+        len -= take;
+        if (ctx->datalen < 64) return;
+        compress(ctx->state, ctx->data, 1);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
+    }
+
+    // Whole blocks straight from the input
+    size_t nblocks = len / 64;
+    if (nblocks > 0) {
+        compress(ctx->state, data, nblocks);
+        ctx->bitlen += (uint64_t)nblocks * 512;
+        data += nblocks * 64;
+        len -= nblocks * 64;
     }
+
+    memcpy(ctx->data, data, len);
+    ctx->datalen = (uint32_t)len;
 }
 
 void sha256_final(SHA256_CTX *ctx, uint8_t hash[]) {
@@ -82,7 +210,7 @@ void sha256_final(SHA256_CTX *ctx, uint8_t hash[]) {
         ctx->data[i++] = 0x80;
         while (i < 64)
             ctx->data[i++] = 0x00;
-        sha256_transform(ctx, ctx->data);
+        compress(ctx->state, ctx->data, 1);
         memset(ctx->data, 0, 56);
     }
 
@@ -95,7 +223,7 @@ void sha256_final(SHA256_CTX *ctx, uint8_t hash[]) {
     ctx->data[58] = ctx->bitlen >> 40;
     ctx->data[57] = ctx->bitlen >> 48;
     ctx->data[56] = ctx->bitlen >> 56;
-    sha256_transform(ctx, ctx->data);
+    compress(ctx->state, ctx->data, 1);
 
     for (i = 0; i < 4; ++i) {
         hash[i]      = (ctx->state[0] >> (24 - i * 8)) & 0x000000ff;
@@ -115,3 +243,88 @@ void sha256(const uint8_t *data, size_t len, uint8_t hash[32]) {
     sha256_update(&ctx, data, len);
     sha256_final(&ctx, hash);
 }
+
+#ifdef SHA256_X86
+// Padded tail of a message: the blocks after its last whole 64 bytes
+typedef struct {
+    const uint8_t* data;
+    size_t whole;          // Blocks read straight from data
+    size_t nblocks;        // Total blocks including padding
+    uint8_t tail[128];
+} LaneMsg;
+
+static void lane_prepare(LaneMsg* m, const uint8_t* data, size_t len) {
+    size_t rem = len % 64;
+    m->data = data;
+    m->whole = len / 64;
+    m->nblocks = m->whole + (rem < 56 ? 1 : 2);
+
+    size_t tail_len = (m->nblocks - m->whole) * 64;
+    memset(m->tail, 0, tail_len);
+    memcpy(m->tail, data + m->whole * 64, rem);
+    m->tail[rem] = 0x80;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) {
+        m->tail[tail_len - 1 - i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+static inline const uint8_t* lane_block(const LaneMsg* m, size_t b) {
+    return b < m->whole ? m->data + b * 64 : m->tail + (b - m->whole) * 64;
+}
+
+// Up to eight messages through the AVX2 lanes; idle lanes hash a dummy block
+__attribute__((target("avx2")))
+static void sha256_lanes(const uint8_t* const data[], const size_t len[], size_t count,
+                         uint8_t hash[][32]) {
+    static const uint8_t dummy[64];
+    LaneMsg msgs[LANES];
+    size_t max_blocks = 0;
+    for (size_t l = 0; l < count; l++) {
+        lane_prepare(&msgs[l], data[l], len[l]);
+        if (msgs[l].nblocks > max_blocks) max_blocks = msgs[l].nblocks;
+    }
+
+    __m256i s[8];
+    for (int i = 0; i < 8; i++) s[i] = _mm256_set1_epi32((int)initial_state[i]);
+
+    for (size_t b = 0; b < max_blocks; b++) {
+        const uint8_t* blocks[LANES];
+        for (size_t l = 0; l < LANES; l++) {
+            blocks[l] = (l < count && b < msgs[l].nblocks) ? lane_block(&msgs[l], b) : dummy;
+        }
+        compress_avx2_x8(s, blocks);
+
+        // Lanes whose message ended on this block are done; later blocks are ignored
+        uint32_t words[8][LANES];
+        int stored = 0;
+        for (size_t l = 0; l < count; l++) {
+            if (msgs[l].nblocks != b + 1) continue;
+            if (!stored) {
+                for (int i = 0; i < 8; i++) _mm256_storeu_si256((__m256i*)words[i], s[i]);
+                stored = 1;
+            }
+            for (int i = 0; i < 8; i++) {
+                uint32_t v = __builtin_bswap32(words[i][l]);
+                memcpy(hash[l] + 4 * i, &v, 4);
+            }
+        }
+    }
+}
+#endif
+
+void sha256_many(const uint8_t* const data[], const size_t len[], size_t count,
+                 uint8_t hash[][32]) {
+#ifdef SHA256_X86
+    if (use_avx2_lanes) {
+        for (size_t i = 0; i < count; i += LANES) {
+            size_t n = count - i < LANES ? count - i : LANES;
+            sha256_lanes(data + i, len + i, n, hash + i);
+        }
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++) {
+        sha256(data[i], len[i], hash[i]);
+    }
+}
@@ -21,4 +21,8 @@ void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len);
 void sha256_final(SHA256_CTX *ctx, uint8_t hash[]);
 void sha256(const uint8_t *data, size_t len, uint8_t hash[32]);
 
+// Hash count independent messages: hash[i] = SHA-256(data[i][0..len[i]))
+void sha256_many(const uint8_t* const data[], const size_t len[], size_t count,
+                 uint8_t hash[][32]);
+
 #endif
@@ -11,8 +11,8 @@
 // Forward declaration from delta.c
 typedef struct {
     uint8_t pubkey[32];
-    double old_balance;
-    double new_balance;
+    PCAmount old_balance;
+    PCAmount new_balance;
     uint64_t old_nonce;
     uint64_t new_nonce;
 } PCWalletDelta;
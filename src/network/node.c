@@ -3,6 +3,7 @@
 // SECURITY HARDENED: Requires validator signatures for state acceptance
 
 #include "../include/physicscoin.h"
+#include "../include/wal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,13 +17,15 @@
 #include <poll.h>
 #include <pthread.h>
 #include <sodium.h>
-#include <math.h>
 
 #define DEFAULT_PORT 9333
 #define MAX_PEERS 32
 #define BUFFER_SIZE 65536
 #define HEARTBEAT_INTERVAL 30
 #define SYNC_INTERVAL 10
+#define NODE_WAL_FILENAME "node.wal"
+#define NODE_WAL_DEPTH 256  // Transactions awaiting durability
+#define NODE_CHECKPOINT_TXS 1000  // Accepted transactions between background checkpoints
 
 // Security limits
 #define MAX_MSG_PER_MINUTE 100
@@ -82,6 +85,7 @@ typedef struct {
     int banned;
     time_t ban_until;
     uint32_t violations;
+    uint64_t generation;  // Unique per connection, so a reused slot is never mistaken for it
 } PCNodePeer;
 
 // Validator registry for this node
@@ -101,6 +105,9 @@ typedef struct {
     PCKeypair wallet;
     volatile int running;
     pthread_mutex_t state_lock;
+    PCWAL wal;  // Accepted transactions; io_uring async when available
+    uint32_t txs_since_checkpoint;
+    uint64_t peer_generation;  // Last generation handed to a connection
     
     // Validator management
     PCTrustedValidator trusted_validators[MAX_STATE_VALIDATORS];
@@ -280,7 +287,7 @@ void handle_getstate(PCNode* node, PCNodePeer* peer) {
     pthread_mutex_lock(&node->state_lock);
     
     uint8_t buffer[BUFFER_SIZE];
-    size_t len = pc_state_serialize(&node->state, buffer, sizeof(buffer));
+    size_t len = pc_state_serialize_compact(&node->state, buffer, sizeof(buffer));
     
     pthread_mutex_unlock(&node->state_lock);
     
@@ -363,9 +370,10 @@ void handle_state(PCNode* node, PCNodePeer* peer, const uint8_t* data, size_t le
     
     // SECURITY CHECK 4: Verify total supply hasn't changed (except genesis)
     if (node->state.total_supply > 0 && 
-        fabs(new_state.total_supply - node->state.total_supply) > 1e-9) {
+        new_state.total_supply != node->state.total_supply) {
         printf("[%s:%d] SECURITY: Rejected state - total supply changed from %.8f to %.8f\n", 
-               peer->ip, peer->port, node->state.total_supply, new_state.total_supply);
+               peer->ip, peer->port, pc_amount_to_coins(node->state.total_supply),
+               pc_amount_to_coins(new_state.total_supply));
         peer->violations++;
         pthread_mutex_unlock(&node->state_lock);
         pc_state_free(&new_state);
@@ -376,12 +384,72 @@ void handle_state(PCNode* node, PCNodePeer* peer, const uint8_t* data, size_t le
     printf("[%s:%d] Syncing state v%lu -> v%lu (verified)\n", 
            peer->ip, peer->port,
            node->state.version, new_state.version);
+    pc_wal_checkpoint_finish(&node->wal);  // A frozen view may share the old pages
     pc_state_free(&node->state);
     node->state = new_state;
     
+    // Replaying the log over the old checkpoint would undo the sync
+    node->state.checkpoint_id = 0;
+    if (pc_wal_checkpoint(&node->wal, &node->state) != PC_OK) {
+        printf("[%s:%d] WARNING: Synced state not checkpointed\n", peer->ip, peer->port);
+    }
+    
     pthread_mutex_unlock(&node->state_lock);
 }
 
+// Transaction waiting for its WAL entry to reach disk
+typedef struct {
+    PCNode* node;
+    uint64_t origin;  // Generation of the peer it came from
+    PCTransaction tx;
+} NodeTxAck;
+
+// Connected peer with this generation, or NULL once it has gone
+static PCNodePeer* find_peer(PCNode* node, uint64_t generation) {
+    for (uint32_t i = 0; i < node->num_peers; i++) {
+        if (node->peers[i].connected && node->peers[i].generation == generation) {
+            return &node->peers[i];
+        }
+    }
+    return NULL;
+}
+
+// WAL completion (state_lock held): the transaction is durable, so apply it
+// in log order - exactly what recovery will do - and relay it
+static void node_tx_durable(void* ctx, PCError err) {
+    NodeTxAck* ack = ctx;
+    PCNode* node = ack->node;
+    PCNodePeer* origin = find_peer(node, ack->origin);
+    const char* ip = origin ? origin->ip : "gone";
+    int port = origin ? origin->port : 0;
+    
+    // Signature was checked before logging
+    if (err == PC_OK) err = pc_state_apply_tx(&node->state, &ack->tx);
+    if (err != PC_OK) {
+        printf("[%s:%d] TX rejected: %s\n", ip, port, pc_strerror(err));
+        free(ack);
+        return;
+    }
+    node->txs_since_checkpoint++;
+    printf("[%s:%d] TX accepted (%.2f coins)\n", ip, port, pc_amount_to_coins(ack->tx.amount));
+    
+    // Broadcast to other peers
+    for (uint32_t i = 0; i < node->num_peers; i++) {
+        PCNodePeer* peer = &node->peers[i];
+        if (peer != origin && peer->connected && peer->handshaked) {
+            node_send_message(peer, MSG_TX, &ack->tx, sizeof(ack->tx));
+        }
+    }
+    free(ack);
+}
+
+// Background checkpoint durable: startup restores from it, so the log
+// segments before it are no longer needed
+static void node_checkpoint_done(void* ctx, PCError err) {
+    PCNode* node = ctx;
+    if (err == PC_OK) pc_wal_retire(&node->wal);
+}
+
 // Handle transaction
 void handle_tx(PCNode* node, PCNodePeer* peer, const uint8_t* data, size_t len) {
     if (len < sizeof(PCTransaction)) {
@@ -400,22 +468,26 @@ void handle_tx(PCNode* node, PCNodePeer* peer, const uint8_t* data, size_t len)
         return;
     }
     
+    // Relayed copies of a transaction already applied are not worth logging
     pthread_mutex_lock(&node->state_lock);
-    PCError err = pc_state_execute_tx(&node->state, &tx);
-    pthread_mutex_unlock(&node->state_lock);
+    const PCWallet* from = pc_state_find_wallet(&node->state, tx.from);
+    if (!from || tx.nonce < from->nonce) {
+        pthread_mutex_unlock(&node->state_lock);
+        printf("[%s:%d] TX rejected: %s\n", peer->ip, peer->port,
+               pc_strerror(from ? PC_ERR_INVALID_SIGNATURE : PC_ERR_WALLET_NOT_FOUND));
+        return;
+    }
     
-    if (err == PC_OK) {
-        printf("[%s:%d] TX accepted (%.2f coins)\n", peer->ip, peer->port, tx.amount);
-        
-        // Broadcast to other peers
-        for (uint32_t i = 0; i < node->num_peers; i++) {
-            if (&node->peers[i] != peer && node->peers[i].handshaked) {
-                node_send_message(&node->peers[i], MSG_TX, &tx, sizeof(tx));
-            }
-        }
-    } else {
-        printf("[%s:%d] TX rejected: %s\n", peer->ip, peer->port, pc_strerror(err));
+    // Log first; node_tx_durable applies and relays once the entry is on
+    // disk (right away, under this lock, on the sync fallback)
+    NodeTxAck* ack = malloc(sizeof(NodeTxAck));
+    if (ack) {
+        ack->node = node;
+        ack->origin = peer->generation;
+        ack->tx = tx;
+        pc_wal_log_tx_async(&node->wal, &tx, node_tx_durable, ack);
     }
+    pthread_mutex_unlock(&node->state_lock);
 }
 
 // Handle ping
@@ -547,6 +619,7 @@ int node_connect_peer(PCNode* node, const char* ip, uint16_t port) {
     peer->port = port;
     peer->connected = 1;
     peer->last_seen = time(NULL);
+    peer->generation = ++node->peer_generation;
     
     node->num_peers++;
     printf("Connected to %s:%d\n", ip, port);
@@ -563,7 +636,7 @@ int node_connect_peer(PCNode* node, const char* ip, uint16_t port) {
 
 // Main node loop
 void node_run(PCNode* node) {
-    struct pollfd fds[MAX_PEERS + 1];
+    struct pollfd fds[MAX_PEERS + 2];
     time_t last_heartbeat = 0;
     
     while (node->running) {
@@ -581,6 +654,15 @@ void node_run(PCNode* node) {
             }
         }
         
+        // WAL completions wake the loop like peer traffic
+        int peer_end = nfds;
+        int wal_fd = pc_wal_async_fd(&node->wal);
+        if (wal_fd >= 0) {
+            fds[nfds].fd = wal_fd;
+            fds[nfds].events = POLLIN;
+            nfds++;
+        }
+        
         int ready = poll(fds, nfds, 1000);
         
         if (ready > 0) {
@@ -590,7 +672,7 @@ void node_run(PCNode* node) {
                 int client_fd = accept(node->listen_fd, 
                                        (struct sockaddr*)&client_addr, 
                                        &addr_len);
-                                       
+                
                 if (client_fd >= 0 && node->num_peers < MAX_PEERS) {
                     PCNodePeer* peer = &node->peers[node->num_peers];
                     memset(peer, 0, sizeof(PCNodePeer));
@@ -599,6 +681,7 @@ void node_run(PCNode* node) {
                     peer->port = ntohs(client_addr.sin_port);
                     peer->connected = 1;
                     peer->last_seen = time(NULL);
+                    peer->generation = ++node->peer_generation;
                     node->num_peers++;
                     
                     printf("Accepted connection from %s:%d\n", peer->ip, peer->port);
@@ -612,7 +695,7 @@ void node_run(PCNode* node) {
             }
             
             int fidx = 1;
-            for (uint32_t i = 0; i < node->num_peers && fidx < nfds; i++) {
+            for (uint32_t i = 0; i < node->num_peers && fidx < peer_end; i++) {
                 if (node->peers[i].connected) {
                     if (fds[fidx].revents & POLLIN) {
                         PCMessageHeader header;
@@ -632,6 +715,18 @@ void node_run(PCNode* node) {
             }
         }
         
+        // Apply and relay transactions whose log writes finished; a
+        // finished checkpoint thaws its view of the state
+        pthread_mutex_lock(&node->state_lock);
+        pc_wal_poll(&node->wal);
+        
+        // Checkpoint in the background so execution never waits on the disk
+        if (node->txs_since_checkpoint >= NODE_CHECKPOINT_TXS &&
+            pc_wal_checkpoint_async(&node->wal, &node->state, node_checkpoint_done, node) == PC_OK) {
+            node->txs_since_checkpoint = 0;
+        }
+        pthread_mutex_unlock(&node->state_lock);
+        
         time_t now = time(NULL);
         if (now - last_heartbeat >= HEARTBEAT_INTERVAL) {
             last_heartbeat = now;
@@ -663,13 +758,28 @@ PCError pc_node_init(PCNode* node, uint16_t port) {
     pc_keypair_generate(&node->wallet);
     memcpy(node->node_id, node->wallet.public_key, 32);
     
-    // Load or create state
+    // Seed state for a log without checkpoints
     if (pc_state_load(&node->state, "state.pcs") != PC_OK) {
         printf("Creating new genesis state...\n");
-        pc_state_genesis(&node->state, node->wallet.public_key, 1000000.0);
+        pc_state_genesis(&node->state, node->wallet.public_key, pc_amount_from_coins(1000000.0));
         pc_state_save(&node->state, "state.pcs");
     }
     
+    // Restore from the newest checkpoint plus the log tail after it; a
+    // fresh log gets a base checkpoint of the seed
+    if (pc_wal_init(&node->wal, NODE_WAL_FILENAME) != PC_OK ||
+        pc_wal_recover(&node->wal, &node->state) != PC_OK ||
+        (node->state.checkpoint_id == 0 && pc_wal_checkpoint(&node->wal, &node->state) != PC_OK)) {
+        fprintf(stderr, "Failed to recover transaction log\n");
+        return PC_ERR_IO;
+    }
+    pc_wal_retire(&node->wal);
+    
+    // io_uring when the kernel has it, sync appends otherwise
+    if (pc_wal_enable_async(&node->wal, NODE_WAL_DEPTH) != PC_OK) {
+        printf("io_uring unavailable, logging transactions synchronously\n");
+    }
+    
     // By default, trust ourselves as validator
     node->is_validator = 1;
     pc_node_add_validator(node, node->wallet.public_key);
@@ -719,7 +829,7 @@ void pc_node_print_status(PCNode* node) {
     printf("Trusted:    %d validators\n", node->num_trusted_validators);
     printf("Peers:      %u/%d\n", node->num_peers, MAX_PEERS);
     printf("State:      v%lu (%u wallets)\n", node->state.version, node->state.num_wallets);
-    printf("Supply:     %.2f\n\n", node->state.total_supply);
+    printf("Supply:     %.2f\n\n", pc_amount_to_coins(node->state.total_supply));
     
     printf("Security Features:\n");
     printf("  ✓ Conservation verification on state sync\n");
@@ -742,6 +852,8 @@ void pc_node_print_status(PCNode* node) {
 
 // Node cleanup
 void pc_node_free(PCNode* node) {
+    // Last completions still apply and relay
+    pc_wal_close(&node->wal);
     close(node->listen_fd);
     for (uint32_t i = 0; i < node->num_peers; i++) {
         if (node->peers[i].connected) {
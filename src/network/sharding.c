@@ -6,7 +6,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <math.h>
 #include <time.h>
 
 #define NUM_SHARDS 16
@@ -23,7 +22,7 @@ typedef struct {
 typedef struct {
     PCShard shards[NUM_SHARDS];
     uint32_t num_shards;
-    double total_supply;              // Sum across all shards
+    PCAmount total_supply;            // Sum across all shards
 } PCShardedNetwork;
 
 // Determine which shard a wallet belongs to
@@ -33,7 +32,7 @@ static uint8_t get_shard_for_wallet(const uint8_t* pubkey) {
 }
 
 // Initialize sharded network
-PCError pc_sharding_init(PCShardedNetwork* network, double initial_supply) {
+PCError pc_sharding_init(PCShardedNetwork* network, PCAmount initial_supply) {
     if (!network) return PC_ERR_IO;
     
     memset(network, 0, sizeof(PCShardedNetwork));
@@ -51,8 +50,7 @@ PCError pc_sharding_init(PCShardedNetwork* network, double initial_supply) {
         state->total_supply = 0;  // Each shard starts with 0
         state->num_wallets = 0;
         state->timestamp = (uint64_t)time(NULL);
-        state->wallets = NULL;
-        state->wallets_capacity = 0;  // Start with 0, will grow on first wallet
+        state->wallet_pages = NULL;  // First page allocated on first wallet
         
         // Initialize hashes to zero
         memset(state->state_hash, 0, 32);
@@ -74,7 +72,7 @@ PCShard* pc_sharding_get_shard(PCShardedNetwork* network, const uint8_t* pubkey)
 }
 
 // Create wallet in appropriate shard
-PCError pc_sharding_create_wallet(PCShardedNetwork* network, const uint8_t* pubkey, double balance) {
+PCError pc_sharding_create_wallet(PCShardedNetwork* network, const uint8_t* pubkey, PCAmount balance) {
     if (!network || !pubkey) return PC_ERR_IO;
     
     PCShard* shard = pc_sharding_get_shard(network, pubkey);
@@ -127,7 +125,7 @@ PCError pc_sharding_execute_cross_tx(PCShardedNetwork* network, const PCTransact
     PCShard* to_shard = &network->shards[to_shard_id];
     
     printf("Cross-shard TX: Shard %u → Shard %u (%.2f coins)\n", 
-           from_shard_id, to_shard_id, tx->amount);
+           from_shard_id, to_shard_id, pc_amount_to_coins(tx->amount));
     
     // PHASE 1: Prepare (lock funds in source shard)
     PCWallet* sender = pc_state_get_wallet(&from_shard->local_state, tx->from);
@@ -142,7 +140,7 @@ PCError pc_sharding_execute_cross_tx(PCShardedNetwork* network, const PCTransact
     sender->nonce++;
     from_shard->local_state.total_supply -= tx->amount;
     
-    printf("  Phase 1: Locked %.2f in shard %u\n", tx->amount, from_shard_id);
+    printf("  Phase 1: Locked %.2f in shard %u\n", pc_amount_to_coins(tx->amount), from_shard_id);
     
     // PHASE 2: Commit (add to destination shard)
     PCWallet* receiver = pc_state_get_wallet(&to_shard->local_state, tx->to);
@@ -154,7 +152,7 @@ PCError pc_sharding_execute_cross_tx(PCShardedNetwork* network, const PCTransact
     receiver->energy += tx->amount;
     to_shard->local_state.total_supply += tx->amount;
     
-    printf("  Phase 2: Added %.2f to shard %u\n", tx->amount, to_shard_id);
+    printf("  Phase 2: Added %.2f to shard %u\n", pc_amount_to_coins(tx->amount), to_shard_id);
     
     // Update both shards
     from_shard->transaction_count++;
@@ -172,14 +170,14 @@ PCError pc_sharding_execute_cross_tx(PCShardedNetwork* network, const PCTransact
 }
 
 // Get balance from appropriate shard
-PCError pc_sharding_get_balance(PCShardedNetwork* network, const uint8_t* pubkey, double* balance) {
+PCError pc_sharding_get_balance(PCShardedNetwork* network, const uint8_t* pubkey, PCAmount* balance) {
     if (!network || !pubkey || !balance) return PC_ERR_IO;
     
     PCShard* shard = pc_sharding_get_shard(network, pubkey);
-    PCWallet* wallet = pc_state_get_wallet(&shard->local_state, pubkey);
+    const PCWallet* wallet = pc_state_find_wallet(&shard->local_state, pubkey);
     
     if (!wallet) {
-        *balance = 0.0;
+        *balance = 0;
         return PC_ERR_WALLET_NOT_FOUND;
     }
     
@@ -191,15 +189,19 @@ PCError pc_sharding_get_balance(PCShardedNetwork* network, const uint8_t* pubkey
 PCError pc_sharding_verify_conservation(const PCShardedNetwork* network) {
     if (!network) return PC_ERR_IO;
     
-    double total = 0.0;
+    PCAmount total = 0;
     
     for (int i = 0; i < NUM_SHARDS; i++) {
-        total += network->shards[i].local_state.total_supply;
+        const PCState* shard = &network->shards[i].local_state;
+        
+        // Each shard's wallets must add up to its own supply
+        if (pc_scan_sum(shard) != (uint64_t)shard->total_supply) {
+            return PC_ERR_CONSERVATION_VIOLATED;
+        }
+        total += shard->total_supply;
     }
     
-    double error = fabs(total - network->total_supply);
-    
-    if (error > 1e-9) {
+    if (total != network->total_supply) {
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
@@ -213,14 +215,14 @@ void pc_sharding_print_stats(const PCShardedNetwork* network) {
     printf("╚═══════════════════════════════════════════════════════════════╝\n\n");
     
     printf("Shards: %u\n", network->num_shards);
-    printf("Total Supply: %.8f\n\n", network->total_supply);
+    printf("Total Supply: %.8f\n\n", pc_amount_to_coins(network->total_supply));
     
     printf("Per-Shard Breakdown:\n");
     printf("┌──────┬──────────┬───────────────┬──────────┬────────────────┐\n");
     printf("│ ID   │ Wallets  │ Supply        │ TX Count │ Hash           │\n");
     printf("├──────┼──────────┼───────────────┼──────────┼────────────────┤\n");
     
-    double verified_total = 0.0;
+    PCAmount verified_total = 0;
     uint64_t total_tx = 0;
     
     for (int i = 0; i < NUM_SHARDS; i++) {
@@ -229,7 +231,7 @@ void pc_sharding_print_stats(const PCShardedNetwork* network) {
         printf("│ 0x%X  │ %-8u │ %-13.2f │ %-8lu │ ", 
                shard->shard_id,
                shard->local_state.num_wallets,
-               shard->local_state.total_supply,
+               pc_amount_to_coins(shard->local_state.total_supply),
                shard->transaction_count);
         
         for (int j = 0; j < 4; j++) printf("%02x", shard->shard_hash[j]);
@@ -243,8 +245,8 @@ void pc_sharding_print_stats(const PCShardedNetwork* network) {
     
     printf("Totals:\n");
     printf("  Transactions: %lu\n", total_tx);
-    printf("  Sum of shards: %.8f\n", verified_total);
-    printf("  Conservation error: %.2e\n", fabs(verified_total - network->total_supply));
+    printf("  Sum of shards: %.8f\n", pc_amount_to_coins(verified_total));
+    printf("  Conservation error: %ld units\n", verified_total - network->total_supply);
     
     PCError cons = pc_sharding_verify_conservation(network);
     printf("  Conservation: %s\n", cons == PC_OK ? "✓ VERIFIED" : "✗ VIOLATED");
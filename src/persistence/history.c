@@ -0,0 +1,462 @@
+// history.c - Random-access on-disk time-travel history
+// Layout: header, checkpoint blocks (block header + compact state), then a
+// footer index of every block and a trailer pointing at it. Appends write
+// the new block over the old footer and a new footer after it.
+
+#include "../include/physicscoin.h"
+#include "../include/history.h"
+#include "../crypto/sha256.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HISTORY_MAGIC 0x48495354         // "HIST"
+#define HISTORY_BLOCK_MAGIC 0x48424C4B   // "HBLK"
+#define HISTORY_FOOTER_MAGIC 0x48465452  // "HFTR"
+#define HISTORY_VERSION 1
+#define HISTORY_ALIGN 8                  // Blocks start 8-byte aligned
+#define HISTORY_MAX_ENTRIES (1u << 26)   // Larger counts in a footer are corruption
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t created_at;
+} HistoryHeader;
+
+// Precedes each block's payload; a block decodes without the footer
+typedef struct {
+    uint32_t magic;
+    uint32_t transaction_index;
+    uint64_t timestamp;
+    uint64_t length;
+    uint8_t state_hash[32];
+    uint8_t checksum[32];  // SHA-256 of the payload
+} HistoryBlockHeader;
+
+// Last bytes of the file
+typedef struct {
+    uint64_t index_offset;
+    uint32_t num_entries;
+    uint32_t magic;
+    uint8_t checksum[32];  // SHA-256 of the index entries
+} HistoryTrailer;
+
+static inline uint64_t align_up(uint64_t offset) {
+    return (offset + HISTORY_ALIGN - 1) & ~(uint64_t)(HISTORY_ALIGN - 1);
+}
+
+// Footer index from the trailer; returns 0 when it is missing or torn
+static int read_footer(int fd, uint64_t size, PCHistoryIndexEntry** entries_out,
+                       uint32_t* count_out, uint64_t* end_out) {
+    HistoryTrailer trailer;
+    if (size < sizeof(HistoryHeader) + sizeof(trailer) ||
+        pread(fd, &trailer, sizeof(trailer), (off_t)(size - sizeof(trailer))) != (ssize_t)sizeof(trailer) ||
+        trailer.magic != HISTORY_FOOTER_MAGIC || trailer.num_entries > HISTORY_MAX_ENTRIES ||
+        trailer.index_offset < sizeof(HistoryHeader) ||
+        trailer.index_offset + (uint64_t)trailer.num_entries * sizeof(PCHistoryIndexEntry) +
+            sizeof(trailer) != size) {
+        return 0;
+    }
+    
+    size_t bytes = (size_t)trailer.num_entries * sizeof(PCHistoryIndexEntry);
+    PCHistoryIndexEntry* entries = malloc(bytes ? bytes : 1);
+    if (!entries) return 0;
+    
+    uint8_t check[32];
+    if (pread(fd, entries, bytes, (off_t)trailer.index_offset) != (ssize_t)bytes) goto torn;
+    sha256((const uint8_t*)entries, bytes, check);
+    if (memcmp(check, trailer.checksum, 32) != 0) goto torn;
+    
+    for (uint32_t i = 0; i < trailer.num_entries; i++) {
+        const PCHistoryIndexEntry* e = &entries[i];
+        if (e->offset < sizeof(HistoryHeader) ||
+            e->offset + sizeof(HistoryBlockHeader) > trailer.index_offset ||
+            e->length > trailer.index_offset - e->offset - sizeof(HistoryBlockHeader) ||
+            (i > 0 && e->timestamp < entries[i - 1].timestamp)) {
+            goto torn;
+        }
+    }
+    
+    *entries_out = entries;
+    *count_out = trailer.num_entries;
+    *end_out = trailer.index_offset;
+    return 1;
+
+torn:
+    free(entries);
+    return 0;
+}
+
+// Rebuild the index by walking blocks from the start; stops at the first
+// block that is incomplete or fails its checksum
+static PCError scan_blocks(int fd, uint64_t size, PCHistoryIndexEntry** entries_out,
+                           uint32_t* count_out, uint64_t* end_out) {
+    PCHistoryIndexEntry* entries = NULL;
+    uint32_t count = 0, cap = 0;
+    uint8_t* payload = NULL;
+    uint64_t payload_cap = 0;
+    uint64_t offset = align_up(sizeof(HistoryHeader));
+    uint64_t end = offset;
+    
+    HistoryBlockHeader bh;
+    while (offset + sizeof(bh) <= size &&
+           pread(fd, &bh, sizeof(bh), (off_t)offset) == (ssize_t)sizeof(bh)) {
+        if (bh.magic != HISTORY_BLOCK_MAGIC || bh.length > size - offset - sizeof(bh) ||
+            (count > 0 && bh.timestamp < entries[count - 1].timestamp)) {
+            break;
+        }
+        
+        if (bh.length > payload_cap) {
+            uint8_t* grown = realloc(payload, bh.length);
+            if (!grown) break;
+            payload = grown;
+            payload_cap = bh.length;
+        }
+        uint8_t check[32];
+        if (pread(fd, payload, bh.length, (off_t)(offset + sizeof(bh))) != (ssize_t)bh.length) break;
+        sha256(payload, bh.length, check);
+        if (memcmp(check, bh.checksum, 32) != 0) break;
+        
+        if (count == cap) {
+            cap = cap ? cap * 2 : 64;
+            PCHistoryIndexEntry* grown = realloc(entries, cap * sizeof(PCHistoryIndexEntry));
+            if (!grown) break;
+            entries = grown;
+        }
+        PCHistoryIndexEntry* e = &entries[count++];
+        memset(e, 0, sizeof(*e));
+        e->timestamp = bh.timestamp;
+        e->offset = offset;
+        e->length = bh.length;
+        e->transaction_index = bh.transaction_index;
+        memcpy(e->state_hash, bh.state_hash, 32);
+        
+        end = offset + sizeof(bh) + bh.length;
+        offset = align_up(end);
+    }
+    
+    free(payload);
+    if (count > 0) printf("Rebuilt history index from %u blocks\n", count);
+    *entries_out = entries;
+    *count_out = count;
+    *end_out = end;
+    return PC_OK;
+}
+
+// Index of an existing file and where the next block goes
+static PCError load_index(int fd, PCHistoryIndexEntry** entries, uint32_t* count, uint64_t* end) {
+    struct stat st;
+    HistoryHeader hdr;
+    if (fstat(fd, &st) != 0 ||
+        pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        hdr.magic != HISTORY_MAGIC || hdr.version != HISTORY_VERSION) {
+        return PC_ERR_INVALID_DATA;
+    }
+    
+    if (read_footer(fd, (uint64_t)st.st_size, entries, count, end)) return PC_OK;
+    return scan_blocks(fd, (uint64_t)st.st_size, entries, count, end);
+}
+
+// Write state as a block at offset and fill its index entry
+static PCError write_block(int fd, uint64_t offset, const PCState* state, uint64_t timestamp,
+                           const uint8_t* state_hash, uint32_t tx_index, PCHistoryIndexEntry* entry) {
+    // Compact records never exceed a raw record plus block framing
+    size_t cap = 4096 + (size_t)state->num_wallets * 64;
+    uint8_t* buf = malloc(sizeof(HistoryBlockHeader) + cap);
+    if (!buf) return PC_ERR_IO;
+    
+    size_t length = pc_state_serialize_compact(state, buf + sizeof(HistoryBlockHeader), cap);
+    if (length == 0) {
+        free(buf);
+        return PC_ERR_IO;
+    }
+    
+    HistoryBlockHeader bh;
+    memset(&bh, 0, sizeof(bh));
+    bh.magic = HISTORY_BLOCK_MAGIC;
+    bh.transaction_index = tx_index;
+    bh.timestamp = timestamp;
+    bh.length = length;
+    memcpy(bh.state_hash, state_hash, 32);
+    sha256(buf + sizeof(bh), length, bh.checksum);
+    memcpy(buf, &bh, sizeof(bh));
+    
+    size_t total = sizeof(bh) + length;
+    ssize_t written = pwrite(fd, buf, total, (off_t)offset);
+    free(buf);
+    if (written != (ssize_t)total) return PC_ERR_IO;
+    
+    memset(entry, 0, sizeof(*entry));
+    entry->timestamp = timestamp;
+    entry->offset = offset;
+    entry->length = length;
+    entry->transaction_index = tx_index;
+    memcpy(entry->state_hash, state_hash, 32);
+    return PC_OK;
+}
+
+// Write the index and trailer at offset, cut the file there and sync
+static PCError write_footer(int fd, uint64_t offset, const PCHistoryIndexEntry* entries, uint32_t count) {
+    HistoryTrailer trailer;
+    size_t bytes = (size_t)count * sizeof(PCHistoryIndexEntry);
+    trailer.index_offset = offset;
+    trailer.num_entries = count;
+    trailer.magic = HISTORY_FOOTER_MAGIC;
+    sha256((const uint8_t*)entries, bytes, trailer.checksum);
+    
+    if (pwrite(fd, entries, bytes, (off_t)offset) != (ssize_t)bytes ||
+        pwrite(fd, &trailer, sizeof(trailer), (off_t)(offset + bytes)) != (ssize_t)sizeof(trailer) ||
+        ftruncate(fd, (off_t)(offset + bytes + sizeof(trailer))) != 0 ||
+        fdatasync(fd) != 0) {
+        return PC_ERR_IO;
+    }
+    return PC_OK;
+}
+
+static PCError write_header(int fd) {
+    HistoryHeader hdr = { HISTORY_MAGIC, HISTORY_VERSION, (uint64_t)time(NULL) };
+    return pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) ? PC_OK : PC_ERR_IO;
+}
+
+// Append one checkpoint
+PCError pc_history_append(const char* filename, const PCState* state, uint32_t tx_index) {
+    if (!filename || !state) return PC_ERR_IO;
+    
+    PCHistoryFile file;
+    PCError err = pc_history_open_append(&file, filename);
+    if (err != PC_OK) return err;
+    err = pc_history_add(&file, state, tx_index);
+    pc_history_close(&file);
+    return err;
+}
+
+// Open for appends; the file is mapped on the first query
+PCError pc_history_open_append(PCHistoryFile* file, const char* filename) {
+    if (!file || !filename) return PC_ERR_IO;
+    
+    memset(file, 0, sizeof(PCHistoryFile));
+    file->fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file->fd < 0) return PC_ERR_IO;
+    file->writable = 1;
+    file->end = align_up(sizeof(HistoryHeader));
+    
+    struct stat st;
+    PCError err = fstat(file->fd, &st) == 0 ? PC_OK : PC_ERR_IO;
+    if (err == PC_OK) {
+        err = st.st_size == 0 ? write_header(file->fd) :
+              load_index(file->fd, &file->index, &file->num_entries, &file->end);
+    }
+    file->index_capacity = file->num_entries;
+    
+    if (err != PC_OK) pc_history_close(file);
+    return err;
+}
+
+// Append through an open file: the block goes over the old footer and a new
+// footer follows it
+PCError pc_history_add(PCHistoryFile* file, const PCState* state, uint32_t tx_index) {
+    if (!file || !file->writable || file->fd < 0 || !state) return PC_ERR_IO;
+    if (file->num_entries >= HISTORY_MAX_ENTRIES) return PC_ERR_LIMIT_EXCEEDED;
+    
+    if (file->num_entries == file->index_capacity) {
+        uint32_t capacity = file->index_capacity ? file->index_capacity * 2 : 64;
+        PCHistoryIndexEntry* grown = realloc(file->index, (size_t)capacity * sizeof(PCHistoryIndexEntry));
+        if (!grown) return PC_ERR_IO;
+        file->index = grown;
+        file->index_capacity = capacity;
+    }
+    
+    // Lookups binary-search timestamps, so a clock step back must not reorder them
+    uint32_t count = file->num_entries;
+    uint64_t timestamp = state->timestamp;
+    if (count > 0 && timestamp < file->index[count - 1].timestamp) timestamp = file->index[count - 1].timestamp;
+    
+    uint64_t offset = align_up(file->end);
+    PCError err = write_block(file->fd, offset, state, timestamp, state->state_hash, tx_index,
+                              &file->index[count]);
+    if (err != PC_OK) return err;
+    uint64_t end = align_up(offset + sizeof(HistoryBlockHeader) + file->index[count].length);
+    err = write_footer(file->fd, end, file->index, count + 1);
+    if (err != PC_OK) return err;
+    
+    file->num_entries = count + 1;
+    file->end = end;
+    return PC_OK;
+}
+
+// Whole history at once (written aside, then renamed over filename)
+PCError pc_history_write(const PCCheckpointHistory* history, const char* filename) {
+    if (!history || !filename) return PC_ERR_IO;
+    
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return PC_ERR_IO;
+    
+    uint32_t count = history->num_checkpoints;
+    PCHistoryIndexEntry* entries = malloc(((size_t)count + 1) * sizeof(PCHistoryIndexEntry));
+    PCError err = entries ? write_header(fd) : PC_ERR_IO;
+    
+    uint64_t end = align_up(sizeof(HistoryHeader));
+    for (uint32_t i = 0; err == PC_OK && i < count; i++) {
+        const PCStateCheckpoint* cp = &history->checkpoints[i];
+        uint64_t timestamp = cp->timestamp;
+        if (i > 0 && timestamp < entries[i - 1].timestamp) timestamp = entries[i - 1].timestamp;
+        
+        err = write_block(fd, end, &cp->state, timestamp, cp->state_hash, cp->transaction_index, &entries[i]);
+        if (err == PC_OK) end = align_up(end + sizeof(HistoryBlockHeader) + entries[i].length);
+    }
+    if (err == PC_OK) err = write_footer(fd, end, entries, count);
+    
+    free(entries);
+    close(fd);
+    if (err == PC_OK && rename(tmp, filename) != 0) err = PC_ERR_IO;
+    if (err != PC_OK) unlink(tmp);
+    return err;
+}
+
+// (Re)map the whole file; queries touch one block each, so no read-ahead
+static PCError map_file(PCHistoryFile* file) {
+    struct stat st;
+    if (fstat(file->fd, &st) != 0 || st.st_size == 0) return PC_ERR_IO;
+    
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (map == MAP_FAILED) return PC_ERR_IO;
+    madvise(map, (size_t)st.st_size, MADV_RANDOM);
+    
+    if (file->map) munmap((void*)file->map, file->map_size);
+    file->map = map;
+    file->map_size = (size_t)st.st_size;
+    return PC_OK;
+}
+
+// Open for queries
+PCError pc_history_open(PCHistoryFile* file, const char* filename) {
+    if (!file || !filename) return PC_ERR_IO;
+    
+    memset(file, 0, sizeof(PCHistoryFile));
+    file->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) return PC_ERR_IO;
+    
+    PCError err = load_index(file->fd, &file->index, &file->num_entries, &file->end);
+    file->index_capacity = file->num_entries;
+    if (err == PC_OK) err = map_file(file);
+    
+    if (err != PC_OK) pc_history_close(file);
+    return err;
+}
+
+// Last entry at or before timestamp, or -1
+static int64_t find_entry_before(const PCHistoryFile* file, uint64_t timestamp) {
+    uint32_t left = 0;
+    uint32_t right = file->num_entries;
+    
+    while (left < right) {
+        uint32_t mid = left + (right - left) / 2;
+        if (file->index[mid].timestamp <= timestamp) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    
+    return (int64_t)left - 1;
+}
+
+// Decoded state of an index entry, through the cache
+static const PCState* block_state(PCHistoryFile* file, uint32_t entry) {
+    PCHistoryCacheSlot* victim = &file->cache[0];
+    for (int i = 0; i < PC_HISTORY_CACHE_BLOCKS; i++) {
+        PCHistoryCacheSlot* slot = &file->cache[i];
+        if (slot->last_use && slot->entry == entry) {
+            slot->last_use = ++file->clock;
+            return &slot->state;
+        }
+        if (slot->last_use < victim->last_use) victim = slot;
+    }
+    
+    // Blocks appended since the file was mapped need a new mapping
+    const PCHistoryIndexEntry* e = &file->index[entry];
+    if (e->offset + sizeof(HistoryBlockHeader) + e->length > file->map_size &&
+        (map_file(file) != PC_OK || e->offset + sizeof(HistoryBlockHeader) + e->length > file->map_size)) {
+        return NULL;
+    }
+    
+    // Least recently used slot takes the block; it is verified before decoding
+    const HistoryBlockHeader* bh = (const HistoryBlockHeader*)(file->map + e->offset);
+    const uint8_t* payload = file->map + e->offset + sizeof(HistoryBlockHeader);
+    uint8_t check[32];
+    sha256(payload, e->length, check);
+    
+    victim->last_use = 0;
+    if (bh->magic != HISTORY_BLOCK_MAGIC || bh->length != e->length ||
+        memcmp(check, bh->checksum, 32) != 0 ||
+        pc_state_deserialize(&victim->state, payload, e->length) != PC_OK) {
+        return NULL;
+    }
+    victim->entry = entry;
+    victim->last_use = ++file->clock;
+    return &victim->state;
+}
+
+// Query wallet contents at specific timestamp
+PCError pc_history_wallet_at(PCHistoryFile* file, const uint8_t* pubkey,
+                             uint64_t timestamp, PCWallet* wallet) {
+    if (!file || file->fd < 0 || !pubkey || !wallet) return PC_ERR_IO;
+    
+    int64_t entry = find_entry_before(file, timestamp);
+    if (entry < 0) return PC_ERR_WALLET_NOT_FOUND;
+    
+    const PCState* state = block_state(file, (uint32_t)entry);
+    if (!state) return PC_ERR_INVALID_DATA;
+    
+    const PCWallet* found = pc_state_find_wallet(state, pubkey);
+    if (found) *wallet = *found;
+    else memset(wallet, 0, sizeof(PCWallet));
+    return PC_OK;
+}
+
+PCError pc_history_balance_at(PCHistoryFile* file, const uint8_t* pubkey,
+                              uint64_t timestamp, PCAmount* balance) {
+    if (!balance) return PC_ERR_IO;
+    
+    PCWallet wallet;
+    PCError err = pc_history_wallet_at(file, pubkey, timestamp, &wallet);
+    if (err == PC_OK) *balance = wallet.energy;
+    return err;
+}
+
+// State hash from the footer alone
+PCError pc_history_state_hash_at(const PCHistoryFile* file, uint64_t timestamp, uint8_t* hash_out) {
+    if (!file || !hash_out) return PC_ERR_IO;
+    
+    int64_t entry = find_entry_before(file, timestamp);
+    if (entry < 0) return PC_ERR_WALLET_NOT_FOUND;
+    
+    memcpy(hash_out, file->index[entry].state_hash, 32);
+    return PC_OK;
+}
+
+void pc_history_close(PCHistoryFile* file) {
+    if (!file) return;
+    
+    for (int i = 0; i < PC_HISTORY_CACHE_BLOCKS; i++) {
+        pc_state_free(&file->cache[i].state);
+        file->cache[i].last_use = 0;
+    }
+    if (file->map) munmap((void*)file->map, file->map_size);
+    if (file->fd >= 0) close(file->fd);
+    free(file->index);
+    file->map = NULL;
+    file->map_size = 0;
+    file->fd = -1;
+    file->index = NULL;
+    file->num_entries = 0;
+    file->index_capacity = 0;
+    file->writable = 0;
+}
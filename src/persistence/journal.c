@@ -0,0 +1,165 @@
+// journal.c - Append-only mutation journals for on-disk registries
+// Each mutation is one checksummed record; the owner folds the journal into
+// a new snapshot generation once it outgrows the registry
+
+#include "../include/physicscoin.h"
+#include "../include/journal.h"
+#include "../crypto/sha256.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define JOURNAL_MAGIC 0x4A524E4C  // "JRNL"
+#define JOURNAL_VERSION 1
+#define JOURNAL_MAX_RECORD (1u << 20)  // Larger lengths are corruption
+#define JOURNAL_COMPACT_MIN 256  // Records before a compaction is considered
+
+static void record_checksum(uint32_t type, uint32_t length, const void* data, uint8_t out[32]) {
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, (const uint8_t*)&type, sizeof(type));
+    sha256_update(&ctx, (const uint8_t*)&length, sizeof(length));
+    sha256_update(&ctx, data, length);
+    sha256_final(&ctx, out);
+}
+
+// Replace the file with an empty journal for generation (written aside, renamed)
+static PCError create_journal(PCJournal* journal, uint64_t generation) {
+    char tmp[300];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", journal->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return PC_ERR_IO;
+    
+    JournalHeader hdr = { JOURNAL_MAGIC, JOURNAL_VERSION, generation };
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) || fdatasync(fd) != 0 ||
+        rename(tmp, journal->path) != 0) {
+        close(fd);
+        unlink(tmp);
+        return PC_ERR_IO;
+    }
+    
+    if (journal->fd >= 0) close(journal->fd);
+    journal->fd = fd;
+    journal->generation = generation;
+    journal->records = 0;
+    return PC_OK;
+}
+
+// Apply records in order; returns the offset just past the last good one
+static off_t replay_records(int fd, PCJournalApplyFn apply, void* ctx, uint32_t* count) {
+    off_t offset = sizeof(JournalHeader);
+    uint8_t* payload = NULL;
+    uint32_t cap = 0;
+    
+    JournalRecord rec;
+    while (pread(fd, &rec, sizeof(rec), offset) == (ssize_t)sizeof(rec)) {
+        if (rec.length > JOURNAL_MAX_RECORD) break;
+        if (rec.length > cap) {
+            uint8_t* grown = realloc(payload, rec.length);
+            if (!grown) break;
+            payload = grown;
+            cap = rec.length;
+        }
+        if (pread(fd, payload, rec.length, offset + (off_t)sizeof(rec)) != (ssize_t)rec.length) break;
+        
+        uint8_t check[32];
+        record_checksum(rec.type, rec.length, payload, check);
+        if (memcmp(check, rec.checksum, 32) != 0) break;
+        
+        apply(ctx, rec.type, payload, rec.length);
+        offset += (off_t)sizeof(rec) + rec.length;
+        (*count)++;
+    }
+    
+    free(payload);
+    return offset;
+}
+
+// Open, replay and position for appends
+PCError pc_journal_open(PCJournal* journal, const char* path, uint64_t generation,
+                        PCJournalApplyFn apply, void* ctx) {
+    if (!journal || !path) return PC_ERR_IO;
+    
+    journal->fd = -1;
+    strncpy(journal->path, path, sizeof(journal->path) - 1);
+    journal->path[sizeof(journal->path) - 1] = '\0';
+    journal->generation = generation;
+    journal->records = 0;
+    
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    JournalHeader hdr;
+    if (fd < 0 || pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        hdr.magic != JOURNAL_MAGIC || hdr.version != JOURNAL_VERSION ||
+        hdr.generation != generation) {
+        if (fd >= 0) close(fd);
+        return create_journal(journal, generation);
+    }
+    
+    // A crash mid-append leaves a torn record: drop it so appends follow
+    // the last complete one
+    uint32_t count = 0;
+    off_t end = replay_records(fd, apply, ctx, &count);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size > end && ftruncate(fd, end) != 0) ||
+        lseek(fd, end, SEEK_SET) != end) {
+        close(fd);
+        return PC_ERR_IO;
+    }
+    if (count > 0) {
+        printf("Replayed %u journal records from %s\n", count, path);
+    }
+    
+    journal->fd = fd;
+    journal->records = count;
+    return PC_OK;
+}
+
+// Append one record
+PCError pc_journal_append(PCJournal* journal, uint32_t type, const void* data, uint32_t length) {
+    if (!journal || journal->fd < 0 || length > JOURNAL_MAX_RECORD) return PC_ERR_IO;
+    
+    uint8_t buf[sizeof(JournalRecord) + 1024];
+    uint8_t* rec = sizeof(JournalRecord) + length <= sizeof(buf) ? buf : malloc(sizeof(JournalRecord) + length);
+    if (!rec) return PC_ERR_IO;
+    
+    JournalRecord hdr;
+    hdr.type = type;
+    hdr.length = length;
+    record_checksum(type, length, data, hdr.checksum);
+    memcpy(rec, &hdr, sizeof(hdr));
+    memcpy(rec + sizeof(hdr), data, length);
+    
+    // One write: a crash can only tear the tail, which open cuts off. A
+    // failed write is cut off here so later records stay reachable.
+    off_t start = lseek(journal->fd, 0, SEEK_CUR);
+    size_t total = sizeof(hdr) + length;
+    int ok = start >= 0 && write(journal->fd, rec, total) == (ssize_t)total &&
+             fdatasync(journal->fd) == 0;
+    if (rec != buf) free(rec);
+    if (!ok) {
+        if (start >= 0 && ftruncate(journal->fd, start) == 0) lseek(journal->fd, start, SEEK_SET);
+        return PC_ERR_IO;
+    }
+    
+    journal->records++;
+    return PC_OK;
+}
+
+// Start an empty journal
+PCError pc_journal_reset(PCJournal* journal, uint64_t generation) {
+    if (!journal) return PC_ERR_IO;
+    return create_journal(journal, generation);
+}
+
+int pc_journal_should_compact(const PCJournal* journal, uint32_t live_entries) {
+    return journal && journal->records >= JOURNAL_COMPACT_MIN && journal->records > live_entries;
+}
+
+void pc_journal_close(PCJournal* journal) {
+    if (!journal || journal->fd < 0) return;
+    close(journal->fd);
+    journal->fd = -1;
+}
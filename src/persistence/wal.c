@@ -2,7 +2,9 @@
 // Logs transactions before execution for durability
 // SECURITY HARDENED: Proper fsync for crash safety
 
+#define _GNU_SOURCE  // fallocate
 #include "../include/physicscoin.h"
+#include "../include/wal.h"
 #include "../crypto/sha256.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,11 +13,29 @@
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
 
 #define WAL_MAGIC 0x57414C50  // "WALP"
-#define WAL_VERSION 2  // Bumped version for new format
-#define WAL_FILENAME "physicscoin.wal"
-#define CHECKPOINT_FILENAME "physicscoin.checkpoint"
+#define WAL_VERSION 4  // Fixed-size preallocated segments
+#define WAL_LEGACY_VERSION 3  // Single-file log, still replayed on startup
+#define WAL_MIN_VERSION 3  // v2 and older logged double amounts
+#define CHECKPOINT_SUFFIX ".checkpoint"  // Base at path.checkpoint, increments at path.checkpoint.NNNNNNNN
+#define LEGACY_CHECKPOINT_FILENAME "physicscoin.checkpoint"  // Shared by every v3 log
+#define WAL_RECOVER_CHUNK 64  // Entries checksummed per sha256_many call during recovery
+#define WAL_GROUP_DEFAULT_MAX 256  // Pending entries that trigger an early group flush
+#define WAL_SEGMENT_SIZE (16u << 20)  // Preallocated bytes per segment file
+#define WAL_ASYNC_DEFAULT_DEPTH 256  // Async appends in flight
+#define WAL_ASYNC_MAX_DEPTH 4096
+#define WAL_INCREMENT_MAGIC 0x49434850  // "PHCI"
+#define WAL_INCREMENT_VERSION 2  // Records are pages of PC_WALLET_PAGE_SIZE wallets
+#define WAL_COMPACT_DEFAULT 16  // Increments stacked on the base before a fold
+#define WAL_COMPACT_INTERVAL_S 60  // Compactor folds at least this often
 
 // WAL entry types
 typedef enum {
@@ -25,15 +45,27 @@ typedef enum {
     WAL_ENTRY_SYNC_MARKER = 4  // New: explicit sync point
 } WALEntryType;
 
-// WAL file header
+// Single-file (v3) log header
 typedef struct {
     uint32_t magic;
     uint32_t version;
     uint64_t created_at;
     uint64_t entry_count;
     uint8_t state_hash[32];
-    uint32_t flags;  // New: feature flags
-} WALHeader;
+    uint32_t flags;
+} WALLegacyHeader;
+
+// Genesis entry payload
+typedef struct {
+    uint8_t pubkey[32];
+    PCAmount supply;
+} WALGenesisPayload;
+
+// Checkpoint entry payload (v3 logs and early v4 entries carry only the hash)
+typedef struct {
+    uint8_t state_hash[32];
+    uint64_t next_sequence;  // First entry the checkpoint does not cover
+} WALCheckpointPayload;
 
 // WAL entry header
 typedef struct {
@@ -44,397 +76,1517 @@ typedef struct {
     uint8_t checksum[32];
 } WALEntryHeader;
 
-// WAL state
-typedef struct {
-    FILE* file;
-    int fd;  // Raw file descriptor for fsync
-    WALHeader header;
-    uint64_t current_sequence;
-    int dirty;
-    int sync_on_write;  // SECURITY: Whether to fsync after each write
-} PCWAL;
-
-// SECURITY: Force data to disk
+// SECURITY: Force data to disk. Segments never change size after
+// preallocation, so fdatasync skips the inode update fsync would add.
 static int wal_sync(PCWAL* wal) {
-    if (!wal || !wal->file) return -1;
+    if (!wal || wal->fd < 0) return -1;
     
-    // Flush stdio buffers
-    if (fflush(wal->file) != 0) {
-        perror("fflush");
+    if (fdatasync(wal->fd) != 0) {
+        perror("fdatasync");
         return -1;
     }
     
-    // Force to disk with fsync
-    if (fsync(wal->fd) != 0) {
-        perror("fsync");
-        return -1;
+    return 0;
+}
+
+static void segment_path(const PCWAL* wal, uint64_t id, char* out, size_t size) {
+    snprintf(out, size, "%s.%08lu", wal->path, id);
+}
+
+// Checkpoints belong to one log, so logs sharing a directory stay apart
+static void checkpoint_path(const PCWAL* wal, char* out, size_t size) {
+    snprintf(out, size, "%s%s", wal->path, CHECKPOINT_SUFFIX);
+}
+
+// Split a path into its directory and file name
+static const char* split_path(const char* path, char* dir, size_t size) {
+    const char* slash = strrchr(path, '/');
+    if (!slash) {
+        snprintf(dir, size, ".");
+        return path;
     }
+    snprintf(dir, size, "%.*s", (int)(slash - path), path);
+    if (!dir[0]) snprintf(dir, size, "/");
+    return slash + 1;
+}
+
+// Make a created or removed segment name durable
+static void sync_dir(const char* path) {
+    char dir[256];
+    split_path(path, dir, sizeof(dir));
+    
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Find the oldest and newest path.NNNNNNNN ids on disk; returns 0 if none
+static int find_numbered(const char* path, uint64_t* first, uint64_t* last) {
+    char dir[256];
+    const char* base = split_path(path, dir, sizeof(dir));
+    
+    DIR* d = opendir(dir);
+    if (!d) return 0;
+    
+    size_t base_len = strlen(base);
+    int found = 0;
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL) {
+        const char* name = ent->d_name;
+        if (strncmp(name, base, base_len) != 0 || name[base_len] != '.') continue;
+        
+        char* end;
+        uint64_t id = strtoull(name + base_len + 1, &end, 10);
+        if (*end != '\0' || end - (name + base_len + 1) != 8 || id == 0) continue;
+        
+        if (!found || id < *first) *first = id;
+        if (!found || id > *last) *last = id;
+        found = 1;
+    }
+    closedir(d);
     
-    return 0;
+    return found;
+}
+
+// Create, preallocate and stamp segment id as the current segment
+static PCError open_segment(PCWAL* wal, uint64_t id) {
+    char name[300];
+    segment_path(wal, id, name, sizeof(name));
+    
+    int fd = open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open WAL segment");
+        return PC_ERR_IO;
+    }
+    
+    // Reserve the whole segment so appends never grow the file
+    if (fallocate(fd, 0, 0, WAL_SEGMENT_SIZE) != 0 &&
+        posix_fallocate(fd, 0, WAL_SEGMENT_SIZE) != 0) {
+        perror("fallocate WAL segment");
+        close(fd);
+        unlink(name);
+        return PC_ERR_IO;
+    }
+    
+    WALHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = WAL_MAGIC;
+    header.version = WAL_VERSION;
+    header.created_at = (uint64_t)time(NULL);
+    header.segment_id = id;
+    header.first_sequence = wal->current_sequence;
+    memcpy(header.state_hash, wal->header.state_hash, 32);
+    
+    // SECURITY: Ensure header and file name are on disk
+    if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        fsync(fd) != 0) {
+        close(fd);
+        unlink(name);
+        return PC_ERR_IO;
+    }
+    sync_dir(name);
+    
+    wal->fd = fd;
+    wal->header = header;
+    wal->write_offset = sizeof(WALHeader);
+    
+    return PC_OK;
+}
+
+// Compute checksum for entry
+static void compute_checksum(const void* data, size_t size, uint8_t checksum[32]) {
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, size);
+    sha256_final(&ctx, checksum);
+}
+
+// Verify checksum
+static int verify_checksum(const void* data, size_t size, const uint8_t expected[32]) {
+    uint8_t computed[32];
+    compute_checksum(data, size, computed);
+    return memcmp(computed, expected, 32) == 0;
 }
 
-// Initialize WAL
+// Walk the current segment to its last intact entry (a torn tail is overwritten)
+static void scan_segment_tail(PCWAL* wal) {
+    uint64_t offset = sizeof(WALHeader);
+    uint64_t sequence = wal->header.first_sequence;
+    uint8_t payload[sizeof(PCTransaction)];
+    
+    for (;;) {
+        WALEntryHeader entry;
+        if (offset + sizeof(entry) > WAL_SEGMENT_SIZE ||
+            pread(wal->fd, &entry, sizeof(entry), offset) != (ssize_t)sizeof(entry)) break;
+        if (entry.type < WAL_ENTRY_TX || entry.type > WAL_ENTRY_SYNC_MARKER) break;
+        if (entry.payload_size > sizeof(payload) || entry.sequence != sequence) break;
+        if (offset + sizeof(entry) + entry.payload_size > WAL_SEGMENT_SIZE) break;
+        if (pread(wal->fd, payload, entry.payload_size, offset + sizeof(entry)) !=
+            (ssize_t)entry.payload_size) break;
+        if (!verify_checksum(payload, entry.payload_size, entry.checksum)) break;
+        
+        offset += sizeof(entry) + entry.payload_size;
+        sequence++;
+    }
+    
+    wal->write_offset = offset;
+    wal->current_sequence = sequence;
+}
+
+// Pick up a pre-segment (v3) log left at the base path
+static PCError open_legacy(PCWAL* wal) {
+    FILE* f = fopen(wal->path, "rb");
+    if (!f) return PC_OK;
+    
+    WALLegacyHeader legacy;
+    PCError err = PC_OK;
+    if (fread(&legacy, sizeof(legacy), 1, f) != 1 || legacy.magic != WAL_MAGIC) {
+        printf("Invalid WAL magic\n");
+    } else if (legacy.version < WAL_MIN_VERSION) {
+        // Signatures cover the amount bytes, so old entries cannot be
+        // converted; refuse rather than truncate the log
+        printf("WAL version %u uses floating-point amounts; checkpoint with an older build\n",
+               legacy.version);
+        err = PC_ERR_IO;
+    } else if (legacy.version == WAL_LEGACY_VERSION) {
+        wal->legacy = 1;
+        wal->current_sequence = legacy.entry_count;
+        memcpy(wal->header.state_hash, legacy.state_hash, 32);
+    }
+    fclose(f);
+    
+    return err;
+}
+
+// Initialize WAL; filename is the base name of the segment files
 PCError pc_wal_init(PCWAL* wal, const char* filename) {
-    if (!wal || !filename) return PC_ERR_IO;
+    if (!wal || !filename || strlen(filename) >= sizeof(wal->path)) return PC_ERR_IO;
     
     memset(wal, 0, sizeof(PCWAL));
+    wal->fd = -1;
     wal->sync_on_write = 1;  // Default: sync after each write for safety
+    strcpy(wal->path, filename);
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_cond_init(&wal->pending, NULL);
+    pthread_cond_init(&wal->durable, NULL);
+    pthread_mutex_init(&wal->checkpoint_lock, NULL);
+    pthread_cond_init(&wal->compact, NULL);
+    wal->compact_after = WAL_COMPACT_DEFAULT;
+    
+    // Increments on disk sit on the base; ids continue after the newest
+    uint64_t first, last;
+    char checkpoint[300];
+    checkpoint_path(wal, checkpoint, sizeof(checkpoint));
+    if (find_numbered(checkpoint, &first, &last)) {
+        wal->checkpoint_id = last;
+        wal->base_id = first - 1;
+    }
     
-    // Try to open existing WAL
-    wal->file = fopen(filename, "r+b");
+    if (open_legacy(wal) != PC_OK) return PC_ERR_IO;
     
-    if (wal->file) {
-        wal->fd = fileno(wal->file);
+    // Try to open existing segments and append after the newest one's tail
+    if (find_numbered(wal->path, &first, &last)) {
+        char name[300];
+        segment_path(wal, last, name, sizeof(name));
+        wal->fd = open(name, O_RDWR | O_CLOEXEC);
         
-        // Read header
-        if (fread(&wal->header, sizeof(WALHeader), 1, wal->file) != 1) {
-            fclose(wal->file);
-            wal->file = NULL;
+        if (wal->fd < 0 ||
+            pread(wal->fd, &wal->header, sizeof(WALHeader), 0) != (ssize_t)sizeof(WALHeader)) {
+            perror("open WAL segment");
         } else if (wal->header.magic != WAL_MAGIC) {
             printf("Invalid WAL magic\n");
-            fclose(wal->file);
-            wal->file = NULL;
-        } else if (wal->header.version > WAL_VERSION) {
-            printf("WAL version %u is newer than supported %u\n", 
+        } else if (wal->header.version != WAL_VERSION) {
+            printf("WAL version %u is not supported (expected %u)\n",
                    wal->header.version, WAL_VERSION);
-            fclose(wal->file);
-            wal->file = NULL;
         } else {
-            wal->current_sequence = wal->header.entry_count;
-            printf("Opened existing WAL with %lu entries\n", wal->header.entry_count);
+            wal->first_segment = first;
+            scan_segment_tail(wal);
+            wal->synced_sequence = wal->current_sequence;
+            printf("Opened existing WAL: segments %lu-%lu, next sequence %lu\n",
+                   first, last, wal->current_sequence);
             return PC_OK;
         }
-    }
-    
-    // Create new WAL
-    wal->file = fopen(filename, "w+b");
-    if (!wal->file) {
-        perror("fopen");
+        
+        if (wal->fd >= 0) close(wal->fd);
+        wal->fd = -1;
         return PC_ERR_IO;
     }
     
-    wal->fd = fileno(wal->file);
+    // Create the first segment (sequences continue after a legacy log)
+    wal->first_segment = 1;
+    if (open_segment(wal, 1) != PC_OK) return PC_ERR_IO;
+    wal->synced_sequence = wal->current_sequence;
     
-    wal->header.magic = WAL_MAGIC;
-    wal->header.version = WAL_VERSION;
-    wal->header.created_at = (uint64_t)time(NULL);
-    wal->header.entry_count = 0;
-    wal->header.flags = 0;
-    memset(wal->header.state_hash, 0, 32);
+    printf("Created new WAL v%u with fsync enabled\n", WAL_VERSION);
     
-    if (fwrite(&wal->header, sizeof(WALHeader), 1, wal->file) != 1) {
-        fclose(wal->file);
+    return PC_OK;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// ============ io_uring async writer ============
+
+// One async append: the encoded entry and who to tell when it is durable
+typedef struct {
+    uint8_t buf[sizeof(WALEntryHeader) + sizeof(PCTransaction)];
+    struct iovec iov;
+    uint32_t outstanding;  // CQEs still expected (write + fdatasync)
+    uint64_t sequence;     // Log sequence of the entry
+    PCError err;
+    PCWALDoneFn done;
+    void* ctx;
+} WALAsyncSlot;
+
+struct PCWALRing {
+    int fd;
+    void* sq_map;
+    size_t sq_map_len;
+    void* cq_map;
+    size_t cq_map_len;
+    struct io_uring_sqe* sqes;
+    size_t sqes_len;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    WALAsyncSlot* slots;
+    uint32_t depth;  // Slots in flight at most (power of two)
+    uint64_t head;   // Oldest slot whose callback has not run
+    uint64_t tail;   // Next slot to submit
+};
+
+// No liburing dependency: the two syscalls and the shared rings are enough
+static int uring_setup(unsigned entries, struct io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static void ring_free(struct PCWALRing* r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_len);
+    if (r->cq_map && r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    if (r->sq_map) munmap(r->sq_map, r->sq_map_len);
+    if (r->fd >= 0) close(r->fd);
+    free(r->slots);
+    free(r);
+}
+
+// Account for finished CQEs; callbacks run later from pc_wal_poll
+static void ring_reap_locked(struct PCWALRing* r) {
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+        WALAsyncSlot* slot = &r->slots[(cqe->user_data >> 1) & (r->depth - 1)];
+        if (cqe->user_data & 1) {
+            if (cqe->res < 0) slot->err = PC_ERR_IO;
+        } else if (cqe->res != (int)slot->iov.iov_len) {
+            slot->err = PC_ERR_IO;  // Failed or short write (its fdatasync is cancelled)
+        }
+        slot->outstanding--;
+        head++;
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Block until every async append before slot mark has completed
+static void ring_wait_locked(struct PCWALRing* r, uint64_t mark) {
+    for (uint64_t i = r->head; i < mark; i++) {
+        WALAsyncSlot* slot = &r->slots[i & (r->depth - 1)];
+        while (slot->outstanding > 0) {
+            ring_reap_locked(r);
+            if (slot->outstanding > 0 &&
+                uring_enter(r->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                return;
+            }
+        }
+    }
+}
+
+// Queue slot's write linked to an fdatasync and submit both (does not wait)
+static PCError ring_submit_locked(PCWAL* wal, uint64_t index, uint64_t offset) {
+    struct PCWALRing* r = wal->ring;
+    WALAsyncSlot* slot = &r->slots[index & (r->depth - 1)];
+    unsigned tail = *r->sq_tail;
+    unsigned mask = *r->sq_mask;
+    
+    struct io_uring_sqe* write = &r->sqes[tail & mask];
+    memset(write, 0, sizeof(*write));
+    write->opcode = IORING_OP_WRITEV;
+    write->flags = IOSQE_IO_LINK;  // fdatasync only runs if the write succeeds
+    write->fd = wal->fd;
+    write->off = offset;
+    write->addr = (uint64_t)(uintptr_t)&slot->iov;
+    write->len = 1;
+    write->user_data = index << 1;
+    r->sq_array[tail & mask] = tail & mask;
+    tail++;
+    
+    struct io_uring_sqe* sync = &r->sqes[tail & mask];
+    memset(sync, 0, sizeof(*sync));
+    sync->opcode = IORING_OP_FSYNC;
+    sync->fd = wal->fd;
+    sync->fsync_flags = IORING_FSYNC_DATASYNC;
+    sync->user_data = (index << 1) | 1;
+    r->sq_array[tail & mask] = tail & mask;
+    tail++;
+    
+    __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+    
+    int ret;
+    do {
+        ret = uring_enter(r->fd, 2, 0, 0);
+    } while (ret < 0 && errno == EINTR);
+    
+    if (ret < 0) {
+        // Nothing was consumed; take the entries back
+        __atomic_store_n(r->sq_tail, tail - 2, __ATOMIC_RELEASE);
+        return PC_ERR_IO;
+    }
+    return PC_OK;
+}
+
+// Set up the io_uring rings (PC_ERR_IO if the kernel has none)
+PCError pc_wal_enable_async(PCWAL* wal, uint32_t depth) {
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
+    if (wal->group_commit) return PC_ERR_INVALID_STATE;
+    if (wal->ring) return PC_OK;
+    
+    if (depth == 0) depth = WAL_ASYNC_DEFAULT_DEPTH;
+    if (depth > WAL_ASYNC_MAX_DEPTH) depth = WAL_ASYNC_MAX_DEPTH;
+    uint32_t slots = 1;
+    while (slots < depth) slots <<= 1;
+    
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = uring_setup(slots * 2, &p);  // Two SQEs per append
+    if (fd < 0) return PC_ERR_IO;
+    
+    struct PCWALRing* r = calloc(1, sizeof(*r));
+    if (!r) {
+        close(fd);
+        return PC_ERR_IO;
+    }
+    r->fd = fd;
+    r->depth = slots;
+    r->slots = calloc(slots, sizeof(WALAsyncSlot));
+    
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single_map = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map && r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+    
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+    if (r->sq_map == MAP_FAILED) r->sq_map = NULL;
+    r->cq_map = single_map ? r->sq_map :
+        mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+             fd, IORING_OFF_CQ_RING);
+    if (r->cq_map == MAP_FAILED) r->cq_map = NULL;
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) r->sqes = NULL;
+    
+    if (!r->slots || !r->sq_map || !r->cq_map || !r->sqes) {
+        ring_free(r);
         return PC_ERR_IO;
     }
     
-    // SECURITY: Ensure header is on disk
-    wal_sync(wal);
+    uint8_t* sq = r->sq_map;
+    uint8_t* cq = r->cq_map;
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
     
-    wal->current_sequence = 0;
+    pthread_mutex_lock(&wal->lock);
+    wal->ring = r;
+    pthread_mutex_unlock(&wal->lock);
     
-    printf("Created new WAL v%u with fsync enabled\n", WAL_VERSION);
+    printf("WAL async writer: io_uring, %u entries in flight\n", slots);
     
     return PC_OK;
 }
 
-// Compute checksum for entry
-static void compute_checksum(const void* data, size_t size, uint8_t checksum[32]) {
-    SHA256_CTX ctx;
-    sha256_init(&ctx);
-    sha256_update(&ctx, data, size);
-    sha256_final(&ctx, checksum);
+// Ring descriptor; readable when completions are waiting
+int pc_wal_async_fd(const PCWAL* wal) {
+    return wal && wal->ring ? wal->ring->fd : -1;
 }
 
-// Verify checksum
-static int verify_checksum(const void* data, size_t size, const uint8_t expected[32]) {
-    uint8_t computed[32];
-    compute_checksum(data, size, computed);
-    return memcmp(computed, expected, 32) == 0;
+static int wal_reap_checkpoint(PCWAL* wal, int wait);
+
+// Run callbacks for async appends that are durable and a finished checkpoint
+uint32_t pc_wal_poll(PCWAL* wal) {
+    if (!wal) return 0;
+    
+    uint32_t delivered = (uint32_t)wal_reap_checkpoint(wal, 0);
+    while (wal->ring) {
+        pthread_mutex_lock(&wal->lock);
+        struct PCWALRing* r = wal->ring;
+        ring_reap_locked(r);
+        
+        // Deliver in log order so an acknowledged entry never follows a hole
+        WALAsyncSlot* slot = &r->slots[r->head & (r->depth - 1)];
+        if (r->head == r->tail || slot->outstanding > 0) {
+            pthread_mutex_unlock(&wal->lock);
+            break;
+        }
+        PCWALDoneFn done = slot->done;
+        void* ctx = slot->ctx;
+        PCError err = slot->err;
+        r->head++;
+        pthread_mutex_unlock(&wal->lock);
+        
+        if (done) done(ctx, err);
+        delivered++;
+    }
+    
+    return delivered;
 }
 
-// Log a transaction (before execution) - DURABLE
-PCError pc_wal_log_tx(PCWAL* wal, const PCTransaction* tx) {
-    if (!wal || !wal->file || !tx) return PC_ERR_IO;
+// Drain and release the async writer
+static void ring_shutdown(PCWAL* wal) {
+    if (!wal->ring) return;
+    
+    pthread_mutex_lock(&wal->lock);
+    ring_wait_locked(wal->ring, wal->ring->tail);
+    pthread_mutex_unlock(&wal->lock);
+    
+    pc_wal_poll(wal);
     
-    // Seek to end
-    fseek(wal->file, 0, SEEK_END);
+    ring_free(wal->ring);
+    wal->ring = NULL;
+}
+
+// Make async appends queued before this point durable too, so a synced
+// entry never lands behind a hole (caller holds the lock)
+static void wal_wait_async_locked(PCWAL* wal) {
+    if (wal->ring) ring_wait_locked(wal->ring, wal->ring->tail);
+}
+
+// Seal the current segment and continue in the next one (caller holds the lock)
+static PCError wal_rotate_locked(PCWAL* wal) {
+    // The flusher may be syncing the descriptor we are about to close
+    while (wal->syncing) {
+        pthread_cond_wait(&wal->durable, &wal->lock);
+    }
+    wal_wait_async_locked(wal);
+    
+    if (wal_sync(wal) != 0) return PC_ERR_IO;
+    wal->synced_sequence = wal->current_sequence;
+    pthread_cond_broadcast(&wal->durable);
+    
+    int old_fd = wal->fd;
+    if (open_segment(wal, wal->header.segment_id + 1) != PC_OK) {
+        return PC_ERR_IO;
+    }
+    close(old_fd);
+    
+    return PC_OK;
+}
+
+// Header for the next entry (caller holds the lock)
+static void wal_entry_header(const PCWAL* wal, WALEntryType type, const void* payload,
+                             uint32_t size, WALEntryHeader* entry) {
+    memset(entry, 0, sizeof(*entry));
+    entry->type = type;
+    entry->timestamp = (uint64_t)time(NULL);
+    entry->sequence = wal->current_sequence;
+    entry->payload_size = size;
+    compute_checksum(payload, size, entry->checksum);
+}
+
+// Append one entry at the tracked offset (caller holds the lock)
+static PCError wal_append_locked(PCWAL* wal, WALEntryType type, const void* payload,
+                                 uint32_t size, uint64_t* seq_out) {
+    if (wal->write_offset + sizeof(WALEntryHeader) + size > WAL_SEGMENT_SIZE &&
+        wal_rotate_locked(wal) != PC_OK) {
+        return PC_ERR_IO;
+    }
     
-    // Create entry header
     WALEntryHeader entry;
-    entry.type = WAL_ENTRY_TX;
-    entry.timestamp = (uint64_t)time(NULL);
-    entry.sequence = wal->current_sequence++;
-    entry.payload_size = sizeof(PCTransaction);
-    compute_checksum(tx, sizeof(PCTransaction), entry.checksum);
-    
-    // Write entry header
-    if (fwrite(&entry, sizeof(WALEntryHeader), 1, wal->file) != 1) {
+    wal_entry_header(wal, type, payload, size, &entry);
+    
+    struct iovec iov[2] = {
+        { &entry, sizeof(entry) },
+        { (void*)payload, size }
+    };
+    ssize_t total = (ssize_t)(sizeof(entry) + size);
+    if (pwritev(wal->fd, iov, 2, (off_t)wal->write_offset) != total) {
         return PC_ERR_IO;
     }
     
-    // Write transaction
-    if (fwrite(tx, sizeof(PCTransaction), 1, wal->file) != 1) {
+    if (wal->synced_sequence == wal->current_sequence) {
+        wal->oldest_pending_us = now_us();
+    }
+    wal->write_offset += (uint64_t)total;
+    wal->current_sequence++;
+    *seq_out = entry.sequence;
+    return PC_OK;
+}
+
+// Append and, in sync mode, return only once the entry is on disk
+static PCError wal_append_durable(PCWAL* wal, WALEntryType type, const void* payload,
+                                  uint32_t size) {
+    uint64_t seq;
+    PCError err = PC_OK;
+    
+    pthread_mutex_lock(&wal->lock);
+    if (wal_append_locked(wal, type, payload, size, &seq) != PC_OK) {
+        pthread_mutex_unlock(&wal->lock);
         return PC_ERR_IO;
     }
     
-    // SECURITY: Force to disk immediately
-    if (wal->sync_on_write) {
+    if (wal->sync_on_write && wal->group_commit) {
+        // Hand the fsync to the flusher and wait for the group holding seq
+        pthread_cond_signal(&wal->pending);
+        while (wal->synced_sequence <= seq && !wal->sync_failed) {
+            pthread_cond_wait(&wal->durable, &wal->lock);
+        }
+        if (wal->synced_sequence <= seq) err = PC_ERR_IO;
+    } else if (wal->sync_on_write) {
+        // SECURITY: Force to disk immediately
         if (wal_sync(wal) != 0) {
             printf("WARNING: Failed to sync WAL - data may be lost on crash\n");
+            err = PC_ERR_IO;
+        } else {
+            wal->synced_sequence = wal->current_sequence;
         }
+        wal_wait_async_locked(wal);
     }
+    pthread_mutex_unlock(&wal->lock);
     
-    // Update header
-    wal->header.entry_count = wal->current_sequence;
-    wal->dirty = 1;
+    return err;
+}
+
+// Log a transaction (before execution) - DURABLE
+PCError pc_wal_log_tx(PCWAL* wal, const PCTransaction* tx) {
+    if (!wal || wal->fd < 0 || !tx) return PC_ERR_IO;
     
-    return PC_OK;
+    return wal_append_durable(wal, WAL_ENTRY_TX, tx, sizeof(PCTransaction));
 }
 
 // Log genesis creation - DURABLE
-PCError pc_wal_log_genesis(PCWAL* wal, const uint8_t* creator_pubkey, double supply) {
-    if (!wal || !wal->file || !creator_pubkey) return PC_ERR_IO;
+PCError pc_wal_log_genesis(PCWAL* wal, const uint8_t* creator_pubkey, PCAmount supply) {
+    if (!wal || wal->fd < 0 || !creator_pubkey) return PC_ERR_IO;
     
-    fseek(wal->file, 0, SEEK_END);
-    
-    // Genesis payload
-    struct {
-        uint8_t pubkey[32];
-        double supply;
-    } payload;
+    WALGenesisPayload payload;
     memcpy(payload.pubkey, creator_pubkey, 32);
     payload.supply = supply;
     
-    WALEntryHeader entry;
-    entry.type = WAL_ENTRY_GENESIS;
-    entry.timestamp = (uint64_t)time(NULL);
-    entry.sequence = wal->current_sequence++;
-    entry.payload_size = sizeof(payload);
-    compute_checksum(&payload, sizeof(payload), entry.checksum);
+    return wal_append_durable(wal, WAL_ENTRY_GENESIS, &payload, sizeof(payload));
+}
+
+// Log a transaction through io_uring; done runs from pc_wal_poll once durable
+PCError pc_wal_log_tx_async(PCWAL* wal, const PCTransaction* tx, PCWALDoneFn done, void* ctx) {
+    if (!wal || wal->fd < 0 || !tx) return PC_ERR_IO;
     
-    if (fwrite(&entry, sizeof(WALEntryHeader), 1, wal->file) != 1) {
-        return PC_ERR_IO;
+    const uint32_t total = sizeof(WALEntryHeader) + sizeof(PCTransaction);
+    
+    pthread_mutex_lock(&wal->lock);
+    struct PCWALRing* r = wal->ring;
+    
+    // Rotation and a full ring are left to the sync path
+    if (r && r->tail - r->head < r->depth && wal->write_offset + total <= WAL_SEGMENT_SIZE) {
+        WALAsyncSlot* slot = &r->slots[r->tail & (r->depth - 1)];
+        WALEntryHeader entry;
+        wal_entry_header(wal, WAL_ENTRY_TX, tx, sizeof(PCTransaction), &entry);
+        memcpy(slot->buf, &entry, sizeof(entry));
+        memcpy(slot->buf + sizeof(entry), tx, sizeof(PCTransaction));
+        slot->iov.iov_base = slot->buf;
+        slot->iov.iov_len = total;
+        slot->outstanding = 2;
+        slot->sequence = wal->current_sequence;
+        slot->err = PC_OK;
+        slot->done = done;
+        slot->ctx = ctx;
+        
+        if (ring_submit_locked(wal, r->tail, wal->write_offset) == PC_OK) {
+            r->tail++;
+            wal->write_offset += total;
+            wal->current_sequence++;
+            pthread_mutex_unlock(&wal->lock);
+            return PC_OK;
+        }
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    // Fallback: durable before returning, so the callback can run now, after
+    // those of the async entries ahead of it (the sync append waited for them)
+    PCError err = pc_wal_log_tx(wal, tx);
+    pc_wal_poll(wal);
+    if (done) done(ctx, err);
+    return err;
+}
+
+// Flusher: one fdatasync per group of waiting appenders
+static void* wal_flusher_main(void* arg) {
+    PCWAL* wal = arg;
+    uint64_t failed_at = UINT64_MAX;  // Don't spin retrying a failed group
+    
+    pthread_mutex_lock(&wal->lock);
+    for (;;) {
+        while ((wal->synced_sequence == wal->current_sequence ||
+                wal->current_sequence == failed_at) && !wal->stopping) {
+            pthread_cond_wait(&wal->pending, &wal->lock);
+        }
+        if (wal->synced_sequence == wal->current_sequence ||
+            wal->current_sequence == failed_at) break;
+        
+        // Hold the group open until it is full or its oldest entry hits the delay
+        uint64_t deadline = wal->oldest_pending_us + wal->max_delay_us;
+        while (!wal->stopping && wal->current_sequence - wal->synced_sequence < wal->max_group) {
+            uint64_t now = now_us();
+            if (now >= deadline) break;
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            uint64_t ns = (uint64_t)ts.tv_nsec + (deadline - now) * 1000;
+            ts.tv_sec += (time_t)(ns / 1000000000);
+            ts.tv_nsec = (long)(ns % 1000000000);
+            pthread_cond_timedwait(&wal->pending, &wal->lock, &ts);
+        }
+        
+        // Sync without blocking new appends; rotation waits for syncing to clear
+        uint64_t target = wal->current_sequence;
+        int fd = wal->fd;
+        wal->syncing = 1;
+        pthread_mutex_unlock(&wal->lock);
+        
+        int ok = fdatasync(fd) == 0;
+        
+        pthread_mutex_lock(&wal->lock);
+        wal->syncing = 0;
+        if (ok) {
+            if (target > wal->synced_sequence) wal->synced_sequence = target;
+            wal->sync_failed = 0;
+            if (wal->current_sequence > wal->synced_sequence) wal->oldest_pending_us = now_us();
+        } else {
+            perror("WAL group fdatasync");
+            wal->sync_failed = 1;
+            failed_at = target;
+        }
+        pthread_cond_broadcast(&wal->durable);
     }
+    pthread_mutex_unlock(&wal->lock);
     
-    if (fwrite(&payload, sizeof(payload), 1, wal->file) != 1) {
+    return NULL;
+}
+
+// Switch sync-on-write appends to group commit. Each append still returns
+// only after its entry is fsynced; max_delay_us bounds how long an entry
+// waits for others to join its group (0 = flush as soon as the flusher is
+// free), and a group of max_group entries (0 = default) flushes at once.
+PCError pc_wal_enable_group_commit(PCWAL* wal, uint32_t max_delay_us, uint32_t max_group) {
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
+    if (wal->ring) return PC_ERR_INVALID_STATE;
+    
+    pthread_mutex_lock(&wal->lock);
+    wal->max_delay_us = max_delay_us;
+    wal->max_group = max_group ? max_group : WAL_GROUP_DEFAULT_MAX;
+    if (wal->group_commit) {
+        pthread_mutex_unlock(&wal->lock);
+        return PC_OK;
+    }
+    wal->stopping = 0;
+    wal->sync_failed = 0;
+    if (pthread_create(&wal->flusher, NULL, wal_flusher_main, wal) != 0) {
+        pthread_mutex_unlock(&wal->lock);
         return PC_ERR_IO;
     }
+    wal->group_commit = 1;
+    pthread_mutex_unlock(&wal->lock);
     
-    // SECURITY: Force to disk
-    if (wal->sync_on_write) {
-        wal_sync(wal);
+    return PC_OK;
+}
+
+// Drain pending groups and stop the flusher
+void pc_wal_disable_group_commit(PCWAL* wal) {
+    if (!wal) return;
+    
+    pthread_mutex_lock(&wal->lock);
+    if (!wal->group_commit) {
+        pthread_mutex_unlock(&wal->lock);
+        return;
     }
+    wal->stopping = 1;
+    pthread_cond_signal(&wal->pending);
+    pthread_mutex_unlock(&wal->lock);
     
-    wal->header.entry_count = wal->current_sequence;
-    wal->dirty = 1;
+    pthread_join(wal->flusher, NULL);
     
+    pthread_mutex_lock(&wal->lock);
+    wal->group_commit = 0;
+    wal->stopping = 0;
+    pthread_mutex_unlock(&wal->lock);
+}
+
+// ============ Incremental checkpoints ============
+
+// Increment file: header, then one record per page dirtied since the
+// previous checkpoint (wallet page followed by key page)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t checkpoint_id;
+    uint64_t state_version;
+    uint64_t timestamp;
+    PCAmount total_supply;
+    uint32_t num_wallets;
+    uint32_t num_records;
+    uint8_t state_hash[32];
+    uint8_t prev_hash[32];
+    uint8_t checksum[32];  // SHA-256 over the records
+} WALIncrementHeader;
+
+typedef struct {
+    uint32_t page;
+    uint32_t reserved;
+} WALPageRecord;
+
+#define WAL_PAGE_WALLET_BYTES ((size_t)PC_WALLET_PAGE_SIZE * sizeof(PCWallet))
+#define WAL_PAGE_KEY_BYTES ((size_t)PC_WALLET_PAGE_SIZE * PHYSICSCOIN_KEY_SIZE)
+#define WAL_PAGE_RECORD_SIZE (sizeof(WALPageRecord) + WAL_PAGE_WALLET_BYTES + WAL_PAGE_KEY_BYTES)
+
+static void increment_path(const PCWAL* wal, uint64_t id, char* out, size_t size) {
+    snprintf(out, size, "%s%s.%08lu", wal->path, CHECKPOINT_SUFFIX, id);
+}
+
+// Write the dirty pages of state as increment id (durable once this returns)
+static PCError write_increment(const PCWAL* wal, const PCState* state, uint64_t id) {
+    WALIncrementHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = WAL_INCREMENT_MAGIC;
+    hdr.version = WAL_INCREMENT_VERSION;
+    hdr.checkpoint_id = id;
+    hdr.state_version = state->version;
+    hdr.timestamp = state->timestamp;
+    hdr.total_supply = state->total_supply;
+    hdr.num_wallets = state->num_wallets;
+    memcpy(hdr.state_hash, state->state_hash, 32);
+    memcpy(hdr.prev_hash, state->prev_hash, 32);
+    
+    char name[300], tmp[310];
+    increment_path(wal, id, name, sizeof(name));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return PC_ERR_IO;
+    
+    // Header goes first as a placeholder; the checksum is known at the end
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    uint32_t pages = (state->num_wallets + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    
+    for (uint32_t p = 0; ok && p < pages; p++) {
+        if (!pc_state_page_dirty(state, p)) continue;
+        
+        WALPageRecord rec = { p, 0 };
+        sha256_update(&ctx, (const uint8_t*)&rec, sizeof(rec));
+        sha256_update(&ctx, (const uint8_t*)state->wallet_pages[p], WAL_PAGE_WALLET_BYTES);
+        sha256_update(&ctx, state->key_pages[p], WAL_PAGE_KEY_BYTES);
+        ok = fwrite(&rec, sizeof(rec), 1, f) == 1 &&
+             fwrite(state->wallet_pages[p], 1, WAL_PAGE_WALLET_BYTES, f) == WAL_PAGE_WALLET_BYTES &&
+             fwrite(state->key_pages[p], 1, WAL_PAGE_KEY_BYTES, f) == WAL_PAGE_KEY_BYTES;
+        hdr.num_records++;
+    }
+    sha256_final(&ctx, hdr.checksum);
+    
+    // SECURITY: Sync the increment before its name appears
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+         fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, name) != 0) {
+        unlink(tmp);
+        return PC_ERR_IO;
+    }
+    sync_dir(name);
+    
+    printf("Checkpoint %lu: %u dirty pages of %u\n", id, hdr.num_records, pages);
     return PC_OK;
 }
 
-// Create checkpoint (snapshot state) - DURABLE
-PCError pc_wal_checkpoint(PCWAL* wal, const PCState* state) {
-    if (!wal || !wal->file || !state) return PC_ERR_IO;
+// Apply increment id on top of state (which must be at id - 1)
+static PCError apply_increment(const PCWAL* wal, PCState* state, uint64_t id) {
+    char name[300];
+    increment_path(wal, id, name, sizeof(name));
+    int fd = open(name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return PC_ERR_IO;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WALIncrementHeader)) {
+        close(fd);
+        return PC_ERR_IO;
+    }
+    size_t size = (size_t)st.st_size;
+    const uint8_t* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return PC_ERR_IO;
+    madvise((void*)map, size, MADV_SEQUENTIAL);
+    
+    WALIncrementHeader hdr;
+    memcpy(&hdr, map, sizeof(hdr));
+    const uint8_t* records = map + sizeof(hdr);
+    size_t records_size = size - sizeof(hdr);
+    
+    // Wallets are never removed, so an increment can only grow the state
+    PCError err = PC_ERR_IO;
+    uint8_t checksum[32];
+    if (hdr.magic == WAL_INCREMENT_MAGIC && hdr.version == WAL_INCREMENT_VERSION &&
+        hdr.checkpoint_id == id && hdr.num_wallets >= state->num_wallets &&
+        records_size == (size_t)hdr.num_records * WAL_PAGE_RECORD_SIZE) {
+        sha256(records, records_size, checksum);
+        if (memcmp(checksum, hdr.checksum, 32) == 0) {
+            err = pc_state_reserve_wallets(state, hdr.num_wallets);
+        } else {
+            printf("SECURITY: Checkpoint increment %lu checksum mismatch\n", id);
+        }
+    }
     
-    // Save state to checkpoint file
-    uint8_t buffer[1024 * 1024];
-    size_t size = pc_state_serialize(state, buffer, sizeof(buffer));
+    uint32_t pages = (hdr.num_wallets + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    for (uint32_t r = 0; err == PC_OK && r < hdr.num_records; r++) {
+        const uint8_t* rec = records + (size_t)r * WAL_PAGE_RECORD_SIZE;
+        WALPageRecord head;
+        memcpy(&head, rec, sizeof(head));
+        if (head.page >= pages) {
+            err = PC_ERR_IO;
+            break;
+        }
+        rec += sizeof(head);
+        memcpy(state->wallet_pages[head.page], rec, WAL_PAGE_WALLET_BYTES);
+        memcpy(state->key_pages[head.page], rec + WAL_PAGE_WALLET_BYTES, WAL_PAGE_KEY_BYTES);
+    }
     
-    // Write checkpoint to temp file first
-    char temp_filename[256];
-    snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", CHECKPOINT_FILENAME);
+    if (err == PC_OK) {
+        state->num_wallets = hdr.num_wallets;
+        state->version = hdr.state_version;
+        state->timestamp = hdr.timestamp;
+        state->total_supply = hdr.total_supply;
+        memcpy(state->state_hash, hdr.state_hash, 32);
+        memcpy(state->prev_hash, hdr.prev_hash, 32);
+        state->checkpoint_id = id;
+    }
     
-    FILE* cp = fopen(temp_filename, "wb");
-    if (!cp) return PC_ERR_IO;
+    munmap((void*)map, size);
+    return err;
+}
+
+// Apply increments after state's checkpoint, stopping at the first missing or
+// damaged one; returns the checkpoint the state ends up at
+static uint64_t fold_increments(const PCWAL* wal, PCState* state, uint64_t upto) {
+    uint64_t from = state->checkpoint_id;
+    while (state->checkpoint_id < upto &&
+           apply_increment(wal, state, state->checkpoint_id + 1) == PC_OK) {
+    }
     
-    if (fwrite(buffer, 1, size, cp) != size) {
-        fclose(cp);
-        unlink(temp_filename);
+    if (state->checkpoint_id != from) {
+        // Merkle tree is rebuilt lazily; new wallets need index entries
+        pc_merkle_invalidate(&state->merkle);
+        if (state->index_count != state->num_wallets) pc_state_rebuild_index(state);
+    }
+    return state->checkpoint_id;
+}
+
+// Delete increments up to and including id (the base already holds them)
+static void remove_increments(const PCWAL* wal, uint64_t id) {
+    uint64_t first, last;
+    char checkpoint[300];
+    checkpoint_path(wal, checkpoint, sizeof(checkpoint));
+    if (!find_numbered(checkpoint, &first, &last)) return;
+    
+    for (uint64_t i = first; i <= last && i <= id; i++) {
+        char name[300];
+        increment_path(wal, i, name, sizeof(name));
+        unlink(name);
+    }
+}
+
+// Rewrite the base from state as checkpoint id
+static PCError write_base(PCWAL* wal, PCState* state, uint64_t id) {
+    char checkpoint[300];
+    checkpoint_path(wal, checkpoint, sizeof(checkpoint));
+    
+    pthread_mutex_lock(&wal->checkpoint_lock);
+    uint64_t prev = state->checkpoint_id;
+    state->checkpoint_id = id;
+    if (pc_state_save(state, checkpoint) != PC_OK) {
+        state->checkpoint_id = prev;
+        pthread_mutex_unlock(&wal->checkpoint_lock);
         return PC_ERR_IO;
     }
+    sync_dir(checkpoint);
+    remove_increments(wal, id);
     
-    // SECURITY: Sync checkpoint file
-    fflush(cp);
-    fsync(fileno(cp));
-    fclose(cp);
+    pthread_mutex_lock(&wal->lock);
+    if (id > wal->base_id) wal->base_id = id;
+    pthread_mutex_unlock(&wal->lock);
+    pthread_mutex_unlock(&wal->checkpoint_lock);
     
-    // Atomic rename
-    if (rename(temp_filename, CHECKPOINT_FILENAME) != 0) {
-        unlink(temp_filename);
+    printf("Checkpoint %lu: full base, %u wallets\n", id, state->num_wallets);
+    return PC_OK;
+}
+
+// Fold increments into the base from disk alone; the live state is untouched
+static uint64_t wal_compact(PCWAL* wal, uint64_t upto) {
+    char checkpoint[300];
+    checkpoint_path(wal, checkpoint, sizeof(checkpoint));
+    
+    pthread_mutex_lock(&wal->checkpoint_lock);
+    
+    PCState base;
+    memset(&base, 0, sizeof(base));
+    uint64_t folded = 0;
+    if (pc_state_load(&base, checkpoint) == PC_OK) {
+        uint64_t from = base.checkpoint_id;
+        folded = fold_increments(wal, &base, upto);
+        
+        if (folded > from && pc_state_save(&base, checkpoint) == PC_OK) {
+            sync_dir(checkpoint);
+            remove_increments(wal, folded);
+            
+            pthread_mutex_lock(&wal->lock);
+            if (folded > wal->base_id) wal->base_id = folded;
+            pthread_mutex_unlock(&wal->lock);
+        }
+    }
+    pc_state_free(&base);
+    
+    pthread_mutex_unlock(&wal->checkpoint_lock);
+    return folded;
+}
+
+// Compactor: fold when enough increments pile up or the interval passes
+static void* wal_compactor_main(void* arg) {
+    PCWAL* wal = (PCWAL*)arg;
+    int stalled = 0;
+    
+    pthread_mutex_lock(&wal->lock);
+    while (!wal->compact_stop) {
+        if (stalled || wal->checkpoint_id - wal->base_id < wal->compact_after) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += WAL_COMPACT_INTERVAL_S;
+            int rc = pthread_cond_timedwait(&wal->compact, &wal->lock, &deadline);
+            if (wal->compact_stop) break;
+            if (wal->checkpoint_id == wal->base_id) continue;
+            if (rc != ETIMEDOUT && wal->checkpoint_id - wal->base_id < wal->compact_after) continue;
+        }
+        
+        uint64_t base = wal->base_id;
+        uint64_t upto = wal->checkpoint_id;
+        pthread_mutex_unlock(&wal->lock);
+        
+        // A missing or damaged increment stops the fold; retry on the interval
+        stalled = wal_compact(wal, upto) <= base;
+        
+        pthread_mutex_lock(&wal->lock);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    return NULL;
+}
+
+// Start the background compactor
+PCError pc_wal_enable_compaction(PCWAL* wal, uint32_t compact_after) {
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
+    
+    pthread_mutex_lock(&wal->lock);
+    if (wal->compacting) {
+        pthread_mutex_unlock(&wal->lock);
+        return PC_ERR_INVALID_STATE;
+    }
+    wal->compact_after = compact_after ? compact_after : WAL_COMPACT_DEFAULT;
+    wal->compact_stop = 0;
+    wal->compacting = 1;
+    pthread_mutex_unlock(&wal->lock);
+    
+    if (pthread_create(&wal->compactor, NULL, wal_compactor_main, wal) != 0) {
+        pthread_mutex_lock(&wal->lock);
+        wal->compacting = 0;
+        pthread_mutex_unlock(&wal->lock);
         return PC_ERR_IO;
     }
     
-    // Log checkpoint entry
-    fseek(wal->file, 0, SEEK_END);
+    return PC_OK;
+}
+
+// Stop the compactor, letting a fold in progress finish
+void pc_wal_disable_compaction(PCWAL* wal) {
+    if (!wal) return;
+    
+    pthread_mutex_lock(&wal->lock);
+    if (!wal->compacting) {
+        pthread_mutex_unlock(&wal->lock);
+        return;
+    }
+    wal->compact_stop = 1;
+    pthread_cond_signal(&wal->compact);
+    pthread_mutex_unlock(&wal->lock);
     
-    WALEntryHeader entry;
-    entry.type = WAL_ENTRY_CHECKPOINT;
-    entry.timestamp = (uint64_t)time(NULL);
-    entry.sequence = wal->current_sequence++;
-    entry.payload_size = 32;  // Just the state hash
-    memcpy(entry.checksum, state->state_hash, 32);
+    pthread_join(wal->compactor, NULL);
     
-    if (fwrite(&entry, sizeof(WALEntryHeader), 1, wal->file) != 1) {
+    pthread_mutex_lock(&wal->lock);
+    wal->compacting = 0;
+    wal->compact_stop = 0;
+    pthread_mutex_unlock(&wal->lock);
+}
+
+// Reserve the next checkpoint id. An increment needs the state to sit on the
+// newest checkpoint; without a compactor, the base is rewritten once enough
+// increments pile up. Entries logged so far are covered, except async ones
+// whose callback has not run: the callback applies them, so recovery must too.
+static uint64_t wal_checkpoint_begin(PCWAL* wal, const PCState* state,
+                                     int* incremental, uint64_t* next_sequence) {
+    pthread_mutex_lock(&wal->lock);
+    uint64_t id = ++wal->checkpoint_id;
+    *incremental = state->checkpoint_id != 0 && state->checkpoint_id == id - 1 &&
+                   (wal->compacting || id - 1 - wal->base_id < wal->compact_after);
+    struct PCWALRing* r = wal->ring;
+    *next_sequence = r && r->head != r->tail ? r->slots[r->head & (r->depth - 1)].sequence :
+                     wal->current_sequence;
+    pthread_mutex_unlock(&wal->lock);
+    return id;
+}
+
+// Write checkpoint id from src, then log it - DURABLE
+static PCError wal_write_checkpoint(PCWAL* wal, PCState* src, uint64_t id,
+                                    int incremental, uint64_t next_sequence) {
+    PCError err = incremental ? write_increment(wal, src, id) : write_base(wal, src, id);
+    if (err != PC_OK) return err;
+    
+    // Log checkpoint entry (payload is the state hash)
+    WALCheckpointPayload payload;
+    memcpy(payload.state_hash, src->state_hash, 32);
+    payload.next_sequence = next_sequence;
+    
+    uint64_t seq;
+    pthread_mutex_lock(&wal->lock);
+    if (incremental && wal->compacting && id - wal->base_id >= wal->compact_after) {
+        pthread_cond_signal(&wal->compact);
+    }
+    if (wal_append_locked(wal, WAL_ENTRY_CHECKPOINT, &payload, sizeof(payload), &seq) != PC_OK) {
+        pthread_mutex_unlock(&wal->lock);
         return PC_ERR_IO;
     }
+    if (next_sequence > wal->covered_sequence) wal->covered_sequence = next_sequence;
     
-    if (fwrite(state->state_hash, 32, 1, wal->file) != 1) {
-        return PC_ERR_IO;
+    // Update the segment header in place with current state hash
+    memcpy(wal->header.state_hash, src->state_hash, 32);
+    if (pwrite(wal->fd, &wal->header, sizeof(WALHeader), 0) != (ssize_t)sizeof(WALHeader)) {
+        perror("WAL header");
     }
     
     // SECURITY: Sync WAL
-    wal_sync(wal);
+    if (wal_sync(wal) == 0) {
+        // Everything appended so far went out with the checkpoint
+        wal->synced_sequence = wal->current_sequence;
+        pthread_cond_broadcast(&wal->durable);
+    }
+    wal_wait_async_locked(wal);
+    pthread_mutex_unlock(&wal->lock);
     
-    // Update header with current state hash
-    memcpy(wal->header.state_hash, state->state_hash, 32);
-    wal->header.entry_count = wal->current_sequence;
+    printf("Checkpoint created at sequence %lu (state synced to disk)\n", seq);
     
-    // Rewrite header
-    fseek(wal->file, 0, SEEK_SET);
-    fwrite(&wal->header, sizeof(WALHeader), 1, wal->file);
-    wal_sync(wal);
+    return PC_OK;
+}
+
+// Create checkpoint - DURABLE. Only pages dirtied since the state's last
+// checkpoint are written, unless the base has to be rewritten.
+PCError pc_wal_checkpoint(PCWAL* wal, PCState* state) {
+    if (!wal || wal->fd < 0 || !state) return PC_ERR_IO;
     
-    printf("Checkpoint created at sequence %lu (state synced to disk)\n", entry.sequence);
+    // A background checkpoint still owns the dirty pages
+    wal_reap_checkpoint(wal, 1);
+    
+    int incremental;
+    uint64_t next_sequence;
+    uint64_t id = wal_checkpoint_begin(wal, state, &incremental, &next_sequence);
+    
+    PCError err = wal_write_checkpoint(wal, state, id, incremental, next_sequence);
+    if (err != PC_OK) return err;
+    state->checkpoint_id = id;
+    pc_state_clear_dirty(state);
     
     return PC_OK;
 }
 
-// Write sync marker (explicit durability point)
-PCError pc_wal_sync_marker(PCWAL* wal) {
-    if (!wal || !wal->file) return PC_ERR_IO;
+// Checkpoint of a frozen view, written by its own thread
+struct PCWALCheckpointJob {
+    PCWAL* wal;
+    PCState* state;          // Live state; only the owner thread touches it
+    PCState view;
+    uint64_t id;
+    uint64_t next_sequence;
+    int incremental;
+    int finished;            // Guarded by wal->lock
+    PCError err;
+    PCWALDoneFn done;
+    void* ctx;
+    pthread_t thread;
+};
+
+static void* wal_checkpoint_main(void* arg) {
+    struct PCWALCheckpointJob* job = arg;
+    PCWAL* wal = job->wal;
     
-    fseek(wal->file, 0, SEEK_END);
+    // A base carries the pubkey index so it maps without a rebuild
+    if (!job->incremental) pc_state_rebuild_index(&job->view);
     
-    uint64_t sync_time = (uint64_t)time(NULL);
+    job->err = wal_write_checkpoint(wal, &job->view, job->id,
+                                    job->incremental, job->next_sequence);
+    if (job->err == PC_OK) pc_state_clear_dirty(&job->view);
     
-    WALEntryHeader entry;
-    entry.type = WAL_ENTRY_SYNC_MARKER;
-    entry.timestamp = sync_time;
-    entry.sequence = wal->current_sequence++;
-    entry.payload_size = 8;
-    compute_checksum(&sync_time, 8, entry.checksum);
+    pthread_mutex_lock(&wal->lock);
+    job->finished = 1;
+    pthread_mutex_unlock(&wal->lock);
     
-    if (fwrite(&entry, sizeof(WALEntryHeader), 1, wal->file) != 1) {
-        return PC_ERR_IO;
+    return NULL;
+}
+
+// Finish the background checkpoint on the owner thread: thaw the view and
+// run the callback. Returns 1 if one finished.
+static int wal_reap_checkpoint(PCWAL* wal, int wait) {
+    struct PCWALCheckpointJob* job = wal->checkpoint_job;
+    if (!job) return 0;
+    
+    if (!wait) {
+        pthread_mutex_lock(&wal->lock);
+        int finished = job->finished;
+        pthread_mutex_unlock(&wal->lock);
+        if (!finished) return 0;
     }
     
-    if (fwrite(&sync_time, 8, 1, wal->file) != 1) {
-        return PC_ERR_IO;
+    pthread_join(job->thread, NULL);
+    wal->checkpoint_job = NULL;
+    
+    if (job->err == PC_OK) job->state->checkpoint_id = job->id;
+    pc_state_thaw(job->state, &job->view);
+    if (job->done) job->done(job->ctx, job->err);
+    free(job);
+    
+    return 1;
+}
+
+// Wait for the background checkpoint
+void pc_wal_checkpoint_finish(PCWAL* wal) {
+    if (wal) wal_reap_checkpoint(wal, 1);
+}
+
+// Start a checkpoint of a frozen view and return at once
+PCError pc_wal_checkpoint_async(PCWAL* wal, PCState* state, PCWALDoneFn done, void* ctx) {
+    if (!wal || wal->fd < 0 || !state) return PC_ERR_IO;
+    if (wal->checkpoint_job) return PC_ERR_INVALID_STATE;
+    
+    struct PCWALCheckpointJob* job = calloc(1, sizeof(*job));
+    if (!job) return PC_ERR_IO;
+    
+    PCError err = pc_state_freeze(state, &job->view);
+    if (err != PC_OK) {
+        free(job);
+        return err;
     }
     
-    // Force sync
-    wal_sync(wal);
+    job->wal = wal;
+    job->state = state;
+    job->done = done;
+    job->ctx = ctx;
+    job->id = wal_checkpoint_begin(wal, &job->view, &job->incremental, &job->next_sequence);
     
-    wal->header.entry_count = wal->current_sequence;
+    if (pthread_create(&job->thread, NULL, wal_checkpoint_main, job) != 0) {
+        pc_state_thaw(state, &job->view);
+        free(job);
+        return PC_ERR_IO;
+    }
+    wal->checkpoint_job = job;
     
     return PC_OK;
 }
 
-// Recover state from WAL
-PCError pc_wal_recover(PCWAL* wal, PCState* state) {
-    if (!wal || !wal->file || !state) return PC_ERR_IO;
+// Write sync marker (explicit durability point)
+PCError pc_wal_sync_marker(PCWAL* wal) {
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
     
-    printf("Starting WAL recovery...\n");
+    uint64_t sync_time = (uint64_t)time(NULL);
+    uint64_t seq;
     
-    // Try to load checkpoint first
-    FILE* cp = fopen(CHECKPOINT_FILENAME, "rb");
-    uint64_t checkpoint_seq = 0;
+    pthread_mutex_lock(&wal->lock);
+    if (wal_append_locked(wal, WAL_ENTRY_SYNC_MARKER, &sync_time, 8, &seq) != PC_OK) {
+        pthread_mutex_unlock(&wal->lock);
+        return PC_ERR_IO;
+    }
+    
+    // Force sync (also releases any group-commit waiters)
+    if (wal_sync(wal) == 0) {
+        wal->synced_sequence = wal->current_sequence;
+        pthread_cond_broadcast(&wal->durable);
+    }
+    wal_wait_async_locked(wal);
+    pthread_mutex_unlock(&wal->lock);
     
-    if (cp) {
-        fseek(cp, 0, SEEK_END);
-        size_t size = ftell(cp);
-        fseek(cp, 0, SEEK_SET);
+    return PC_OK;
+}
+
+// Replay progress carried across the legacy log and every segment
+typedef struct {
+    PCState* state;
+    uint64_t resume_seq;  // First TX not covered by the last checkpoint
+    uint64_t tx_count;
+    uint64_t skip_count;
+    uint64_t corrupt_count;
+} WALReplay;
+
+// One entry found by the boundary scan of a mapped log file
+typedef struct {
+    WALEntryHeader header;  // Copied out: entries are not 8-byte aligned in the map
+    const uint8_t* payload;
+    uint32_t tx;            // Index into the file's transactions (TX entries)
+    int valid;              // Checksum matched
+} WALScanEntry;
+
+// Payload bytes recovery reads for an entry (0 = not an entry)
+static uint32_t wal_payload_size(const WALEntryHeader* header) {
+    switch (header->type) {
+        case WAL_ENTRY_TX: return sizeof(PCTransaction);
+        case WAL_ENTRY_GENESIS: return sizeof(WALGenesisPayload);
+        case WAL_ENTRY_CHECKPOINT:
+            return header->payload_size == sizeof(WALCheckpointPayload) ?
+                   sizeof(WALCheckpointPayload) : 32;
+        case WAL_ENTRY_SYNC_MARKER: return 8;
+        default: return 0;
+    }
+}
+
+// Find entry boundaries; stops at the zeroed tail, a torn entry or the end
+static uint32_t wal_scan_entries(const uint8_t* base, size_t size, size_t offset,
+                                 WALScanEntry** entries_out, uint32_t* num_tx) {
+    WALScanEntry* entries = NULL;
+    uint32_t count = 0, capacity = 0;
+    *num_tx = 0;
+    
+    while (offset + sizeof(WALEntryHeader) <= size) {
+        WALEntryHeader header;
+        memcpy(&header, base + offset, sizeof(header));
+        uint32_t payload_size = wal_payload_size(&header);
+        if (payload_size == 0 || offset + sizeof(header) + payload_size > size) break;
         
-        uint8_t* buffer = malloc(size);
-        if (buffer && fread(buffer, 1, size, cp) == size) {
-            if (pc_state_deserialize(state, buffer, size) == PC_OK) {
-                printf("Loaded checkpoint, replaying WAL entries...\n");
-            }
-            free(buffer);
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            WALScanEntry* grown = realloc(entries, capacity * sizeof(WALScanEntry));
+            if (!grown) break;
+            entries = grown;
         }
-        fclose(cp);
+        
+        WALScanEntry* e = &entries[count++];
+        e->header = header;
+        e->payload = base + offset + sizeof(header);
+        e->tx = header.type == WAL_ENTRY_TX ? (*num_tx)++ : 0;
+        e->valid = 0;
+        offset += sizeof(header) + payload_size;
     }
     
-    // Seek past header
-    fseek(wal->file, sizeof(WALHeader), SEEK_SET);
+    *entries_out = entries;
+    return count;
+}
+
+// Replay one mapped log file: boundaries are found serially, checksums and
+// signatures are verified in parallel, then entries apply in log order.
+// The legacy log stored the state hash in a checkpoint's checksum field.
+static void wal_replay_map(const uint8_t* base, size_t size, size_t offset, int legacy, WALReplay* r) {
+    WALScanEntry* entries;
+    uint32_t num_tx;
+    uint32_t count = wal_scan_entries(base, size, offset, &entries, &num_tx);
+    if (count == 0) {
+        free(entries);
+        return;
+    }
     
-    uint64_t tx_count = 0;
-    uint64_t skip_count = 0;
-    uint64_t corrupt_count = 0;
+    PCTransaction* txs = calloc(num_tx ? num_tx : 1, sizeof(PCTransaction));
+    const PCTransaction** tx_ptrs = malloc((num_tx ? num_tx : 1) * sizeof(PCTransaction*));
+    int* sig_ok = calloc(num_tx ? num_tx : 1, sizeof(int));
+    if (!txs || !tx_ptrs || !sig_ok) {
+        printf("WARNING: Out of memory replaying WAL\n");
+        free(txs);
+        free(tx_ptrs);
+        free(sig_ok);
+        free(entries);
+        return;
+    }
     
-    // Replay entries
-    while (!feof(wal->file)) {
-        WALEntryHeader entry;
-        if (fread(&entry, sizeof(WALEntryHeader), 1, wal->file) != 1) {
-            break;
+    // SECURITY: Verify checksums, WAL_RECOVER_CHUNK entries per sha256_many call
+    uint32_t num_chunks = (count + WAL_RECOVER_CHUNK - 1) / WAL_RECOVER_CHUNK;
+    #pragma omp parallel for schedule(dynamic)
+    for (uint32_t c = 0; c < num_chunks; c++) {
+        uint32_t first = c * WAL_RECOVER_CHUNK;
+        uint32_t n = count - first < WAL_RECOVER_CHUNK ? count - first : WAL_RECOVER_CHUNK;
+        const uint8_t* data[WAL_RECOVER_CHUNK];
+        size_t lens[WAL_RECOVER_CHUNK];
+        uint8_t hashes[WAL_RECOVER_CHUNK][32];
+        
+        for (uint32_t i = 0; i < n; i++) {
+            data[i] = entries[first + i].payload;
+            lens[i] = wal_payload_size(&entries[first + i].header);
         }
+        sha256_many(data, lens, n, hashes);
         
-        if (entry.type == WAL_ENTRY_GENESIS) {
-            struct {
-                uint8_t pubkey[32];
-                double supply;
-            } payload;
-            
-            if (fread(&payload, sizeof(payload), 1, wal->file) != 1) break;
-            
-            // SECURITY: Verify checksum
-            if (!verify_checksum(&payload, sizeof(payload), entry.checksum)) {
-                printf("SECURITY: Genesis entry checksum mismatch at seq %lu\n", entry.sequence);
-                corrupt_count++;
+        for (uint32_t i = 0; i < n; i++) {
+            WALScanEntry* e = &entries[first + i];
+            e->valid = (legacy && e->header.type == WAL_ENTRY_CHECKPOINT) ||
+                       memcmp(hashes[i], e->header.checksum, 32) == 0;
+            if (e->valid && e->header.type == WAL_ENTRY_TX) {
+                memcpy(&txs[e->tx], e->payload, sizeof(PCTransaction));
+            }
+        }
+    }
+    
+    // SECURITY: Verify every signature up front (parallel batches)
+    for (uint32_t i = 0; i < num_tx; i++) {
+        tx_ptrs[i] = &txs[i];
+    }
+    if (num_tx > 0) pc_transaction_verify_batch(tx_ptrs, (int)num_tx, sig_ok);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        const WALScanEntry* e = &entries[i];
+        
+        if (e->header.type == WAL_ENTRY_GENESIS) {
+            if (!e->valid) {
+                printf("SECURITY: Genesis entry checksum mismatch at seq %lu\n", e->header.sequence);
+                r->corrupt_count++;
                 continue;
             }
             
-            pc_state_genesis(state, payload.pubkey, payload.supply);
-            printf("Replayed genesis: %.2f coins\n", payload.supply);
+            WALGenesisPayload payload;
+            memcpy(&payload, e->payload, sizeof(payload));
+            pc_state_free(r->state);  // Drop a checkpoint the log starts before
+            pc_state_genesis(r->state, payload.pubkey, payload.supply);
+            printf("Replayed genesis: %.2f coins\n", pc_amount_to_coins(payload.supply));
         }
-        else if (entry.type == WAL_ENTRY_TX) {
-            PCTransaction tx;
-            if (fread(&tx, sizeof(PCTransaction), 1, wal->file) != 1) break;
-            
-            // SECURITY: Verify checksum
-            if (!verify_checksum(&tx, sizeof(PCTransaction), entry.checksum)) {
-                printf("SECURITY: TX checksum mismatch at seq %lu - SKIPPING\n", entry.sequence);
-                corrupt_count++;
+        else if (e->header.type == WAL_ENTRY_TX) {
+            if (!e->valid) {
+                printf("SECURITY: TX checksum mismatch at seq %lu - SKIPPING\n", e->header.sequence);
+                r->corrupt_count++;
                 continue;
             }
             
-            // Skip if before checkpoint
-            if (entry.sequence <= checkpoint_seq) {
-                skip_count++;
+            // Skip if before checkpoint; failed transactions might be
+            // already applied or invalid
+            if (e->header.sequence < r->resume_seq ||
+                !sig_ok[e->tx] || pc_state_apply_tx(r->state, &txs[e->tx]) != PC_OK) {
+                r->skip_count++;
+                continue;
+            }
+            r->tx_count++;
+        }
+        else if (e->header.type == WAL_ENTRY_CHECKPOINT) {
+            // A damaged next_sequence would silently skip every later TX
+            if (!e->valid) {
+                printf("SECURITY: Checkpoint entry checksum mismatch at seq %lu - IGNORED\n",
+                       e->header.sequence);
+                r->corrupt_count++;
                 continue;
             }
             
-            // Execute transaction
-            PCError err = pc_state_execute_tx(state, &tx);
-            if (err == PC_OK) {
-                tx_count++;
+            WALCheckpointPayload payload;
+            if (e->header.payload_size == sizeof(payload)) {
+                memcpy(&payload, e->payload, sizeof(payload));
+                r->resume_seq = payload.next_sequence;
             } else {
-                // Transaction failed - might be already applied or invalid
-                skip_count++;
+                r->resume_seq = e->header.sequence + 1;
             }
         }
-        else if (entry.type == WAL_ENTRY_CHECKPOINT) {
-            uint8_t hash[32];
-            if (fread(hash, 32, 1, wal->file) != 1) break;
-            checkpoint_seq = entry.sequence;
-        }
-        else if (entry.type == WAL_ENTRY_SYNC_MARKER) {
-            uint64_t sync_time;
-            if (fread(&sync_time, 8, 1, wal->file) != 1) break;
-            // Sync markers are just durability points
+        // Sync markers are just durability points
+    }
+    
+    free(txs);
+    free(tx_ptrs);
+    free(sig_ok);
+    free(entries);
+}
+
+// Map a log file read-only and replay it
+static void wal_replay_file(const char* name, size_t offset, int legacy, WALReplay* r) {
+    int fd = open(name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size > offset) {
+        void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            wal_replay_map(map, (size_t)st.st_size, offset, legacy, r);
+            munmap(map, (size_t)st.st_size);
         }
-        else {
-            // Skip unknown entry
-            fseek(wal->file, entry.payload_size, SEEK_CUR);
+    }
+    close(fd);
+}
+
+// Recover state from WAL
+PCError pc_wal_recover(PCWAL* wal, PCState* state) {
+    if (!wal || wal->fd < 0 || !state) return PC_ERR_IO;
+    
+    printf("Starting WAL recovery...\n");
+    
+    // Base snapshot (or the single-file checkpoint of a v3 log), then its increments
+    char checkpoint[300];
+    checkpoint_path(wal, checkpoint, sizeof(checkpoint));
+    if (pc_state_load(state, checkpoint) == PC_OK ||
+        (wal->legacy && pc_state_load(state, LEGACY_CHECKPOINT_FILENAME) == PC_OK)) {
+        uint64_t base = state->checkpoint_id;
+        uint64_t last = fold_increments(wal, state, wal->checkpoint_id);
+        printf("Loaded checkpoint %lu (%lu increments), replaying WAL entries...\n",
+               last, last - base);
+        if (last < wal->checkpoint_id) {
+            printf("WARNING: Checkpoint increments after %lu could not be applied\n", last);
         }
+        
+        // A compacted base has no increment to number the next one after
+        if (last > wal->checkpoint_id) wal->checkpoint_id = last;
+        if (base > wal->base_id) wal->base_id = base;
+    } else {
+        state->checkpoint_id = 0;  // A seed state is not one of this log's checkpoints
     }
+    pc_state_clear_dirty(state);
+    
+    WALReplay r;
+    memset(&r, 0, sizeof(r));
+    r.state = state;
+    
+    // Replay the legacy log, then live segments oldest first
+    if (wal->legacy) {
+        wal_replay_file(wal->path, sizeof(WALLegacyHeader), 1, &r);
+    }
+    
+    for (uint64_t id = wal->first_segment; id <= wal->header.segment_id; id++) {
+        char name[300];
+        segment_path(wal, id, name, sizeof(name));
+        wal_replay_file(name, sizeof(WALHeader), 0, &r);
+    }
+    
+    pthread_mutex_lock(&wal->lock);
+    if (r.resume_seq > wal->covered_sequence) wal->covered_sequence = r.resume_seq;
+    pthread_mutex_unlock(&wal->lock);
     
     printf("Recovery complete:\n");
-    printf("  TXs replayed: %lu\n", tx_count);
-    printf("  TXs skipped: %lu\n", skip_count);
-    printf("  Corrupt entries: %lu\n", corrupt_count);
+    printf("  TXs replayed: %lu\n", r.tx_count);
+    printf("  TXs skipped: %lu\n", r.skip_count);
+    printf("  Corrupt entries: %lu\n", r.corrupt_count);
     
-    if (corrupt_count > 0) {
-        printf("WARNING: %lu corrupt entries found in WAL\n", corrupt_count);
+    if (r.corrupt_count > 0) {
+        printf("WARNING: %lu corrupt entries found in WAL\n", r.corrupt_count);
     }
     
     // Verify conservation after recovery
@@ -449,28 +1601,64 @@ PCError pc_wal_recover(PCWAL* wal, PCState* state) {
     return PC_OK;
 }
 
-// Truncate WAL after checkpoint
+// Truncate WAL after checkpoint: rotate to a fresh segment and retire
+// every older one, so appends never wait for the log to be recreated
 PCError pc_wal_truncate(PCWAL* wal) {
-    if (!wal || !wal->file) return PC_ERR_IO;
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
     
-    // Rewrite with just header
-    fclose(wal->file);
-    
-    wal->file = fopen(WAL_FILENAME, "w+b");
-    if (!wal->file) return PC_ERR_IO;
-    
-    wal->fd = fileno(wal->file);
-    wal->header.entry_count = 0;
-    wal->current_sequence = 0;
+    pthread_mutex_lock(&wal->lock);
+    if (wal_rotate_locked(wal) != PC_OK) {
+        pthread_mutex_unlock(&wal->lock);
+        return PC_ERR_IO;
+    }
     
-    fwrite(&wal->header, sizeof(WALHeader), 1, wal->file);
-    wal_sync(wal);
+    for (uint64_t id = wal->first_segment; id < wal->header.segment_id; id++) {
+        char name[300];
+        segment_path(wal, id, name, sizeof(name));
+        unlink(name);
+    }
+    if (wal->legacy) {
+        unlink(wal->path);
+        wal->legacy = 0;
+    }
+    wal->first_segment = wal->header.segment_id;
+    sync_dir(wal->path);
+    pthread_mutex_unlock(&wal->lock);
     
     printf("WAL truncated\n");
     
     return PC_OK;
 }
 
+// Retire sealed segments whose entries all sit below the newest checkpoint
+PCError pc_wal_retire(PCWAL* wal) {
+    if (!wal || wal->fd < 0) return PC_ERR_IO;
+    
+    pthread_mutex_lock(&wal->lock);
+    uint64_t first = wal->first_segment;
+    while (wal->first_segment < wal->header.segment_id) {
+        // A segment ends where the next one starts
+        char name[300];
+        WALHeader next = wal->header;
+        if (wal->first_segment + 1 < wal->header.segment_id) {
+            segment_path(wal, wal->first_segment + 1, name, sizeof(name));
+            int fd = open(name, O_RDONLY | O_CLOEXEC);
+            ssize_t n = fd >= 0 ? pread(fd, &next, sizeof(next), 0) : -1;
+            if (fd >= 0) close(fd);
+            if (n != (ssize_t)sizeof(next) || next.magic != WAL_MAGIC) break;
+        }
+        if (next.first_sequence > wal->covered_sequence) break;
+        
+        segment_path(wal, wal->first_segment, name, sizeof(name));
+        unlink(name);
+        wal->first_segment++;
+    }
+    if (wal->first_segment != first) sync_dir(wal->path);
+    pthread_mutex_unlock(&wal->lock);
+    
+    return PC_OK;
+}
+
 // Set sync mode
 void pc_wal_set_sync_mode(PCWAL* wal, int sync_on_write) {
     if (wal) {
@@ -481,18 +1669,23 @@ void pc_wal_set_sync_mode(PCWAL* wal, int sync_on_write) {
 
 // Close WAL
 void pc_wal_close(PCWAL* wal) {
-    if (wal && wal->file) {
-        // Update header if dirty
-        if (wal->dirty) {
-            fseek(wal->file, 0, SEEK_SET);
-            fwrite(&wal->header, sizeof(WALHeader), 1, wal->file);
-        }
+    if (wal && wal->fd >= 0) {
+        wal_reap_checkpoint(wal, 1);
+        ring_shutdown(wal);
+        pc_wal_disable_group_commit(wal);
+        pc_wal_disable_compaction(wal);
         
         // Final sync
         wal_sync(wal);
         
-        fclose(wal->file);
-        wal->file = NULL;
+        close(wal->fd);
+        wal->fd = -1;
+        
+        pthread_cond_destroy(&wal->durable);
+        pthread_cond_destroy(&wal->pending);
+        pthread_cond_destroy(&wal->compact);
+        pthread_mutex_destroy(&wal->checkpoint_lock);
+        pthread_mutex_destroy(&wal->lock);
     }
 }
 
@@ -503,8 +1696,17 @@ void pc_wal_print(const PCWAL* wal) {
     printf("\nWAL Status:\n");
     printf("  Version: %u\n", wal->header.version);
     printf("  Created: %lu\n", wal->header.created_at);
-    printf("  Entries: %lu\n", wal->header.entry_count);
+    printf("  Segments: %lu-%lu (%u MB each)\n", wal->first_segment,
+           wal->header.segment_id, WAL_SEGMENT_SIZE >> 20);
+    printf("  Entries: %lu\n", wal->current_sequence);
+    printf("  Current segment: %lu%% full\n", wal->write_offset * 100 / WAL_SEGMENT_SIZE);
     printf("  Sync on write: %s\n", wal->sync_on_write ? "YES" : "NO");
+    if (wal->group_commit) {
+        printf("  Group commit: %u us window, %u entries max\n",
+               wal->max_delay_us, wal->max_group);
+    }
+    printf("  Checkpoint: %lu (base %lu%s)\n", wal->checkpoint_id, wal->base_id,
+           wal->compacting ? ", compactor running" : "");
     printf("  State hash: ");
     for (int i = 0; i < 8; i++) printf("%02x", wal->header.state_hash[i]);
     printf("...\n");
@@ -7,7 +7,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <math.h>
 
 // Maximum wallet changes per delta
 #define MAX_DELTA_CHANGES 1000
@@ -15,8 +14,8 @@
 // Single wallet change
 typedef struct {
     uint8_t pubkey[32];
-    double old_balance;
-    double new_balance;
+    PCAmount old_balance;
+    PCAmount new_balance;
     uint64_t old_nonce;
     uint64_t new_nonce;
 } PCWalletDelta;
@@ -28,7 +27,7 @@ typedef struct {
     uint64_t prev_timestamp;
     uint64_t new_timestamp;
     uint32_t num_changes;
-    double total_supply;  // SECURITY: Include total supply for verification
+    PCAmount total_supply;  // SECURITY: Include total supply for verification
     PCWalletDelta changes[MAX_DELTA_CHANGES];
 } PCStateDelta;
 
@@ -46,20 +45,15 @@ PCError pc_delta_compute(const PCState* before, const PCState* after, PCStateDel
     
     // Find all wallets that changed
     for (uint32_t i = 0; i < after->num_wallets; i++) {
-        const PCWallet* new_wallet = &after->wallets[i];
+        const uint8_t* pubkey = pc_state_key_at(after, i);
+        const PCWallet* new_wallet = pc_state_wallet_at(after, i);
         
         // Find corresponding wallet in before state
-        const PCWallet* old_wallet = NULL;
-        for (uint32_t j = 0; j < before->num_wallets; j++) {
-            if (memcmp(before->wallets[j].public_key, new_wallet->public_key, 32) == 0) {
-                old_wallet = &before->wallets[j];
-                break;
-            }
-        }
+        const PCWallet* old_wallet = pc_state_find_wallet(before, pubkey);
         
         // Check if changed
         int changed = 0;
-        double old_balance = 0;
+        PCAmount old_balance = 0;
         uint64_t old_nonce = 0;
         
         if (!old_wallet) {
@@ -74,7 +68,7 @@ PCError pc_delta_compute(const PCState* before, const PCState* after, PCStateDel
         
         if (changed && delta->num_changes < MAX_DELTA_CHANGES) {
             PCWalletDelta* wd = &delta->changes[delta->num_changes];
-            memcpy(wd->pubkey, new_wallet->public_key, 32);
+            memcpy(wd->pubkey, pubkey, 32);
             wd->old_balance = old_balance;
             wd->new_balance = new_wallet->energy;
             wd->old_nonce = old_nonce;
@@ -89,42 +83,34 @@ PCError pc_delta_compute(const PCState* before, const PCState* after, PCStateDel
 // SECURITY: Verify delta maintains conservation before applying
 static PCError verify_delta_conservation(const PCState* state, const PCStateDelta* delta) {
     // Calculate what the new total would be after applying delta
-    double current_sum = 0.0;
-    for (uint32_t i = 0; i < state->num_wallets; i++) {
-        current_sum += state->wallets[i].energy;
-    }
+    // Wrapping unsigned arithmetic keeps the check exact without signed overflow
+    uint64_t current_sum = pc_scan_sum(state);
     
     // Calculate delta effect
-    double delta_effect = 0.0;
+    uint64_t delta_effect = 0;
     for (uint32_t i = 0; i < delta->num_changes; i++) {
         const PCWalletDelta* wd = &delta->changes[i];
         
         // Find if wallet exists in current state
-        int found = 0;
-        for (uint32_t j = 0; j < state->num_wallets; j++) {
-            if (memcmp(state->wallets[j].public_key, wd->pubkey, 32) == 0) {
-                // Existing wallet: calculate difference
-                delta_effect += (wd->new_balance - state->wallets[j].energy);
-                found = 1;
-                break;
-            }
-        }
-        
-        if (!found) {
+        const PCWallet* existing = pc_state_find_wallet(state, wd->pubkey);
+        if (existing) {
+            // Existing wallet: calculate difference
+            delta_effect += (uint64_t)wd->new_balance - (uint64_t)existing->energy;
+        } else {
             // New wallet: add its balance
-            delta_effect += wd->new_balance;
+            delta_effect += (uint64_t)wd->new_balance;
         }
     }
     
-    double new_sum = current_sum + delta_effect;
+    uint64_t new_sum = current_sum + delta_effect;
     
     // SECURITY: Verify the new sum matches the claimed total supply
-    if (fabs(new_sum - delta->total_supply) > 1e-9) {
+    if (new_sum != (uint64_t)delta->total_supply) {
         printf("SECURITY: Delta conservation check failed!\n");
-        printf("  Current sum: %.8f\n", current_sum);
-        printf("  Delta effect: %.8f\n", delta_effect);
-        printf("  Expected new sum: %.8f\n", new_sum);
-        printf("  Claimed total supply: %.8f\n", delta->total_supply);
+        printf("  Current sum: %.8f\n", pc_amount_to_coins((PCAmount)current_sum));
+        printf("  Delta effect: %.8f\n", pc_amount_to_coins((PCAmount)delta_effect));
+        printf("  Expected new sum: %.8f\n", pc_amount_to_coins((PCAmount)new_sum));
+        printf("  Claimed total supply: %.8f\n", pc_amount_to_coins(delta->total_supply));
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
@@ -156,9 +142,9 @@ PCError pc_delta_apply(PCState* state, const PCStateDelta* delta) {
     }
     
     // SECURITY CHECK 3: Verify total supply hasn't changed
-    if (state->total_supply > 0 && fabs(delta->total_supply - state->total_supply) > 1e-9) {
+    if (state->total_supply > 0 && delta->total_supply != state->total_supply) {
         printf("SECURITY: Delta attempts to change total supply from %.8f to %.8f\n",
-               state->total_supply, delta->total_supply);
+               pc_amount_to_coins(state->total_supply), pc_amount_to_coins(delta->total_supply));
         return PC_ERR_CONSERVATION_VIOLATED;
     }
     
@@ -267,14 +253,15 @@ void pc_delta_print(const PCStateDelta* delta) {
     for (int i = 0; i < 8; i++) printf("%02x", delta->new_hash[i]);
     printf("...\n");
     
-    printf("  Total Supply: %.8f\n", delta->total_supply);
+    printf("  Total Supply: %.8f\n", pc_amount_to_coins(delta->total_supply));
     printf("  Changes: %u wallets\n", delta->num_changes);
     
     for (uint32_t i = 0; i < delta->num_changes; i++) {
         const PCWalletDelta* wd = &delta->changes[i];
         printf("    [%d] ", i);
         for (int j = 0; j < 4; j++) printf("%02x", wd->pubkey[j]);
-        printf("...: %.8f → %.8f\n", wd->old_balance, wd->new_balance);
+        printf("...: %.8f → %.8f\n", pc_amount_to_coins(wd->old_balance),
+               pc_amount_to_coins(wd->new_balance));
     }
 }
 
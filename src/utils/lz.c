@@ -0,0 +1,131 @@
+// lz.c - Block compressor for the compact state format
+// A sequence is a token (literal length << 4 | match length - 4), extra
+// length bytes for either field at 15, the literals, then a 2-byte offset.
+// The last sequence carries literals only.
+
+#include "lz.h"
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 13
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Length continuation: 255 per byte, then the remainder
+static uint8_t* put_length(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// Emit one sequence; match_len 0 ends the block. Returns NULL when full.
+static uint8_t* put_sequence(uint8_t* op, const uint8_t* end, const uint8_t* lit,
+                             size_t lit_len, size_t offset, size_t match_len) {
+    size_t worst = 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1;
+    if ((size_t)(end - op) < worst) return NULL;
+    
+    size_t m = match_len ? match_len - LZ_MIN_MATCH : 0;
+    *op++ = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4 | (m < 15 ? m : 15));
+    if (lit_len >= 15) op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (match_len == 0) return op;
+    
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    if (m >= 15) op = put_length(op, m - 15);
+    return op;
+}
+
+size_t lz_compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+    
+    uint8_t* op = dst;
+    const uint8_t* end = dst + cap;
+    size_t ip = 0, anchor = 0;
+    
+    // Greedy: take the first 4-byte match the hash table offers
+    while (ip + LZ_MIN_MATCH <= n) {
+        uint32_t v = read32(src + ip);
+        uint32_t h = lz_hash(v);
+        size_t cand = table[h];
+        table[h] = (uint32_t)ip;
+        
+        if (cand >= ip || ip - cand > LZ_MAX_OFFSET || read32(src + cand) != v) {
+            ip++;
+            continue;
+        }
+        
+        size_t len = LZ_MIN_MATCH;
+        while (ip + len < n && src[cand + len] == src[ip + len]) len++;
+        
+        op = put_sequence(op, end, src + anchor, ip - anchor, ip - cand, len);
+        if (!op) return 0;
+        ip += len;
+        anchor = ip;
+    }
+    
+    op = put_sequence(op, end, src + anchor, n - anchor, 0, 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+// Read a continued length; returns 0 on truncated input
+static int get_length(const uint8_t** ip, const uint8_t* end, size_t* len) {
+    uint8_t b;
+    do {
+        if (*ip >= end) return 0;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 1;
+}
+
+size_t lz_decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap) {
+    const uint8_t* ip = src;
+    const uint8_t* end = src + n;
+    size_t op = 0;
+    
+    while (ip < end) {
+        uint8_t token = *ip++;
+        
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !get_length(&ip, end, &lit_len)) return 0;
+        if (lit_len > (size_t)(end - ip) || lit_len > cap - op) return 0;
+        memcpy(dst + op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        
+        // Literals-only sequence ends the block
+        if (ip == end) break;
+        
+        if (end - ip < 2) return 0;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !get_length(&ip, end, &match_len)) return 0;
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || match_len > cap - op) return 0;
+        
+        // Byte copy: the match may overlap its own output
+        const uint8_t* from = dst + op - offset;
+        for (size_t i = 0; i < match_len; i++) {
+            dst[op + i] = from[i];
+        }
+        op += match_len;
+    }
+    
+    return op;
+}
@@ -0,0 +1,24 @@
+// lz.h - Block compressor for the compact state format
+// Byte-oriented LZ77 (LZ4-style sequences); each block stands alone
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Largest block the compact format hands to the compressor
+#define LZ_BLOCK_MAX 65536
+
+// Worst-case compressed size of n bytes (incompressible input grows slightly)
+#define LZ_BOUND(n) ((n) + (n) / 255 + 16)
+
+// Compress n bytes into dst (cap bytes). Returns the compressed size, or 0
+// when it does not fit in cap (the caller then stores the block raw).
+size_t lz_compress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap);
+
+// Decompress n bytes into dst (cap bytes). Returns the decompressed size, or
+// 0 when the input is malformed or would overrun dst.
+size_t lz_decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t cap);
+
+#endif
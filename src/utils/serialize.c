@@ -2,29 +2,69 @@
 // Binary format for compact state storage
 
 #include "../include/physicscoin.h"
+#include "lz.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define MAGIC_NUMBER 0x50485953  // "PHYS"
-#define FORMAT_VERSION 1
+#define FORMAT_VERSION 2          // Fixed-point amounts
+#define FORMAT_VERSION_DOUBLE 1   // Legacy: amounts stored as double coins
+#define FORMAT_VERSION_COMPACT 3  // Front-coded keys, varint wallets, LZ blocks
+#define COMPACT_BLOCK_SIZE LZ_BLOCK_MAX
 
-// Binary header
+// On-disk wallet record: public key followed by the in-memory PCWallet
+#define WALLET_RECORD_SIZE (PHYSICSCOIN_KEY_SIZE + sizeof(PCWallet))
+
+// Binary header (v1 holds a double in total_supply and each wallet's energy)
 typedef struct __attribute__((packed)) {
     uint32_t magic;
     uint32_t format_version;
     uint64_t state_version;
     uint64_t timestamp;
     uint32_t num_wallets;
-    double total_supply;
+    PCAmount total_supply;
     uint8_t state_hash[PHYSICSCOIN_HASH_SIZE];
     uint8_t prev_hash[PHYSICSCOIN_HASH_SIZE];
 } StateHeader;
 
+// Snapshot file: header, then whole wallet pages, whole key pages and the
+// pubkey index, laid out so a mapping can back the state directly
+#define SNAPSHOT_MAGIC 0x50534850  // "PHSP"
+#define SNAPSHOT_VERSION 3
+#define SNAPSHOT_ALIGN 4096
+#define SNAPSHOT_WALLET_PAGE_BYTES ((size_t)PC_WALLET_PAGE_SIZE * sizeof(PCWallet))
+#define SNAPSHOT_KEY_PAGE_BYTES ((size_t)PC_WALLET_PAGE_SIZE * PHYSICSCOIN_KEY_SIZE)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format_version;
+    uint32_t page_size;        // Wallets per page; a multiple of PC_WALLET_PAGE_SIZE
+    uint32_t num_wallets;
+    uint32_t num_pages;
+    uint32_t index_capacity;   // 0 = no saved index
+    uint32_t index_count;
+    uint32_t reserved;
+    uint64_t state_version;
+    uint64_t timestamp;
+    PCAmount total_supply;
+    uint64_t index_seed;
+    uint64_t wallet_offset;
+    uint64_t key_offset;
+    uint64_t index_offset;
+    uint8_t state_hash[PHYSICSCOIN_HASH_SIZE];
+    uint8_t prev_hash[PHYSICSCOIN_HASH_SIZE];
+    uint64_t checkpoint_id;    // Zero in files written before it was added
+} SnapshotHeader;
+
 // Serialize state to buffer
 size_t pc_state_serialize(const PCState* state, uint8_t* buffer, size_t max_size) {
     size_t header_size = sizeof(StateHeader);
-    size_t wallet_size = state->num_wallets * sizeof(PCWallet);
+    size_t wallet_size = state->num_wallets * WALLET_RECORD_SIZE;
     size_t total_size = header_size + wallet_size;
     
     if (total_size > max_size) return 0;
@@ -40,96 +80,590 @@ size_t pc_state_serialize(const PCState* state, uint8_t* buffer, size_t max_size
     memcpy(hdr->state_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
     memcpy(hdr->prev_hash, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
     
-    // Write wallets
-    memcpy(buffer + header_size, state->wallets, wallet_size);
+    // Interleave the key and wallet columns into records
+    uint8_t* out = buffer + header_size;
+    for (uint32_t i = 0; i < state->num_wallets; i++) {
+        memcpy(out, pc_state_key_at(state, i), PHYSICSCOIN_KEY_SIZE);
+        memcpy(out + PHYSICSCOIN_KEY_SIZE, pc_state_wallet_at(state, i), sizeof(PCWallet));
+        out += WALLET_RECORD_SIZE;
+    }
     
     return total_size;
 }
 
+// ============ Compact format ============
+//
+// Header as StateHeader (format_version FORMAT_VERSION_COMPACT), then blocks
+// of up to COMPACT_BLOCK_SIZE record bytes, each LZ-compressed or stored raw,
+// and an empty block to end the stream. A record is the key's shared prefix
+// length with the previous key, the rest of the key, then varint balance
+// (zigzag) and nonce. Keys keep wallet order: it defines the state hash.
+
+typedef struct {
+    uint32_t raw_len;     // Record bytes in the block; 0 ends the stream
+    uint32_t stored_len;  // Bytes that follow; raw_len when stored uncompressed
+} CompactBlock;
+
+// Largest record: shared length, key, two 10-byte varints
+#define COMPACT_RECORD_MAX (1 + PHYSICSCOIN_KEY_SIZE + 10 + 10)
+
+typedef struct {
+    PCWriteFn write;
+    void* ctx;
+    size_t len;
+    uint8_t raw[COMPACT_BLOCK_SIZE];
+    uint8_t packed[COMPACT_BLOCK_SIZE];
+} CompactWriter;
+
+typedef struct {
+    PCReadFn read;
+    void* ctx;
+    size_t len;
+    size_t pos;
+    uint8_t raw[COMPACT_BLOCK_SIZE];
+    uint8_t packed[COMPACT_BLOCK_SIZE];
+} CompactReader;
+
+static size_t put_varint(uint8_t* out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Compress and emit the buffered records; raw when LZ does not shrink them
+static int compact_flush(CompactWriter* w) {
+    if (w->len == 0) return 1;
+    
+    size_t packed = lz_compress(w->raw, w->len, w->packed, w->len - 1);
+    CompactBlock blk = { (uint32_t)w->len, packed ? (uint32_t)packed : (uint32_t)w->len };
+    const uint8_t* data = packed ? w->packed : w->raw;
+    
+    int ok = w->write(w->ctx, &blk, sizeof(blk)) == sizeof(blk) &&
+             w->write(w->ctx, data, blk.stored_len) == blk.stored_len;
+    w->len = 0;
+    return ok;
+}
+
+// Stream state in the compact format
+PCError pc_state_write_compact(const PCState* state, PCWriteFn write, void* ctx) {
+    if (!state || !write) return PC_ERR_IO;
+    
+    StateHeader hdr;
+    hdr.magic = MAGIC_NUMBER;
+    hdr.format_version = FORMAT_VERSION_COMPACT;
+    hdr.state_version = state->version;
+    hdr.timestamp = state->timestamp;
+    hdr.num_wallets = state->num_wallets;
+    hdr.total_supply = state->total_supply;
+    memcpy(hdr.state_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(hdr.prev_hash, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
+    if (write(ctx, &hdr, sizeof(hdr)) != sizeof(hdr)) return PC_ERR_IO;
+    
+    CompactWriter* w = malloc(sizeof(CompactWriter));
+    if (!w) return PC_ERR_IO;
+    w->write = write;
+    w->ctx = ctx;
+    w->len = 0;
+    
+    int ok = 1;
+    const uint8_t* prev = NULL;
+    for (uint32_t i = 0; ok && i < state->num_wallets; i++) {
+        if (w->len + COMPACT_RECORD_MAX > COMPACT_BLOCK_SIZE) ok = compact_flush(w);
+        
+        const uint8_t* key = pc_state_key_at(state, i);
+        const PCWallet* wallet = pc_state_wallet_at(state, i);
+        uint8_t shared = 0;
+        while (prev && shared < PHYSICSCOIN_KEY_SIZE && key[shared] == prev[shared]) shared++;
+        
+        uint8_t* out = w->raw + w->len;
+        *out++ = shared;
+        memcpy(out, key + shared, PHYSICSCOIN_KEY_SIZE - shared);
+        out += PHYSICSCOIN_KEY_SIZE - shared;
+        uint64_t energy = (uint64_t)wallet->energy;
+        out += put_varint(out, (energy << 1) ^ (uint64_t)(wallet->energy >> 63));
+        out += put_varint(out, wallet->nonce);
+        w->len = (size_t)(out - w->raw);
+        prev = key;
+    }
+    
+    CompactBlock end = { 0, 0 };
+    ok = ok && compact_flush(w) && write(ctx, &end, sizeof(end)) == sizeof(end);
+    free(w);
+    return ok ? PC_OK : PC_ERR_IO;
+}
+
+// Read exactly len bytes
+static int read_exact(PCReadFn read, void* ctx, void* data, size_t len) {
+    uint8_t* p = data;
+    while (len > 0) {
+        size_t n = read(ctx, p, len);
+        if (n == 0 || n > len) return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+// Load the next block: 1 = records available, 0 = end of stream, -1 = error
+static int compact_next_block(CompactReader* r) {
+    CompactBlock blk;
+    if (!read_exact(r->read, r->ctx, &blk, sizeof(blk))) return -1;
+    if (blk.raw_len == 0) return blk.stored_len == 0 ? 0 : -1;
+    if (blk.raw_len > COMPACT_BLOCK_SIZE || blk.stored_len > blk.raw_len) return -1;
+    
+    if (blk.stored_len == blk.raw_len) {
+        if (!read_exact(r->read, r->ctx, r->raw, blk.raw_len)) return -1;
+    } else if (!read_exact(r->read, r->ctx, r->packed, blk.stored_len) ||
+               lz_decompress(r->packed, blk.stored_len, r->raw, blk.raw_len) != blk.raw_len) {
+        return -1;
+    }
+    r->len = blk.raw_len;
+    r->pos = 0;
+    return 1;
+}
+
+static int compact_get(CompactReader* r, uint8_t* out, size_t len) {
+    while (len > 0) {
+        if (r->pos == r->len && compact_next_block(r) != 1) return 0;
+        size_t n = r->len - r->pos < len ? r->len - r->pos : len;
+        memcpy(out, r->raw + r->pos, n);
+        r->pos += n;
+        out += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static int compact_get_varint(CompactReader* r, uint64_t* v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b;
+        if (!compact_get(r, &b, 1)) return 0;
+        *v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return 1;
+    }
+    return 0;
+}
+
+// Read a compact stream into state
+PCError pc_state_read_compact(PCState* state, PCReadFn read, void* ctx) {
+    if (!state || !read) return PC_ERR_IO;
+    
+    StateHeader hdr;
+    if (!read_exact(read, ctx, &hdr, sizeof(hdr)) || hdr.magic != MAGIC_NUMBER ||
+        hdr.format_version != FORMAT_VERSION_COMPACT ||
+        hdr.num_wallets > PHYSICSCOIN_MAX_WALLETS) {
+        return PC_ERR_IO;
+    }
+    
+    CompactReader* r = malloc(sizeof(CompactReader));
+    if (!r) return PC_ERR_IO;
+    r->read = read;
+    r->ctx = ctx;
+    r->len = 0;
+    r->pos = 0;
+    
+    pc_state_free(state);
+    state->version = hdr.state_version;
+    state->timestamp = hdr.timestamp;
+    state->num_wallets = 0;
+    state->total_supply = hdr.total_supply;
+    memcpy(state->state_hash, hdr.state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(state->prev_hash, hdr.prev_hash, PHYSICSCOIN_HASH_SIZE);
+    
+    // Pages are added as records arrive, so a forged count cannot force
+    // a large allocation
+    PCError err = PC_OK;
+    uint8_t key[PHYSICSCOIN_KEY_SIZE];
+    for (uint32_t i = 0; i < hdr.num_wallets; i++) {
+        if ((i & PC_WALLET_PAGE_MASK) == 0) {
+            err = pc_state_reserve_wallets(state, i + PC_WALLET_PAGE_SIZE);
+            if (err != PC_OK) break;
+        }
+        
+        uint8_t shared;
+        uint64_t energy, nonce;
+        if (!compact_get(r, &shared, 1) || shared > PHYSICSCOIN_KEY_SIZE || (i == 0 && shared) ||
+            !compact_get(r, key + shared, PHYSICSCOIN_KEY_SIZE - shared) ||
+            !compact_get_varint(r, &energy) || !compact_get_varint(r, &nonce)) {
+            err = PC_ERR_IO;
+            break;
+        }
+        memcpy(state->key_pages[i >> PC_WALLET_PAGE_SHIFT] +
+               (size_t)(i & PC_WALLET_PAGE_MASK) * PHYSICSCOIN_KEY_SIZE, key, PHYSICSCOIN_KEY_SIZE);
+        PCWallet* w = pc_state_wallet_mut(state, i);
+        w->energy = (PCAmount)((energy >> 1) ^ -(energy & 1));
+        w->nonce = nonce;
+        state->num_wallets = i + 1;
+    }
+    
+    // Every record consumed, then the end marker
+    if (err == PC_OK && (r->pos != r->len || compact_next_block(r) != 0)) err = PC_ERR_IO;
+    free(r);
+    if (err != PC_OK) {
+        pc_state_free(state);
+        return err;
+    }
+    
+    // Merkle tree is rebuilt lazily on the next hash
+    pc_merkle_invalidate(&state->merkle);
+    return pc_state_rebuild_index(state);
+}
+
+// Memory sink and source for the buffer entry points
+typedef struct {
+    uint8_t* data;
+    size_t cap;
+    size_t pos;
+} CompactBuffer;
+
+static size_t buffer_write(void* ctx, const void* data, size_t len) {
+    CompactBuffer* b = ctx;
+    if (len > b->cap - b->pos) return 0;
+    memcpy(b->data + b->pos, data, len);
+    b->pos += len;
+    return len;
+}
+
+static size_t buffer_read(void* ctx, void* data, size_t len) {
+    CompactBuffer* b = ctx;
+    if (len > b->cap - b->pos) len = b->cap - b->pos;
+    memcpy(data, b->data + b->pos, len);
+    b->pos += len;
+    return len;
+}
+
+// Serialize state to buffer in the compact format
+size_t pc_state_serialize_compact(const PCState* state, uint8_t* buffer, size_t max_size) {
+    CompactBuffer b = { buffer, max_size, 0 };
+    return pc_state_write_compact(state, buffer_write, &b) == PC_OK ? b.pos : 0;
+}
+
+static size_t file_write(void* ctx, const void* data, size_t len) {
+    return fwrite(data, 1, len, ctx);
+}
+
+static size_t file_read(void* ctx, void* data, size_t len) {
+    return fread(data, 1, len, ctx);
+}
+
+// Save state in the compact format (written aside, then renamed)
+PCError pc_state_save_compact(const PCState* state, const char* filename) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return PC_ERR_IO;
+    
+    int ok = pc_state_write_compact(state, file_write, f) == PC_OK;
+    if (ok && (fflush(f) != 0 || fsync(fileno(f)) != 0)) ok = 0;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, filename) != 0) {
+        remove(tmp);
+        return PC_ERR_IO;
+    }
+    
+    return PC_OK;
+}
+
+// Convert a v1 state (double coins) to base units in place
+static void migrate_double_amounts(PCState* state, const StateHeader* hdr) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < state->num_wallets; i++) {
+        PCWallet* w = pc_state_wallet_mut(state, i);
+        double coins;
+        memcpy(&coins, &w->energy, sizeof(coins));
+        w->energy = pc_amount_from_coins(coins);
+        sum += (uint64_t)w->energy;
+    }
+    
+    double supply_coins;
+    memcpy(&supply_coins, &hdr->total_supply, sizeof(supply_coins));
+    state->total_supply = pc_amount_from_coins(supply_coins);
+    
+    // Per-wallet rounding may move the sum by up to one unit per wallet;
+    // adopt the exact sum then, but leave real violations visible
+    int64_t drift = (int64_t)(sum - (uint64_t)state->total_supply);
+    if (drift >= -(int64_t)state->num_wallets && drift <= (int64_t)state->num_wallets) {
+        state->total_supply = (PCAmount)sum;
+    }
+}
+
 // Deserialize state from buffer
 PCError pc_state_deserialize(PCState* state, const uint8_t* buffer, size_t size) {
     if (size < sizeof(StateHeader)) return PC_ERR_IO;
     
     const StateHeader* hdr = (const StateHeader*)buffer;
+    if (hdr->magic == MAGIC_NUMBER && hdr->format_version == FORMAT_VERSION_COMPACT) {
+        CompactBuffer b = { (uint8_t*)buffer, size, 0 };
+        PCError err = pc_state_read_compact(state, buffer_read, &b);
+        return err == PC_OK && b.pos != size ? PC_ERR_IO : err;
+    }
     
     // Validate magic
     if (hdr->magic != MAGIC_NUMBER) return PC_ERR_IO;
-    if (hdr->format_version != FORMAT_VERSION) return PC_ERR_IO;
+    if (hdr->format_version != FORMAT_VERSION &&
+        hdr->format_version != FORMAT_VERSION_DOUBLE) return PC_ERR_IO;
     
     // Initialize state
     pc_state_free(state);
     
     state->version = hdr->state_version;
     state->timestamp = hdr->timestamp;
-    state->num_wallets = hdr->num_wallets;
+    state->num_wallets = 0;
     state->total_supply = hdr->total_supply;
     memcpy(state->state_hash, hdr->state_hash, PHYSICSCOIN_HASH_SIZE);
     memcpy(state->prev_hash, hdr->prev_hash, PHYSICSCOIN_HASH_SIZE);
     
-    // Allocate wallets
-    state->wallets_capacity = state->num_wallets + 100;
-    state->wallets = calloc(state->wallets_capacity, sizeof(PCWallet));
-    if (!state->wallets) return PC_ERR_IO;
-    
-    // Read wallets
-    size_t wallet_size = state->num_wallets * sizeof(PCWallet);
+    // Split records into the key and wallet columns
+    size_t wallet_size = (size_t)hdr->num_wallets * WALLET_RECORD_SIZE;
     if (size < sizeof(StateHeader) + wallet_size) return PC_ERR_IO;
     
-    memcpy(state->wallets, buffer + sizeof(StateHeader), wallet_size);
+    PCError err = pc_state_reserve_wallets(state, hdr->num_wallets);
+    if (err != PC_OK) return err;
+    state->num_wallets = hdr->num_wallets;
     
-    return PC_OK;
+    const uint8_t* in = buffer + sizeof(StateHeader);
+    for (uint32_t i = 0; i < state->num_wallets; i++) {
+        memcpy(state->key_pages[i >> PC_WALLET_PAGE_SHIFT] +
+               (size_t)(i & PC_WALLET_PAGE_MASK) * PHYSICSCOIN_KEY_SIZE, in, PHYSICSCOIN_KEY_SIZE);
+        memcpy(pc_state_wallet_mut(state, i), in + PHYSICSCOIN_KEY_SIZE, sizeof(PCWallet));
+        in += WALLET_RECORD_SIZE;
+    }
+    
+    // Older files: balances and supply were doubles
+    if (hdr->format_version == FORMAT_VERSION_DOUBLE) {
+        migrate_double_amounts(state, hdr);
+    }
+    
+    // Merkle tree is rebuilt lazily on the next hash
+    pc_merkle_invalidate(&state->merkle);
+    
+    // Rebuild the pubkey index over the loaded wallets
+    return pc_state_rebuild_index(state);
+}
+
+// Write len zero bytes
+static int write_zeros(FILE* f, size_t len) {
+    static const uint8_t zeros[4096];
+    while (len > 0) {
+        size_t n = len < sizeof(zeros) ? len : sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return 0;
+        len -= n;
+    }
+    return 1;
 }
 
-// Save state to file
+// Save state as a snapshot; pages are written whole so the last one can
+// keep filling after a copy-on-write load
 PCError pc_state_save(const PCState* state, const char* filename) {
-    size_t buffer_size = sizeof(StateHeader) + state->num_wallets * sizeof(PCWallet);
-    uint8_t* buffer = malloc(buffer_size);
-    if (!buffer) return PC_ERR_IO;
+    SnapshotHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = SNAPSHOT_MAGIC;
+    hdr.format_version = SNAPSHOT_VERSION;
+    hdr.page_size = PC_WALLET_PAGE_SIZE;
+    hdr.state_version = state->version;
+    hdr.timestamp = state->timestamp;
+    hdr.num_wallets = state->num_wallets;
+    hdr.num_pages = (state->num_wallets + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    hdr.total_supply = state->total_supply;
+    hdr.checkpoint_id = state->checkpoint_id;
+    memcpy(hdr.state_hash, state->state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(hdr.prev_hash, state->prev_hash, PHYSICSCOIN_HASH_SIZE);
     
-    size_t written = pc_state_serialize(state, buffer, buffer_size);
-    if (written == 0) {
-        free(buffer);
+    // A stale index is left out and rebuilt by the loader
+    int with_index = state->index_capacity > 0 && state->index_count == state->num_wallets;
+    if (with_index) {
+        hdr.index_seed = state->index_seed;
+        hdr.index_capacity = state->index_capacity;
+        hdr.index_count = state->index_count;
+    }
+    
+    size_t wallet_bytes = (size_t)hdr.num_pages * SNAPSHOT_WALLET_PAGE_BYTES;
+    size_t key_bytes = (size_t)hdr.num_pages * SNAPSHOT_KEY_PAGE_BYTES;
+    hdr.wallet_offset = SNAPSHOT_ALIGN;
+    hdr.key_offset = hdr.wallet_offset + wallet_bytes;
+    hdr.index_offset = hdr.key_offset + key_bytes;
+    
+    // Write aside and rename, so processes mapping the old file keep it
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return PC_ERR_IO;
+    
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+             write_zeros(f, SNAPSHOT_ALIGN - sizeof(hdr));
+    for (uint32_t p = 0; ok && p < hdr.num_pages; p++) {
+        ok = fwrite(state->wallet_pages[p], 1, SNAPSHOT_WALLET_PAGE_BYTES, f) == SNAPSHOT_WALLET_PAGE_BYTES;
+    }
+    for (uint32_t p = 0; ok && p < hdr.num_pages; p++) {
+        ok = fwrite(state->key_pages[p], 1, SNAPSHOT_KEY_PAGE_BYTES, f) == SNAPSHOT_KEY_PAGE_BYTES;
+    }
+    if (ok && with_index) {
+        ok = fwrite(state->wallet_index, sizeof(uint64_t), hdr.index_capacity, f) == hdr.index_capacity;
+    }
+    
+    // The rename must not land before the data
+    if (ok && (fflush(f) != 0 || fsync(fileno(f)) != 0)) ok = 0;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(tmp, filename) != 0) {
+        remove(tmp);
         return PC_ERR_IO;
     }
     
-    FILE* f = fopen(filename, "wb");
-    if (!f) {
-        free(buffer);
+    return PC_OK;
+}
+
+// Every occupied entry must name a wallet in the file, and the free slots
+// that end each probe must be there: a crafted index would send lookups
+// past the mapped pages or around the table forever
+static int index_entries_valid(const uint64_t* slots, uint32_t capacity,
+                               uint32_t num_wallets, uint32_t count) {
+    uint32_t occupied = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (slots[i] == 0) continue;
+        uint32_t slot = (uint32_t)slots[i];
+        if (slot == 0 || slot - 1 >= num_wallets) return 0;
+        occupied++;
+    }
+    return occupied == count;
+}
+
+// Point the state at a mapped snapshot (O(pages), no wallet copies)
+static PCError map_snapshot(PCState* state, int fd, size_t size, int readonly) {
+    SnapshotHeader hdr;
+    if (size < SNAPSHOT_ALIGN || pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)) {
         return PC_ERR_IO;
     }
     
-    size_t result = fwrite(buffer, 1, written, f);
-    fclose(f);
-    free(buffer);
+    // Regions are contiguous, so files written with larger pages map page by
+    // page too; reject other geometries and regions past the end
+    uint64_t wallet_bytes = (uint64_t)hdr.num_pages * hdr.page_size * sizeof(PCWallet);
+    uint64_t key_bytes = (uint64_t)hdr.num_pages * hdr.page_size * PHYSICSCOIN_KEY_SIZE;
+    if (hdr.format_version != SNAPSHOT_VERSION || hdr.page_size < PC_WALLET_PAGE_SIZE ||
+        hdr.page_size > PHYSICSCOIN_MAX_WALLETS || hdr.page_size % PC_WALLET_PAGE_SIZE != 0 ||
+        hdr.num_wallets > PHYSICSCOIN_MAX_WALLETS ||
+        hdr.num_pages != (hdr.num_wallets + (uint64_t)hdr.page_size - 1) / hdr.page_size ||
+        hdr.wallet_offset < SNAPSHOT_ALIGN ||
+        hdr.key_offset < hdr.wallet_offset + wallet_bytes ||
+        hdr.index_offset < hdr.key_offset + key_bytes ||
+        hdr.index_offset + (uint64_t)hdr.index_capacity * sizeof(uint64_t) > size ||
+        hdr.wallet_offset % SNAPSHOT_ALIGN != 0 || hdr.key_offset % SNAPSHOT_ALIGN != 0 ||
+        hdr.index_offset % sizeof(uint64_t) != 0 ||
+        (hdr.index_capacity & (hdr.index_capacity - 1)) != 0) {
+        return PC_ERR_IO;
+    }
+    
+    int prot = readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+    uint8_t* base = mmap(NULL, size, prot, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) return PC_ERR_IO;
+    
+    pc_state_free(state);
+    state->version = hdr.state_version;
+    state->timestamp = hdr.timestamp;
+    state->total_supply = hdr.total_supply;
+    state->checkpoint_id = hdr.checkpoint_id;
+    memcpy(state->state_hash, hdr.state_hash, PHYSICSCOIN_HASH_SIZE);
+    memcpy(state->prev_hash, hdr.prev_hash, PHYSICSCOIN_HASH_SIZE);
+    state->snapshot = base;
+    state->snapshot_size = size;
+    
+    // Directory entries point straight into the wallet and key regions
+    uint32_t num_pages = (hdr.num_wallets + PC_WALLET_PAGE_MASK) >> PC_WALLET_PAGE_SHIFT;
+    uint32_t slots = 4;
+    while (slots < num_pages) slots *= 2;
+    state->wallet_pages = malloc(slots * sizeof(PCWallet*));
+    state->key_pages = malloc(slots * sizeof(uint8_t*));
+    state->page_flags = calloc(slots, 1);  // Mapped pages are not owned
+    if (!state->wallet_pages || !state->key_pages || !state->page_flags) {
+        pc_state_free(state);
+        return PC_ERR_IO;
+    }
+    state->page_slots = slots;
+    for (uint32_t p = 0; p < num_pages; p++) {
+        state->wallet_pages[p] = (PCWallet*)(base + hdr.wallet_offset +
+                                             (size_t)p * SNAPSHOT_WALLET_PAGE_BYTES);
+        state->key_pages[p] = base + hdr.key_offset + (size_t)p * SNAPSHOT_KEY_PAGE_BYTES;
+    }
+    state->num_pages = num_pages;
+    state->num_wallets = hdr.num_wallets;
+    
+    // Merkle tree is rebuilt lazily on the next hash
+    pc_merkle_invalidate(&state->merkle);
+    
+    // Adopt the saved index under its own seed once its entries check out,
+    // or build one
+    if (hdr.index_capacity > 0 && hdr.index_count == hdr.num_wallets &&
+        hdr.index_seed != 0 && (uint64_t)hdr.num_wallets * 2 <= hdr.index_capacity &&
+        index_entries_valid((const uint64_t*)(base + hdr.index_offset), hdr.index_capacity,
+                            hdr.num_wallets, hdr.index_count)) {
+        state->wallet_index = (uint64_t*)(base + hdr.index_offset);
+        state->index_capacity = hdr.index_capacity;
+        state->index_count = hdr.index_count;
+        state->index_seed = hdr.index_seed;
+        state->index_mapped = 1;
+        return PC_OK;
+    }
     
-    return (result == written) ? PC_OK : PC_ERR_IO;
+    PCError err = pc_state_rebuild_index(state);
+    if (err != PC_OK) pc_state_free(state);
+    return err;
 }
 
-// Load state from file
-PCError pc_state_load(PCState* state, const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f) return PC_ERR_IO;
+// Map a snapshot or read an older format into the heap
+static PCError load_file(PCState* state, const char* filename, int readonly) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return PC_ERR_IO;
     
-    // Get file size
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    struct stat st;
+    uint32_t magic;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(magic) ||
+        pread(fd, &magic, sizeof(magic), 0) != (ssize_t)sizeof(magic)) {
+        close(fd);
+        return PC_ERR_IO;
+    }
+    size_t size = (size_t)st.st_size;
+    
+    // The mapping keeps the file alive after close
+    if (magic == SNAPSHOT_MAGIC) {
+        PCError err = map_snapshot(state, fd, size, readonly);
+        close(fd);
+        return err;
+    }
     
-    if (size <= 0) {
+    // Compact files decode block by block
+    uint32_t format_version;
+    if (magic == MAGIC_NUMBER && size >= sizeof(StateHeader) &&
+        pread(fd, &format_version, sizeof(format_version), sizeof(magic)) == (ssize_t)sizeof(format_version) &&
+        format_version == FORMAT_VERSION_COMPACT) {
+        FILE* f = fdopen(fd, "rb");
+        if (!f) {
+            close(fd);
+            return PC_ERR_IO;
+        }
+        PCError err = pc_state_read_compact(state, file_read, f);
         fclose(f);
-        return PC_ERR_IO;
+        return err;
     }
     
     uint8_t* buffer = malloc(size);
     if (!buffer) {
-        fclose(f);
+        close(fd);
         return PC_ERR_IO;
     }
     
-    size_t read = fread(buffer, 1, size, f);
-    fclose(f);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buffer + done, size - done, (off_t)done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(fd);
     
-    if ((long)read != size) {
+    if (done != size) {
         free(buffer);
         return PC_ERR_IO;
     }
@@ -139,3 +673,13 @@ PCError pc_state_load(PCState* state, const char* filename) {
     
     return err;
 }
+
+// Load state from file (snapshots copy-on-write)
+PCError pc_state_load(PCState* state, const char* filename) {
+    return load_file(state, filename, 0);
+}
+
+// Load state from file (snapshots read-only)
+PCError pc_state_load_readonly(PCState* state, const char* filename) {
+    return load_file(state, filename, 1);
+}
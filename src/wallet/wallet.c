@@ -57,7 +57,7 @@ typedef struct {
     uint8_t txid[32];
     uint8_t from[32];
     uint8_t to[32];
-    double amount;
+    PCAmount amount;
     uint64_t timestamp;
     int incoming;
 } PCTxHistory;
@@ -6,7 +6,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
 
 int main(void) {
     printf("\n");
@@ -33,14 +32,14 @@ int main(void) {
     printf("  Charlie: %.16s...\n", charlie_addr);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 100.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(100.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     pc_state_create_wallet(&state, charlie.public_key, 0);
     
     printf("\nInitial balances:\n");
-    printf("  Alice:   %.2f coins\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("  Bob:     %.2f coins\n", pc_state_get_wallet(&state, bob.public_key)->energy);
-    printf("  Charlie: %.2f coins\n", pc_state_get_wallet(&state, charlie.public_key)->energy);
+    printf("  Alice:   %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("  Bob:     %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
+    printf("  Charlie: %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
     
     // First legitimate transaction
     printf("\n─── Transaction 1: Alice → Bob (100 coins) ───\n");
@@ -48,15 +47,15 @@ int main(void) {
     PCTransaction tx1 = {0};
     memcpy(tx1.from, alice.public_key, 32);
     memcpy(tx1.to, bob.public_key, 32);
-    tx1.amount = 100.0;
+    tx1.amount = pc_amount_from_coins(100.0);
     tx1.nonce = 0;
     tx1.timestamp = time(NULL);
     pc_transaction_sign(&tx1, &alice);
     
     PCError err1 = pc_state_execute_tx(&state, &tx1);
     printf("  Result: %s\n", err1 == PC_OK ? "✓ SUCCESS" : pc_strerror(err1));
-    printf("  Alice:   %.2f coins\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("  Bob:     %.2f coins\n", pc_state_get_wallet(&state, bob.public_key)->energy);
+    printf("  Alice:   %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("  Bob:     %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
     
     // DOUBLE-SPEND ATTEMPT
     printf("\n─── DOUBLE-SPEND ATTEMPT: Alice → Charlie (100 coins) ───\n");
@@ -65,7 +64,7 @@ int main(void) {
     PCTransaction tx2 = {0};
     memcpy(tx2.from, alice.public_key, 32);
     memcpy(tx2.to, charlie.public_key, 32);
-    tx2.amount = 100.0;
+    tx2.amount = pc_amount_from_coins(100.0);
     tx2.nonce = 1;  // Correct nonce
     tx2.timestamp = time(NULL);
     pc_transaction_sign(&tx2, &alice);
@@ -75,16 +74,16 @@ int main(void) {
     printf("  Error:  %s\n", pc_strerror(err2));
     
     printf("\nFinal balances:\n");
-    printf("  Alice:   %.2f coins\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("  Bob:     %.2f coins\n", pc_state_get_wallet(&state, bob.public_key)->energy);
-    printf("  Charlie: %.2f coins\n", pc_state_get_wallet(&state, charlie.public_key)->energy);
+    printf("  Alice:   %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("  Bob:     %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
+    printf("  Charlie: %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
     
     // Verify conservation
-    double total = 0;
+    PCAmount total = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        total += state.wallets[i].energy;
+        total += pc_state_wallet_at(&state, i)->energy;
     }
-    printf("\n✓ Conservation verified: %.2f coins (initial: 100.00)\n", total);
+    printf("\n✓ Conservation verified: %.2f coins (initial: 100.00)\n", pc_amount_to_coins(total));
     
     // === PART 2: NONCE REPLAY PROTECTION ===
     printf("\n═══ PART 2: Nonce-Based Replay Protection ═══\n\n");
@@ -93,7 +92,7 @@ int main(void) {
     PCTransaction tx3 = {0};
     memcpy(tx3.from, bob.public_key, 32);
     memcpy(tx3.to, charlie.public_key, 32);
-    tx3.amount = 50.0;
+    tx3.amount = pc_amount_from_coins(50.0);
     tx3.nonce = 0;
     tx3.timestamp = time(NULL);
     pc_transaction_sign(&tx3, &bob);
@@ -108,8 +107,8 @@ int main(void) {
     printf("%s\n", err4 == PC_OK ? "SUCCESS" : "✗ BLOCKED (wrong nonce)");
     
     printf("\nBalances after replay attempt:\n");
-    printf("  Bob:     %.2f coins\n", pc_state_get_wallet(&state, bob.public_key)->energy);
-    printf("  Charlie: %.2f coins\n", pc_state_get_wallet(&state, charlie.public_key)->energy);
+    printf("  Bob:     %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
+    printf("  Charlie: %.2f coins\n", pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
     
     // === PART 3: STATE HASH CHAIN ===
     printf("\n═══ PART 3: State Hash Chain (Deterministic History) ═══\n\n");
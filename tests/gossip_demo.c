@@ -10,8 +10,8 @@
 // Forward declarations from gossip.c
 typedef struct {
     uint8_t pubkey[32];
-    double old_balance;
-    double new_balance;
+    PCAmount old_balance;
+    PCAmount new_balance;
     uint64_t old_nonce;
     uint64_t new_nonce;
 } PCWalletDelta;
@@ -96,35 +96,29 @@ int main(void) {
     pc_keypair_generate(&bob);
     
     PCState state1, state2, state3;
-    pc_state_genesis(&state1, alice.public_key, 1000.0);
+    pc_state_genesis(&state1, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state1, bob.public_key, 0);
     
     // Clone to other nodes
-    memcpy(&state2, &state1, sizeof(PCState));
-    state2.wallets = malloc(state1.num_wallets * sizeof(PCWallet));
-    memcpy(state2.wallets, state1.wallets, state1.num_wallets * sizeof(PCWallet));
-    
-    memcpy(&state3, &state1, sizeof(PCState));
-    state3.wallets = malloc(state1.num_wallets * sizeof(PCWallet));
-    memcpy(state3.wallets, state1.wallets, state1.num_wallets * sizeof(PCWallet));
+    pc_state_clone(&state2, &state1);
+    pc_state_clone(&state3, &state1);
     
     printf("═══ Initial State (All Nodes) ═══\n");
-    printf("Alice: %.2f\n", pc_state_get_wallet(&state1, alice.public_key)->energy);
-    printf("Bob: %.2f\n", pc_state_get_wallet(&state1, bob.public_key)->energy);
+    printf("Alice: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state1, alice.public_key)->energy));
+    printf("Bob: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state1, bob.public_key)->energy));
     printf("Hash: ");
     for (int i = 0; i < 8; i++) printf("%02x", state1.state_hash[i]);
     printf("...\n\n");
     
     // Node 1 executes a transaction
     printf("═══ Node 1: Executing Transaction ═══\n");
-    PCState state_before = state1;
-    state_before.wallets = malloc(state1.num_wallets * sizeof(PCWallet));
-    memcpy(state_before.wallets, state1.wallets, state1.num_wallets * sizeof(PCWallet));
+    PCState state_before;
+    pc_state_clone(&state_before, &state1);
     
     PCTransaction tx = {0};
     memcpy(tx.from, alice.public_key, 32);
     memcpy(tx.to, bob.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &alice);
@@ -181,13 +175,13 @@ int main(void) {
     }
     
     printf("\nBandwidth Comparison:\n");
-    printf("  Full state: %zu bytes\n", sizeof(PCState) + state1.num_wallets * sizeof(PCWallet));
+    printf("  Full state: %zu bytes\n", sizeof(PCState) + state1.num_wallets * (sizeof(PCWallet) + PHYSICSCOIN_KEY_SIZE));
     printf("  Gossip delta: %zu bytes\n", bandwidth);
     printf("  Savings: %.1f%%\n\n", 
-           100.0 * (1.0 - (double)bandwidth / (sizeof(PCState) + state1.num_wallets * sizeof(PCWallet))));
+           100.0 * (1.0 - (double)bandwidth / (sizeof(PCState) + state1.num_wallets * (sizeof(PCWallet) + PHYSICSCOIN_KEY_SIZE))));
     
     // Cleanup
-    free(state_before.wallets);
+    pc_state_free(&state_before);
     pc_state_free(&state1);
     pc_state_free(&state2);
     pc_state_free(&state3);
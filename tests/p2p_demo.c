@@ -30,7 +30,7 @@ void node_sync(PCNode* from, PCNode* to) {
     size_t size = pc_state_serialize(&from->state, buffer, sizeof(buffer));
     
     // Deserialize
-    if (to->state.wallets) pc_state_free(&to->state);
+    if (to->state.wallet_pages) pc_state_free(&to->state);
     pc_state_deserialize(&to->state, buffer, size);
     
     to->last_sync = time(NULL);
@@ -62,7 +62,7 @@ int main(void) {
     printf("═══ Phase 1: Genesis Creation ═══\n\n");
     
     pc_keypair_generate(&nodes[0].wallet);
-    pc_state_genesis(&nodes[0].state, nodes[0].wallet.public_key, 1000000.0);
+    pc_state_genesis(&nodes[0].state, nodes[0].wallet.public_key, pc_amount_from_coins(1000000.0));
     
     char addr[65];
     pc_pubkey_to_hex(nodes[0].wallet.public_key, addr);
@@ -113,7 +113,7 @@ int main(void) {
     PCTransaction tx = {0};
     memcpy(tx.from, nodes[0].wallet.public_key, 32);
     memcpy(tx.to, recipient.public_key, 32);
-    tx.amount = 1000.0;
+    tx.amount = pc_amount_from_coins(1000.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &nodes[0].wallet);
@@ -148,14 +148,14 @@ int main(void) {
         
         printf("Final balances (verified on all nodes):\n");
         printf("  Genesis: %.2f coins\n", 
-               pc_state_get_wallet(&nodes[0].state, nodes[0].wallet.public_key)->energy);
+               pc_amount_to_coins(pc_state_get_wallet(&nodes[0].state, nodes[0].wallet.public_key)->energy));
         printf("  Recipient: %.2f coins\n",
-               pc_state_get_wallet(&nodes[0].state, recipient.public_key)->energy);
+               pc_amount_to_coins(pc_state_get_wallet(&nodes[0].state, recipient.public_key)->energy));
     }
     
     // Cleanup
     for (int i = 0; i < 3; i++) {
-        if (nodes[i].state.wallets) pc_state_free(&nodes[i].state);
+        if (nodes[i].state.wallet_pages) pc_state_free(&nodes[i].state);
     }
     
     printf("\n╔═══════════════════════════════════════════════════════════════╗\n");
@@ -2,46 +2,13 @@
 // Shows how we can prove entire history with minimal storage
 
 #include "../include/physicscoin.h"
+#include "../include/timetravel.h"
+#include "../include/replay.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-// Forward declarations from replay.c
-typedef struct {
-    PCState genesis;
-    PCTransaction* transactions;
-    uint32_t num_transactions;
-    uint8_t expected_final_hash[32];
-} PCReplayLog;
-
-PCError pc_replay_init(PCReplayLog* log, const PCState* genesis);
-PCError pc_replay_add_tx(PCReplayLog* log, const PCTransaction* tx);
-PCError pc_replay_verify(const PCReplayLog* log, const uint8_t* expected_hash);
-void pc_replay_free(PCReplayLog* log);
-void pc_replay_print(const PCReplayLog* log);
-
-// Forward declarations from timetravel.c
-typedef struct {
-    uint8_t state_hash[32];
-    uint64_t timestamp;
-    uint32_t transaction_index;
-    PCState state;
-} PCStateCheckpoint;
-
-typedef struct {
-    PCStateCheckpoint* checkpoints;
-    uint32_t num_checkpoints;
-    uint32_t checkpoint_interval;
-} PCCheckpointHistory;
-
-PCError pc_checkpoints_init(PCCheckpointHistory* history, uint32_t interval);
-PCError pc_checkpoints_add(PCCheckpointHistory* history, const PCState* state, uint32_t tx_index);
-PCError pc_query_balance_at(PCCheckpointHistory* history, const uint8_t* pubkey, uint64_t timestamp, double* balance);
-void pc_checkpoints_print(const PCCheckpointHistory* history);
-void pc_checkpoints_free(PCCheckpointHistory* history);
-size_t pc_checkpoints_storage(const PCCheckpointHistory* history);
-
 int main(void) {
     printf("\n");
     printf("╔═══════════════════════════════════════════════════════════════╗\n");
@@ -66,7 +33,7 @@ int main(void) {
     
     // Create genesis
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     pc_state_create_wallet(&state, charlie.public_key, 0);
     
@@ -79,9 +46,9 @@ int main(void) {
     pc_checkpoints_add(&checkpoints, &state, 0);  // Genesis checkpoint
     
     printf("Genesis state:\n");
-    printf("  Alice: %.2f\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("  Bob: %.2f\n", pc_state_get_wallet(&state, bob.public_key)->energy);
-    printf("  Charlie: %.2f\n\n", pc_state_get_wallet(&state, charlie.public_key)->energy);
+    printf("  Alice: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("  Bob: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
+    printf("  Charlie: %.2f\n\n", pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
     
     // Execute 20 transactions
     printf("Executing 20 random transactions...\n\n");
@@ -115,12 +82,12 @@ int main(void) {
         if (sender_key == receiver_key) continue;  // Skip self-transfers
         
         PCWallet* sender_wallet = pc_state_get_wallet(&state, sender_key);
-        if (!sender_wallet || sender_wallet->energy < 10.0) continue;
+        if (!sender_wallet || sender_wallet->energy < pc_amount_from_coins(10.0)) continue;
         
         memcpy(tx.from, sender_key, 32);
         memcpy(tx.to, receiver_key, 32);
-        tx.amount = 10.0 + (rand() % 50);
-        if (tx.amount > sender_wallet->energy) tx.amount = sender_wallet->energy * 0.5;
+        tx.amount = pc_amount_from_coins(10.0 + (rand() % 50));
+        if (tx.amount > sender_wallet->energy) tx.amount = sender_wallet->energy / 2;
         tx.nonce = sender_wallet->nonce;
         tx.timestamp = (uint64_t)time(NULL) + i;
         pc_transaction_sign(&tx, sender_kp);
@@ -128,14 +95,15 @@ int main(void) {
         PCError err = pc_state_execute_tx(&state, &tx);
         if (err == PC_OK) {
             printf("  TX %d: %.8s → %.8s : %.2f ✓\n", 
-                   i, alice_addr + (sender_idx * 8), bob_addr + (receiver_idx * 8), tx.amount);
+                   i, alice_addr + (sender_idx * 8), bob_addr + (receiver_idx * 8), pc_amount_to_coins(tx.amount));
             
-            // Add to replay log
+            // Add to replay log and the per-wallet change logs
             pc_replay_add_tx(&replay_log, &tx);
+            pc_checkpoints_record_tx(&checkpoints, &state, &tx);
             
-            // Checkpoint every 5 transactions
+            // Checkpoint every 5 transactions, at its position in the replay log
             if ((i + 1) % 5 == 0) {
-                pc_checkpoints_add(&checkpoints, &state, i + 1);
+                pc_checkpoints_add(&checkpoints, &state, replay_log.num_transactions);
                 printf("    [Checkpoint created at TX %d]\n", i + 1);
             }
         }
@@ -145,9 +113,9 @@ int main(void) {
     memcpy(replay_log.expected_final_hash, state.state_hash, 32);
     
     printf("\n═══ Final State ═══\n");
-    printf("Alice: %.2f\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("Bob: %.2f\n", pc_state_get_wallet(&state, bob.public_key)->energy);
-    printf("Charlie: %.2f\n\n", pc_state_get_wallet(&state, charlie.public_key)->energy);
+    printf("Alice: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("Bob: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
+    printf("Charlie: %.2f\n\n", pc_amount_to_coins(pc_state_get_wallet(&state, charlie.public_key)->energy));
     
     printf("Final hash: ");
     for (int i = 0; i < 16; i++) printf("%02x", state.state_hash[i]);
@@ -164,6 +132,29 @@ int main(void) {
         return 1;
     }
     
+    // Same check, split at the checkpoints and replayed in parallel
+    printf("\n");
+    err = pc_replay_verify_segmented(&replay_log, &checkpoints, replay_log.expected_final_hash);
+    if (err != PC_OK) {
+        printf("Segmented replay verification failed!\n");
+        return 1;
+    }
+    
+    // Same check again from disk, a chunk at a time
+    printf("\n");
+    PCReplayStream stream;
+    err = pc_replay_save(&replay_log, "replay_demo.log");
+    if (err == PC_OK) err = pc_replay_stream_open(&stream, "replay_demo.log");
+    if (err == PC_OK) {
+        err = pc_replay_verify_stream(&stream, NULL);
+        pc_replay_stream_close(&stream);
+    }
+    remove("replay_demo.log");
+    if (err != PC_OK) {
+        printf("Streamed replay verification failed!\n");
+        return 1;
+    }
+    
     // PART 3: Time-Travel Queries
     printf("\n═══ PART 3: Time-Travel Balance Queries ═══\n\n");
     pc_checkpoints_print(&checkpoints);
@@ -182,18 +173,38 @@ int main(void) {
     uint64_t genesis_time = checkpoints.checkpoints[0].timestamp;
     
     for (uint32_t i = 0; i < checkpoints.num_checkpoints; i++) {
-        double balance;
+        PCAmount balance;
         uint64_t query_time = checkpoints.checkpoints[i].timestamp;
         
         pc_query_balance_at(&checkpoints, alice.public_key, query_time, &balance);
         printf("Alice's balance at TX %u (time %lu): %.2f\n", 
-               checkpoints.checkpoints[i].transaction_index, query_time, balance);
+               checkpoints.checkpoints[i].transaction_index, query_time, pc_amount_to_coins(balance));
+    }
+    
+    // One pass over history for a whole series
+    printf("\n═══ Balance Series (one query) ═══\n\n");
+    uint8_t keys[3 * 32];
+    memcpy(keys, alice.public_key, 32);
+    memcpy(keys + 32, bob.public_key, 32);
+    memcpy(keys + 64, charlie.public_key, 32);
+    uint32_t points = pc_query_range_points(genesis_time, state.timestamp, 1);
+    PCAmount* series = calloc((size_t)3 * points, sizeof(PCAmount));
+    if (series && pc_query_balance_range(&checkpoints, keys, 3, genesis_time, state.timestamp, 1, series) == PC_OK) {
+        const char* names[3] = { "Alice", "Bob", "Charlie" };
+        for (int w = 0; w < 3; w++) {
+            printf("  %-8s", names[w]);
+            for (uint32_t i = 0; i < points; i++) {
+                printf(" %.2f", pc_amount_to_coins(series[(size_t)w * points + i]));
+            }
+            printf("\n");
+        }
     }
+    free(series);
     
     printf("\n✓ All demonstrations complete!\n");
     printf("\nKey Insights:\n");
     printf("  • History is 100%% deterministically verifiable\n");
-    printf("  • Can query any past balance using checkpoints\n");
+    printf("  • Can query any past balance exactly (change logs + checkpoints)\n");
     printf("  • Storage: %zu bytes for %u checkpoints (vs blockchain)\n",
            pc_checkpoints_storage(&checkpoints), checkpoints.num_checkpoints);
     printf("  • No trust required—anyone can replay and verify\n\n");
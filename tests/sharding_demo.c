@@ -19,14 +19,14 @@ typedef struct {
 typedef struct {
     PCShard shards[NUM_SHARDS];
     uint32_t num_shards;
-    double total_supply;
+    PCAmount total_supply;
 } PCShardedNetwork;
 
-PCError pc_sharding_init(PCShardedNetwork* network, double initial_supply);
-PCError pc_sharding_create_wallet(PCShardedNetwork* network, const uint8_t* pubkey, double balance);
+PCError pc_sharding_init(PCShardedNetwork* network, PCAmount initial_supply);
+PCError pc_sharding_create_wallet(PCShardedNetwork* network, const uint8_t* pubkey, PCAmount balance);
 PCError pc_sharding_execute_intra_tx(PCShardedNetwork* network, const PCTransaction* tx);
 PCError pc_sharding_execute_cross_tx(PCShardedNetwork* network, const PCTransaction* tx);
-PCError pc_sharding_get_balance(PCShardedNetwork* network, const uint8_t* pubkey, double* balance);
+PCError pc_sharding_get_balance(PCShardedNetwork* network, const uint8_t* pubkey, PCAmount* balance);
 void pc_sharding_print_stats(const PCShardedNetwork* network);
 void pc_sharding_free(PCShardedNetwork* network);
 PCShard* pc_sharding_get_shard(PCShardedNetwork* network, const uint8_t* pubkey);
@@ -39,7 +39,7 @@ int main(void) {
     
     // Initialize sharded network
     PCShardedNetwork network;
-    pc_sharding_init(&network, 10000.0);
+    pc_sharding_init(&network, pc_amount_from_coins(10000.0));
     
     printf("═══ Creating Wallets Across Shards ═══\n\n");
     
@@ -52,7 +52,7 @@ int main(void) {
         wallets[i].public_key[0] = (i << 4);  // 0x00, 0x10, 0x20, ..., 0x70
         
         double balance = 1000.0 + i * 100;
-        pc_sharding_create_wallet(&network, wallets[i].public_key, balance);
+        pc_sharding_create_wallet(&network, wallets[i].public_key, pc_amount_from_coins(balance));
         
         PCShard* shard = pc_sharding_get_shard(&network, wallets[i].public_key);
         
@@ -73,7 +73,7 @@ int main(void) {
     memcpy(intra_tx.from, wallets[0].public_key, 32);
     memcpy(intra_tx.to, wallets[0].public_key, 32);
     intra_tx.to[0] = 0x01;  // Still in shard 0
-    intra_tx.amount = 50.0;
+    intra_tx.amount = pc_amount_from_coins(50.0);
     intra_tx.nonce = 0;
     intra_tx.timestamp = time(NULL);
     pc_transaction_sign(&intra_tx, &wallets[0]);
@@ -92,7 +92,7 @@ int main(void) {
     PCTransaction cross_tx = {0};
     memcpy(cross_tx.from, wallets[0].public_key, 32);
     memcpy(cross_tx.to, wallets[1].public_key, 32);
-    cross_tx.amount = 200.0;
+    cross_tx.amount = pc_amount_from_coins(200.0);
     cross_tx.nonce = 1;
     cross_tx.timestamp = time(NULL);
     pc_transaction_sign(&cross_tx, &wallets[0]);
@@ -104,7 +104,7 @@ int main(void) {
     PCTransaction cross_tx2 = {0};
     memcpy(cross_tx2.from, wallets[2].public_key, 32);
     memcpy(cross_tx2.to, wallets[5].public_key, 32);
-    cross_tx2.amount = 150.0;
+    cross_tx2.amount = pc_amount_from_coins(150.0);
     cross_tx2.nonce = 0;
     cross_tx2.timestamp = time(NULL);
     pc_transaction_sign(&cross_tx2, &wallets[2]);
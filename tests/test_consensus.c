@@ -35,7 +35,7 @@ void test_double_spend_prevention(void) {
     pc_keypair_generate(&charlie);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 100.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(100.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     pc_state_create_wallet(&state, charlie.public_key, 0);
     
@@ -45,7 +45,7 @@ void test_double_spend_prevention(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 50.0;
+        tx.amount = pc_amount_from_coins(50.0);
         tx.nonce = 0;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -60,7 +60,7 @@ void test_double_spend_prevention(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, charlie.public_key, 32);
-        tx.amount = 100.0;  // Only has 50 left
+        tx.amount = pc_amount_from_coins(100.0);  // Only has 50 left
         tx.nonce = 1;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -75,7 +75,7 @@ void test_double_spend_prevention(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 10.0;
+        tx.amount = pc_amount_from_coins(10.0);
         tx.nonce = 0;  // Already used!
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -90,7 +90,7 @@ void test_double_spend_prevention(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 10.0;
+        tx.amount = pc_amount_from_coins(10.0);
         tx.nonce = 1;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &bob);  // Wrong key!
@@ -103,11 +103,11 @@ void test_double_spend_prevention(void) {
     // Test 5: Conservation maintained
     TEST("Conservation after TXs");
     {
-        double total = 0;
+        PCAmount total = 0;
         for (uint32_t i = 0; i < state.num_wallets; i++) {
-            total += state.wallets[i].energy;
+            total += pc_state_wallet_at(&state, i)->energy;
         }
-        if (total == 100.0) PASS(); else FAIL("Conservation violated");
+        if (total == pc_amount_from_coins(100.0)) PASS(); else FAIL("Conservation violated");
     }
     
     pc_state_free(&state);
@@ -124,7 +124,7 @@ void test_serialization(void) {
     TEST("State serialize/deserialize");
     {
         PCState original;
-        pc_state_genesis(&original, kp.public_key, 1000.0);
+        pc_state_genesis(&original, kp.public_key, pc_amount_from_coins(1000.0));
         
         uint8_t buffer[4096];
         size_t size = pc_state_serialize(&original, buffer, sizeof(buffer));
@@ -142,15 +142,15 @@ void test_serialization(void) {
         }
         
         pc_state_free(&original);
-        if (restored.wallets) pc_state_free(&restored);
+        if (restored.wallet_pages) pc_state_free(&restored);
     }
     
     // Test 2: State hash determinism
     TEST("Deterministic state hash");
     {
         PCState s1, s2;
-        pc_state_genesis(&s1, kp.public_key, 500.0);
-        pc_state_genesis(&s2, kp.public_key, 500.0);
+        pc_state_genesis(&s1, kp.public_key, pc_amount_from_coins(500.0));
+        pc_state_genesis(&s2, kp.public_key, pc_amount_from_coins(500.0));
         
         if (memcmp(s1.state_hash, s2.state_hash, 32) == 0) PASS();
         else FAIL("Hash not deterministic");
@@ -169,7 +169,7 @@ void test_streaming(void) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     // Test: Multiple small TXs
@@ -180,7 +180,7 @@ void test_streaming(void) {
             PCTransaction tx = {0};
             memcpy(tx.from, alice.public_key, 32);
             memcpy(tx.to, bob.public_key, 32);
-            tx.amount = 1.0;
+            tx.amount = pc_amount_from_coins(1.0);
             tx.nonce = i;
             tx.timestamp = time(NULL);
             pc_transaction_sign(&tx, &alice);
@@ -194,10 +194,10 @@ void test_streaming(void) {
     // Test: Final balances
     TEST("Final balances correct");
     {
-        double alice_bal = pc_state_get_wallet(&state, alice.public_key)->energy;
-        double bob_bal = pc_state_get_wallet(&state, bob.public_key)->energy;
+        PCAmount alice_bal = pc_state_get_wallet(&state, alice.public_key)->energy;
+        PCAmount bob_bal = pc_state_get_wallet(&state, bob.public_key)->energy;
         
-        if (alice_bal == 900.0 && bob_bal == 100.0) PASS();
+        if (alice_bal == pc_amount_from_coins(900.0) && bob_bal == pc_amount_from_coins(100.0)) PASS();
         else FAIL("Wrong balances");
     }
     
@@ -213,7 +213,7 @@ void test_performance(void) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     TEST("10000 TXs performance");
@@ -224,7 +224,7 @@ void test_performance(void) {
             PCTransaction tx = {0};
             memcpy(tx.from, alice.public_key, 32);
             memcpy(tx.to, bob.public_key, 32);
-            tx.amount = 1.0;
+            tx.amount = pc_amount_from_coins(1.0);
             tx.nonce = i;
             tx.timestamp = time(NULL);
             pc_transaction_sign(&tx, &alice);
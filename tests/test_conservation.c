@@ -2,15 +2,33 @@
 // Stress tests for energy conservation across many transactions
 
 #include "../include/physicscoin.h"
+#include "../include/timetravel.h"
+#include "../include/replay.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #define NUM_WALLETS 100
 #define NUM_TRANSACTIONS 1000
-#define INITIAL_SUPPLY 1000000.0
+#define INITIAL_SUPPLY (1000000 * PC_AMOUNT_SCALE)
+#define HISTORY_STEPS 30
+#define HISTORY_END (110 + 10 * HISTORY_STEPS)
+
+// From batch.c
+typedef struct {
+    PCTransaction* transactions;
+    uint32_t count;
+    uint32_t successful;
+    uint32_t failed;
+    int* results;
+} PCTransactionBatch;
+
+PCError pc_batch_execute(PCState* state, PCTransactionBatch* batch);
+PCError pc_batch_execute_parallel(PCState* state, PCTransactionBatch* batch);
+void pc_batch_free(PCTransactionBatch* batch);
 
 static PCKeypair wallets[NUM_WALLETS];
 static int tests_passed = 0;
@@ -30,6 +48,25 @@ void test_fail(const char* reason) {
     tests_failed++;
 }
 
+// Library progress output would split the result lines; park it in /dev/null
+static int quiet_begin(void) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) {
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+    return saved;
+}
+
+static void quiet_end(int saved) {
+    fflush(stdout);
+    if (saved < 0) return;
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
 // Test 1: Genesis conservation
 void test_genesis_conservation(void) {
     test_start("Genesis creates exact supply");
@@ -38,12 +75,12 @@ void test_genesis_conservation(void) {
     pc_keypair_generate(&wallets[0]);
     pc_state_genesis(&state, wallets[0].public_key, INITIAL_SUPPLY);
     
-    double sum = 0;
+    PCAmount sum = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        sum += state.wallets[i].energy;
+        sum += pc_state_wallet_at(&state, i)->energy;
     }
     
-    if (fabs(sum - INITIAL_SUPPLY) < 1e-10) {
+    if (sum == INITIAL_SUPPLY) {
         test_pass();
     } else {
         test_fail("Supply mismatch");
@@ -60,27 +97,27 @@ void test_single_tx_conservation(void) {
     pc_keypair_generate(&wallets[0]);
     pc_keypair_generate(&wallets[1]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 1000.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, wallets[1].public_key, 0);
     
-    double before = state.total_supply;
+    PCAmount before = state.total_supply;
     
     PCTransaction tx = {0};
     memcpy(tx.from, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, wallets[1].public_key, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &wallets[0]);
     
     pc_state_execute_tx(&state, &tx);
     
-    double after = 0;
+    PCAmount after = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        after += state.wallets[i].energy;
+        after += pc_state_wallet_at(&state, i)->energy;
     }
     
-    if (fabs(before - after) < 1e-10) {
+    if (before == after) {
         test_pass();
     } else {
         test_fail("Energy leaked");
@@ -118,10 +155,10 @@ void test_mass_transactions(void) {
         if (from_idx == to_idx) continue;
         
         PCWallet* from_wallet = pc_state_get_wallet(&state, wallets[from_idx].public_key);
-        if (!from_wallet || from_wallet->energy < 1.0) continue;
+        if (!from_wallet || from_wallet->energy < PC_AMOUNT_SCALE) continue;
         
-        double amount = ((double)(rand() % 100) + 1.0);
-        if (amount > from_wallet->energy) amount = from_wallet->energy * 0.5;
+        PCAmount amount = (PCAmount)(rand() % 100 + 1) * PC_AMOUNT_SCALE;
+        if (amount > from_wallet->energy) amount = from_wallet->energy / 2;
         
         PCTransaction tx = {0};
         memcpy(tx.from, wallets[from_idx].public_key, PHYSICSCOIN_KEY_SIZE);
@@ -138,19 +175,19 @@ void test_mass_transactions(void) {
     }
     
     // Verify conservation
-    double final_sum = 0;
+    PCAmount final_sum = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        final_sum += state.wallets[i].energy;
+        final_sum += pc_state_wallet_at(&state, i)->energy;
     }
     
-    double error = fabs(final_sum - INITIAL_SUPPLY);
+    PCAmount error = final_sum - INITIAL_SUPPLY;
     
-    if (error < 1e-9) {
+    if (error == 0) {
         test_pass();
-        printf("       (Executed %d transactions, error: %.2e)\n", successful, error);
+        printf("       (Executed %d transactions, error: %ld)\n", successful, error);
     } else {
         char buf[128];
-        snprintf(buf, sizeof(buf), "Conservation error: %.12f", error);
+        snprintf(buf, sizeof(buf), "Conservation error: %ld units", error);
         test_fail(buf);
     }
     
@@ -165,13 +202,13 @@ void test_insufficient_funds(void) {
     pc_keypair_generate(&wallets[0]);
     pc_keypair_generate(&wallets[1]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 100.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(100.0));
     pc_state_create_wallet(&state, wallets[1].public_key, 0);
     
     PCTransaction tx = {0};
     memcpy(tx.from, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, wallets[1].public_key, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = 200.0;  // More than available
+    tx.amount = pc_amount_from_coins(200.0);  // More than available
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &wallets[0]);
@@ -195,13 +232,13 @@ void test_negative_amount(void) {
     pc_keypair_generate(&wallets[0]);
     pc_keypair_generate(&wallets[1]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 100.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(100.0));
     pc_state_create_wallet(&state, wallets[1].public_key, 0);
     
     PCTransaction tx = {0};
     memcpy(tx.from, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, wallets[1].public_key, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = -50.0;
+    tx.amount = pc_amount_from_coins(-50.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &wallets[0]);
@@ -225,13 +262,13 @@ void test_replay_protection(void) {
     pc_keypair_generate(&wallets[0]);
     pc_keypair_generate(&wallets[1]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 1000.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, wallets[1].public_key, 0);
     
     PCTransaction tx = {0};
     memcpy(tx.from, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, wallets[1].public_key, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &wallets[0]);
@@ -258,12 +295,12 @@ void test_self_transfer(void) {
     PCState state;
     pc_keypair_generate(&wallets[0]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 500.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(500.0));
     
     PCTransaction tx = {0};
     memcpy(tx.from, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
     memcpy(tx.to, wallets[0].public_key, PHYSICSCOIN_KEY_SIZE);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &wallets[0]);
@@ -272,7 +309,7 @@ void test_self_transfer(void) {
     
     PCWallet* w = pc_state_get_wallet(&state, wallets[0].public_key);
     
-    if (err == PC_OK && fabs(w->energy - 500.0) < 1e-10) {
+    if (err == PC_OK && w->energy == pc_amount_from_coins(500.0)) {
         test_pass();
     } else {
         test_fail("Balance changed on self-transfer");
@@ -288,7 +325,7 @@ void test_verify_function(void) {
     PCState state;
     pc_keypair_generate(&wallets[0]);
     
-    pc_state_genesis(&state, wallets[0].public_key, 1000.0);
+    pc_state_genesis(&state, wallets[0].public_key, pc_amount_from_coins(1000.0));
     
     PCError err = pc_state_verify_conservation(&state);
     
@@ -301,6 +338,386 @@ void test_verify_function(void) {
     pc_state_free(&state);
 }
 
+// Test 9: Parallel batch execution matches sequential execution
+void test_parallel_batch(void) {
+    test_start("Parallel batch == sequential batch");
+    
+    for (int i = 0; i < 20; i++) {
+        pc_keypair_generate(&wallets[i]);
+    }
+    
+    PCState seq;
+    pc_state_genesis(&seq, wallets[0].public_key, INITIAL_SUPPLY);
+    for (int i = 1; i < 10; i++) {
+        pc_state_create_wallet(&seq, wallets[i].public_key, 0);
+    }
+    
+    // Mix of independent pairs, shared senders, new recipients and failures
+    PCTransaction txs[400];
+    uint64_t nonces[20] = {0};
+    srand(7);
+    for (int i = 0; i < 400; i++) {
+        int from = (i < 10) ? 0 : rand() % 20;
+        int to = (i < 10) ? i + 1 : rand() % 20;
+        
+        PCTransaction* tx = &txs[i];
+        memset(tx, 0, sizeof(*tx));
+        memcpy(tx->from, wallets[from].public_key, PHYSICSCOIN_KEY_SIZE);
+        memcpy(tx->to, wallets[to].public_key, PHYSICSCOIN_KEY_SIZE);
+        tx->amount = (PCAmount)((i < 10) ? 5000 : rand() % 900 + 1) * PC_AMOUNT_SCALE;
+        tx->nonce = (rand() % 17 == 0) ? nonces[from] + 1 : nonces[from]++;
+        tx->timestamp = 1000 + i;
+        pc_transaction_sign(tx, &wallets[from]);
+        if (i % 53 == 0) tx->signature[5] ^= 1;
+    }
+    
+    PCState par;
+    pc_state_clone(&par, &seq);
+    
+    PCTransactionBatch b1 = { txs, 400, 0, 0, NULL };
+    PCTransactionBatch b2 = { txs, 400, 0, 0, NULL };
+    
+    time_t t0 = time(NULL);
+    pc_batch_execute(&seq, &b1);
+    PCError err = pc_batch_execute_parallel(&par, &b2);
+    time_t t1 = time(NULL);
+    
+    int ok = (err == PC_OK) && b1.successful == b2.successful && b1.successful > 0 &&
+             b1.failed > 0 && seq.num_wallets == par.num_wallets;
+    for (uint32_t i = 0; i < 400 && ok; i++) {
+        ok = b1.results[i] == b2.results[i];
+    }
+    for (uint32_t i = 0; i < seq.num_wallets && ok; i++) {
+        ok = memcmp(pc_state_wallet_at(&seq, i), pc_state_wallet_at(&par, i), sizeof(PCWallet)) == 0 &&
+             memcmp(pc_state_key_at(&seq, i), pc_state_key_at(&par, i), PHYSICSCOIN_KEY_SIZE) == 0;
+    }
+    
+    // Hash chain embeds time(NULL); compare it when both runs saw the same second
+    if (ok && t0 == t1) {
+        ok = memcmp(seq.state_hash, par.state_hash, 32) == 0 &&
+             memcmp(seq.prev_hash, par.prev_hash, 32) == 0;
+    }
+    
+    // Incremental tree must agree with a fresh rebuild
+    uint8_t root_inc[32], root_full[32];
+    pc_state_merkle_root(&par, root_inc);
+    pc_merkle_invalidate(&par.merkle);
+    pc_state_merkle_root(&par, root_full);
+    ok = ok && memcmp(root_inc, root_full, 32) == 0;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Parallel result differs");
+    }
+    
+    pc_batch_free(&b1);
+    pc_batch_free(&b2);
+    pc_state_free(&seq);
+    pc_state_free(&par);
+}
+
+// Test 10: SIMD scan kernels agree with a scalar pass
+void test_scan_kernels(void) {
+    test_start("Scan kernels match scalar reference");
+    
+    pc_keypair_generate(&wallets[0]);
+    PCState state;
+    pc_state_genesis(&state, wallets[0].public_key, INITIAL_SUPPLY);
+    
+    // Spans several pages with a ragged tail; includes ties and negatives
+    uint8_t key[PHYSICSCOIN_KEY_SIZE] = {0};
+    key[31] = 1;
+    srand(11);
+    for (uint32_t i = 0; i < 2 * PC_WALLET_PAGE_SIZE + 37; i++) {
+        memcpy(key, &i, sizeof(i));
+        pc_state_create_wallet(&state, key, 0);
+        PCWallet* w = pc_state_wallet_mut(&state, state.num_wallets - 1);
+        w->energy = (PCAmount)(rand() % 20000 - 500) * (PC_AMOUNT_SCALE / 8);
+    }
+    
+    uint64_t sum = 0, pos_sum = 0;
+    uint32_t pos = 0, neg = 0, buckets[4] = {0};
+    PCAmount lo = INT64_MAX, hi = INT64_MIN;
+    const PCAmount bounds[3] = {0, 100 * PC_AMOUNT_SCALE, 1000 * PC_AMOUNT_SCALE};
+    PCAmount* sorted = malloc(state.num_wallets * sizeof(PCAmount));
+    for (uint32_t i = 0; i < state.num_wallets; i++) {
+        PCAmount v = pc_state_wallet_at(&state, i)->energy;
+        sum += (uint64_t)v;
+        if (v > 0) { pos++; pos_sum += (uint64_t)v; }
+        if (v < 0) neg++;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        uint32_t b = 0;
+        while (b < 3 && v >= bounds[b]) b++;
+        buckets[b]++;
+        sorted[i] = v;
+    }
+    // Descending insertion of the top 50 is enough for the threshold check
+    for (uint32_t i = 0; i < 50; i++) {
+        for (uint32_t j = i + 1; j < state.num_wallets; j++) {
+            if (sorted[j] > sorted[i]) { PCAmount t = sorted[i]; sorted[i] = sorted[j]; sorted[j] = t; }
+        }
+    }
+    
+    PCScanStats st;
+    pc_scan_stats(&state, &st);
+    uint32_t counts[4];
+    pc_scan_histogram(&state, bounds, 3, counts);
+    
+    // More bounds than the kernels take in one pass
+    PCAmount fine[100];
+    uint32_t fine_counts[101], fine_expected[101] = {0};
+    for (uint32_t j = 0; j < 100; j++) fine[j] = (PCAmount)j * 25 * PC_AMOUNT_SCALE - 500 * PC_AMOUNT_SCALE;
+    for (uint32_t i = 0; i < state.num_wallets; i++) {
+        uint32_t b = 0;
+        while (b < 100 && pc_state_wallet_at(&state, i)->energy >= fine[b]) b++;
+        fine_expected[b]++;
+    }
+    pc_scan_histogram(&state, fine, 100, fine_counts);
+    
+    int ok = pc_scan_sum(&state) == sum && st.sum == sum && st.positive_sum == pos_sum &&
+             st.positive == pos && st.negative == neg && st.min == lo && st.max == hi &&
+             memcmp(counts, buckets, sizeof(counts)) == 0 &&
+             memcmp(fine_counts, fine_expected, sizeof(fine_counts)) == 0 &&
+             pc_scan_topk_threshold(&state, 1) == sorted[0] &&
+             pc_scan_topk_threshold(&state, 50) == sorted[49] &&
+             pc_scan_topk_threshold(&state, state.num_wallets + 1) == INT64_MIN;
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Kernel result differs");
+    }
+    
+    free(sorted);
+    pc_state_free(&state);
+}
+
+// Three wallets trade with transfer i at time 110 + 10i; genesis is at 100
+// and a checkpoint follows every fourth transfer. expected[k][w] is wallet w
+// after k transfers.
+static int build_history(PCCheckpointHistory* history, PCWallet expected[][3]) {
+    for (int w = 0; w < 3; w++) pc_keypair_generate(&wallets[w]);
+    PCState state;
+    pc_state_genesis(&state, wallets[0].public_key, INITIAL_SUPPLY);
+    state.timestamp = 100;
+    pc_state_compute_hash(&state);
+    pc_checkpoints_init(history, 4);
+    
+    int ok = pc_checkpoints_add(history, &state, 0) == PC_OK;
+    memset(expected, 0, (HISTORY_STEPS + 1) * sizeof(expected[0]));
+    expected[0][0] = *pc_state_get_wallet(&state, wallets[0].public_key);
+    
+    uint64_t nonces[3] = {0};
+    for (uint32_t i = 0; ok && i < HISTORY_STEPS; i++) {
+        // The first two transfers fund wallets 1 and 2
+        int from = i < 2 ? 0 : (int)(i % 3);
+        int to = i < 2 ? (int)i + 1 : (from + 1 + (int)(i % 2)) % 3;
+        
+        PCTransaction tx;
+        memset(&tx, 0, sizeof(tx));
+        memcpy(tx.from, wallets[from].public_key, PHYSICSCOIN_KEY_SIZE);
+        memcpy(tx.to, wallets[to].public_key, PHYSICSCOIN_KEY_SIZE);
+        tx.amount = (PCAmount)(i < 2 ? 100 : i % 5 + 1) * PC_AMOUNT_SCALE;
+        tx.nonce = nonces[from]++;
+        tx.timestamp = 110 + 10 * i;
+        pc_transaction_sign(&tx, &wallets[from]);
+        
+        ok = pc_state_execute_tx(&state, &tx) == PC_OK;
+        state.timestamp = 110 + 10 * i;
+        pc_state_compute_hash(&state);
+        ok = ok && pc_checkpoints_record_tx(history, &state, &tx) == PC_OK;
+        if (ok && (i + 1) % 4 == 0) ok = pc_checkpoints_add(history, &state, i + 1) == PC_OK;
+        
+        for (int w = 0; w < 3; w++) {
+            PCWallet* wallet = pc_state_get_wallet(&state, wallets[w].public_key);
+            if (wallet) expected[i + 1][w] = *wallet;
+        }
+    }
+    
+    pc_state_free(&state);
+    return ok;
+}
+
+// Transfers applied by time t (t >= 100)
+static uint32_t history_step_at(uint64_t t) {
+    if (t < 110) return 0;
+    uint64_t k = (t - 110) / 10 + 1;
+    return k < HISTORY_STEPS ? (uint32_t)k : HISTORY_STEPS;
+}
+
+// Test 11: Time-travel queries are exact between checkpoints
+void test_timetravel_exact(void) {
+    test_start("Wallet at any time matches applied history");
+    
+    PCCheckpointHistory history;
+    PCWallet expected[HISTORY_STEPS + 1][3];
+    int saved = quiet_begin();
+    int ok = build_history(&history, expected);
+    
+    // On, between and past the transfer times; nothing exists before genesis
+    PCWallet wallet;
+    ok = ok && pc_query_wallet_at(&history, wallets[0].public_key, 95, &wallet) != PC_OK;
+    for (uint64_t t = 100; ok && t <= HISTORY_END + 20; t += 5) {
+        uint32_t k = history_step_at(t);
+        for (int w = 0; ok && w < 3; w++) {
+            ok = pc_query_wallet_at(&history, wallets[w].public_key, t, &wallet) == PC_OK &&
+                 wallet.energy == expected[k][w].energy && wallet.nonce == expected[k][w].nonce;
+        }
+    }
+    quiet_end(saved);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Historical wallet differs");
+    }
+    
+    pc_checkpoints_free(&history);
+}
+
+// Test 12: Range queries agree with one point query per sample
+void test_timetravel_range(void) {
+    test_start("Balance range == per-point queries");
+    
+    PCCheckpointHistory history;
+    PCWallet expected[HISTORY_STEPS + 1][3];
+    int saved = quiet_begin();
+    int ok = build_history(&history, expected);
+    
+    // The three traders plus a key that never held a wallet
+    uint8_t keys[4 * PHYSICSCOIN_KEY_SIZE];
+    for (int w = 0; w < 3; w++) {
+        memcpy(keys + w * PHYSICSCOIN_KEY_SIZE, wallets[w].public_key, PHYSICSCOIN_KEY_SIZE);
+    }
+    memset(keys + 3 * PHYSICSCOIN_KEY_SIZE, 0xAB, PHYSICSCOIN_KEY_SIZE);
+    
+    // Steps that land on, between and across transfer times
+    const uint64_t starts[3] = {100, 103, 100};
+    const uint64_t steps[3] = {10, 7, 1};
+    for (int r = 0; ok && r < 3; r++) {
+        uint32_t points = pc_query_range_points(starts[r], HISTORY_END + 20, steps[r]);
+        PCAmount* out = malloc((size_t)4 * points * sizeof(PCAmount));
+        ok = out && pc_query_balance_range(&history, keys, 4, starts[r], HISTORY_END + 20,
+                                           steps[r], out) == PC_OK;
+        for (uint32_t k = 0; ok && k < 4; k++) {
+            for (uint32_t i = 0; ok && i < points; i++) {
+                PCAmount balance;
+                ok = pc_query_balance_at(&history, keys + k * PHYSICSCOIN_KEY_SIZE,
+                                         starts[r] + i * steps[r], &balance) == PC_OK &&
+                     out[(size_t)k * points + i] == balance;
+            }
+        }
+        free(out);
+    }
+    
+    // Empty ranges are rejected
+    PCAmount unused;
+    ok = ok && pc_query_balance_range(&history, keys, 1, 200, 100, 10, &unused) != PC_OK &&
+         pc_query_balance_range(&history, keys, 1, 100, 200, 0, &unused) != PC_OK;
+    quiet_end(saved);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Range sample differs from point query");
+    }
+    
+    pc_checkpoints_free(&history);
+}
+
+// Test 13: A trimmed history keeps exact answers from its oldest checkpoint
+void test_timetravel_trim(void) {
+    test_start("Trimmed history exact from oldest checkpoint");
+    
+    PCCheckpointHistory history;
+    PCWallet expected[HISTORY_STEPS + 1][3];
+    int saved = quiet_begin();
+    int ok = build_history(&history, expected);
+    
+    // Checkpoints follow transfers 4, 8, ..., 28; keep the last three
+    ok = ok && pc_checkpoints_trim(&history, 3) == PC_OK && history.num_checkpoints == 3 &&
+         history.checkpoints[0].transaction_index == 20;
+    uint64_t oldest = history.checkpoints[0].timestamp;
+    
+    PCWallet wallet;
+    ok = ok && pc_query_wallet_at(&history, wallets[0].public_key, oldest - 1, &wallet) != PC_OK;
+    for (uint64_t t = oldest; ok && t <= HISTORY_END + 20; t += 5) {
+        uint32_t k = history_step_at(t);
+        for (int w = 0; ok && w < 3; w++) {
+            ok = pc_query_wallet_at(&history, wallets[w].public_key, t, &wallet) == PC_OK &&
+                 wallet.energy == expected[k][w].energy && wallet.nonce == expected[k][w].nonce;
+        }
+    }
+    quiet_end(saved);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Trimmed history answer differs");
+    }
+    
+    pc_checkpoints_free(&history);
+}
+
+// Test 14: Segmented replay catches a transaction altered inside the log
+void test_segmented_replay_tamper(void) {
+    test_start("Segmented replay detects a tampered mid-log tx");
+    
+    for (int w = 0; w < 3; w++) pc_keypair_generate(&wallets[w]);
+    PCState state;
+    pc_state_genesis(&state, wallets[0].public_key, INITIAL_SUPPLY);
+    PCReplayLog log;
+    PCCheckpointHistory history;
+    int saved = quiet_begin();
+    int ok = pc_replay_init(&log, &state) == PC_OK && pc_checkpoints_init(&history, 6) == PC_OK;
+    
+    // 24 transfers; checkpoints after 6, 12 and 18 cut the log into four segments
+    uint64_t nonces[3] = {0};
+    for (uint32_t i = 0; ok && i < 24; i++) {
+        int from = i < 2 ? 0 : (int)(i % 3);
+        int to = i < 2 ? (int)i + 1 : (from + 1) % 3;
+        PCTransaction tx;
+        memset(&tx, 0, sizeof(tx));
+        memcpy(tx.from, wallets[from].public_key, PHYSICSCOIN_KEY_SIZE);
+        memcpy(tx.to, wallets[to].public_key, PHYSICSCOIN_KEY_SIZE);
+        tx.amount = (PCAmount)(i < 2 ? 1000 : i + 1) * PC_AMOUNT_SCALE;
+        tx.nonce = nonces[from]++;
+        tx.timestamp = 1000 + i;
+        pc_transaction_sign(&tx, &wallets[from]);
+        
+        ok = pc_state_execute_tx(&state, &tx) == PC_OK && pc_replay_add_tx(&log, &tx) == PC_OK;
+        if (ok && (i + 1) % 6 == 0) ok = pc_checkpoints_add(&history, &state, log.num_transactions) == PC_OK;
+    }
+    ok = ok && pc_replay_verify_segmented(&log, &history, NULL) == PC_OK;
+    
+    // Transfer 9 sits in the second segment: a re-signed amount, then a
+    // broken signature, must each fail against the checkpoint after 12
+    PCTransaction original = log.transactions[9];
+    PCTransaction* tx = &log.transactions[9];
+    int from = 9 % 3;
+    tx->amount += PC_AMOUNT_SCALE;
+    pc_transaction_sign(tx, &wallets[from]);
+    ok = ok && pc_replay_verify_segmented(&log, &history, NULL) == PC_ERR_INVALID_STATE;
+    *tx = original;
+    tx->signature[0] ^= 1;
+    ok = ok && pc_replay_verify_segmented(&log, &history, NULL) == PC_ERR_INVALID_STATE;
+    *tx = original;
+    ok = ok && pc_replay_verify_segmented(&log, &history, NULL) == PC_OK;
+    quiet_end(saved);
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Tampered log was not rejected");
+    }
+    
+    pc_replay_free(&log);
+    pc_checkpoints_free(&history);
+    pc_state_free(&state);
+}
+
 int main(void) {
     printf("\n");
     printf("╔═══════════════════════════════════════════════════════════════╗\n");
@@ -315,6 +732,12 @@ int main(void) {
     test_replay_protection();
     test_self_transfer();
     test_verify_function();
+    test_parallel_batch();
+    test_scan_kernels();
+    test_timetravel_exact();
+    test_timetravel_range();
+    test_timetravel_trim();
+    test_segmented_replay_tamper();
     
     printf("\n");
     printf("═══════════════════════════════════════════════════════════════\n");
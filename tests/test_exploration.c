@@ -42,7 +42,7 @@ void explore_determinism(void) {
         }
         
         PCState state;
-        pc_state_genesis(&state, alice.public_key, 1000.0);
+        pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
         pc_state_create_wallet(&state, bob.public_key, 0);
         
         // Same transactions every time
@@ -50,7 +50,7 @@ void explore_determinism(void) {
             PCTransaction tx = {0};
             memcpy(tx.from, alice.public_key, 32);
             memcpy(tx.to, bob.public_key, 32);
-            tx.amount = 10.0;
+            tx.amount = pc_amount_from_coins(10.0);
             tx.nonce = i;
             tx.timestamp = 1000000 + i;  // Fixed timestamp
             pc_transaction_sign(&tx, &alice);
@@ -98,7 +98,7 @@ void explore_precision(void) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     double test_amounts[] = {0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 
@@ -112,13 +112,13 @@ void explore_precision(void) {
     for (int i = 0; i < 12; i++) {
         // Reset state
         pc_state_free(&state);
-        pc_state_genesis(&state, alice.public_key, 1.0);
+        pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1.0));
         pc_state_create_wallet(&state, bob.public_key, 0);
         
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = test_amounts[i];
+        tx.amount = pc_amount_from_coins(test_amounts[i]);
         tx.nonce = 0;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -167,7 +167,7 @@ void explore_parallelism(void) {
     
     PCState state;
     pc_keypair_generate(&senders[0]);
-    pc_state_genesis(&state, senders[0].public_key, 1000000.0);
+    pc_state_genesis(&state, senders[0].public_key, pc_amount_from_coins(1000000.0));
     
     // Distribute funds
     for (int i = 0; i < N_PAIRS; i++) {
@@ -177,11 +177,11 @@ void explore_parallelism(void) {
     
     // Give each sender funds
     PCWallet* genesis = pc_state_get_wallet(&state, senders[0].public_key);
-    genesis->energy = 1000000.0;
+    genesis->energy = pc_amount_from_coins(1000000.0);
     for (int i = 1; i < N_PAIRS; i++) {
         PCWallet* w = pc_state_get_wallet(&state, senders[i].public_key);
-        w->energy = 1000.0;
-        genesis->energy -= 1000.0;
+        w->energy = pc_amount_from_coins(1000.0);
+        genesis->energy -= pc_amount_from_coins(1000.0);
     }
     
     // Pre-build all transactions (simulating batch arrival)
@@ -190,7 +190,7 @@ void explore_parallelism(void) {
         memset(&txs[i], 0, sizeof(PCTransaction));
         memcpy(txs[i].from, senders[i].public_key, 32);
         memcpy(txs[i].to, receivers[i].public_key, 32);
-        txs[i].amount = 100.0;
+        txs[i].amount = pc_amount_from_coins(100.0);
         txs[i].nonce = 0;
         txs[i].timestamp = time(NULL);
         pc_transaction_sign(&txs[i], &senders[i]);
@@ -234,7 +234,7 @@ void explore_state_diff(void) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     // Serialize before transaction
@@ -245,7 +245,7 @@ void explore_state_diff(void) {
     PCTransaction tx = {0};
     memcpy(tx.from, alice.public_key, 32);
     memcpy(tx.to, bob.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &alice);
@@ -293,7 +293,7 @@ void explore_hash_chain(void) {
     pc_keypair_generate(&bob);
     
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     // Record hash chain
@@ -304,7 +304,7 @@ void explore_hash_chain(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 10.0;
+        tx.amount = pc_amount_from_coins(10.0);
         tx.nonce = i - 1;
         tx.timestamp = 1000000 + i;
         pc_transaction_sign(&tx, &alice);
@@ -361,7 +361,7 @@ void explore_wallet_patterns(void) {
     pc_keypair_generate(&vendor1);
     
     PCState state;
-    pc_state_genesis(&state, company_main.public_key, 100000.0);
+    pc_state_genesis(&state, company_main.public_key, pc_amount_from_coins(100000.0));
     pc_state_create_wallet(&state, company_payroll.public_key, 0);
     pc_state_create_wallet(&state, company_vendor.public_key, 0);
     pc_state_create_wallet(&state, employee1.public_key, 0);
@@ -374,7 +374,7 @@ void explore_wallet_patterns(void) {
     PCTransaction tx1 = {0};
     memcpy(tx1.from, company_main.public_key, 32);
     memcpy(tx1.to, company_payroll.public_key, 32);
-    tx1.amount = 10000.0;
+    tx1.amount = pc_amount_from_coins(10000.0);
     tx1.nonce = 0;
     tx1.timestamp = time(NULL);
     pc_transaction_sign(&tx1, &company_main);
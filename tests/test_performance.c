@@ -23,7 +23,7 @@ void benchmark_transactions(void) {
     pc_keypair_generate(&alice);
     pc_keypair_generate(&bob);
     
-    pc_state_genesis(&state, alice.public_key, 1000000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     int num_tx = 10000;
@@ -33,7 +33,7 @@ void benchmark_transactions(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, PHYSICSCOIN_KEY_SIZE);
         memcpy(tx.to, bob.public_key, PHYSICSCOIN_KEY_SIZE);
-        tx.amount = 1.0;
+        tx.amount = pc_amount_from_coins(1.0);
         tx.nonce = i;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -74,7 +74,7 @@ void benchmark_state_size(void) {
         PCKeypair kp;
         
         pc_keypair_generate(&kp);
-        pc_state_genesis(&state, kp.public_key, 1000000.0);
+        pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000000.0));
         
         for (int i = 1; i < n; i++) {
             pc_keypair_generate(&kp);
@@ -99,7 +99,7 @@ void benchmark_hash_computation(void) {
     PCKeypair kp;
     
     pc_keypair_generate(&kp);
-    pc_state_genesis(&state, kp.public_key, 1000000.0);
+    pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000000.0));
     
     // Add 100 wallets
     for (int i = 0; i < 100; i++) {
@@ -123,10 +123,10 @@ int main(void) {
         memset(&p2, 0, sizeof(POCProposal));
         
         p1.sequence_num = 1;
-        p1.total_supply = 1000.0;
+        p1.total_supply = pc_amount_from_coins(1000.0);
         
         p2.sequence_num = 1;
-        p2.total_supply = 1000.0;
+        p2.total_supply = pc_amount_from_coins(1000.0);
         
         uint8_t hash1[32], hash2[32];
         poc_hash_proposal(&p1, hash1);
@@ -135,7 +135,7 @@ int main(void) {
         // Same proposals should have same hash
         if (memcmp(hash1, hash2, 32) == 0) {
             // Modify p2 and verify hash changes
-            p2.total_supply = 1001.0;
+            p2.total_supply = pc_amount_from_coins(1001.0);
             poc_hash_proposal(&p2, hash2);
             
             if (memcmp(hash1, hash2, 32) != 0) {
@@ -157,7 +157,7 @@ int main(void) {
         PCKeypair sender;
         pc_keypair_generate(&sender);
         
-        PCError err = poc_acquire_lock(&consensus, sender.public_key, 100.0, 0, 1);
+        PCError err = poc_acquire_lock(&consensus, sender.public_key, pc_amount_from_coins(100.0), 0, 1);
         
         if (err == PC_OK && 
             consensus.num_pending_locks == 1 &&
@@ -177,8 +177,8 @@ int main(void) {
         PCKeypair sender;
         pc_keypair_generate(&sender);
         
-        poc_acquire_lock(&consensus, sender.public_key, 100.0, 0, 1);
-        PCError err = poc_acquire_lock(&consensus, sender.public_key, 50.0, 0, 2);
+        poc_acquire_lock(&consensus, sender.public_key, pc_amount_from_coins(100.0), 0, 1);
+        PCError err = poc_acquire_lock(&consensus, sender.public_key, pc_amount_from_coins(50.0), 0, 2);
         
         if (err == PC_ERR_WALLET_EXISTS) {
             PASS();
@@ -6,7 +6,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
 #include <sodium.h>
 
 static int tests_passed = 0;
@@ -37,20 +36,20 @@ void test_conservation_enforcement(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Verify initial conservation
-    double initial_sum = 0;
+    PCAmount initial_sum = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        initial_sum += state.wallets[i].energy;
+        initial_sum += pc_state_wallet_at(&state, i)->energy;
     }
     
     // Valid transaction
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -58,14 +57,14 @@ void test_conservation_enforcement(void) {
     PCError err = pc_state_execute_tx(&state, &tx);
     
     // Verify conservation maintained
-    double final_sum = 0;
+    PCAmount final_sum = 0;
     for (uint32_t i = 0; i < state.num_wallets; i++) {
-        final_sum += state.wallets[i].energy;
+        final_sum += pc_state_wallet_at(&state, i)->energy;
     }
     
     PCError cons = pc_state_verify_conservation(&state);
     
-    if (err == PC_OK && cons == PC_OK && fabs(initial_sum - final_sum) < 1e-10) {
+    if (err == PC_OK && cons == PC_OK && initial_sum == final_sum) {
         test_pass();
     } else {
         test_fail("Conservation check failed");
@@ -81,9 +80,9 @@ void test_no_money_creation(void) {
     pc_keypair_generate(&kp);
     
     PCState state;
-    pc_state_genesis(&state, kp.public_key, 1000.0);
+    pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000.0));
     
-    double original_supply = state.total_supply;
+    PCAmount original_supply = state.total_supply;
     
     // Try to directly add balance (simulating an attack)
     // This should NOT be possible through public API
@@ -101,7 +100,7 @@ void test_no_money_creation(void) {
     }
     
     // Attacker wallet should have 0 balance
-    if (attacker_wallet->energy != 0.0) {
+    if (attacker_wallet->energy != 0) {
         test_fail("New wallet has non-zero balance");
         pc_state_free(&state);
         return;
@@ -110,7 +109,7 @@ void test_no_money_creation(void) {
     // Total supply should not have changed
     PCError cons = pc_state_verify_conservation(&state);
     
-    if (cons == PC_OK && fabs(state.total_supply - original_supply) < 1e-10) {
+    if (cons == PC_OK && state.total_supply == original_supply) {
         test_pass();
     } else {
         test_fail("Supply changed without valid transaction");
@@ -127,14 +126,14 @@ void test_negative_balance_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 100.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(100.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Try to send more than balance
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 200.0;  // More than available
+    tx.amount = pc_amount_from_coins(200.0);  // More than available
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -162,14 +161,14 @@ void test_invalid_signature_rejected(void) {
     pc_keypair_generate(&attacker);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Create transaction from kp1 but sign with attacker key
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     
@@ -195,20 +194,20 @@ void test_modified_transaction_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Create and sign valid transaction
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
     
     // Modify amount AFTER signing
-    tx.amount = 900.0;  // Attacker tries to steal more
+    tx.amount = pc_amount_from_coins(900.0);  // Attacker tries to steal more
     
     PCError err = pc_state_execute_tx(&state, &tx);
     
@@ -221,6 +220,108 @@ void test_modified_transaction_rejected(void) {
     pc_state_free(&state);
 }
 
+void test_batch_verify_matches_single(void) {
+    test_start("Crypto: Batch verify matches single verify");
+    
+    enum { COUNT = 150 };
+    PCKeypair keys[3], attacker;
+    for (int i = 0; i < 3; i++) pc_keypair_generate(&keys[i]);
+    pc_keypair_generate(&attacker);
+    
+    PCTransaction* txs = calloc(COUNT, sizeof(PCTransaction));
+    const PCTransaction* ptrs[COUNT];
+    int results[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        const PCKeypair* kp = &keys[i % 3];
+        memcpy(txs[i].from, kp->public_key, 32);
+        memcpy(txs[i].to, keys[(i + 1) % 3].public_key, 32);
+        txs[i].amount = pc_amount_from_coins(1.0) + i;
+        txs[i].nonce = (uint64_t)i;
+        txs[i].timestamp = time(NULL);
+        pc_transaction_sign(&txs[i], kp);
+        ptrs[i] = &txs[i];
+    }
+    
+    // Bad entries spread over several batch chunks
+    memcpy(txs[3].from, attacker.public_key, 32);
+    pc_transaction_sign(&txs[3], &attacker);
+    memcpy(txs[3].from, keys[0].public_key, 32);    // Signed by the wrong key
+    txs[40].amount += 1;                            // Modified after signing
+    memset(txs[70].signature, 0, 64);               // Unsigned
+    txs[71].signature[63] |= 0xf0;                  // s >= L
+    txs[140].signature[0] ^= 1;                     // Corrupted R
+    
+    int passed = pc_transaction_verify_batch(ptrs, COUNT, results);
+    
+    int ok = passed == COUNT - 5;
+    for (int i = 0; i < COUNT && ok; i++) {
+        ok = results[i] == (pc_transaction_verify(&txs[i]) == PC_OK);
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Batch results differ from single verification");
+    }
+    
+    free(txs);
+}
+
+// Keys A' = A + T (T of order 8) sign validly for the secret behind A but
+// pass a cofactorless check only for some hashes. Batch and single paths must
+// still agree, every time.
+void test_mixed_order_keys_consistent(void) {
+    test_start("Crypto: Mixed-order keys get one verdict on every path");
+    
+    static const uint8_t order8[32] = {
+        0xc7, 0x17, 0x6a, 0x70, 0x3d, 0x4d, 0xd8, 0x4f, 0xba, 0x3c, 0x0b, 0x76, 0x0d, 0x10, 0x67, 0x0f,
+        0x2a, 0x20, 0x53, 0xfa, 0x2c, 0x39, 0xcc, 0xc6, 0x4e, 0xc7, 0xfd, 0x77, 0x92, 0xac, 0x03, 0x7a
+    };
+    enum { COUNT = 256, KEYS = 8, ROUNDS = 4 };
+    PCKeypair keys[KEYS];
+    int ok = 1;
+    for (int k = 0; k < KEYS; k++) {
+        pc_keypair_generate(&keys[k]);
+        if (k % 2 == 0) continue;    // Half the keys stay honest
+        uint8_t mixed[32];
+        ok &= crypto_core_ed25519_add(mixed, keys[k].public_key, order8) == 0;
+        ok &= !crypto_core_ed25519_is_valid_point(mixed);
+        memcpy(keys[k].public_key, mixed, 32);
+        memcpy(keys[k].secret_key + 32, mixed, 32);    // Signing hashes this key
+    }
+    
+    PCTransaction* txs = calloc(COUNT, sizeof(PCTransaction));
+    const PCTransaction* ptrs[COUNT];
+    int single[COUNT], results[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        const PCKeypair* kp = &keys[i % KEYS];
+        memcpy(txs[i].from, kp->public_key, 32);
+        memcpy(txs[i].to, keys[(i + 1) % KEYS].public_key, 32);
+        txs[i].amount = pc_amount_from_coins(1.0) + i;
+        txs[i].nonce = (uint64_t)i;
+        txs[i].timestamp = time(NULL);
+        pc_transaction_sign(&txs[i], kp);
+        ptrs[i] = &txs[i];
+    }
+    txs[9].amount += 1;    // One genuinely bad signature from a mixed-order key
+    
+    for (int i = 0; i < COUNT; i++) single[i] = pc_transaction_verify(&txs[i]) == PC_OK;
+    ok &= !single[9];
+    
+    for (int r = 0; r < ROUNDS && ok; r++) {
+        pc_transaction_verify_batch(ptrs, COUNT, results);
+        for (int i = 0; i < COUNT && ok; i++) ok = results[i] == single[i];
+    }
+    
+    if (ok) {
+        test_pass();
+    } else {
+        test_fail("Batch and single verdicts differ for mixed-order keys");
+    }
+    
+    free(txs);
+}
+
 //=============================================================================
 // TEST 3: Nonce/Replay Protection
 //=============================================================================
@@ -232,14 +333,14 @@ void test_replay_attack_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Create valid transaction
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -267,14 +368,14 @@ void test_future_nonce_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     // Create transaction with future nonce
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 5;  // Wrong - should be 0
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -301,7 +402,7 @@ void test_state_hash_changes(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     uint8_t hash_before[32];
@@ -311,7 +412,7 @@ void test_state_hash_changes(void) {
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -336,7 +437,7 @@ void test_prev_hash_links(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     uint8_t hash_before[32];
@@ -345,7 +446,7 @@ void test_prev_hash_links(void) {
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -373,7 +474,7 @@ void test_serialization_roundtrip_conservation(void) {
     pc_keypair_generate(&kp2);
     
     PCState state1;
-    pc_state_genesis(&state1, kp1.public_key, 1000.0);
+    pc_state_genesis(&state1, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state1, kp2.public_key, 0);
     
     // Execute some transactions
@@ -381,7 +482,7 @@ void test_serialization_roundtrip_conservation(void) {
         PCTransaction tx;
         memcpy(tx.from, kp1.public_key, 32);
         memcpy(tx.to, kp2.public_key, 32);
-        tx.amount = 10.0;
+        tx.amount = pc_amount_from_coins(10.0);
         tx.nonce = i;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &kp1);
@@ -401,7 +502,7 @@ void test_serialization_roundtrip_conservation(void) {
     PCError cons = pc_state_verify_conservation(&state2);
     
     if (cons == PC_OK && 
-        fabs(state1.total_supply - state2.total_supply) < 1e-10) {
+        state1.total_supply == state2.total_supply) {
         test_pass();
     } else {
         test_fail("Conservation violated after serialization");
@@ -422,13 +523,13 @@ void test_zero_amount_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = 0.0;  // Zero amount
+    tx.amount = 0;  // Zero amount
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -452,13 +553,13 @@ void test_negative_amount_rejected(void) {
     pc_keypair_generate(&kp2);
     
     PCState state;
-    pc_state_genesis(&state, kp1.public_key, 1000.0);
+    pc_state_genesis(&state, kp1.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, kp2.public_key, 0);
     
     PCTransaction tx;
     memcpy(tx.from, kp1.public_key, 32);
     memcpy(tx.to, kp2.public_key, 32);
-    tx.amount = -100.0;  // Negative amount
+    tx.amount = pc_amount_from_coins(-100.0);  // Negative amount
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp1);
@@ -484,15 +585,15 @@ void test_self_transfer_conservation(void) {
     pc_keypair_generate(&kp);
     
     PCState state;
-    pc_state_genesis(&state, kp.public_key, 1000.0);
+    pc_state_genesis(&state, kp.public_key, pc_amount_from_coins(1000.0));
     
     PCWallet* wallet = pc_state_get_wallet(&state, kp.public_key);
-    double before = wallet->energy;
+    PCAmount before = wallet->energy;
     
     PCTransaction tx;
     memcpy(tx.from, kp.public_key, 32);
     memcpy(tx.to, kp.public_key, 32);  // Same wallet
-    tx.amount = 100.0;
+    tx.amount = pc_amount_from_coins(100.0);
     tx.nonce = 0;
     tx.timestamp = time(NULL);
     pc_transaction_sign(&tx, &kp);
@@ -500,9 +601,9 @@ void test_self_transfer_conservation(void) {
     PCError err = pc_state_execute_tx(&state, &tx);
     
     // Self-transfer should work and maintain balance
-    double after = wallet->energy;
+    PCAmount after = wallet->energy;
     
-    if (err == PC_OK && fabs(before - after) < 1e-10) {
+    if (err == PC_OK && before == after) {
         test_pass();
     } else {
         test_fail("Self-transfer changed balance unexpectedly");
@@ -534,6 +635,8 @@ int main(void) {
     printf("\n=== CRYPTOGRAPHIC SECURITY TESTS ===\n");
     test_invalid_signature_rejected();
     test_modified_transaction_rejected();
+    test_batch_verify_matches_single();
+    test_mixed_order_keys_consistent();
     
     printf("\n=== REPLAY/NONCE PROTECTION TESTS ===\n");
     test_replay_attack_rejected();
@@ -2,28 +2,194 @@
 // Demonstrates crash recovery with WAL
 
 #include "../include/physicscoin.h"
+#include "../include/wal.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+
+// Remove a WAL's segment files (base.00000001, ...)
+static void remove_wal(const char* base) {
+    char name[300];
+    for (int id = 1; id <= 16; id++) {
+        snprintf(name, sizeof(name), "%s.%08d", base, id);
+        remove(name);
+    }
+}
+
+// Remove a WAL's checkpoint base and its increments
+static void remove_checkpoints(const char* base) {
+    char name[300];
+    snprintf(name, sizeof(name), "%s.checkpoint", base);
+    remove(name);
+    for (int id = 1; id <= 64; id++) {
+        snprintf(name, sizeof(name), "%s.checkpoint.%08d", base, id);
+        remove(name);
+    }
+}
+
+static double elapsed_since(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+#define CKPT_WALLETS 200000
+#define CKPT_ROUNDS 4
+
+#define GROUP_THREADS 4
+#define GROUP_TXS_PER_THREAD 64
 
-// Forward declarations from wal.c
 typedef struct {
-    FILE* file;
-    struct { uint32_t magic; uint32_t version; uint64_t created_at; uint64_t entry_count; uint8_t state_hash[32]; } header;
-    uint64_t current_sequence;
-    int dirty;
-} PCWAL;
-
-PCError pc_wal_init(PCWAL* wal, const char* filename);
-PCError pc_wal_log_tx(PCWAL* wal, const PCTransaction* tx);
-PCError pc_wal_log_genesis(PCWAL* wal, const uint8_t* creator_pubkey, double supply);
-PCError pc_wal_checkpoint(PCWAL* wal, const PCState* state);
-PCError pc_wal_recover(PCWAL* wal, PCState* state);
-PCError pc_wal_truncate(PCWAL* wal);
-void pc_wal_close(PCWAL* wal);
-void pc_wal_print(const PCWAL* wal);
+    PCWAL* wal;
+    const PCTransaction* tx;
+    int failed;
+} AppendJob;
+
+static void* append_worker(void* arg) {
+    AppendJob* job = arg;
+    for (int i = 0; i < GROUP_TXS_PER_THREAD; i++) {
+        if (pc_wal_log_tx(job->wal, job->tx) != PC_OK) job->failed = 1;
+    }
+    return NULL;
+}
+
+// Concurrent durable appends; returns elapsed seconds or -1 on failure
+static double timed_appends(int group_commit, const PCTransaction* tx) {
+    remove_wal("test_group.wal");
+    
+    PCWAL wal;
+    if (pc_wal_init(&wal, "test_group.wal") != PC_OK) return -1;
+    // No extra window: appends that arrive during an fsync form the next group
+    if (group_commit) pc_wal_enable_group_commit(&wal, 0, 0);
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    pthread_t threads[GROUP_THREADS];
+    AppendJob jobs[GROUP_THREADS];
+    for (int t = 0; t < GROUP_THREADS; t++) {
+        jobs[t] = (AppendJob){ &wal, tx, 0 };
+        pthread_create(&threads[t], NULL, append_worker, &jobs[t]);
+    }
+    int failed = 0;
+    for (int t = 0; t < GROUP_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        failed |= jobs[t].failed;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t entries = wal.current_sequence;
+    pc_wal_close(&wal);
+    
+    // Every acknowledged append must be in the reopened log
+    PCWAL check;
+    if (pc_wal_init(&check, "test_group.wal") != PC_OK) return -1;
+    if (check.current_sequence != entries ||
+        entries != GROUP_THREADS * GROUP_TXS_PER_THREAD) failed = 1;
+    
+    // Truncate rotates to a new segment and retires the old one
+    if (pc_wal_truncate(&check) != PC_OK || pc_wal_log_tx(&check, tx) != PC_OK ||
+        access("test_group.wal.00000001", F_OK) == 0 ||
+        check.header.segment_id != 2 || check.current_sequence != entries + 1) failed = 1;
+    pc_wal_close(&check);
+    remove_wal("test_group.wal");
+    
+    if (failed) return -1;
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+#define ASYNC_TXS 256
+
+typedef struct {
+    uint32_t acked;
+    uint32_t failed;
+} AsyncAcks;
+
+static void async_done(void* ctx, PCError err) {
+    AsyncAcks* acks = ctx;
+    if (err == PC_OK) acks->acked++;
+    else acks->failed++;
+}
+
+// Async appends from one thread; returns elapsed seconds or -1 on failure
+static double timed_async_appends(const PCTransaction* tx, int* used_uring) {
+    remove_wal("test_async.wal");
+    
+    PCWAL wal;
+    if (pc_wal_init(&wal, "test_async.wal") != PC_OK) return -1;
+    *used_uring = pc_wal_enable_async(&wal, 64) == PC_OK;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    AsyncAcks acks = {0, 0};
+    for (int i = 0; i < ASYNC_TXS; i++) {
+        pc_wal_log_tx_async(&wal, tx, async_done, &acks);
+        pc_wal_poll(&wal);
+    }
+    
+    // Event loop: wait on the ring until every append is acknowledged
+    while (acks.acked + acks.failed < ASYNC_TXS) {
+        struct pollfd pfd = { pc_wal_async_fd(&wal), POLLIN, 0 };
+        poll(&pfd, 1, 100);
+        pc_wal_poll(&wal);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uint64_t entries = wal.current_sequence;
+    pc_wal_close(&wal);
+    
+    PCWAL check;
+    int failed = acks.failed > 0 || pc_wal_init(&check, "test_async.wal") != PC_OK;
+    if (!failed) {
+        failed = check.current_sequence != entries || entries != ASYNC_TXS;
+        pc_wal_close(&check);
+    }
+    remove_wal("test_async.wal");
+    
+    if (failed) return -1;
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static PCTransaction signed_transfer(const PCKeypair* from, const uint8_t* to,
+                                     double coins, uint64_t nonce) {
+    PCTransaction tx = {0};
+    memcpy(tx.from, from->public_key, 32);
+    memcpy(tx.to, to, 32);
+    tx.amount = pc_amount_from_coins(coins);
+    tx.nonce = nonce;
+    tx.timestamp = time(NULL);
+    pc_transaction_sign(&tx, from);
+    return tx;
+}
+
+static double balance_of(PCState* state, const uint8_t* pubkey) {
+    PCWallet* w = pc_state_get_wallet(state, pubkey);
+    return w ? pc_amount_to_coins(w->energy) : -1;
+}
+
+// Overwrite len bytes of a segment at offset: flip them, or zero them
+// like a write that never completed
+static int damage_segment(const char* base, uint64_t segment, uint64_t offset,
+                          size_t len, int zero) {
+    char name[300];
+    uint8_t buf[64];
+    snprintf(name, sizeof(name), "%s.%08lu", base, segment);
+    int fd = open(name, O_RDWR);
+    if (fd < 0 || len > sizeof(buf) || pread(fd, buf, len, offset) != (ssize_t)len) {
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) buf[i] = zero ? 0 : buf[i] ^ 0xFF;
+    int ok = pwrite(fd, buf, len, offset) == (ssize_t)len;
+    close(fd);
+    return ok;
+}
 
 int main(void) {
     printf("\n");
@@ -32,8 +198,8 @@ int main(void) {
     printf("╚═══════════════════════════════════════════════════════════════╝\n\n");
     
     // Clean up old files
-    remove("test.wal");
-    remove("physicscoin.checkpoint");
+    remove_wal("test.wal");
+    remove_checkpoints("test.wal");
     
     // === PHASE 1: Create transactions with WAL ===
     printf("═══ Phase 1: Creating Transactions with WAL ═══\n\n");
@@ -52,11 +218,11 @@ int main(void) {
     
     // Log genesis
     printf("Logging genesis...\n");
-    pc_wal_log_genesis(&wal, alice.public_key, 1000.0);
+    pc_wal_log_genesis(&wal, alice.public_key, pc_amount_from_coins(1000.0));
     
     // Create and log transactions
     PCState state;
-    pc_state_genesis(&state, alice.public_key, 1000.0);
+    pc_state_genesis(&state, alice.public_key, pc_amount_from_coins(1000.0));
     pc_state_create_wallet(&state, bob.public_key, 0);
     
     printf("Creating 5 transactions...\n");
@@ -64,7 +230,7 @@ int main(void) {
         PCTransaction tx = {0};
         memcpy(tx.from, alice.public_key, 32);
         memcpy(tx.to, bob.public_key, 32);
-        tx.amount = 100.0;
+        tx.amount = pc_amount_from_coins(100.0);
         tx.nonce = i;
         tx.timestamp = time(NULL);
         pc_transaction_sign(&tx, &alice);
@@ -79,8 +245,8 @@ int main(void) {
     }
     
     printf("\nState after 5 TXs:\n");
-    printf("  Alice: %.2f\n", pc_state_get_wallet(&state, alice.public_key)->energy);
-    printf("  Bob:   %.2f\n", pc_state_get_wallet(&state, bob.public_key)->energy);
+    printf("  Alice: %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, alice.public_key)->energy));
+    printf("  Bob:   %.2f\n", pc_amount_to_coins(pc_state_get_wallet(&state, bob.public_key)->energy));
     
     // Create checkpoint
     printf("\nCreating checkpoint...\n");
@@ -109,7 +275,7 @@ int main(void) {
     
     printf("\nRecovered state:\n");
     printf("  Wallets: %u\n", recovered.num_wallets);
-    printf("  Total supply: %.2f\n", recovered.total_supply);
+    printf("  Total supply: %.2f\n", pc_amount_to_coins(recovered.total_supply));
     
     // Verify balances match
     printf("\n═══ Phase 3: Verification ═══\n\n");
@@ -120,11 +286,11 @@ int main(void) {
     double alice_balance = 0, bob_balance = 0;
     
     for (uint32_t i = 0; i < recovered.num_wallets; i++) {
-        if (memcmp(recovered.wallets[i].public_key, alice.public_key, 32) == 0) {
-            alice_balance = recovered.wallets[i].energy;
+        if (memcmp(pc_state_key_at(&recovered, i), alice.public_key, 32) == 0) {
+            alice_balance = pc_amount_to_coins(pc_state_wallet_at(&recovered, i)->energy);
         }
-        if (memcmp(recovered.wallets[i].public_key, bob.public_key, 32) == 0) {
-            bob_balance = recovered.wallets[i].energy;
+        if (memcmp(pc_state_key_at(&recovered, i), bob.public_key, 32) == 0) {
+            bob_balance = pc_amount_to_coins(pc_state_wallet_at(&recovered, i)->energy);
         }
     }
     
@@ -133,6 +299,329 @@ int main(void) {
     
     int success = (alice_balance == alice_expected && bob_balance == bob_expected);
     
+    // === PHASE 4: Group commit ===
+    printf("\n═══ Phase 4: Group Commit (%d appenders) ═══\n\n", GROUP_THREADS);
+    
+    PCTransaction tx = {0};
+    memcpy(tx.from, alice.public_key, 32);
+    memcpy(tx.to, bob.public_key, 32);
+    tx.amount = pc_amount_from_coins(1.0);
+    pc_transaction_sign(&tx, &alice);
+    
+    double per_write = timed_appends(0, &tx);
+    double grouped = timed_appends(1, &tx);
+    int total = GROUP_THREADS * GROUP_TXS_PER_THREAD;
+    
+    if (per_write < 0 || grouped < 0) {
+        printf("  ✗ Durable appends lost or failed\n\n");
+        success = 0;
+    } else {
+        printf("  fsync per append: %8.0f appends/sec\n", total / per_write);
+        printf("  group commit:     %8.0f appends/sec (%.1fx)\n\n",
+               total / grouped, per_write / grouped);
+    }
+    
+    // === PHASE 5: Async writer ===
+    printf("═══ Phase 5: Async Writer (1 event-loop thread) ═══\n\n");
+    
+    int used_uring = 0;
+    double async_time = timed_async_appends(&tx, &used_uring);
+    if (async_time < 0) {
+        printf("  ✗ Async appends lost or failed\n\n");
+        success = 0;
+    } else {
+        printf("  %s: %8.0f durable appends/sec\n\n",
+               used_uring ? "io_uring" : "sync fallback", ASYNC_TXS / async_time);
+    }
+    
+    printf("═══ Phase 6: Incremental Checkpoints (%d wallets) ═══\n\n", CKPT_WALLETS);
+    
+    remove_checkpoints("ckpt.wal");
+    remove_wal("ckpt.wal");
+    PCWAL cwal;
+    pc_wal_init(&cwal, "ckpt.wal");
+    
+    PCState big;
+    pc_state_genesis(&big, alice.public_key, pc_amount_from_coins(1000.0));
+    uint8_t key[32] = {0};
+    key[31] = 7;
+    for (uint32_t i = 0; i < CKPT_WALLETS; i++) {
+        memcpy(key, &i, sizeof(i));
+        pc_state_create_wallet(&big, key, 0);
+    }
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ckpt_ok = pc_wal_checkpoint(&cwal, &big) == PC_OK;
+    double full_time = elapsed_since(&start);
+    
+    // Each round moves a coin to a few wallets: a handful of dirty pages
+    double inc_time = 0;
+    for (int round = 0; round < CKPT_ROUNDS && ckpt_ok; round++) {
+        for (uint32_t k = 0; k < 3; k++) {
+            uint32_t i = (round * 3 + k) * 7919;
+            memcpy(key, &i, sizeof(i));
+            pc_state_get_wallet(&big, alice.public_key)->energy -= PC_AMOUNT_SCALE;
+            pc_state_get_wallet(&big, key)->energy += PC_AMOUNT_SCALE;
+        }
+        pc_state_compute_hash(&big);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ckpt_ok = pc_wal_checkpoint(&cwal, &big) == PC_OK;
+        inc_time += elapsed_since(&start);
+    }
+    printf("  full checkpoint:        %8.2f ms\n", full_time * 1e3);
+    printf("  incremental checkpoint: %8.2f ms\n\n", inc_time * 1e3 / CKPT_ROUNDS);
+    
+    // Fold in the background, then recover from base + remaining increments
+    pc_wal_enable_compaction(&cwal, 2);
+    pc_wal_checkpoint(&cwal, &big);
+    for (int wait = 0; wait < 200 && cwal.base_id == 1; wait++) {
+        usleep(10000);
+    }
+    printf("  compactor folded up to checkpoint %lu of %lu\n\n", cwal.base_id, cwal.checkpoint_id);
+    pc_wal_close(&cwal);
+    
+    PCWAL cwal2;
+    pc_wal_init(&cwal2, "ckpt.wal");
+    PCState back;
+    memset(&back, 0, sizeof(back));
+    ckpt_ok = ckpt_ok && pc_wal_recover(&cwal2, &back) == PC_OK &&
+              back.num_wallets == big.num_wallets;
+    for (uint32_t i = 0; i < big.num_wallets && ckpt_ok; i++) {
+        ckpt_ok = memcmp(pc_state_wallet_at(&big, i), pc_state_wallet_at(&back, i),
+                         sizeof(PCWallet)) == 0;
+    }
+    printf("  %s recovered from base + increments\n\n", ckpt_ok ? "✓" : "✗");
+    success = success && ckpt_ok;
+    
+    pc_wal_close(&cwal2);
+    pc_state_free(&back);
+    remove_checkpoints("ckpt.wal");
+    remove_wal("ckpt.wal");
+    
+    printf("═══ Phase 7: Background Checkpoint (copy-on-write view) ═══\n\n");
+    
+    pc_wal_init(&cwal, "ckpt.wal");
+    pc_state_compute_hash(&big);
+    uint8_t frozen_hash[32];
+    memcpy(frozen_hash, big.state_hash, 32);
+    
+    // The caller only pays for the freeze; the write runs beside it
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int async_ok = pc_wal_checkpoint_async(&cwal, &big, NULL, NULL) == PC_OK;
+    double freeze_time = elapsed_since(&start);
+    
+    // Keep executing against the live state while the view is written
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t k = 0; k < 64 && async_ok; k++) {
+        uint32_t i = k * 3089;
+        memcpy(key, &i, sizeof(i));
+        pc_state_get_wallet(&big, alice.public_key)->energy -= PC_AMOUNT_SCALE;
+        pc_state_get_wallet(&big, key)->energy += PC_AMOUNT_SCALE;
+    }
+    double mutate_time = elapsed_since(&start);
+    while (cwal.checkpoint_job) {
+        pc_wal_poll(&cwal);
+        usleep(1000);
+    }
+    printf("  caller stalled:         %8.2f ms (full write was %.2f ms)\n",
+           freeze_time * 1e3, full_time * 1e3);
+    printf("  64 transfers meanwhile: %8.2f ms\n", mutate_time * 1e3);
+    pc_wal_close(&cwal);
+    
+    // Recovery sees the frozen view, not the writes made during the checkpoint
+    pc_wal_init(&cwal2, "ckpt.wal");
+    memset(&back, 0, sizeof(back));
+    async_ok = async_ok && pc_wal_recover(&cwal2, &back) == PC_OK;
+    if (async_ok) {
+        pc_state_compute_hash(&back);
+        pc_state_compute_hash(&big);
+        async_ok = memcmp(back.state_hash, frozen_hash, 32) == 0 &&
+                   memcmp(big.state_hash, frozen_hash, 32) != 0;
+    }
+    printf("  %s recovered the state as of the freeze\n\n", async_ok ? "✓" : "✗");
+    success = success && async_ok;
+    
+    pc_wal_close(&cwal2);
+    pc_state_free(&back);
+    pc_state_free(&big);
+    remove_wal("ckpt.wal");
+    remove_checkpoints("ckpt.wal");
+    
+    printf("═══ Phase 8: Two Logs, One Directory ═══\n\n");
+    
+    // Each log checkpoints (base, then an increment) under its own name
+    const char* logs[2] = { "node_a.wal", "node_b.wal" };
+    PCWAL side[2];
+    PCState own[2];
+    int apart_ok = 1;
+    for (int w = 0; w < 2; w++) {
+        remove_wal(logs[w]);
+        remove_checkpoints(logs[w]);
+        apart_ok = apart_ok && pc_wal_init(&side[w], logs[w]) == PC_OK;
+        pc_state_genesis(&own[w], w ? bob.public_key : alice.public_key,
+                         pc_amount_from_coins(w ? 250.0 : 750.0));
+    }
+    for (int round = 0; round < 2 && apart_ok; round++) {
+        for (int w = 0; w < 2 && apart_ok; w++) {
+            pc_state_create_wallet(&own[w], round ? alice.public_key : bob.public_key, 0);
+            apart_ok = pc_wal_checkpoint(&side[w], &own[w]) == PC_OK;
+        }
+    }
+    for (int w = 0; w < 2; w++) pc_wal_close(&side[w]);
+    
+    for (int w = 0; w < 2 && apart_ok; w++) {
+        PCState again;
+        memset(&again, 0, sizeof(again));
+        apart_ok = pc_wal_init(&side[w], logs[w]) == PC_OK &&
+                   pc_wal_recover(&side[w], &again) == PC_OK &&
+                   again.total_supply == own[w].total_supply &&
+                   again.num_wallets == own[w].num_wallets &&
+                   memcmp(again.state_hash, own[w].state_hash, 32) == 0;
+        pc_wal_close(&side[w]);
+        pc_state_free(&again);
+    }
+    printf("  %s each log recovered its own checkpoints\n\n", apart_ok ? "✓" : "✗");
+    success = success && apart_ok;
+    
+    for (int w = 0; w < 2; w++) {
+        pc_state_free(&own[w]);
+        remove_wal(logs[w]);
+        remove_checkpoints(logs[w]);
+    }
+    
+    printf("═══ Phase 9: Damaged Entries Across Segments ═══\n\n");
+    
+    // Alice's transfers span three segments, so their nonces only line up
+    // when segments replay in order. Unsigned filler rolls the segments.
+    PCKeypair carol;
+    pc_keypair_generate(&carol);
+    PCTransaction filler = {0};
+    memcpy(filler.from, carol.public_key, 32);
+    memcpy(filler.to, bob.public_key, 32);
+    filler.amount = pc_amount_from_coins(1.0);
+    
+    remove_wal("damage.wal");
+    remove_checkpoints("damage.wal");
+    PCWAL dwal;
+    int damage_ok = pc_wal_init(&dwal, "damage.wal") == PC_OK;
+    uint64_t flipped_seg = 0, flipped_end = 0, torn_seg = 0, torn_start = 0, torn_end = 0;
+    uint64_t alice_nonce = 0;
+    if (damage_ok) {
+        pc_wal_set_sync_mode(&dwal, 0);
+        pc_wal_log_genesis(&dwal, alice.public_key, pc_amount_from_coins(1000.0));
+    }
+    for (uint64_t seg = 1; seg <= 3 && damage_ok; seg++) {
+        for (int i = 0; i < 3; i++) {
+            PCTransaction t = signed_transfer(&alice, bob.public_key, 1.0, alice_nonce++);
+            damage_ok = damage_ok && pc_wal_log_tx(&dwal, &t) == PC_OK;
+        }
+        if (seg == 2) {
+            // Bob -> Carol 5, corrupted below
+            PCTransaction t = signed_transfer(&bob, carol.public_key, 5.0, 0);
+            damage_ok = damage_ok && pc_wal_log_tx(&dwal, &t) == PC_OK;
+            flipped_seg = dwal.header.segment_id;
+            flipped_end = dwal.write_offset;
+        }
+        if (seg == 3) {
+            // Bob resends for 2, then Alice's last transfer is torn
+            PCTransaction t = signed_transfer(&bob, carol.public_key, 2.0, 0);
+            damage_ok = damage_ok && pc_wal_log_tx(&dwal, &t) == PC_OK;
+            t = signed_transfer(&alice, bob.public_key, 1.0, alice_nonce);
+            torn_seg = dwal.header.segment_id;
+            torn_start = dwal.write_offset;
+            damage_ok = damage_ok && pc_wal_log_tx(&dwal, &t) == PC_OK;
+            torn_end = dwal.write_offset;
+            break;
+        }
+        while (damage_ok && dwal.header.segment_id == seg) {
+            damage_ok = pc_wal_log_tx(&dwal, &filler) == PC_OK;
+        }
+    }
+    if (damage_ok) pc_wal_close(&dwal);
+    damage_ok = damage_ok && flipped_seg == 2 && torn_seg == 3 &&
+                damage_segment("damage.wal", flipped_seg, flipped_end - 1, 1, 0) &&
+                damage_segment("damage.wal", torn_seg, torn_end - 48, 48, 1);
+    
+    // Nine transfers and the resend survive; the flipped and torn entries do not
+    PCState damaged;
+    memset(&damaged, 0, sizeof(damaged));
+    damage_ok = damage_ok && pc_wal_init(&dwal, "damage.wal") == PC_OK &&
+                pc_wal_recover(&dwal, &damaged) == PC_OK;
+    int replay_ok = damage_ok &&
+                    balance_of(&damaged, alice.public_key) == 991.0 &&
+                    balance_of(&damaged, bob.public_key) == 7.0 &&
+                    balance_of(&damaged, carol.public_key) == 2.0;
+    printf("  %s segments replayed in order, damaged entries skipped\n", replay_ok ? "✓" : "✗");
+    
+    // The torn entry is cut off: the next append lands where it started
+    int torn_ok = replay_ok && dwal.header.segment_id == torn_seg &&
+                  dwal.write_offset == torn_start;
+    if (torn_ok) {
+        PCTransaction t = signed_transfer(&alice, bob.public_key, 1.0, alice_nonce);
+        torn_ok = pc_wal_log_tx(&dwal, &t) == PC_OK;
+    }
+    if (damage_ok) pc_wal_close(&dwal);
+    pc_state_free(&damaged);
+    if (torn_ok) {
+        memset(&damaged, 0, sizeof(damaged));
+        torn_ok = pc_wal_init(&dwal, "damage.wal") == PC_OK &&
+                  pc_wal_recover(&dwal, &damaged) == PC_OK &&
+                  balance_of(&damaged, alice.public_key) == 990.0 &&
+                  balance_of(&damaged, bob.public_key) == 8.0;
+        pc_wal_close(&dwal);
+        pc_state_free(&damaged);
+    }
+    printf("  %s torn tail cut off, appends resume after the last whole entry\n\n",
+           torn_ok ? "✓" : "✗");
+    success = success && replay_ok && torn_ok;
+    remove_wal("damage.wal");
+    remove_checkpoints("damage.wal");
+    
+    printf("═══ Phase 10: Damaged Checkpoint Entry ═══\n\n");
+    
+    // Three transfers, a checkpoint, two more; then flip the top byte of the
+    // checkpoint entry's next_sequence (the last bytes of its payload)
+    remove_wal("mark.wal");
+    remove_checkpoints("mark.wal");
+    PCWAL mwal;
+    PCState live;
+    pc_state_genesis(&live, alice.public_key, pc_amount_from_coins(1000.0));
+    int mark_ok = pc_wal_init(&mwal, "mark.wal") == PC_OK;
+    uint64_t mark_seg = 0, mark_end = 0;
+    if (mark_ok) {
+        pc_wal_log_genesis(&mwal, alice.public_key, pc_amount_from_coins(1000.0));
+        for (uint64_t n = 0; mark_ok && n < 5; n++) {
+            if (n == 3) {
+                mark_ok = pc_wal_checkpoint(&mwal, &live) == PC_OK;
+                mark_seg = mwal.header.segment_id;
+                mark_end = mwal.write_offset;
+            }
+            PCTransaction t = signed_transfer(&alice, bob.public_key, 1.0, n);
+            mark_ok = mark_ok && pc_wal_log_tx(&mwal, &t) == PC_OK &&
+                      pc_state_execute_tx(&live, &t) == PC_OK;
+        }
+        pc_wal_close(&mwal);
+    }
+    mark_ok = mark_ok && damage_segment("mark.wal", mark_seg, mark_end - 1, 1, 0);
+    
+    // The entry fails its checksum and is ignored, so the two later
+    // transfers still replay
+    PCState from_ckpt;
+    memset(&from_ckpt, 0, sizeof(from_ckpt));
+    mark_ok = mark_ok && pc_wal_init(&mwal, "mark.wal") == PC_OK &&
+              pc_wal_recover(&mwal, &from_ckpt) == PC_OK &&
+              balance_of(&from_ckpt, alice.public_key) == 995.0 &&
+              balance_of(&from_ckpt, bob.public_key) == 5.0;
+    if (mwal.fd >= 0) pc_wal_close(&mwal);
+    printf("  %s damaged checkpoint entry ignored, later transfers replayed\n\n",
+           mark_ok ? "✓" : "✗");
+    success = success && mark_ok;
+    pc_state_free(&live);
+    pc_state_free(&from_ckpt);
+    remove_wal("mark.wal");
+    remove_checkpoints("mark.wal");
+    
     printf("\n╔═══════════════════════════════════════════════════════════╗\n");
     printf("║  WAL RECOVERY: %s                                  ║\n", 
            success ? "✓ PERFECT" : "✗ FAILED ");
@@ -142,8 +631,8 @@ int main(void) {
     pc_state_free(&recovered);
     
     // Cleanup
-    remove("test.wal");
-    remove("physicscoin.checkpoint");
+    remove_wal("test.wal");
+    remove_checkpoints("test.wal");
     
     return success ? 0 : 1;
 }